@@ -917,6 +917,19 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         default=0,
         min=0, max=16,
     )
+    use_bvh_cache: BoolProperty(
+        name="Use BVH Cache",
+        description="Store BVHs of instanced geometry built for final renders on disk, and reuse them when rendering the same geometry again. "
+        "Only used when Cycles builds its own BVH, not for Embree, OptiX or Metal",
+        default=False,
+    )
+    bvh_cache_directory: StringProperty(
+        name="BVH Cache Directory",
+        description="Directory to store BVHs in, can be shared between computers rendering the same scene. "
+        "When empty, the user cache directory is used",
+        default="",
+        subtype='DIR_PATH',
+    )
 
     bake_type: EnumProperty(
         name="Bake Type",
@@ -1038,6 +1051,17 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         description="",
         min=8, max=8192,
     )
+    use_texture_cache: BoolProperty(
+        name="Use Texture Cache",
+        description="Load tiles of image textures on demand when rendering on the CPU, instead of loading full images into memory. Images are always sampled at full resolution, MIP levels are not used. Images larger than the Simplify texture limit are loaded fully",
+        default=False,
+    )
+    texture_cache_size: IntProperty(
+        name="Texture Cache Size",
+        description="Maximum amount of memory used by the texture cache, in megabytes",
+        default=4096,
+        min=64, max=1048576,
+    )
 
     # Various fine-tuning debug flags
 
@@ -834,6 +834,13 @@ class CYCLES_RENDER_PT_performance_memory(CyclesButtonsPanel, Panel):
         sub.active = cscene.use_auto_tile
         sub.prop(cscene, "tile_size")
 
+        col = layout.column()
+        col.active = use_cpu(context)
+        col.prop(cscene, "use_texture_cache")
+        sub = col.column()
+        sub.active = cscene.use_texture_cache
+        sub.prop(cscene, "texture_cache_size", text="Cache Size")
+
 
 class CYCLES_RENDER_PT_performance_acceleration_structure(CyclesButtonsPanel, Panel):
     bl_label = "Acceleration Structure"
@@ -883,6 +890,13 @@ class CYCLES_RENDER_PT_performance_acceleration_structure(CyclesButtonsPanel, Pa
             if use_multi_device(context) and use_embree:
                 col.prop(cscene, "debug_use_compact_bvh")
 
+        if not (use_cpu(context) and use_embree):
+            col = layout.column()
+            col.prop(cscene, "use_bvh_cache")
+            sub = col.column()
+            sub.active = cscene.use_bvh_cache
+            sub.prop(cscene, "bvh_cache_directory", text="Directory")
+
 
 class CYCLES_RENDER_PT_performance_final_render(CyclesButtonsPanel, Panel):
     bl_label = "Final Render"
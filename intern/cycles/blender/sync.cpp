@@ -62,7 +62,8 @@ BlenderSync::BlenderSync(BL::RenderEngine &b_engine,
       dicing_rate(1.0f),
       max_subdivisions(12),
       progress(progress),
-      has_updates_(true)
+      has_updates_(true),
+      has_object_updates_(true)
 {
   PointerRNA cscene = RNA_pointer_get(&b_scene.ptr, "cycles");
   dicing_rate = preview ? RNA_float_get(&cscene, "preview_dicing_rate") :
@@ -85,10 +86,26 @@ void BlenderSync::reset(BL::BlendData &b_data, BL::Scene &b_scene)
 void BlenderSync::tag_update()
 {
   has_updates_ = true;
+  has_object_updates_ = true;
 }
 
 /* Sync */
 
+static bool depsgraph_object_data_updated(BL::Depsgraph &b_depsgraph)
+{
+  /* Data-block types which are used when synchronizing objects, through the geometry, lights,
+   * particles and shaders they use. Updates of objects themselves are checked in #sync_recalc. */
+  static const short id_types[] = {ID_ME, ID_CU_LEGACY, ID_MB, ID_LT, ID_KE, ID_CV, ID_PT, ID_VO,
+                                   ID_LA, ID_GR, ID_PA, ID_WO, ID_MA, ID_NT, ID_CF};
+
+  for (const short id_type : id_types) {
+    if (b_depsgraph.id_type_updated(id_type)) {
+      return true;
+    }
+  }
+  return false;
+}
+
 void BlenderSync::sync_recalc(BL::Depsgraph &b_depsgraph, BL::SpaceView3D &b_v3d)
 {
   /* Sync recalc flags from blender to cycles. Actual update is done separate,
@@ -130,6 +147,20 @@ void BlenderSync::sync_recalc(BL::Depsgraph &b_depsgraph, BL::SpaceView3D &b_v3d
     }
   }
 
+  /* Final renders with persistent data only walk all object instances again when data they use
+   * was updated. Everything is synchronized for viewport renders and procedurals. */
+  if (preview || experimental || depsgraph_object_data_updated(b_depsgraph)) {
+    has_object_updates_ = true;
+  }
+
+  /* The active camera is synchronized separately. Objects only depend on it for culling. */
+  BL::Object b_camera_override(b_engine.camera_override());
+  BL::Object b_camera = (b_camera_override) ? b_camera_override : b_scene.camera();
+  PointerRNA cscene = RNA_pointer_get(&b_scene.ptr, "cycles");
+  const bool use_camera_culling = b_scene.render().use_simplify() &&
+                                  (get_boolean(cscene, "use_camera_cull") ||
+                                   get_boolean(cscene, "use_distance_cull"));
+
   /* Iterate over all IDs in this depsgraph. */
   for (BL::DepsgraphUpdate &b_update : b_depsgraph.updates) {
     /* TODO(sergey): Can do more selective filter here. For example, ignore changes made to
@@ -153,6 +184,10 @@ void BlenderSync::sync_recalc(BL::Depsgraph &b_depsgraph, BL::SpaceView3D &b_v3d
     /* Object */
     else if (b_id.is_a(&RNA_Object)) {
       BL::Object b_ob(b_id);
+      if (use_camera_culling || b_ob.ptr.data != b_camera.ptr.data) {
+        has_object_updates_ = true;
+      }
+
       const bool can_have_geometry = object_can_have_geometry(b_ob);
       const bool is_light = !can_have_geometry && object_is_light(b_ob);
 
@@ -227,6 +262,14 @@ void BlenderSync::sync_recalc(BL::Depsgraph &b_depsgraph, BL::SpaceView3D &b_v3d
     /* World */
     else if (b_id.is_a(&RNA_Scene)) {
       shader_map.set_recalc(b_id);
+
+      /* Changing the frame alone does not affect objects, other scene changes such as view layer
+       * and collection settings might. */
+      if (b_update.is_updated_transform() || b_update.is_updated_geometry() ||
+          b_update.is_updated_shading())
+      {
+        has_object_updates_ = true;
+      }
     }
     /* Volume */
     else if (b_id.is_a(&RNA_Volume)) {
@@ -273,6 +316,11 @@ void BlenderSync::sync_data(BL::RenderSettings &b_render,
    * implicit check on whether it is a background render or not. What is the nicer thing here? */
   const bool background = !b_v3d;
 
+  /* Objects and their visibility differ between view layers. */
+  if (b_view_layer.name() != view_layer.name) {
+    has_object_updates_ = true;
+  }
+
   sync_view_layer(b_view_layer);
   sync_integrator(b_view_layer, background, device_info);
   sync_film(b_view_layer, b_v3d);
@@ -281,10 +329,25 @@ void BlenderSync::sync_data(BL::RenderSettings &b_render,
 
   geometry_synced.clear(); /* use for objects and motion sync */
 
+  /* Render settings such as motion blur only tag the scene for update. Motion of objects and
+   * geometry is only synchronized as part of the full object walk, also when it is turned off. */
+  if (scene->need_motion() != synced_motion_type_) {
+    has_object_updates_ = true;
+  }
+  synced_motion_type_ = scene->need_motion();
+
   if (scene->need_motion() == Scene::MOTION_PASS || scene->need_motion() == Scene::MOTION_NONE ||
       scene->camera->get_motion_position() == MOTION_POSITION_CENTER)
   {
-    sync_objects(b_depsgraph, b_v3d);
+    /* Motion and auto refreshed images used for displacement are only synchronized as part of
+     * the full object walk. */
+    if (has_object_updates_ || auto_refresh_update || scene->need_motion() != Scene::MOTION_NONE)
+    {
+      sync_objects(b_depsgraph, b_v3d);
+    }
+    else {
+      VLOG_INFO << "Skipping object synchronization, no object data was updated.";
+    }
   }
   sync_motion(b_render, b_depsgraph, b_v3d, b_override, width, height, python_thread_state);
 
@@ -297,6 +360,7 @@ void BlenderSync::sync_data(BL::RenderSettings &b_render,
   VLOG_INFO << "Total time spent synchronizing data: " << timer.get_time();
 
   has_updates_ = false;
+  has_object_updates_ = false;
 }
 
 /* Integrator */
@@ -834,7 +898,8 @@ void BlenderSync::free_data_after_sync(BL::Depsgraph &b_depsgraph)
 
 /* Scene Parameters */
 
-SceneParams BlenderSync::get_scene_params(BL::Scene &b_scene,
+SceneParams BlenderSync::get_scene_params(BL::BlendData &b_data,
+                                          BL::Scene &b_scene,
                                           const bool background,
                                           const bool use_developer_ui)
 {
@@ -880,6 +945,17 @@ SceneParams BlenderSync::get_scene_params(BL::Scene &b_scene,
     params.texture_limit = 0;
   }
 
+  /* Reusing BVHs from disk is meant for final renders of static geometry. */
+  if (background && RNA_boolean_get(&cscene, "use_bvh_cache")) {
+    const string directory = get_string(cscene, "bvh_cache_directory");
+    params.bvh_cache_directory = (directory.empty()) ?
+                                     path_cache_get("bvh") :
+                                     blender_absolute_path(b_data, b_scene, directory);
+  }
+
+  params.use_texture_cache = RNA_boolean_get(&cscene, "use_texture_cache");
+  params.texture_cache_size = RNA_int_get(&cscene, "texture_cache_size");
+
   params.bvh_layout = DebugFlags().cpu.bvh_layout;
 
   params.background = background;
@@ -91,7 +91,8 @@ class BlenderSync {
   void free_data_after_sync(BL::Depsgraph &b_depsgraph);
 
   /* get parameters */
-  static SceneParams get_scene_params(BL::Scene &b_scene,
+  static SceneParams get_scene_params(BL::BlendData &b_data,
+                                      BL::Scene &b_scene,
                                       const bool background,
                                       const bool use_developer_ui);
   static SessionParams get_session_params(BL::RenderEngine &b_engine,
@@ -282,6 +283,13 @@ class BlenderSync {
    * If this flag is false then the data is considered to be up-to-date and will not be
    * synchronized at all. */
   bool has_updates_ = true;
+
+  /* Indicates that changes which may affect objects were detected. If this flag is false then
+   * walking all object instances is skipped, keeping the objects synchronized before. */
+  bool has_object_updates_ = true;
+
+  /* Motion needed by the scene when objects were last synchronized. */
+  Scene::MotionType synced_motion_type_ = Scene::MOTION_NONE;
 };
 
 CCL_NAMESPACE_END
@@ -17,7 +17,14 @@
 #include "bvh/unaligned.h"
 
 #include "util/foreach.h"
+#include "util/log.h"
+#include "util/md5.h"
+#include "util/path.h"
 #include "util/progress.h"
+#include "util/system.h"
+#include "util/time.h"
+
+#include <cstdio>
 
 CCL_NAMESPACE_BEGIN
 
@@ -31,12 +38,25 @@ int BVHStackEntry::encodeIdx() const
 BVH2::BVH2(const BVHParams &params_,
            const vector<Geometry *> &geometry_,
            const vector<Object *> &objects_)
-    : BVH(params_, geometry_, objects_)
+    : BVH(params_, geometry_, objects_),
+      num_top_level_prims(0),
+      build_sah_cost(0.0f),
+      refit_sah_cost(0.0f),
+      refit_valid(true)
 {
 }
 
 void BVH2::build(Progress &progress, Stats *)
 {
+  const string cache_path = cache_filepath();
+  if (!cache_path.empty()) {
+    progress.set_substatus("Reading BVH from cache");
+    if (cache_read(cache_path)) {
+      VLOG_INFO << "Read BVH from cache " << cache_path;
+      return;
+    }
+  }
+
   progress.set_substatus("Building BVH");
 
   /* build nodes */
@@ -73,6 +93,7 @@ void BVH2::build(Progress &progress, Stats *)
   /* pack triangles */
   progress.set_substatus("Packing BVH triangles and strands");
   pack_primitives();
+  num_top_level_prims = pack.prim_index.size();
 
   if (progress.get_cancel()) {
     root->deleteSubtree();
@@ -83,14 +104,32 @@ void BVH2::build(Progress &progress, Stats *)
   progress.set_substatus("Packing BVH nodes");
   pack_nodes(root);
 
+  build_sah_cost = root->computeSubtreeSAHCost(params);
+  refit_sah_cost = build_sah_cost;
+
   /* free build nodes */
   root->deleteSubtree();
+
+  if (!cache_path.empty() && !progress.get_cancel()) {
+    progress.set_substatus("Writing BVH to cache");
+    cache_write(cache_path);
+  }
 }
 
 void BVH2::refit(Progress &progress)
 {
   progress.set_substatus("Packing BVH primitives");
-  pack_primitives();
+  if (params.top_level) {
+    /* Primitives of merged instance BVHs keep the visibility from those. */
+    for (size_t i = 0; i < num_top_level_prims; i++) {
+      pack.prim_visibility[i] = (pack.prim_index[i] != -1) ?
+                                    objects[pack.prim_object[i]]->visibility_for_tracing() :
+                                    0;
+    }
+  }
+  else {
+    pack_primitives();
+  }
 
   if (progress.get_cancel()) {
     return;
@@ -305,14 +344,25 @@ void BVH2::pack_nodes(const BVHNode *root)
 
 void BVH2::refit_nodes()
 {
-  assert(!params.top_level);
-
+  /* For the top level BVH only the top level nodes are refit, nodes of merged instance BVHs are
+   * not reachable from there and object instance leaves use the object bounds. */
   BoundBox bbox = BoundBox::empty;
   uint visibility = 0;
-  refit_node(0, (pack.root_index == -1) ? true : false, bbox, visibility);
+  float sah_cost = 0.0f;
+  refit_valid = true;
+  refit_node(0, (pack.root_index == -1) ? true : false, bbox, visibility, sah_cost);
+
+  /* Relative to the root bounds, same as BVHNode::computeSubtreeSAHCost(). */
+  refit_sah_cost = (bbox.valid()) ? sah_cost / bbox.safe_area() : 0.0f;
+}
+
+bool BVH2::refit_needs_rebuild(const float max_sah_ratio) const
+{
+  return !refit_valid ||
+         (build_sah_cost > 0.0f && refit_sah_cost > build_sah_cost * max_sah_ratio);
 }
 
-void BVH2::refit_node(int idx, bool leaf, BoundBox &bbox, uint &visibility)
+void BVH2::refit_node(int idx, bool leaf, BoundBox &bbox, uint &visibility, float &sah_cost)
 {
   if (leaf) {
     /* refit leaf node */
@@ -321,7 +371,15 @@ void BVH2::refit_node(int idx, bool leaf, BoundBox &bbox, uint &visibility)
     const int c0 = data[0].x;
     const int c1 = data[0].y;
 
-    refit_primitives(c0, c1, bbox, visibility);
+    if (c0 < 0) {
+      /* Object instance leaf in the top level BVH. */
+      refit_primitives(~c0, ~c0 + 1, bbox, visibility);
+      sah_cost += bbox.safe_area() * params.primitive_cost(1);
+    }
+    else {
+      refit_primitives(c0, c1, bbox, visibility);
+      sah_cost += bbox.safe_area() * params.primitive_cost(c1 - c0);
+    }
 
     /* TODO(sergey): De-duplicate with pack_leaf(). */
     float4 leaf_data[BVH_NODE_LEAF_SIZE];
@@ -342,8 +400,8 @@ void BVH2::refit_node(int idx, bool leaf, BoundBox &bbox, uint &visibility)
     BoundBox bbox0 = BoundBox::empty, bbox1 = BoundBox::empty;
     uint visibility0 = 0, visibility1 = 0;
 
-    refit_node((c0 < 0) ? -c0 - 1 : c0, (c0 < 0), bbox0, visibility0);
-    refit_node((c1 < 0) ? -c1 - 1 : c1, (c1 < 0), bbox1, visibility1);
+    refit_node((c0 < 0) ? -c0 - 1 : c0, (c0 < 0), bbox0, visibility0, sah_cost);
+    refit_node((c1 < 0) ? -c1 - 1 : c1, (c1 < 0), bbox1, visibility1, sah_cost);
 
     if (is_unaligned) {
       Transform aligned_space = transform_identity();
@@ -357,6 +415,7 @@ void BVH2::refit_node(int idx, bool leaf, BoundBox &bbox, uint &visibility)
     bbox.grow(bbox0);
     bbox.grow(bbox1);
     visibility = visibility0 | visibility1;
+    sah_cost += bbox.safe_area() * params.node_cost(2);
   }
 }
 
@@ -370,6 +429,12 @@ void BVH2::refit_primitives(int start, int end, BoundBox &bbox, uint &visibility
     int tob = pack.prim_object[prim];
     Object *ob = objects[tob];
 
+    /* Primitives of geometry with applied transform are part of the top level BVH, others are
+     * instanced. This may have changed since the BVH was built. */
+    if (params.top_level && (pidx == -1) != ob->get_geometry()->is_instanced()) {
+      refit_valid = false;
+    }
+
     if (pidx == -1) {
       /* Object instance. */
       bbox.grow(ob->bounds);
@@ -653,4 +718,359 @@ void BVH2::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
   }
 }
 
+/* Cache */
+
+/* Increase when the layout of the packed BVH or the cache files changes. */
+#define BVH2_CACHE_VERSION 2
+
+struct BVH2CacheHeader {
+  char magic[8];
+  uint32_t version;
+  int32_t root_index;
+  float build_sah_cost;
+  uint32_t pad;
+  uint64_t num_top_level_prims;
+  uint64_t num_nodes;
+  uint64_t num_leaf_nodes;
+  uint64_t num_object_node;
+  uint64_t num_prim_type;
+  uint64_t num_prim_visibility;
+  uint64_t num_prim_index;
+  uint64_t num_prim_object;
+  uint64_t num_prim_time;
+};
+
+static const char bvh2_cache_magic[8] = {'C', 'Y', 'C', 'B', 'V', 'H', '2', '\0'};
+
+template<typename T> static void cache_hash_value(MD5Hash &md5, const T &value)
+{
+  md5.append((const uint8_t *)&value, sizeof(value));
+}
+
+template<typename T> static void cache_hash_array(MD5Hash &md5, const T *data, const size_t size)
+{
+  cache_hash_value(md5, size);
+
+  /* MD5Hash takes an int size, so hash large arrays in chunks. */
+  const uint8_t *bytes = (const uint8_t *)data;
+  size_t num_bytes = sizeof(T) * size;
+  while (num_bytes > 0) {
+    const int chunk_size = (int)min(num_bytes, (size_t)(1 << 30));
+    md5.append(bytes, chunk_size);
+    bytes += chunk_size;
+    num_bytes -= chunk_size;
+  }
+}
+
+static void cache_hash_float3_array(MD5Hash &md5, const float3 *data, const size_t size)
+{
+  cache_hash_value(md5, size);
+
+  /* Skip the padding of float3, which is not guaranteed to be initialized. */
+  float buffer[3 * 1024];
+  for (size_t offset = 0; offset < size; offset += 1024) {
+    const size_t num = min(size - offset, (size_t)1024);
+    for (size_t i = 0; i < num; i++) {
+      buffer[i * 3 + 0] = data[offset + i].x;
+      buffer[i * 3 + 1] = data[offset + i].y;
+      buffer[i * 3 + 2] = data[offset + i].z;
+    }
+    md5.append((const uint8_t *)buffer, (int)(sizeof(float) * 3 * num));
+  }
+}
+
+static void cache_hash_motion_attribute(MD5Hash &md5, const Geometry *geom)
+{
+  const Attribute *attr = geom->attributes.find(ATTR_STD_MOTION_VERTEX_POSITION);
+  if (geom->has_motion_blur() && attr) {
+    cache_hash_float3_array(
+        md5, (const float3 *)attr->data(), attr->buffer.size() / sizeof(float3));
+  }
+  else {
+    cache_hash_value(md5, (size_t)0);
+  }
+}
+
+string BVH2::cache_filepath() const
+{
+  /* Only BVHs of single geometry are cached. The scene BVH changes whenever any object does, so
+   * caching it would write a new file for every frame of an animation. */
+  if (params.cache_directory.empty() || params.top_level) {
+    return "";
+  }
+
+  /* The key covers everything the built tree depends on: build parameters, object visibility and
+   * the primitives of the geometry. Object transforms and primitive offsets in the scene are only
+   * used for the scene BVH, so they are left out to reuse the tree while objects move. */
+  MD5Hash md5;
+  cache_hash_value(md5, BVH2_CACHE_VERSION);
+
+  cache_hash_value(md5, params.use_spatial_split);
+  cache_hash_value(md5, params.spatial_split_alpha);
+  cache_hash_value(md5, params.unaligned_split_threshold);
+  cache_hash_value(md5, params.sah_node_cost);
+  cache_hash_value(md5, params.sah_primitive_cost);
+  cache_hash_value(md5, params.min_leaf_size);
+  cache_hash_value(md5, params.max_triangle_leaf_size);
+  cache_hash_value(md5, params.max_motion_triangle_leaf_size);
+  cache_hash_value(md5, params.max_curve_leaf_size);
+  cache_hash_value(md5, params.max_motion_curve_leaf_size);
+  cache_hash_value(md5, params.max_point_leaf_size);
+  cache_hash_value(md5, params.max_motion_point_leaf_size);
+  cache_hash_value(md5, params.top_level);
+  cache_hash_value(md5, params.bvh_layout);
+  cache_hash_value(md5, params.use_unaligned_nodes);
+  cache_hash_value(md5, params.num_motion_triangle_steps);
+  cache_hash_value(md5, params.num_motion_curve_steps);
+  cache_hash_value(md5, params.num_motion_point_steps);
+  cache_hash_value(md5, params.bvh_type);
+  cache_hash_value(md5, params.curve_subdivisions);
+
+  unordered_map<const Geometry *, int> geometry_index;
+  cache_hash_value(md5, geometry.size());
+  foreach (const Geometry *geom, geometry) {
+    const int index = (int)geometry_index.size();
+    geometry_index[geom] = index;
+
+    cache_hash_value(md5, geom->geometry_type);
+    cache_hash_value(md5, geom->is_instanced());
+    cache_hash_value(md5, geom->need_build_bvh(params.bvh_layout));
+    cache_hash_value(md5, geom->get_motion_steps());
+    cache_hash_value(md5, geom->primitive_type());
+    cache_hash_motion_attribute(md5, geom);
+
+    if (geom->is_mesh() || geom->is_volume()) {
+      const Mesh *mesh = static_cast<const Mesh *>(geom);
+      cache_hash_array(md5, mesh->get_triangles().data(), mesh->get_triangles().size());
+      cache_hash_float3_array(md5, mesh->get_verts().data(), mesh->get_verts().size());
+    }
+    else if (geom->is_hair()) {
+      const Hair *hair = static_cast<const Hair *>(geom);
+      cache_hash_value(md5, hair->curve_shape);
+      cache_hash_array(
+          md5, hair->get_curve_first_key().data(), hair->get_curve_first_key().size());
+      cache_hash_array(md5, hair->get_curve_radius().data(), hair->get_curve_radius().size());
+      cache_hash_float3_array(md5, hair->get_curve_keys().data(), hair->get_curve_keys().size());
+    }
+    else if (geom->is_pointcloud()) {
+      const PointCloud *pointcloud = static_cast<const PointCloud *>(geom);
+      cache_hash_array(md5, pointcloud->get_radius().data(), pointcloud->get_radius().size());
+      cache_hash_float3_array(
+          md5, pointcloud->get_points().data(), pointcloud->get_points().size());
+    }
+  }
+
+  cache_hash_value(md5, objects.size());
+  foreach (const Object *ob, objects) {
+    const Geometry *geom = ob->get_geometry();
+    const auto it = geometry_index.find(geom);
+    cache_hash_value(md5, (it != geometry_index.end()) ? it->second : -1);
+    cache_hash_value(md5, ob->visibility_for_tracing());
+  }
+
+  return path_join(params.cache_directory, md5.get_hex() + ".bvh2");
+}
+
+template<typename T> static bool cache_read_array(FILE *f, array<T> &data, const uint64_t size)
+{
+  data.resize(size);
+  return size == 0 || fread(data.data(), sizeof(T), size, f) == size;
+}
+
+template<typename T> static bool cache_write_array(FILE *f, const array<T> &data)
+{
+  return data.size() == 0 || fwrite(data.data(), sizeof(T), data.size(), f) == data.size();
+}
+
+bool BVH2::cache_read(const string &filepath)
+{
+  FILE *f = path_fopen(filepath, "rb");
+  if (!f) {
+    return false;
+  }
+
+  BVH2CacheHeader header;
+  bool ok = fread(&header, sizeof(header), 1, f) == 1 &&
+            memcmp(header.magic, bvh2_cache_magic, sizeof(header.magic)) == 0 &&
+            header.version == BVH2_CACHE_VERSION;
+
+  /* Files may be truncated when writing failed, verify the size before allocating. */
+  if (ok) {
+    const uint64_t expected_size = sizeof(header) + sizeof(int4) * header.num_nodes +
+                                   sizeof(int4) * header.num_leaf_nodes +
+                                   sizeof(int) * header.num_object_node +
+                                   sizeof(int) * header.num_prim_type +
+                                   sizeof(uint) * header.num_prim_visibility +
+                                   sizeof(int) * header.num_prim_index +
+                                   sizeof(int) * header.num_prim_object +
+                                   sizeof(float2) * header.num_prim_time;
+    ok = path_file_size(filepath) == expected_size &&
+         header.num_top_level_prims <= header.num_prim_index;
+  }
+
+  ok = ok && cache_read_array(f, pack.nodes, header.num_nodes) &&
+       cache_read_array(f, pack.leaf_nodes, header.num_leaf_nodes) &&
+       cache_read_array(f, pack.object_node, header.num_object_node) &&
+       cache_read_array(f, pack.prim_type, header.num_prim_type) &&
+       cache_read_array(f, pack.prim_visibility, header.num_prim_visibility) &&
+       cache_read_array(f, pack.prim_index, header.num_prim_index) &&
+       cache_read_array(f, pack.prim_object, header.num_prim_object) &&
+       cache_read_array(f, pack.prim_time, header.num_prim_time);
+
+  fclose(f);
+
+  if (ok) {
+    pack.root_index = header.root_index;
+    num_top_level_prims = header.num_top_level_prims;
+    ok = cache_validate();
+  }
+
+  if (!ok) {
+    VLOG_WARNING << "Failed to read BVH cache file " << filepath;
+    pack = PackedBVH();
+    return false;
+  }
+
+  build_sah_cost = header.build_sah_cost;
+  refit_sah_cost = header.build_sah_cost;
+  return true;
+}
+
+static size_t cache_geometry_num_primitives(const Geometry *geom)
+{
+  if (geom->is_mesh() || geom->is_volume()) {
+    return static_cast<const Mesh *>(geom)->num_triangles();
+  }
+  if (geom->is_hair()) {
+    return static_cast<const Hair *>(geom)->num_curves();
+  }
+  if (geom->is_pointcloud()) {
+    return static_cast<const PointCloud *>(geom)->num_points();
+  }
+  return 0;
+}
+
+bool BVH2::cache_validate() const
+{
+  /* Sizes match the file, but the contents may still be corrupted. Check every index that is
+   * used to access arrays during refit and traversal, so such a file is built again instead. */
+  const size_t num_prims = pack.prim_index.size();
+  const size_t num_nodes = pack.nodes.size();
+  const size_t num_leaf_nodes = pack.leaf_nodes.size();
+
+  if (pack.prim_type.size() != num_prims || pack.prim_visibility.size() != num_prims ||
+      pack.prim_object.size() != num_prims ||
+      (pack.prim_time.size() != 0 && pack.prim_time.size() != num_prims) ||
+      num_leaf_nodes % BVH_NODE_LEAF_SIZE != 0)
+  {
+    return false;
+  }
+
+  /* A single leaf as root, or inner nodes starting at the first node. */
+  if (!((pack.root_index == -1 && num_nodes == 0 && num_leaf_nodes == BVH_NODE_LEAF_SIZE) ||
+        (pack.root_index == 0 && num_nodes != 0)))
+  {
+    return false;
+  }
+
+  for (size_t i = 0; i < num_prims; i++) {
+    const int object = pack.prim_object[i];
+    if (object < 0 || (size_t)object >= objects.size() || pack.prim_index[i] < 0 ||
+        (size_t)pack.prim_index[i] >=
+            cache_geometry_num_primitives(objects[object]->get_geometry()))
+    {
+      return false;
+    }
+  }
+
+  for (size_t i = 0; i < num_leaf_nodes; i += BVH_NODE_LEAF_SIZE) {
+    const int c0 = pack.leaf_nodes[i].x;
+    const int c1 = pack.leaf_nodes[i].y;
+    if (c0 < 0 || c0 > c1 || (size_t)c1 > num_prims) {
+      return false;
+    }
+  }
+
+  /* Nodes have different sizes, so child indices must point to the start of a node. */
+  vector<bool> is_node_start(num_nodes, false);
+  for (size_t i = 0; i < num_nodes;) {
+    const size_t node_size = (pack.nodes[i].x & PATH_RAY_NODE_UNALIGNED) ?
+                                 BVH_UNALIGNED_NODE_SIZE :
+                                 BVH_NODE_SIZE;
+    if (i + node_size > num_nodes) {
+      return false;
+    }
+    is_node_start[i] = true;
+    i += node_size;
+  }
+
+  for (size_t i = 0; i < num_nodes; i++) {
+    if (!is_node_start[i]) {
+      continue;
+    }
+    for (const int c : {pack.nodes[i].z, pack.nodes[i].w}) {
+      if ((c < 0) ? ((size_t)(-c - 1) >= num_leaf_nodes) :
+                    ((size_t)c >= num_nodes || !is_node_start[c]))
+      {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+void BVH2::cache_write(const string &filepath) const
+{
+  BVH2CacheHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, bvh2_cache_magic, sizeof(header.magic));
+  header.version = BVH2_CACHE_VERSION;
+  header.root_index = pack.root_index;
+  header.build_sah_cost = build_sah_cost;
+  header.num_top_level_prims = num_top_level_prims;
+  header.num_nodes = pack.nodes.size();
+  header.num_leaf_nodes = pack.leaf_nodes.size();
+  header.num_object_node = pack.object_node.size();
+  header.num_prim_type = pack.prim_type.size();
+  header.num_prim_visibility = pack.prim_visibility.size();
+  header.num_prim_index = pack.prim_index.size();
+  header.num_prim_object = pack.prim_object.size();
+  header.num_prim_time = pack.prim_time.size();
+
+  /* Write to a temporary file first, so other processes sharing the cache directory never read a
+   * partially written file. */
+  const string tmp_filepath = string_printf("%s.%llu.%llu.tmp",
+                                            filepath.c_str(),
+                                            (unsigned long long)system_self_process_id(),
+                                            (unsigned long long)(time_dt() * 1e6));
+
+  path_create_directories(tmp_filepath);
+  FILE *f = path_fopen(tmp_filepath, "wb");
+  if (!f) {
+    VLOG_WARNING << "Failed to write BVH cache file " << filepath;
+    return;
+  }
+
+  const bool ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+                  cache_write_array(f, pack.nodes) && cache_write_array(f, pack.leaf_nodes) &&
+                  cache_write_array(f, pack.object_node) &&
+                  cache_write_array(f, pack.prim_type) &&
+                  cache_write_array(f, pack.prim_visibility) &&
+                  cache_write_array(f, pack.prim_index) &&
+                  cache_write_array(f, pack.prim_object) &&
+                  cache_write_array(f, pack.prim_time);
+
+  if (fclose(f) != 0 || !ok || rename(tmp_filepath.c_str(), filepath.c_str()) != 0) {
+    /* Another process may have written the same file in the meantime, which is fine. */
+    path_remove(tmp_filepath);
+    if (!path_exists(filepath)) {
+      VLOG_WARNING << "Failed to write BVH cache file " << filepath;
+    }
+    return;
+  }
+
+  VLOG_INFO << "Wrote BVH to cache " << filepath;
+}
+
 CCL_NAMESPACE_END
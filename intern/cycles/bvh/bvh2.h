@@ -38,6 +38,11 @@ class BVH2 : public BVH {
   void build(Progress &progress, Stats *stats);
   void refit(Progress &progress);
 
+  /* Refitting keeps the topology of the tree, which becomes less efficient to traverse the more
+   * primitives move relative to each other. Test if the tree should be rebuilt instead, also
+   * when geometry switched between being instanced and having its transform applied. */
+  bool refit_needs_rebuild(float max_sah_ratio) const;
+
   PackedBVH pack;
 
  protected:
@@ -47,9 +52,24 @@ class BVH2 : public BVH {
        const vector<Geometry *> &geometry,
        const vector<Object *> &objects);
 
+  /* Number of primitives in the top level BVH, excluding the primitives of merged instances. */
+  size_t num_top_level_prims;
+
+  /* SAH cost of the tree after the last build and refit, relative to the root bounds. */
+  float build_sah_cost;
+  float refit_sah_cost;
+  /* False when the last refit found primitives that must be handled differently now. */
+  bool refit_valid;
+
   /* Building process. */
   virtual BVHNode *widen_children_nodes(const BVHNode *root);
 
+  /* Cache of built trees on disk. */
+  string cache_filepath() const;
+  bool cache_read(const string &filepath);
+  bool cache_validate() const;
+  void cache_write(const string &filepath) const;
+
   /* pack */
   void pack_nodes(const BVHNode *root);
 
@@ -82,7 +102,7 @@ class BVH2 : public BVH {
 
   /* refit */
   void refit_nodes();
-  void refit_node(int idx, bool leaf, BoundBox &bbox, uint &visibility);
+  void refit_node(int idx, bool leaf, BoundBox &bbox, uint &visibility, float &sah_cost);
 
   /* Refit range of primitives. */
   void refit_primitives(int start, int end, BoundBox &bbox, uint &visibility);
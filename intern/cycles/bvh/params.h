@@ -9,6 +9,7 @@
 #define __BVH_PARAMS_H__
 
 #include "util/boundbox.h"
+#include "util/string.h"
 #include "util/vector.h"
 
 #include "kernel/types.h"
@@ -108,6 +109,10 @@ class BVHParams {
   /* These are needed for Embree. */
   int curve_subdivisions;
 
+  /* Directory to store built BVH2 trees of instanced geometry in, to reuse them when building the
+   * BVH for the same geometry again. Empty when disabled, always empty for the scene BVH. */
+  string cache_directory;
+
   /* fixed parameters */
   enum { MAX_DEPTH = 64, MAX_SPATIAL_DEPTH = 48, NUM_SPATIAL_BINS = 32 };
 
@@ -844,6 +844,11 @@ ccl_device float4 kernel_tex_image_interp(KernelGlobals kg, int id, float x, flo
       return TextureInterpolator<ushort4>::interp(info, x, y);
     case IMAGE_DATA_TYPE_FLOAT4:
       return TextureInterpolator<float4>::interp(info, x, y);
+    case IMAGE_DATA_TYPE_TEXTURE_CACHE: {
+      /* Tiles are loaded on demand by the texture cache owned by the image manager. */
+      const TextureCacheInfo &cache_info = *(const TextureCacheInfo *)info.data;
+      return cache_info.lookup(cache_info, info, x, y);
+    }
     default:
       assert(0);
       return make_float4(
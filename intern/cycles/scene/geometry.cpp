@@ -54,6 +54,7 @@ Geometry::Geometry(const NodeType *node_type, const Type type)
 {
   need_update_rebuild = false;
   need_update_bvh_for_offset = false;
+  need_update_light_tree = true;
 
   transform_applied = false;
   transform_negative_scaled = false;
@@ -933,6 +934,9 @@ void GeometryManager::device_update(Device *device,
    * change. */
   bool need_update_scene_bvh = (scene->bvh == nullptr ||
                                 (update_flags & (TRANSFORM_MODIFIED | VISIBILITY_MODIFIED)) != 0);
+  /* Refitting the scene BVH is possible as long as the set of primitives and instances stays
+   * the same. Visibility changes can add or remove objects from it. */
+  bool can_refit_scene_bvh = (update_flags & VISIBILITY_MODIFIED) == 0;
   {
     scoped_callback_timer timer([scene](double time) {
       if (scene->update_stats) {
@@ -945,6 +949,10 @@ void GeometryManager::device_update(Device *device,
     foreach (Geometry *geom, scene->geometry) {
       if (geom->is_modified() || geom->need_update_bvh_for_offset) {
         need_update_scene_bvh = true;
+        /* Merged instance BVHs and primitive offsets can not be updated by a refit. */
+        if (geom->need_build_bvh(bvh_layout) || geom->need_update_bvh_for_offset) {
+          can_refit_scene_bvh = false;
+        }
         pool.push(function_bind(
             &Geometry::compute_bvh, geom, device, dscene, &scene->params, &progress, i, num_bvh));
         if (geom->need_build_bvh(bvh_layout)) {
@@ -989,7 +997,7 @@ void GeometryManager::device_update(Device *device,
         scene->update_stats->geometry.times.add_entry({"device_update (build scene BVH)", time});
       }
     });
-    device_update_bvh(device, dscene, scene, progress);
+    device_update_bvh(device, dscene, scene, can_refit_scene_bvh, progress);
     if (progress.get_cancel()) {
       return;
     }
@@ -1016,6 +1024,10 @@ void GeometryManager::device_update(Device *device,
   /* unset flags */
 
   foreach (Geometry *geom, scene->geometry) {
+    /* The light tree is built after the flags are cleared, keep track of the change. */
+    if (geom->is_modified()) {
+      geom->need_update_light_tree = true;
+    }
     geom->clear_modified();
     geom->attributes.clear_modified();
 
@@ -111,6 +111,7 @@ class Geometry : public Node {
   /* Update Flags */
   bool need_update_rebuild;
   bool need_update_bvh_for_offset;
+  bool need_update_light_tree; /* Cleared by the light tree once emitters are built. */
 
   /* Index into scene->geometry (only valid during update) */
   size_t index;
@@ -271,7 +272,11 @@ class GeometryManager {
                                 Scene *scene,
                                 Progress &progress);
 
-  void device_update_bvh(Device *device, DeviceScene *dscene, Scene *scene, Progress &progress);
+  void device_update_bvh(Device *device,
+                         DeviceScene *dscene,
+                         Scene *scene,
+                         const bool can_refit_scene_bvh,
+                         Progress &progress);
 
   void device_update_displacement_images(Device *device, Scene *scene, Progress &progress);
 
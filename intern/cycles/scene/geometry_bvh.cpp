@@ -92,6 +92,7 @@ void Geometry::compute_bvh(Device *device,
       bparams.num_motion_point_steps = params->num_bvh_time_steps;
       bparams.bvh_type = params->bvh_type;
       bparams.curve_subdivisions = params->curve_subdivisions();
+      bparams.cache_directory = params->bvh_cache_directory;
 
       delete bvh;
       bvh = BVH::create(bparams, geometry, objects, device);
@@ -103,9 +104,18 @@ void Geometry::compute_bvh(Device *device,
   need_update_bvh_for_offset = false;
 }
 
+template<typename T> static void bvh_pack_copy_from_device(array<T> &to, device_vector<T> &from)
+{
+  to.resize(from.size());
+  if (from.size()) {
+    memcpy(to.data(), from.data(), sizeof(T) * from.size());
+  }
+}
+
 void GeometryManager::device_update_bvh(Device *device,
                                         DeviceScene *dscene,
                                         Scene *scene,
+                                        const bool can_refit_scene_bvh,
                                         Progress &progress)
 {
   /* bvh build */
@@ -130,12 +140,47 @@ void GeometryManager::device_update_bvh(Device *device,
                          (bparams.bvh_layout == BVHLayout::BVH_LAYOUT_OPTIX ||
                           bparams.bvh_layout == BVHLayout::BVH_LAYOUT_METAL);
 
+  /* When only primitive positions and object transforms changed, refit the BVH2 instead of
+   * building it again, unless that makes it too slow to traverse compared to a new build. */
+  bool is_bvh2_refit = false;
+  if (scene->bvh && can_refit_scene_bvh && bparams.bvh_layout == BVH_LAYOUT_BVH2 &&
+      dscene->bvh_leaf_nodes.size() != 0)
+  {
+    progress.set_status("Updating Scene BVH", "Refitting");
+
+    /* Packed data was moved to the device vectors after the previous build. */
+    BVH2 *bvh2 = static_cast<BVH2 *>(scene->bvh);
+    bvh_pack_copy_from_device(bvh2->pack.nodes, dscene->bvh_nodes);
+    bvh_pack_copy_from_device(bvh2->pack.leaf_nodes, dscene->bvh_leaf_nodes);
+    bvh_pack_copy_from_device(bvh2->pack.object_node, dscene->object_node);
+    bvh_pack_copy_from_device(bvh2->pack.prim_type, dscene->prim_type);
+    bvh_pack_copy_from_device(bvh2->pack.prim_visibility, dscene->prim_visibility);
+    bvh_pack_copy_from_device(bvh2->pack.prim_index, dscene->prim_index);
+    bvh_pack_copy_from_device(bvh2->pack.prim_object, dscene->prim_object);
+    bvh_pack_copy_from_device(bvh2->pack.prim_time, dscene->prim_time);
+    bvh2->pack.root_index = dscene->data.bvh.root;
+
+    device->build_bvh(bvh2, progress, true);
+
+    /* Dynamic BVHs favor fast updates, static ones fast rendering. */
+    const float max_sah_ratio = (bparams.bvh_type == BVH_TYPE_DYNAMIC) ? 2.0f : 1.2f;
+    if (bvh2->refit_needs_rebuild(max_sah_ratio)) {
+      VLOG_INFO << "Rebuilding scene BVH, it can not be refit efficiently.";
+      progress.set_status("Updating Scene BVH", "Building");
+    }
+    else {
+      is_bvh2_refit = true;
+    }
+  }
+
   BVH *bvh = scene->bvh;
   if (!scene->bvh) {
     bvh = scene->bvh = BVH::create(bparams, scene->geometry, scene->objects, device);
   }
 
-  device->build_bvh(bvh, progress, can_refit);
+  if (!is_bvh2_refit) {
+    device->build_bvh(bvh, progress, can_refit);
+  }
 
   if (progress.get_cancel()) {
     return;
@@ -20,6 +20,8 @@
 #include "util/texture.h"
 #include "util/unique_ptr.h"
 
+#include <OpenImageIO/texture.h>
+
 #ifdef WITH_OSL
 #  include <OSL/oslexec.h>
 #endif
@@ -69,6 +71,8 @@ const char *name_from_type(ImageDataType type)
       return "nanovdb_fpn";
     case IMAGE_DATA_TYPE_NANOVDB_FP16:
       return "nanovdb_fp16";
+    case IMAGE_DATA_TYPE_TEXTURE_CACHE:
+      return "texture_cache";
     case IMAGE_DATA_NUM_TYPES:
       assert(!"System enumerator type, should never be used");
       return "";
@@ -322,6 +326,7 @@ ImageManager::ImageManager(const DeviceInfo &info)
 {
   need_update_ = true;
   osl_texture_system = NULL;
+  texture_cache = NULL;
   animation_frame = 0;
 
   /* Set image limits */
@@ -333,6 +338,7 @@ ImageManager::~ImageManager()
   for (size_t slot = 0; slot < images.size(); slot++) {
     assert(!images[slot]);
   }
+  assert(!texture_cache);
 }
 
 void ImageManager::set_osl_texture_system(void *texture_system)
@@ -689,6 +695,181 @@ bool ImageManager::file_load_image(Image *img, int texture_limit)
   return true;
 }
 
+/* Weight of the pixels inside the image for a lookup at x, where pixels outside of the image are
+ * transparent black like for a full image load with clip extension. Cubic interpolation uses the
+ * bilinear weight as approximation. */
+static float texture_cache_clip_coverage(const float x,
+                                         const int size,
+                                         const InterpolationType interpolation)
+{
+  if (interpolation == INTERPOLATION_CLOSEST) {
+    return (x >= 0.0f && x < 1.0f) ? 1.0f : 0.0f;
+  }
+  const float px = x * size - 0.5f;
+  return clamp(min(px + 1.0f, float(size) - px), 0.0f, 1.0f);
+}
+
+static float4 texture_cache_lookup(const TextureCacheInfo &cache_info,
+                                   const TextureInfo &info,
+                                   const float x,
+                                   const float y)
+{
+  TextureSystem *ts = (TextureSystem *)cache_info.texture_system;
+  TextureOpt opt;
+
+  switch (info.interpolation) {
+    case INTERPOLATION_CLOSEST:
+      opt.interpmode = TextureOpt::InterpClosest;
+      break;
+    case INTERPOLATION_LINEAR:
+      opt.interpmode = TextureOpt::InterpBilinear;
+      break;
+    default:
+      opt.interpmode = TextureOpt::InterpBicubic;
+      break;
+  }
+
+  switch (info.extension) {
+    case EXTENSION_REPEAT:
+      opt.swrap = opt.twrap = TextureOpt::WrapPeriodic;
+      break;
+    case EXTENSION_CLIP:
+      opt.swrap = opt.twrap = TextureOpt::WrapBlack;
+      break;
+    case EXTENSION_MIRROR:
+      opt.swrap = opt.twrap = TextureOpt::WrapMirror;
+      break;
+    default:
+      opt.swrap = opt.twrap = TextureOpt::WrapClamp;
+      break;
+  }
+
+  /* Opaque alpha for images without alpha channel. The fill value is also used outside of the
+   * image, so alpha is clipped after the lookup. */
+  opt.fill = 1.0f;
+
+  /* SVM image texture nodes do not provide texture coordinate differentials, so MIP level
+   * selection is out of scope and the lookup always uses the full resolution image. Only the
+   * tiles that are actually sampled get loaded. */
+  float result[4];
+  const bool status = ts->texture((TextureSystem::TextureHandle *)cache_info.texture_handle,
+                                  ts->get_perthread_info(),
+                                  opt,
+                                  x,
+                                  1.0f - y,
+                                  0.0f,
+                                  0.0f,
+                                  0.0f,
+                                  0.0f,
+                                  4,
+                                  result);
+
+  if (!status) {
+    /* Clear error so it does not accumulate. */
+    ts->geterror();
+    return make_float4(
+        TEX_IMAGE_MISSING_R, TEX_IMAGE_MISSING_G, TEX_IMAGE_MISSING_B, TEX_IMAGE_MISSING_A);
+  }
+
+  if (info.extension == EXTENSION_CLIP && !cache_info.has_alpha) {
+    result[3] *= texture_cache_clip_coverage(x, cache_info.width, info.interpolation) *
+                 texture_cache_clip_coverage(y, cache_info.height, info.interpolation);
+  }
+
+  if (cache_info.processor) {
+    ColorSpaceManager::to_scene_linear((ColorSpaceProcessor *)cache_info.processor, result, 4);
+  }
+
+  return make_float4(result[0], result[1], result[2], result[3]);
+}
+
+void ImageManager::texture_cache_init(Device *device, Scene *scene)
+{
+  /* The texture cache is sampled from the kernel through a function pointer, which only works
+   * when rendering on the CPU. With OSL file images already use the OSL texture system. */
+  if (texture_cache || !scene->params.use_texture_cache || device->info.type != DEVICE_CPU ||
+      osl_texture_system)
+  {
+    return;
+  }
+
+  TextureSystem *ts = TextureSystem::create(false);
+  ts->attribute("autotile", 64);
+  ts->attribute("gray_to_rgb", 1);
+  ts->attribute("max_memory_MB", (float)max(scene->params.texture_cache_size, 1));
+  texture_cache = ts;
+}
+
+void ImageManager::texture_cache_free()
+{
+  if (texture_cache) {
+    TextureSystem *ts = (TextureSystem *)texture_cache;
+    ts->invalidate_all(true);
+    TextureSystem::destroy(ts);
+    texture_cache = NULL;
+  }
+}
+
+bool ImageManager::texture_cache_load_image(Device *device,
+                                            Image *img,
+                                            size_t slot,
+                                            int texture_limit)
+{
+  if (!texture_cache || img->builtin) {
+    return false;
+  }
+
+  /* Only 2D image files, for which alpha can be handled the same way as a full load. */
+  const ustring filepath = img->loader->osl_filepath();
+  if (filepath.empty() || img->metadata.depth > 1 || !image_associate_alpha(img)) {
+    return false;
+  }
+
+  /* Lookups always use the full resolution, images that have to be scaled down are loaded
+   * fully instead. */
+  if (texture_limit > 0 && max(img->metadata.width, img->metadata.height) > (size_t)texture_limit) {
+    return false;
+  }
+
+  TextureSystem *ts = (TextureSystem *)texture_cache;
+  TextureSystem::TextureHandle *handle = ts->get_texture_handle(filepath);
+  if (!handle || !ts->good(handle)) {
+    ts->geterror();
+    return false;
+  }
+
+  img->mem_name = string_printf(
+      "tex_image_%s_%03d", name_from_type(IMAGE_DATA_TYPE_TEXTURE_CACHE), (int)slot);
+  img->mem = new device_texture(device,
+                                img->mem_name.c_str(),
+                                slot,
+                                IMAGE_DATA_TYPE_TEXTURE_CACHE,
+                                img->params.interpolation,
+                                img->params.extension);
+
+  {
+    thread_scoped_lock device_lock(device_mutex);
+    TextureCacheInfo *cache_info = (TextureCacheInfo *)img->mem->alloc(
+        sizeof(TextureCacheInfo) / sizeof(uint64_t), 1);
+    cache_info->lookup = texture_cache_lookup;
+    cache_info->texture_system = ts;
+    cache_info->texture_handle = handle;
+    /* Colors are converted at lookup time, same as for textures in the OSL texture system.
+     * Images stored as sRGB are converted by the image texture node. */
+    cache_info->processor = (img->metadata.compress_as_srgb) ?
+                                NULL :
+                                ColorSpaceManager::get_processor(img->metadata.colorspace);
+    cache_info->width = (int)img->metadata.width;
+    cache_info->height = (int)img->metadata.height;
+    cache_info->has_alpha = (img->metadata.channels == 2 || img->metadata.channels == 4);
+    img->mem->copy_to_device();
+  }
+
+  img->loader->cleanup();
+  img->need_load = false;
+  return true;
+}
+
 void ImageManager::device_load_image(Device *device, Scene *scene, size_t slot, Progress *progress)
 {
   if (progress->get_cancel()) {
@@ -714,6 +895,11 @@ void ImageManager::device_load_image(Device *device, Scene *scene, size_t slot,
     img->mem = NULL;
   }
 
+  /* Sample tiles on demand through the texture cache, instead of loading all pixels. */
+  if (texture_cache_load_image(device, img, slot, texture_limit)) {
+    return;
+  }
+
   img->mem = new device_texture(
       device, img->mem_name.c_str(), slot, type, img->params.interpolation, img->params.extension);
   img->mem->info.use_transform_3d = img->metadata.use_transform_3d;
@@ -843,6 +1029,13 @@ void ImageManager::device_free_image(Device *, size_t slot)
 #endif
   }
 
+  if (texture_cache) {
+    ustring filepath = img->loader->osl_filepath();
+    if (!filepath.empty()) {
+      ((TextureSystem *)texture_cache)->invalidate(filepath);
+    }
+  }
+
   if (img->mem) {
     thread_scoped_lock device_lock(device_mutex);
     delete img->mem;
@@ -865,6 +1058,8 @@ void ImageManager::device_update(Device *device, Scene *scene, Progress &progres
     }
   });
 
+  texture_cache_init(device, scene);
+
   TaskPool pool;
   for (size_t slot = 0; slot < images.size(); slot++) {
     Image *img = images[slot];
@@ -934,6 +1129,8 @@ void ImageManager::device_free(Device *device)
     device_free_image(device, slot);
   }
   images.clear();
+
+  texture_cache_free();
 }
 
 void ImageManager::collect_statistics(RenderStats *stats)
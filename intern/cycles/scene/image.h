@@ -223,6 +223,8 @@ class ImageManager {
 
   vector<Image *> images;
   void *osl_texture_system;
+  /* OpenImageIO texture system used to load tiles of file images on demand, if enabled. */
+  void *texture_cache;
 
   size_t add_image_slot(ImageLoader *loader, const ImageParams &params, const bool builtin);
   void add_image_user(size_t slot);
@@ -236,6 +238,10 @@ class ImageManager {
   void device_load_image(Device *device, Scene *scene, size_t slot, Progress *progress);
   void device_free_image(Device *device, size_t slot);
 
+  void texture_cache_init(Device *device, Scene *scene);
+  void texture_cache_free();
+  bool texture_cache_load_image(Device *device, Image *img, size_t slot, int texture_limit);
+
   friend class ImageHandle;
 };
 
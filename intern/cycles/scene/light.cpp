@@ -218,6 +218,7 @@ LightManager::LightManager()
   need_update_background = true;
   last_background_enabled = false;
   last_background_resolution = 0;
+  light_tree_mesh_cache = make_unique<LightTreeMeshCache>();
 }
 
 LightManager::~LightManager()
@@ -799,16 +800,22 @@ void LightManager::device_update_tree(Device *,
   KernelIntegrator *kintegrator = &dscene->data.integrator;
 
   if (!kintegrator->use_light_tree) {
+    light_tree_mesh_cache->meshes.clear();
     return;
   }
 
   /* Update light tree. */
   progress.set_status("Updating Lights", "Computing tree");
 
+  /* The energy of cached triangle emitters depends on the emission of their shaders. */
+  if (update_flags & (SHADER_COMPILED | SHADER_MODIFIED)) {
+    light_tree_mesh_cache->meshes.clear();
+  }
+
   /* TODO: For now, we'll start with a smaller number of max lights in a node.
    * More benchmarking is needed to determine what number works best. */
   LightTree light_tree(scene, dscene, progress, 8);
-  LightTreeNode *root = light_tree.build(scene, dscene);
+  LightTreeNode *root = light_tree.build(scene, dscene, light_tree_mesh_cache.get());
   if (progress.get_cancel()) {
     return;
   }
@@ -886,6 +893,8 @@ void LightManager::device_update_tree(Device *,
               << light_link_nodes.size() - light_tree.num_nodes << " additional nodes.";
   }
 
+  light_tree.store_mesh_cache(scene, light_tree_mesh_cache.get());
+
   /* Copy arrays to device. */
   dscene->light_tree_nodes.copy_to_device();
   dscene->light_tree_emitters.copy_to_device();
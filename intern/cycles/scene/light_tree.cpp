@@ -254,12 +254,97 @@ bool LightTree::triangle_usable_as_light(Mesh *mesh, int prim_id)
 
 void LightTree::add_mesh(Scene *scene, Mesh *mesh, int object_id)
 {
+  vector<int> prim_ids;
   size_t mesh_num_triangles = mesh->num_triangles();
   for (size_t i = 0; i < mesh_num_triangles; i++) {
     if (triangle_usable_as_light(mesh, i)) {
-      emitters_.emplace_back(scene, i, object_id);
+      prim_ids.push_back(i);
     }
   }
+
+  /* Computing the measure of every triangle is expensive for meshes with many emissive
+   * triangles, create the emitters in parallel. */
+  const size_t offset = emitters_.size();
+  emitters_.resize(offset + prim_ids.size());
+  parallel_for(blocked_range<size_t>(0, prim_ids.size(), 1024),
+               [&](const blocked_range<size_t> &range) {
+                 for (size_t i = range.begin(); i != range.end(); i++) {
+                   emitters_[offset + i] = LightTreeEmitter(scene, prim_ids[i], object_id);
+                 }
+               });
+}
+
+static bool mesh_light_negative_scale(Object *object, Mesh *mesh)
+{
+  return mesh->transform_applied && transform_negative_scale(object->get_tfm());
+}
+
+/* Offset the emitter indices of the leaves in a subtree, and reset the state left behind by the
+ * conversion to the kernel representation. Returns the number of nodes in the subtree. */
+static int light_tree_subtree_rebase(LightTreeNode *node, const int offset)
+{
+  node->light_link.shared_node_index = -1;
+  if (node->is_leaf()) {
+    node->get_leaf().first_emitter_index += offset;
+    return 1;
+  }
+
+  int num_nodes = 1;
+  for (int i = 0; i < 2; i++) {
+    num_nodes += light_tree_subtree_rebase(node->get_inner().children[i].get(), offset);
+  }
+  return num_nodes;
+}
+
+bool LightTree::add_mesh_from_cache(Scene *scene,
+                                    LightTreeMeshCache *mesh_cache,
+                                    Mesh *mesh,
+                                    LightTreeEmitter &emitter,
+                                    MeshSubtree &subtree)
+{
+  if (mesh_cache == nullptr) {
+    return false;
+  }
+
+  auto cache_it = mesh_cache->meshes.find(mesh);
+  if (cache_it == mesh_cache->meshes.end()) {
+    return false;
+  }
+
+  /* Triangle emitters store the light set membership and orientation of the object they were
+   * created with. Outdated entries are removed, so that they are not used if this build gets
+   * cancelled after the mesh has been tagged as up to date. */
+  Object *object = scene->objects[emitter.object_id];
+  LightTreeMeshCache::Entry &entry = cache_it->second;
+  if (mesh->need_update_light_tree || !entry.root ||
+      entry.light_set_membership != object->get_light_set_membership() ||
+      entry.negative_scale != mesh_light_negative_scale(object, mesh))
+  {
+    mesh_cache->meshes.erase(cache_it);
+    return false;
+  }
+
+  const int offset = emitters_.size();
+  for (LightTreeEmitter &triangle : entry.emitters) {
+    triangle.object_id = emitter.object_id;
+    emitters_.push_back(std::move(triangle));
+  }
+  entry.emitters.clear();
+
+  num_nodes += light_tree_subtree_rebase(entry.root.get(), offset);
+  emitter.root = std::move(entry.root);
+  emitter.root->object_id = emitter.object_id;
+  emitter.root->measure = entry.measure;
+  emitter.root->type |= LIGHT_TREE_INSTANCE;
+
+  subtree.root = emitter.root.get();
+  subtree.start = offset;
+  subtree.end = emitters_.size();
+  subtree.from_cache = true;
+  subtree.measure = entry.measure;
+  subtree.light_set_membership = entry.light_set_membership;
+  subtree.negative_scale = entry.negative_scale;
+  return true;
 }
 
 LightTree::LightTree(Scene *scene,
@@ -320,7 +405,7 @@ LightTree::LightTree(Scene *scene,
   }
 }
 
-LightTreeNode *LightTree::build(Scene *scene, DeviceScene *dscene)
+LightTreeNode *LightTree::build(Scene *scene, DeviceScene *dscene, LightTreeMeshCache *mesh_cache)
 {
   if (local_lights_.empty() && distant_lights_.empty() && mesh_lights_.empty()) {
     return nullptr;
@@ -330,46 +415,59 @@ LightTreeNode *LightTree::build(Scene *scene, DeviceScene *dscene)
   int num_local_lights = local_lights_.size() + num_mesh_lights;
   const int num_distant_lights = distant_lights_.size();
 
-  /* Create a node for each mesh light, and keep track of unique mesh lights. */
-  std::unordered_map<Mesh *, std::tuple<LightTreeNode *, int, int>> unique_mesh;
+  /* Create a node for each mesh light, and keep track of unique mesh lights. Subtrees of meshes
+   * that did not change since the previous build are taken from the cache. */
   uint *object_offsets = dscene->object_lookup_offset.alloc(scene->objects.size());
   emitters_.reserve(num_triangles + num_local_lights + num_distant_lights);
   for (LightTreeEmitter &emitter : mesh_lights_) {
     Object *object = scene->objects[emitter.object_id];
     Mesh *mesh = static_cast<Mesh *>(object->get_geometry());
-    emitter.root = create_node(LightTreeMeasure::empty, 0);
 
-    auto map_it = unique_mesh.find(mesh);
-    if (map_it == unique_mesh.end()) {
-      const int start = emitters_.size();
-      add_mesh(scene, mesh, emitter.object_id);
-      const int end = emitters_.size();
-
-      unique_mesh[mesh] = std::make_tuple(emitter.root.get(), start, end);
-      emitter.root->object_id = emitter.object_id;
+    auto map_it = unique_meshes_.find(mesh);
+    if (map_it == unique_meshes_.end()) {
+      MeshSubtree &subtree = unique_meshes_[mesh];
+      if (!add_mesh_from_cache(scene, mesh_cache, mesh, emitter, subtree)) {
+        emitter.root = create_node(LightTreeMeasure::empty, 0);
+        emitter.root->object_id = emitter.object_id;
+
+        subtree.root = emitter.root.get();
+        subtree.start = emitters_.size();
+        add_mesh(scene, mesh, emitter.object_id);
+        subtree.end = emitters_.size();
+        subtree.light_set_membership = object->get_light_set_membership();
+        subtree.negative_scale = mesh_light_negative_scale(object, mesh);
+      }
+      mesh->need_update_light_tree = false;
     }
     else {
-      emitter.root->make_instance(std::get<0>(map_it->second), emitter.object_id);
+      emitter.root = create_node(LightTreeMeasure::empty, 0);
+      emitter.root->make_instance(map_it->second.root, emitter.object_id);
     }
     object_offsets[emitter.object_id] = offset_map_[mesh];
   }
 
   /* Build a subtree for each unique mesh light. */
-  parallel_for_each(unique_mesh, [this](auto &map_it) {
-    LightTreeNode *node = std::get<0>(map_it.second);
-    int start = std::get<1>(map_it.second);
-    int end = std::get<2>(map_it.second);
-    recursive_build(self, node, start, end, emitters_.data(), 0, 0);
-    node->type |= LIGHT_TREE_INSTANCE;
+  parallel_for_each(unique_meshes_, [this](auto &map_it) {
+    MeshSubtree &subtree = map_it.second;
+    if (subtree.from_cache) {
+      return;
+    }
+    recursive_build(self, subtree.root, subtree.start, subtree.end, emitters_.data(), 0, 0);
+    subtree.root->type |= LIGHT_TREE_INSTANCE;
   });
   task_pool.wait_work();
 
+  /* Remember the measure of the subtrees before the object transform is applied. */
+  for (auto &map_it : unique_meshes_) {
+    map_it.second.measure = map_it.second.root->measure;
+  }
+
   /* Update measure. */
   parallel_for_each(mesh_lights_, [&](LightTreeEmitter &emitter) {
     Object *object = scene->objects[emitter.object_id];
     Mesh *mesh = static_cast<Mesh *>(object->get_geometry());
 
-    LightTreeNode *reference = std::get<0>(unique_mesh.find(mesh)->second);
+    LightTreeNode *reference = unique_meshes_.find(mesh)->second.root;
     emitter.measure = emitter.root->measure = reference->measure;
 
     /* Transform measure. The measure is only directly transformable if the transformation has
@@ -437,6 +535,39 @@ LightTreeNode *LightTree::build(Scene *scene, DeviceScene *dscene)
   return root_.get();
 }
 
+void LightTree::store_mesh_cache(Scene *scene, LightTreeMeshCache *mesh_cache)
+{
+  mesh_cache->meshes.clear();
+
+  for (LightTreeEmitter &emitter : emitters_) {
+    /* Converting to the kernel representation may have moved the subtree from the first
+     * instance of a mesh to any of the other instances, look for the one that holds it. */
+    if (!emitter.is_mesh() ||
+        std::holds_alternative<LightTreeNode::Instance>(emitter.root->variant_type))
+    {
+      continue;
+    }
+
+    Mesh *mesh = static_cast<Mesh *>(scene->objects[emitter.object_id]->get_geometry());
+    auto map_it = unique_meshes_.find(mesh);
+    if (map_it == unique_meshes_.end()) {
+      continue;
+    }
+    const MeshSubtree &subtree = map_it->second;
+
+    LightTreeMeshCache::Entry &entry = mesh_cache->meshes[mesh];
+    entry.root = std::move(emitter.root);
+    light_tree_subtree_rebase(entry.root.get(), -subtree.start);
+    entry.emitters.reserve(subtree.end - subtree.start);
+    std::move(emitters_.begin() + subtree.start,
+              emitters_.begin() + subtree.end,
+              std::back_inserter(entry.emitters));
+    entry.measure = subtree.measure;
+    entry.light_set_membership = subtree.light_set_membership;
+    entry.negative_scale = subtree.negative_scale;
+  }
+}
+
 void LightTree::recursive_build(const Child child,
                                 LightTreeNode *inner,
                                 const int start,
@@ -520,8 +651,23 @@ bool LightTree::should_split(LightTreeEmitter *emitters,
   middle = (start + end) / 2;
 
   BoundBox centroid_bbox = BoundBox::empty;
-  for (int i = start; i < end; i++) {
-    centroid_bbox.grow((emitters + i)->centroid);
+  if (num_emitters > 2 * BINNING_EMITTERS_PER_TASK) {
+    const int num_blocks = divide_up(num_emitters, BINNING_EMITTERS_PER_TASK);
+    vector<BoundBox> block_bbox(num_blocks, BoundBox::empty);
+    parallel_for(0, num_blocks, [&](const int block) {
+      const int block_end = min(start + (block + 1) * BINNING_EMITTERS_PER_TASK, end);
+      for (int i = start + block * BINNING_EMITTERS_PER_TASK; i < block_end; i++) {
+        block_bbox[block].grow((emitters + i)->centroid);
+      }
+    });
+    for (const BoundBox &bbox : block_bbox) {
+      centroid_bbox.grow(bbox);
+    }
+  }
+  else {
+    for (int i = start; i < end; i++) {
+      centroid_bbox.grow((emitters + i)->centroid);
+    }
   }
 
   const float3 extent = centroid_bbox.size();
@@ -541,17 +687,7 @@ bool LightTree::should_split(LightTreeEmitter *emitters,
 
     /* Fill in buckets with emitters. */
     std::array<LightTreeBucket, LightTreeBucket::num_buckets> buckets;
-    for (int i = start; i < end; i++) {
-      const LightTreeEmitter *emitter = emitters + i;
-
-      /* Place emitter into the appropriate bucket, where the centroid box is split into equal
-       * partitions. */
-      int bucket_idx = LightTreeBucket::num_buckets *
-                       (emitter->centroid[dim] - centroid_bbox.min[dim]) * inv_extent;
-      bucket_idx = clamp(bucket_idx, 0, LightTreeBucket::num_buckets - 1);
-
-      buckets[bucket_idx].add(*emitter);
-    }
+    fill_buckets(emitters, start, end, dim, centroid_bbox, buckets);
 
     /* Precompute the left bucket measure cumulatively. */
     std::array<LightTreeBucket, LightTreeBucket::num_buckets - 1> left_buckets;
@@ -605,6 +741,53 @@ bool LightTree::should_split(LightTreeEmitter *emitters,
   return min_cost < total_cost || num_emitters > max_lights_in_leaf_;
 }
 
+void LightTree::fill_buckets(const LightTreeEmitter *emitters,
+                             const int start,
+                             const int end,
+                             const int dim,
+                             const BoundBox &centroid_bbox,
+                             std::array<LightTreeBucket, LightTreeBucket::num_buckets> &buckets)
+{
+  const float inv_extent = 1 / (centroid_bbox.size()[dim]);
+
+  auto fill = [&](const int fill_start,
+                  const int fill_end,
+                  std::array<LightTreeBucket, LightTreeBucket::num_buckets> &bins) {
+    for (int i = fill_start; i < fill_end; i++) {
+      const LightTreeEmitter *emitter = emitters + i;
+
+      /* Place emitter into the appropriate bucket, where the centroid box is split into equal
+       * partitions. */
+      int bucket_idx = LightTreeBucket::num_buckets *
+                       (emitter->centroid[dim] - centroid_bbox.min[dim]) * inv_extent;
+      bucket_idx = clamp(bucket_idx, 0, LightTreeBucket::num_buckets - 1);
+
+      bins[bucket_idx].add(*emitter);
+    }
+  };
+
+  const int num_emitters = end - start;
+  if (num_emitters <= 2 * BINNING_EMITTERS_PER_TASK) {
+    fill(start, end, buckets);
+    return;
+  }
+
+  /* Nodes near the root of large trees are binned in parallel. Blocks have a fixed size and are
+   * merged in order, so that the resulting tree does not depend on the scheduling. */
+  const int num_blocks = divide_up(num_emitters, BINNING_EMITTERS_PER_TASK);
+  vector<std::array<LightTreeBucket, LightTreeBucket::num_buckets>> block_buckets(num_blocks);
+  parallel_for(0, num_blocks, [&](const int block) {
+    const int block_start = start + block * BINNING_EMITTERS_PER_TASK;
+    fill(block_start, min(block_start + BINNING_EMITTERS_PER_TASK, end), block_buckets[block]);
+  });
+
+  for (int block = 0; block < num_blocks; block++) {
+    for (int i = 0; i < LightTreeBucket::num_buckets; i++) {
+      buckets[i] = buckets[i] + block_buckets[block][i];
+    }
+  }
+}
+
 __forceinline LightTreeMeasure operator+(const LightTreeMeasure &a, const LightTreeMeasure &b)
 {
   LightTreeMeasure c(a);
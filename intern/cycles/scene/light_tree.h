@@ -191,6 +191,7 @@ struct LightTreeEmitter {
 
   LightTreeMeasure measure;
 
+  LightTreeEmitter() = default;
   LightTreeEmitter(Object *object, int object_id); /* Mesh emitter. */
   LightTreeEmitter(Scene *scene, int prim_id, int object_id, bool with_transformation = false);
 
@@ -370,6 +371,25 @@ struct LightTreeNode {
   }
 };
 
+/* Light Tree Mesh Cache
+ *
+ * Subtrees of unique emissive meshes kept from the previous build, so that meshes which did not
+ * change reuse their emitters and subtree instead of building them again. */
+struct LightTreeMeshCache {
+  struct Entry {
+    unique_ptr<LightTreeNode> root;
+    /* Emissive triangles, in the order the leaves of the subtree refer to them. */
+    vector<LightTreeEmitter> emitters;
+    /* Measure of the subtree before the object transform is applied. */
+    LightTreeMeasure measure;
+    /* Object state the triangle emitters were computed with. */
+    uint64_t light_set_membership = 0;
+    bool negative_scale = false;
+  };
+
+  std::unordered_map<Mesh *, Entry> meshes;
+};
+
 /* Light BVH
  *
  * BVH-like data structure that keeps track of lights
@@ -386,6 +406,19 @@ class LightTree {
 
   std::unordered_map<Mesh *, int> offset_map_;
 
+  /* Unique emissive mesh, with the range of its triangle emitters in `emitters_`. */
+  struct MeshSubtree {
+    LightTreeNode *root = nullptr;
+    int start = 0;
+    int end = 0;
+    bool from_cache = false;
+    /* State stored in the cache along with the subtree. */
+    LightTreeMeasure measure;
+    uint64_t light_set_membership = 0;
+    bool negative_scale = false;
+  };
+  std::unordered_map<Mesh *, MeshSubtree> unique_meshes_;
+
   Progress &progress_;
 
   uint max_lights_in_leaf_;
@@ -406,8 +439,12 @@ class LightTree {
 
   LightTree(Scene *scene, DeviceScene *dscene, Progress &progress, uint max_lights_in_leaf);
 
-  /* Returns a pointer to the root node. */
-  LightTreeNode *build(Scene *scene, DeviceScene *dscene);
+  /* Returns a pointer to the root node. Subtrees of unchanged meshes are taken from the cache. */
+  LightTreeNode *build(Scene *scene, DeviceScene *dscene, LightTreeMeshCache *mesh_cache = NULL);
+
+  /* Move the mesh subtrees into the cache for the next build. Must be called after the tree has
+   * been converted to the kernel representation, as the tree is not usable afterwards. */
+  void store_mesh_cache(Scene *scene, LightTreeMeshCache *mesh_cache);
 
   /* NOTE: Always use this function to create a new node so the number of nodes is in sync. */
   unique_ptr<LightTreeNode> create_node(const LightTreeMeasure &measure, const uint &bit_trial)
@@ -431,6 +468,8 @@ class LightTree {
   TaskPool task_pool;
   /* Do not spawn a thread if less than this amount of emitters are to be processed. */
   enum { MIN_EMITTERS_PER_THREAD = 4096 };
+  /* Number of emitters binned by one task, when splitting nodes with many emitters. */
+  enum { BINNING_EMITTERS_PER_TASK = 65536 };
 
   void recursive_build(Child child,
                        LightTreeNode *inner,
@@ -448,11 +487,26 @@ class LightTree {
                     LightTreeLightLink &light_link,
                     int &split_dim);
 
+  /* Fill in buckets with the emitters between start and end along a dimension. */
+  void fill_buckets(const LightTreeEmitter *emitters,
+                    const int start,
+                    const int end,
+                    const int dim,
+                    const BoundBox &centroid_bbox,
+                    std::array<LightTreeBucket, LightTreeBucket::num_buckets> &buckets);
+
   /* Check whether the light tree can use this triangle as light-emissive. */
   bool triangle_usable_as_light(Mesh *mesh, int prim_id);
 
   /* Add all the emissive triangles of a mesh to the light tree. */
   void add_mesh(Scene *scene, Mesh *mesh, int object_id);
+
+  /* Add the emitters and subtree of a mesh from the cache, if the mesh did not change. */
+  bool add_mesh_from_cache(Scene *scene,
+                           LightTreeMeshCache *mesh_cache,
+                           Mesh *mesh,
+                           LightTreeEmitter &emitter,
+                           MeshSubtree &subtree);
 };
 
 CCL_NAMESPACE_END
@@ -193,6 +193,7 @@ void Object::apply_transform(bool apply_to_motion)
   }
 
   geometry->apply_transform(tfm, apply_to_motion);
+  geometry->need_update_light_tree = true;
 
   /* we keep normals pointing in same direction on negative scale, notify
    * geometry about this in it (re)calculates normals */
@@ -442,6 +443,7 @@ ObjectManager::ObjectManager()
 {
   update_flags = UPDATE_ALL;
   need_flags_update = true;
+  packed_need_motion = Scene::MOTION_NONE;
 }
 
 ObjectManager::~ObjectManager() {}
@@ -470,6 +472,32 @@ void ObjectManager::device_update_object_transform(UpdateObjectTransformState *s
   Geometry *geom = ob->geometry;
   uint flag = 0;
 
+  /* Flags which will be synchronized to Integrator, gathered from all objects. */
+  if (geom->get_use_motion_blur() ||
+      (state->need_motion == Scene::MOTION_BLUR && ob->use_motion()))
+  {
+    state->have_motion = true;
+  }
+  if (geom->geometry_type == Geometry::HAIR) {
+    state->have_curves = true;
+  }
+  if (geom->geometry_type == Geometry::POINTCLOUD) {
+    state->have_points = true;
+  }
+  if (geom->geometry_type == Geometry::VOLUME) {
+    state->have_volumes = true;
+  }
+
+  /* Objects which did not change since the previous update keep their packed data, unless the
+   * motion of other objects moved their decomposed transforms in the global motion array. */
+  const bool motion_offset_changed = state->need_motion == Scene::MOTION_BLUR &&
+                                     ob->use_motion() &&
+                                     kobject.motion_offset != state->motion_offset[ob->index];
+  if (!update_all && !motion_offset_changed && !ob->is_modified() && !geom->is_modified()) {
+    return;
+  }
+  update_all = update_all || motion_offset_changed;
+
   /* Compute transformations. */
   Transform tfm = ob->tfm;
   Transform itfm = transform_inverse(tfm);
@@ -502,10 +530,6 @@ void ObjectManager::device_update_object_transform(UpdateObjectTransformState *s
                                    ob->blocker_shadow_set;
   kobject.shadow_set_membership = ob->shadow_set_membership;
 
-  if (geom->get_use_motion_blur()) {
-    state->have_motion = true;
-  }
-
   if (transform_negative_scale(tfm)) {
     flag |= SD_OBJECT_NEGATIVE_SCALE;
   }
@@ -564,7 +588,6 @@ void ObjectManager::device_update_object_transform(UpdateObjectTransformState *s
       }
 
       flag |= SD_OBJECT_MOTION;
-      state->have_motion = true;
     }
   }
 
@@ -616,17 +639,6 @@ void ObjectManager::device_update_object_transform(UpdateObjectTransformState *s
   state->object_flag[ob->index] = flag;
   state->object_volume_step[ob->index] = FLT_MAX;
 
-  /* Have curves. */
-  if (geom->geometry_type == Geometry::HAIR) {
-    state->have_curves = true;
-  }
-  if (geom->geometry_type == Geometry::POINTCLOUD) {
-    state->have_points = true;
-  }
-  if (geom->geometry_type == Geometry::VOLUME) {
-    state->have_volumes = true;
-  }
-
   /* Light group. */
   auto it = scene->lightgroups.find(ob->lightgroup);
   if (it != scene->lightgroups.end()) {
@@ -681,6 +693,16 @@ void ObjectManager::device_update_transforms(DeviceScene *dscene, Scene *scene,
   state.scene = scene;
   state.queue_start_object = 0;
 
+  /* Only objects which changed are packed again, unless the arrays get reallocated or a setting
+   * which affects all objects changed. The flag and volume step arrays are the same size as
+   * dscene.objects, so checking only that one is sufficient for them. */
+  bool update_all = dscene->objects.need_realloc() ||
+                    dscene->objects.size() != scene->objects.size() ||
+                    state.need_motion != packed_need_motion ||
+                    (update_flags & (PARTICLE_MODIFIED | MOTION_BLUR_MODIFIED |
+                                     LIGHTGROUPS_MODIFIED)) != 0;
+  packed_need_motion = state.need_motion;
+
   state.objects = dscene->objects.alloc(scene->objects.size());
   state.object_flag = dscene->object_flag.alloc(scene->objects.size());
   state.object_volume_step = dscene->object_volume_step.alloc(scene->objects.size());
@@ -688,6 +710,8 @@ void ObjectManager::device_update_transforms(DeviceScene *dscene, Scene *scene,
   state.object_motion_pass = NULL;
 
   if (state.need_motion == Scene::MOTION_PASS) {
+    update_all = update_all || dscene->object_motion_pass.size() !=
+                                   OBJECT_MOTION_PASS_SIZE * scene->objects.size();
     state.object_motion_pass = dscene->object_motion_pass.alloc(OBJECT_MOTION_PASS_SIZE *
                                                                 scene->objects.size());
   }
@@ -705,6 +729,7 @@ void ObjectManager::device_update_transforms(DeviceScene *dscene, Scene *scene,
       motion_offset += ob->motion.size();
     }
 
+    update_all = update_all || dscene->object_motion.size() != motion_offset;
     state.object_motion = dscene->object_motion.alloc(motion_offset);
   }
 
@@ -717,9 +742,6 @@ void ObjectManager::device_update_transforms(DeviceScene *dscene, Scene *scene,
     numparticles += psys->particles.size();
   }
 
-  /* as all the arrays are the same size, checking only dscene.objects is sufficient */
-  const bool update_all = dscene->objects.need_realloc();
-
   /* Parallel object update, with grain size to avoid too much threading overhead
    * for individual objects. */
   static const int OBJECTS_PER_TASK = 32;
@@ -774,7 +796,7 @@ void ObjectManager::device_update(Device *device,
     dscene->object_flag.tag_modified();
   }
 
-  if (update_flags & PARTICLE_MODIFIED) {
+  if (update_flags & (PARTICLE_MODIFIED | LIGHTGROUPS_MODIFIED)) {
     dscene->objects.tag_modified();
   }
 
@@ -900,6 +922,9 @@ void ObjectManager::device_update_flags(
   }
 
   foreach (Object *object, scene->objects) {
+    /* Objects keep their flags from the previous update when they are not packed again. */
+    object_flag[object->index] &= ~SD_OBJECT_INTERSECTS_VOLUME;
+
     if (object->geometry->has_volume) {
       object_flag[object->index] |= SD_OBJECT_HAS_VOLUME;
       object_flag[object->index] &= ~SD_OBJECT_HAS_VOLUME_ATTRIBUTES;
@@ -1042,6 +1067,8 @@ void ObjectManager::apply_static_transforms(DeviceScene *dscene, Scene *scene, P
      * Could be solved by moving reference counter to Geometry.
      */
     Geometry *geom = object->geometry;
+    object_flag[i] &= ~SD_OBJECT_TRANSFORM_APPLIED;
+
     bool apply = (geometry_users[geom] == 1) && !geom->has_surface_bssrdf &&
                  !geom->has_true_displacement();
 
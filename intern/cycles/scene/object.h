@@ -137,6 +137,9 @@ class Object : public Node {
 class ObjectManager {
   uint32_t update_flags;
 
+  /* Motion type the object data on the device was last packed for. */
+  Scene::MotionType packed_need_motion;
+
  public:
   enum : uint32_t {
     PARTICLE_MODIFIED = (1 << 0),
@@ -148,6 +151,7 @@ class ObjectManager {
     HOLDOUT_MODIFIED = (1 << 6),
     TRANSFORM_MODIFIED = (1 << 7),
     VISIBILITY_MODIFIED = (1 << 8),
+    LIGHTGROUPS_MODIFIED = (1 << 9),
 
     /* tag everything in the manager for an update */
     UPDATE_ALL = ~0u,
@@ -207,7 +207,7 @@ void Scene::device_update(Device *device_, Progress &progress)
 
   if (film->update_lightgroups(this)) {
     light_manager->tag_update(this, ccl::LightManager::LIGHT_MODIFIED);
-    object_manager->tag_update(this, ccl::ObjectManager::OBJECT_MODIFIED);
+    object_manager->tag_update(this, ccl::ObjectManager::LIGHTGROUPS_MODIFIED);
     background->tag_modified();
   }
   if (film->exposure_is_modified()) {
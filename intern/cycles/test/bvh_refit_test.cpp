@@ -0,0 +1,165 @@
+/* SPDX-FileCopyrightText: 2011-2024 Blender Foundation
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include "device/device.h"
+
+#include "kernel/types.h"
+
+#include "scene/mesh.h"
+#include "scene/object.h"
+#include "scene/scene.h"
+#include "scene/shader.h"
+
+#include "util/boundbox.h"
+#include "util/progress.h"
+#include "util/stats.h"
+#include "util/transform.h"
+#include "util/vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+namespace {
+
+constexpr int num_objects = 3;
+
+Transform object_transform(const int index, const float offset)
+{
+  return transform_translate(index * 3.0f + offset, offset * 0.5f, 0.0f);
+}
+
+/* Scene with instances of a single mesh, so that the scene BVH has an object leaf for each. */
+class InstancedScene {
+ public:
+  Stats stats;
+  Profiler profiler;
+  DeviceInfo device_info;
+  Device *device_cpu;
+  SceneParams scene_params;
+  Scene *scene;
+  vector<Object *> objects;
+
+  explicit InstancedScene(const float offset)
+  {
+    scene_params.bvh_layout = BVH_LAYOUT_BVH2;
+    scene_params.bvh_type = BVH_TYPE_DYNAMIC;
+    device_cpu = Device::create(device_info, stats, profiler, true);
+    scene = new Scene(scene_params, device_cpu);
+
+    Mesh *mesh = scene->create_node<Mesh>();
+    array<Node *> used_shaders;
+    used_shaders.push_back_slow(scene->default_surface);
+    mesh->set_used_shaders(used_shaders);
+    mesh->reserve_mesh(4, 4);
+    mesh->add_vertex(make_float3(0.0f, 0.0f, 0.0f));
+    mesh->add_vertex(make_float3(1.0f, 0.0f, 0.0f));
+    mesh->add_vertex(make_float3(0.0f, 1.0f, 0.0f));
+    mesh->add_vertex(make_float3(0.0f, 0.0f, 1.0f));
+    mesh->add_triangle(0, 1, 2, 0, false);
+    mesh->add_triangle(0, 1, 3, 0, false);
+    mesh->add_triangle(0, 2, 3, 0, false);
+    mesh->add_triangle(1, 2, 3, 0, false);
+
+    for (int i = 0; i < num_objects; i++) {
+      Object *object = scene->create_node<Object>();
+      object->set_geometry(mesh);
+      object->set_tfm(object_transform(i, (i == 0) ? offset : 0.0f));
+      object->tag_update(scene);
+      objects.push_back(object);
+    }
+  }
+
+  ~InstancedScene()
+  {
+    delete scene;
+    delete device_cpu;
+  }
+
+  void update()
+  {
+    Progress progress;
+    scene->update(progress);
+  }
+
+  /* Bounds of each object as stored in the parent node of its leaf. */
+  vector<BoundBox> object_bounds()
+  {
+    DeviceScene &dscene = scene->dscene;
+    vector<BoundBox> bounds(num_objects, BoundBox::empty);
+    EXPECT_EQ(dscene.data.bvh.root, 0);
+    if (dscene.data.bvh.root != 0) {
+      return bounds;
+    }
+
+    vector<int> stack = {0};
+    while (!stack.empty()) {
+      const int idx = stack.back();
+      stack.pop_back();
+
+      const int4 *node = &dscene.bvh_nodes[idx];
+      EXPECT_FALSE(node[0].x & PATH_RAY_NODE_UNALIGNED);
+      const int children[2] = {node[0].z, node[0].w};
+      for (int i = 0; i < 2; i++) {
+        if (children[i] >= 0) {
+          stack.push_back(children[i]);
+          continue;
+        }
+        const int leaf = -children[i] - 1;
+        const int prim = ~dscene.bvh_leaf_nodes[leaf].x;
+        EXPECT_GE(prim, 0) << "Expected an object instance leaf";
+        if (prim < 0) {
+          continue;
+        }
+        const int object = dscene.prim_object[prim];
+        bounds[object].grow(make_float3(__int_as_float(node[1][i]),
+                                        __int_as_float(node[2][i]),
+                                        __int_as_float(node[3][i])));
+        bounds[object].grow(make_float3(__int_as_float(node[1][i + 2]),
+                                        __int_as_float(node[2][i + 2]),
+                                        __int_as_float(node[3][i + 2])));
+      }
+    }
+    return bounds;
+  }
+};
+
+void expect_bounds_eq(const BoundBox &a, const BoundBox &b, const int object)
+{
+  EXPECT_FLOAT_EQ(a.min.x, b.min.x) << "object " << object;
+  EXPECT_FLOAT_EQ(a.min.y, b.min.y) << "object " << object;
+  EXPECT_FLOAT_EQ(a.min.z, b.min.z) << "object " << object;
+  EXPECT_FLOAT_EQ(a.max.x, b.max.x) << "object " << object;
+  EXPECT_FLOAT_EQ(a.max.y, b.max.y) << "object " << object;
+  EXPECT_FLOAT_EQ(a.max.z, b.max.z) << "object " << object;
+}
+
+}  // namespace
+
+TEST(BVH2, refit_moved_instance_matches_rebuild)
+{
+  const float offset = 0.25f;
+
+  /* Build with the first object at its original position, then move it so the BVH is refit. */
+  InstancedScene refit(0.0f);
+  refit.update();
+  const vector<BoundBox> bounds_before = refit.object_bounds();
+
+  refit.objects[0]->set_tfm(object_transform(0, offset));
+  refit.objects[0]->tag_update(refit.scene);
+  refit.update();
+  const vector<BoundBox> bounds_refit = refit.object_bounds();
+
+  /* Build with the first object at the moved position right away. */
+  InstancedScene rebuild(offset);
+  rebuild.update();
+  const vector<BoundBox> bounds_rebuild = rebuild.object_bounds();
+
+  EXPECT_NE(bounds_before[0].min.x, bounds_refit[0].min.x) << "Moved object was not updated";
+  for (int i = 0; i < num_objects; i++) {
+    expect_bounds_eq(bounds_refit[i], bounds_rebuild[i], i);
+  }
+}
+
+CCL_NAMESPACE_END
@@ -0,0 +1,214 @@
+/* SPDX-FileCopyrightText: 2011-2024 Blender Foundation
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include <OpenImageIO/filesystem.h>
+
+#include "device/device.h"
+
+#include "scene/colorspace.h"
+#include "scene/image.h"
+#include "scene/scene.h"
+
+#include "util/image.h"
+#include "util/path.h"
+#include "util/progress.h"
+#include "util/stats.h"
+#include "util/texture.h"
+#include "util/vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+namespace {
+
+constexpr int width = 7;
+constexpr int height = 5;
+
+/* Pixels with distinct values, so that flipped or shifted lookups are detected. Alpha is opaque
+ * unless it varies, then both loads associate alpha. */
+template<typename T>
+vector<T> make_pixels(const int channels,
+                      const float scale,
+                      const T alpha,
+                      const bool vary_alpha = false)
+{
+  vector<T> pixels(width * height * channels);
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      T *pixel = &pixels[(y * width + x) * channels];
+      pixel[0] = T((x * 31 + y * 7) % 256 * scale);
+      pixel[1] = T((x * 3 + y * 53) % 256 * scale);
+      pixel[2] = T((x * y * 11 + 5) % 256 * scale);
+      if (channels == 4) {
+        pixel[3] = (vary_alpha) ? T((x * 37 + y * 101 + 17) % 256 * scale) : alpha;
+      }
+    }
+  }
+  return pixels;
+}
+
+class TextureCacheScene {
+ public:
+  Stats stats;
+  Profiler profiler;
+  DeviceInfo device_info;
+  Device *device_cpu;
+  SceneParams scene_params;
+  Scene *scene;
+
+  explicit TextureCacheScene(const bool use_texture_cache)
+  {
+    scene_params.use_texture_cache = use_texture_cache;
+    device_cpu = Device::create(device_info, stats, profiler, true);
+    scene = new Scene(scene_params, device_cpu);
+  }
+
+  ~TextureCacheScene()
+  {
+    delete scene;
+    delete device_cpu;
+  }
+
+  device_texture *load(const string &filepath,
+                       const ustring colorspace,
+                       const ExtensionType extension,
+                       ImageHandle &handle)
+  {
+    ImageParams params;
+    params.interpolation = INTERPOLATION_CLOSEST;
+    params.extension = extension;
+    params.colorspace = colorspace;
+    handle = scene->image_manager->add_image(filepath, params);
+
+    Progress progress;
+    scene->image_manager->device_update(device_cpu, scene, progress);
+    return handle.image_memory();
+  }
+};
+
+}  // namespace
+
+class TextureCache : public testing::Test {
+ protected:
+  string filepath;
+
+  void SetUp() override
+  {
+    ColorSpaceManager::init_fallback_config();
+  }
+
+  void TearDown() override
+  {
+    if (!filepath.empty()) {
+      path_remove(filepath);
+    }
+  }
+
+  template<typename T>
+  void write_image(const char *extension,
+                   const TypeDesc format,
+                   const int channels,
+                   const vector<T> &pixels)
+  {
+    filepath = path_join(OIIO::Filesystem::temp_directory_path(),
+                         "cycles-texture-cache-" + OIIO::Filesystem::unique_path() + extension);
+
+    unique_ptr<ImageOutput> out = ImageOutput::create(filepath);
+    ASSERT_TRUE(out);
+    const ImageSpec spec(width, height, channels, format);
+    ASSERT_TRUE(out->open(filepath, spec));
+    ASSERT_TRUE(out->write_image(format, pixels.data()));
+    out->close();
+  }
+
+  /* Sample every pixel center through the texture cache, and compare against the pixels of a full
+   * image load. */
+  template<typename T>
+  void compare_with_full_load(const ustring colorspace,
+                              const float scale,
+                              const float eps,
+                              const ExtensionType extension = EXTENSION_CLIP)
+  {
+    TextureCacheScene full(false);
+    TextureCacheScene cached(true);
+
+    ImageHandle full_handle;
+    ImageHandle cached_handle;
+    const device_texture *full_mem = full.load(filepath, colorspace, extension, full_handle);
+    const device_texture *cached_mem = cached.load(filepath, colorspace, extension, cached_handle);
+    ASSERT_NE(full_mem, nullptr);
+    ASSERT_NE(cached_mem, nullptr);
+
+    ASSERT_NE(full_mem->info.data_type, IMAGE_DATA_TYPE_TEXTURE_CACHE);
+    ASSERT_EQ(cached_mem->info.data_type, IMAGE_DATA_TYPE_TEXTURE_CACHE);
+    ASSERT_EQ(full_mem->data_width, size_t(width));
+    ASSERT_EQ(full_mem->data_height, size_t(height));
+
+    const T *full_pixels = (const T *)full_mem->host_pointer;
+    const TextureCacheInfo &cache_info = *(const TextureCacheInfo *)cached_mem->host_pointer;
+
+    for (int y = 0; y < height; y++) {
+      for (int x = 0; x < width; x++) {
+        const float4 result = cache_info.lookup(
+            cache_info, cached_mem->info, (x + 0.5f) / width, (y + 0.5f) / height);
+        const T *expected = &full_pixels[(y * width + x) * 4];
+        EXPECT_NEAR(result.x, expected[0] * scale, eps) << "x=" << x << " y=" << y;
+        EXPECT_NEAR(result.y, expected[1] * scale, eps) << "x=" << x << " y=" << y;
+        EXPECT_NEAR(result.z, expected[2] * scale, eps) << "x=" << x << " y=" << y;
+        EXPECT_NEAR(result.w, expected[3] * scale, eps) << "x=" << x << " y=" << y;
+      }
+    }
+  }
+};
+
+TEST_F(TextureCache, byte_srgb_matches_full_load)
+{
+  write_image(".png", TypeDesc::UINT8, 4, make_pixels<uchar>(4, 1.0f, 255));
+  /* Both keep the sRGB encoded values, the image texture node converts them to linear. */
+  compare_with_full_load<uchar>(u_colorspace_srgb, 1.0f / 255.0f, 1e-5f);
+}
+
+TEST_F(TextureCache, float_matches_full_load)
+{
+  write_image(".exr", TypeDesc::FLOAT, 4, make_pixels<float>(4, 1.0f / 64.0f, 1.0f));
+  compare_with_full_load<float>(u_colorspace_raw, 1.0f, 1e-6f);
+}
+
+TEST_F(TextureCache, byte_alpha_matches_full_load)
+{
+  /* Unassociated alpha in the file, both loads associate it. Rounding of the associated 8-bit
+   * values may differ by one step. */
+  write_image(".png", TypeDesc::UINT8, 4, make_pixels<uchar>(4, 1.0f, 255, true));
+  compare_with_full_load<uchar>(u_colorspace_srgb, 1.0f / 255.0f, 1.01f / 255.0f);
+}
+
+TEST_F(TextureCache, rgb_clip_matches_full_load)
+{
+  /* Without alpha channel alpha is opaque inside the image, and transparent outside of it. */
+  write_image(".exr", TypeDesc::FLOAT, 3, make_pixels<float>(3, 1.0f / 64.0f, 1.0f));
+  compare_with_full_load<float>(u_colorspace_raw, 1.0f, 1e-6f, EXTENSION_CLIP);
+
+  TextureCacheScene cached(true);
+  ImageHandle handle;
+  const device_texture *mem = cached.load(filepath, u_colorspace_raw, EXTENSION_CLIP, handle);
+  ASSERT_NE(mem, nullptr);
+  ASSERT_EQ(mem->info.data_type, IMAGE_DATA_TYPE_TEXTURE_CACHE);
+  const TextureCacheInfo &cache_info = *(const TextureCacheInfo *)mem->host_pointer;
+
+  /* A full load returns transparent black outside of the image with clip extension. */
+  const float2 outside[] = {make_float2(-0.5f, 0.5f),
+                            make_float2(1.5f, 0.5f),
+                            make_float2(0.5f, -0.5f),
+                            make_float2(0.5f, 1.5f)};
+  for (const float2 uv : outside) {
+    const float4 result = cache_info.lookup(cache_info, mem->info, uv.x, uv.y);
+    EXPECT_NEAR(result.x, 0.0f, 1e-6f) << "u=" << uv.x << " v=" << uv.y;
+    EXPECT_NEAR(result.y, 0.0f, 1e-6f) << "u=" << uv.x << " v=" << uv.y;
+    EXPECT_NEAR(result.z, 0.0f, 1e-6f) << "u=" << uv.x << " v=" << uv.y;
+    EXPECT_NEAR(result.w, 0.0f, 1e-6f) << "u=" << uv.x << " v=" << uv.y;
+  }
+}
+
+CCL_NAMESPACE_END
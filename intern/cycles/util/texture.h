@@ -40,6 +40,8 @@ typedef enum ImageDataType {
   IMAGE_DATA_TYPE_NANOVDB_FLOAT3 = 9,
   IMAGE_DATA_TYPE_NANOVDB_FPN = 10,
   IMAGE_DATA_TYPE_NANOVDB_FP16 = 11,
+  /* Image sampled on demand through a texture cache, only supported on the CPU. */
+  IMAGE_DATA_TYPE_TEXTURE_CACHE = 12,
 
   IMAGE_DATA_NUM_TYPES
 } ImageDataType;
@@ -86,6 +88,29 @@ typedef struct TextureInfo {
   Transform transform_3d;
 } TextureInfo;
 
+#ifndef __KERNEL_GPU__
+/* Texture data for IMAGE_DATA_TYPE_TEXTURE_CACHE. Tiles and MIP levels are loaded by the texture
+ * cache as they are sampled, so the kernel only stores what is needed to perform a lookup. */
+struct TextureCacheInfo;
+typedef float4 (*TextureCacheLookupFunction)(const TextureCacheInfo &cache_info,
+                                             const TextureInfo &info,
+                                             float x,
+                                             float y);
+
+typedef struct TextureCacheInfo {
+  TextureCacheLookupFunction lookup;
+  /* OpenImageIO texture system and texture handle. */
+  void *texture_system;
+  void *texture_handle;
+  /* Color space processor to convert to scene linear, or NULL if no conversion is needed. */
+  void *processor;
+  /* Resolution of the image, and whether the file has an alpha channel. */
+  int width;
+  int height;
+  bool has_alpha;
+} TextureCacheInfo;
+#endif
+
 CCL_NAMESPACE_END
 
 #endif /* __UTIL_TEXTURE_H__ */
@@ -802,6 +802,7 @@ class USERPREF_PT_system_video_sequencer(SystemPanel, CenterAlignMixIn, Panel):
         layout.separator()
 
         layout.prop(system, "sequencer_proxy_setup")
+        layout.prop(system, "sequencer_proxy_threads")
 
 
 # -----------------------------------------------------------------------------
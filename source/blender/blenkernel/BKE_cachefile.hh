@@ -8,6 +8,11 @@
  * \ingroup bke
  */
 
+#include <cstdint>
+#include <functional>
+
+#include "BLI_function_ref.hh"
+
 struct CacheFile;
 struct CacheFileLayer;
 struct CacheReader;
@@ -39,6 +44,51 @@ void BKE_cachefile_reader_open(CacheFile *cache_file,
                                const char *object_path);
 void BKE_cachefile_reader_free(CacheFile *cache_file, CacheReader **reader);
 
+namespace blender::bke {
+struct GeometrySet;
+}
+
+/**
+ * Read the data of a reader at the given time (as returned by #BKE_cachefile_time_offset) into
+ * the geometry set, which contains the input geometry of the reader. This may be called from
+ * background threads, so it must not access data that is modified by depsgraph evaluation.
+ */
+using CacheFileReadGeometryFn = std::function<void(CacheReader *reader,
+                                                   double time,
+                                                   blender::bke::GeometrySet &geometry_set,
+                                                   const char **r_err_str)>;
+
+/**
+ * Read the geometry of \a reader at \a frame through \a read_fn.
+ *
+ * When prefetching is enabled on the cache file, the frames following \a frame are then read in
+ * the background into a cache bounded by #CacheFile.prefetch_cache_size, so that the next frames
+ * of the playback do not have to wait for the file. Prefetched data is only used when the input
+ * geometry and \a params_hash, which identifies all other settings used by \a read_fn, match.
+ */
+void BKE_cachefile_read_geometry(CacheFile *cache_file,
+                                 CacheReader *reader,
+                                 double frame,
+                                 double fps,
+                                 uint64_t params_hash,
+                                 blender::bke::GeometrySet &geometry_set,
+                                 const CacheFileReadGeometryFn &read_fn,
+                                 const char **r_err_str);
+
+/**
+ * Run \a fn while no background task is reading with \a reader, for other uses of a reader that
+ * is read through #BKE_cachefile_read_geometry.
+ */
+void BKE_cachefile_reader_run_exclusive(CacheFile *cache_file,
+                                        CacheReader *reader,
+                                        blender::FunctionRef<void()> fn);
+
+/**
+ * Wait until the frames queued by #BKE_cachefile_read_geometry are read in the background, or
+ * until reading ahead stopped because the prefetch cache is full. Used by tests.
+ */
+void BKE_cachefile_prefetch_wait(CacheFile *cache_file);
+
 /**
  * Determine whether the #CacheFile should use a render engine procedural. If so, data is not read
  * from the file and bounding boxes are used to represent the objects in the Scene.
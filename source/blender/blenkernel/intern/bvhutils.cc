@@ -6,20 +6,30 @@
  * \ingroup bke
  */
 
+#include <array>
+#include <memory>
+#include <mutex>
+#include <optional>
+
 #include "DNA_meshdata_types.h"
 #include "DNA_pointcloud_types.h"
 
+#include "BLI_implicit_sharing.hh"
+#include "BLI_map.hh"
 #include "BLI_math_geom.h"
+#include "BLI_struct_equality_utils.hh"
 #include "BLI_task.h"
 
 #include "BKE_attribute.hh"
 #include "BKE_bvhutils.hh"
+#include "BKE_customdata.hh"
 #include "BKE_editmesh.hh"
 #include "BKE_mesh.hh"
 
 using blender::BitSpan;
 using blender::BitVector;
 using blender::float3;
+using blender::ImplicitSharingInfo;
 using blender::IndexRange;
 using blender::int3;
 using blender::Span;
@@ -30,8 +40,9 @@ using blender::VArray;
  * \{ */
 
 struct BVHCacheItem {
-  bool is_filled;
-  BVHTree *tree;
+  bool is_filled = false;
+  /** The tree may be shared with other meshes, see #SharedBVHTrees. */
+  std::shared_ptr<BVHTree> tree;
 };
 
 struct BVHCache {
@@ -71,7 +82,7 @@ static bool bvhcache_find(BVHCache **bvh_cache_p,
   BVHCache *bvh_cache = *bvh_cache_p;
 
   if (bvh_cache->items[type].is_filled) {
-    *r_tree = bvh_cache->items[type].tree;
+    *r_tree = bvh_cache->items[type].tree.get();
     return true;
   }
   if (do_lock) {
@@ -100,7 +111,7 @@ bool bvhcache_has_tree(const BVHCache *bvh_cache, const BVHTree *tree)
   }
 
   for (int i = 0; i < BVHTREE_MAX_ITEM; i++) {
-    if (bvh_cache->items[i].tree == tree) {
+    if (bvh_cache->items[i].tree.get() == tree) {
       return true;
     }
   }
@@ -109,7 +120,7 @@ bool bvhcache_has_tree(const BVHCache *bvh_cache, const BVHTree *tree)
 
 BVHCache *bvhcache_init()
 {
-  BVHCache *cache = MEM_cnew<BVHCache>(__func__);
+  BVHCache *cache = MEM_new<BVHCache>(__func__);
   BLI_mutex_init(&cache->mutex);
   return cache;
 }
@@ -121,23 +132,20 @@ BVHCache *bvhcache_init()
  * A call to this assumes that there was no previous cached tree of the given type
  * \warning The #BVHTree can be nullptr.
  */
-static void bvhcache_insert(BVHCache *bvh_cache, BVHTree *tree, BVHCacheType type)
+static void bvhcache_insert(BVHCache *bvh_cache,
+                            std::shared_ptr<BVHTree> tree,
+                            BVHCacheType type)
 {
   BVHCacheItem *item = &bvh_cache->items[type];
   BLI_assert(!item->is_filled);
-  item->tree = tree;
+  item->tree = std::move(tree);
   item->is_filled = true;
 }
 
 void bvhcache_free(BVHCache *bvh_cache)
 {
-  for (int index = 0; index < BVHTREE_MAX_ITEM; index++) {
-    BVHCacheItem *item = &bvh_cache->items[index];
-    BLI_bvhtree_free(item->tree);
-    item->tree = nullptr;
-  }
   BLI_mutex_end(&bvh_cache->mutex);
-  MEM_freeN(bvh_cache);
+  MEM_delete(bvh_cache);
 }
 
 /**
@@ -164,6 +172,165 @@ static void bvhtree_balance(BVHTree *tree, const bool isolate)
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Shared BVH Trees
+ *
+ * Some BVH trees only depend on a few arrays of the mesh. When another mesh references the same
+ * arrays through implicit sharing, e.g. because it is a copy made for evaluation or because a
+ * modifier passed the geometry through unchanged, the tree of the other mesh can be used instead
+ * of building a new one.
+ * \{ */
+
+/** Identifies the state of a mesh array by its implicit-sharing info and version. */
+struct SharedArrayID {
+  const ImplicitSharingInfo *sharing_info = nullptr;
+  int64_t version = 0;
+
+  BLI_STRUCT_EQUALITY_OPERATORS_2(SharedArrayID, sharing_info, version)
+};
+
+struct SharedBVHTreeKey {
+  BVHCacheType type;
+  std::array<SharedArrayID, 3> arrays;
+
+  uint64_t hash() const
+  {
+    return blender::get_default_hash(
+        blender::get_default_hash(int(type), arrays[0].sharing_info, arrays[0].version),
+        blender::get_default_hash(arrays[1].sharing_info, arrays[1].version),
+        blender::get_default_hash(arrays[2].sharing_info, arrays[2].version));
+  }
+
+  BLI_STRUCT_EQUALITY_OPERATORS_2(SharedBVHTreeKey, type, arrays)
+};
+
+static std::optional<SharedArrayID> get_shared_array_id(const CustomData &data,
+                                                        const eCustomDataType data_type,
+                                                        const blender::StringRef name)
+{
+  const int layer_index = CustomData_get_named_layer_index(&data, data_type, name);
+  if (layer_index == -1) {
+    return std::nullopt;
+  }
+  const ImplicitSharingInfo *sharing_info = data.layers[layer_index].sharing_info;
+  if (sharing_info == nullptr) {
+    return std::nullopt;
+  }
+  return SharedArrayID{sharing_info, sharing_info->version()};
+}
+
+/**
+ * Build a key that identifies the data the tree depends on. Returns none for tree types that also
+ * depend on other data like hidden or loose elements.
+ */
+static std::optional<SharedBVHTreeKey> get_shared_bvh_tree_key(const Mesh &mesh,
+                                                                const BVHCacheType type)
+{
+  const std::optional<SharedArrayID> positions = get_shared_array_id(
+      mesh.vert_data, CD_PROP_FLOAT3, "position");
+  if (!positions) {
+    return std::nullopt;
+  }
+  switch (type) {
+    case BVHTREE_FROM_VERTS: {
+      return SharedBVHTreeKey{type, {*positions, {}, {}}};
+    }
+    case BVHTREE_FROM_EDGES: {
+      const std::optional<SharedArrayID> edges = get_shared_array_id(
+          mesh.edge_data, CD_PROP_INT32_2D, ".edge_verts");
+      if (!edges) {
+        return std::nullopt;
+      }
+      return SharedBVHTreeKey{type, {*positions, *edges, {}}};
+    }
+    case BVHTREE_FROM_CORNER_TRIS: {
+      const std::optional<SharedArrayID> corner_verts = get_shared_array_id(
+          mesh.corner_data, CD_PROP_INT32, ".corner_vert");
+      const ImplicitSharingInfo *face_offsets = mesh.runtime->face_offsets_sharing_info;
+      if (!corner_verts || (mesh.faces_num > 0 && face_offsets == nullptr)) {
+        return std::nullopt;
+      }
+      const SharedArrayID faces = face_offsets ?
+                                      SharedArrayID{face_offsets, face_offsets->version()} :
+                                      SharedArrayID{};
+      return SharedBVHTreeKey{type, {*positions, *corner_verts, faces}};
+    }
+    default: {
+      return std::nullopt;
+    }
+  }
+}
+
+/**
+ * Remembers the trees that have been built for shareable mesh data, so that they can be found
+ * for other meshes using the same data. Only weak references are kept here, trees are still
+ * freed when the last mesh using them is freed or changed.
+ */
+class SharedBVHTrees {
+ private:
+  std::mutex mutex_;
+  blender::Map<SharedBVHTreeKey, std::weak_ptr<BVHTree>> trees_;
+  /** Expired trees are removed when the map grows beyond this size. */
+  int64_t cleanup_size_ = 64;
+
+ public:
+  std::shared_ptr<BVHTree> lookup(const SharedBVHTreeKey &key)
+  {
+    std::lock_guard lock{mutex_};
+    const std::weak_ptr<BVHTree> *tree = trees_.lookup_ptr(key);
+    if (tree == nullptr) {
+      return nullptr;
+    }
+    return tree->lock();
+  }
+
+  void add(const SharedBVHTreeKey &key, const std::shared_ptr<BVHTree> &tree)
+  {
+    std::lock_guard lock{mutex_};
+    trees_.add_overwrite(key, tree);
+    if (trees_.size() >= cleanup_size_) {
+      trees_.remove_if([](const auto item) { return item.value.expired(); });
+      cleanup_size_ = std::max<int64_t>(64, trees_.size() * 2);
+    }
+  }
+};
+
+static SharedBVHTrees &get_shared_bvh_trees()
+{
+  static SharedBVHTrees trees;
+  return trees;
+}
+
+/**
+ * Take ownership of a newly built tree. The tree keeps weak users of the sharing infos in the key,
+ * so that the keys of living trees stay unique. Otherwise, the memory of the sharing info might be
+ * reused for unrelated data after it has been freed.
+ */
+static std::shared_ptr<BVHTree> bvhtree_make_shared(BVHTree *tree,
+                                                    const std::optional<SharedBVHTreeKey> &key)
+{
+  if (!key) {
+    return std::shared_ptr<BVHTree>(tree, BLI_bvhtree_free);
+  }
+  std::array<const ImplicitSharingInfo *, 3> sharing_infos;
+  for (const int i : IndexRange(3)) {
+    sharing_infos[i] = key->arrays[i].sharing_info;
+    if (sharing_infos[i]) {
+      sharing_infos[i]->add_weak_user();
+    }
+  }
+  return std::shared_ptr<BVHTree>(tree, [sharing_infos](BVHTree *tree) {
+    BLI_bvhtree_free(tree);
+    for (const ImplicitSharingInfo *sharing_info : sharing_infos) {
+      if (sharing_info) {
+        sharing_info->remove_weak_user_and_delete_if_last();
+      }
+    }
+  });
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name Local Callbacks
  * \{ */
@@ -935,6 +1102,19 @@ BVHTree *BKE_bvhtree_from_mesh_get(BVHTreeFromMesh *data,
     return data->tree;
   }
 
+  /* Reuse the tree from another mesh that shares the same data. */
+  const std::optional<SharedBVHTreeKey> shared_key = get_shared_bvh_tree_key(*mesh,
+                                                                             bvh_cache_type);
+  if (shared_key) {
+    if (std::shared_ptr<BVHTree> shared_tree = get_shared_bvh_trees().lookup(*shared_key)) {
+      data->tree = shared_tree.get();
+      data->cached = true;
+      bvhcache_insert(*bvh_cache_p, std::move(shared_tree), bvh_cache_type);
+      bvhcache_unlock(*bvh_cache_p, lock_started);
+      return data->tree;
+    }
+  }
+
   /* Create BVHTree. */
 
   switch (bvh_cache_type) {
@@ -1014,7 +1194,11 @@ BVHTree *BKE_bvhtree_from_mesh_get(BVHTreeFromMesh *data,
   // printf("BVHTree built and saved on cache\n");
   BLI_assert(data->cached == false);
   data->cached = true;
-  bvhcache_insert(*bvh_cache_p, data->tree, bvh_cache_type);
+  std::shared_ptr<BVHTree> tree = bvhtree_make_shared(data->tree, shared_key);
+  if (shared_key && data->tree != nullptr) {
+    get_shared_bvh_trees().add(*shared_key, tree);
+  }
+  bvhcache_insert(*bvh_cache_p, std::move(tree), bvh_cache_type);
   bvhcache_unlock(*bvh_cache_p, lock_started);
 
 #ifndef NDEBUG
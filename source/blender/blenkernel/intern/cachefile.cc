@@ -6,28 +6,43 @@
  * \ingroup bke
  */
 
+#include <condition_variable>
 #include <cstring>
+#include <memory>
+#include <mutex>
 #include <optional>
 
 #include "DNA_cachefile_types.h"
+#include "DNA_curves_types.h"
+#include "DNA_mesh_types.h"
 #include "DNA_object_types.h"
+#include "DNA_pointcloud_types.h"
 #include "DNA_scene_types.h"
 
 #include "BLI_fileops.h"
+#include "BLI_function_ref.hh"
 #include "BLI_ghash.h"
 #include "BLI_listbase.h"
+#include "BLI_map.hh"
 #include "BLI_path_util.h"
 #include "BLI_string.h"
+#include "BLI_task.hh"
 #include "BLI_threads.h"
 #include "BLI_utildefines.h"
+#include "BLI_vector.hh"
 
 #include "BLT_translation.hh"
 
 #include "BKE_bpath.hh"
 #include "BKE_cachefile.hh"
+#include "BKE_curves.hh"
+#include "BKE_customdata.hh"
+#include "BKE_geometry_set.hh"
 #include "BKE_idtype.hh"
 #include "BKE_lib_id.hh"
 #include "BKE_main.hh"
+#include "BKE_mesh.hh"
+#include "BKE_pointcloud.hh"
 #include "BKE_scene.hh"
 
 #include "DEG_depsgraph_query.hh"
@@ -55,6 +70,8 @@ static void cache_file_init_data(ID *id)
   BLI_assert(MEMCMP_STRUCT_AFTER_IS_ZERO(cache_file, id));
 
   cache_file->scale = 1.0f;
+  cache_file->prefetch_cache_size = 4096;
+  cache_file->prefetch_frames = 8;
   cache_file->velocity_unit = CACHEFILE_VELOCITY_UNIT_SECOND;
   STRNCPY(cache_file->velocity_name, ".velocities");
 }
@@ -70,6 +87,7 @@ static void cache_file_copy_data(Main * /*bmain*/,
 
   cache_file_dst->handle = nullptr;
   cache_file_dst->handle_readers = nullptr;
+  cache_file_dst->prefetch = nullptr;
   BLI_duplicatelist(&cache_file_dst->object_paths, &cache_file_src->object_paths);
   BLI_duplicatelist(&cache_file_dst->layers, &cache_file_src->layers);
 }
@@ -98,6 +116,7 @@ static void cache_file_blend_write(BlendWriter *writer, ID *id, const void *id_a
   cache_file->handle = nullptr;
   memset(cache_file->handle_filepath, 0, sizeof(cache_file->handle_filepath));
   cache_file->handle_readers = nullptr;
+  cache_file->prefetch = nullptr;
 
   BLO_write_id_struct(writer, CacheFile, id_address, &cache_file->id);
   BKE_id_blend_write(writer, &cache_file->id);
@@ -115,6 +134,7 @@ static void cache_file_blend_read_data(BlendDataReader *reader, ID *id)
   cache_file->handle = nullptr;
   cache_file->handle_filepath[0] = '\0';
   cache_file->handle_readers = nullptr;
+  cache_file->prefetch = nullptr;
 
   /* relink layers */
   BLO_read_struct_list(reader, CacheFileLayer, &cache_file->layers);
@@ -163,6 +183,523 @@ void BKE_cachefiles_exit()
   BLI_spin_end(&spin);
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Prefetching
+ *
+ * Frames following the current one are read by a dedicated IO thread per cache file, so that
+ * playback does not have to wait for the file. Blocking file access is kept out of the task
+ * scheduler threads that evaluate the depsgraph. Readers are not thread-safe, every use of a
+ * reader while prefetching is enabled goes through its #CacheReaderPrefetch::read_mutex.
+ * \{ */
+
+namespace {
+
+enum class PrefetchFrameState {
+  /** Waiting for the IO thread. */
+  Queued,
+  /** Being read by the IO thread, #CacheFilePrefetch::frame_read is notified when done. */
+  Reading,
+  Ready,
+};
+
+struct PrefetchFrame {
+  double time;
+  PrefetchFrameState state = PrefetchFrameState::Queued;
+  blender::bke::GeometrySet geometry;
+  const char *err_str = nullptr;
+  int64_t size_in_bytes = 0;
+};
+
+struct CacheReaderPrefetch {
+  std::mutex read_mutex;
+  /** Copy of the input geometry owning its data, which keeps the shared arrays alive. */
+  blender::bke::GeometrySet input;
+  uint64_t params_hash = 0;
+  CacheFileReadGeometryFn read_fn;
+  blender::Vector<PrefetchFrame> frames;
+};
+
+}  // namespace
+
+struct CacheFilePrefetch {
+  /** Protects everything but the reader mutexes and the IO thread. */
+  std::mutex mutex;
+  std::condition_variable frame_read;
+  /** Notified when frames are queued, or when the IO thread has to stop. */
+  std::condition_variable frames_queued;
+  blender::Map<const CacheReader *, std::unique_ptr<CacheReaderPrefetch>> readers;
+  int64_t size_in_bytes = 0;
+  int64_t max_size_in_bytes = 0;
+  bool stop_thread = false;
+
+  /** Guards starting and stopping the IO thread. */
+  std::mutex thread_mutex;
+  ListBase thread = {nullptr, nullptr};
+  bool thread_running = false;
+};
+
+/** Guards creating and freeing #CacheFile.prefetch. */
+static std::mutex prefetch_lifetime_mutex;
+
+static int64_t customdata_size_in_bytes(const CustomData &data, const int elements_num)
+{
+  int64_t size = 0;
+  for (const CustomDataLayer &layer : blender::Span(data.layers, data.totlayer)) {
+    size += int64_t(CustomData_sizeof(eCustomDataType(layer.type))) * elements_num;
+  }
+  return size;
+}
+
+static int64_t prefetch_geometry_size_in_bytes(const blender::bke::GeometrySet &geometry)
+{
+  int64_t size = 0;
+  if (const Mesh *mesh = geometry.get_mesh()) {
+    size += customdata_size_in_bytes(mesh->vert_data, mesh->verts_num);
+    size += customdata_size_in_bytes(mesh->edge_data, mesh->edges_num);
+    size += customdata_size_in_bytes(mesh->face_data, mesh->faces_num);
+    size += customdata_size_in_bytes(mesh->corner_data, mesh->corners_num);
+    size += int64_t(sizeof(int)) * (mesh->faces_num + 1);
+  }
+  if (const PointCloud *pointcloud = geometry.get_pointcloud()) {
+    size += customdata_size_in_bytes(pointcloud->pdata, pointcloud->totpoint);
+  }
+  if (const Curves *curves = geometry.get_curves()) {
+    const CurvesGeometry &data = curves->geometry;
+    size += customdata_size_in_bytes(data.point_data, data.point_num);
+    size += customdata_size_in_bytes(data.curve_data, data.curve_num);
+    size += int64_t(sizeof(int)) * (data.curve_num + 1);
+  }
+  return size;
+}
+
+/** Copy of the input geometry of a reader that can outlive the modifier evaluation. */
+static blender::bke::GeometrySet prefetch_input_copy(const blender::bke::GeometrySet &geometry)
+{
+  blender::bke::GeometrySet input;
+  if (const Mesh *mesh = geometry.get_mesh()) {
+    input.replace_mesh(BKE_mesh_copy_for_eval(*mesh));
+  }
+  if (const PointCloud *pointcloud = geometry.get_pointcloud()) {
+    input.replace_pointcloud(BKE_pointcloud_copy_for_eval(pointcloud));
+  }
+  if (const Curves *curves = geometry.get_curves()) {
+    input.replace_curves(BKE_curves_copy_for_eval(curves));
+  }
+  return input;
+}
+
+/**
+ * Layers are implicitly shared between the input and its copy, and the copy keeps them alive, so
+ * equal data pointers mean equal data.
+ */
+static bool customdata_layers_shared(const CustomData &a, const CustomData &b)
+{
+  if (a.totlayer != b.totlayer) {
+    return false;
+  }
+  for (const int i : blender::IndexRange(a.totlayer)) {
+    if (a.layers[i].type != b.layers[i].type || a.layers[i].data != b.layers[i].data ||
+        !STREQ(a.layers[i].name, b.layers[i].name))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool prefetch_input_matches(const blender::bke::GeometrySet &input,
+                                   const blender::bke::GeometrySet &geometry)
+{
+  const Mesh *mesh_a = input.get_mesh();
+  const Mesh *mesh_b = geometry.get_mesh();
+  if ((mesh_a == nullptr) != (mesh_b == nullptr)) {
+    return false;
+  }
+  if (mesh_a) {
+    if (mesh_a->verts_num != mesh_b->verts_num || mesh_a->edges_num != mesh_b->edges_num ||
+        mesh_a->faces_num != mesh_b->faces_num || mesh_a->corners_num != mesh_b->corners_num ||
+        mesh_a->face_offset_indices != mesh_b->face_offset_indices ||
+        !customdata_layers_shared(mesh_a->vert_data, mesh_b->vert_data) ||
+        !customdata_layers_shared(mesh_a->edge_data, mesh_b->edge_data) ||
+        !customdata_layers_shared(mesh_a->face_data, mesh_b->face_data) ||
+        !customdata_layers_shared(mesh_a->corner_data, mesh_b->corner_data))
+    {
+      return false;
+    }
+  }
+
+  const PointCloud *pointcloud_a = input.get_pointcloud();
+  const PointCloud *pointcloud_b = geometry.get_pointcloud();
+  if ((pointcloud_a == nullptr) != (pointcloud_b == nullptr)) {
+    return false;
+  }
+  if (pointcloud_a) {
+    if (pointcloud_a->totpoint != pointcloud_b->totpoint ||
+        !customdata_layers_shared(pointcloud_a->pdata, pointcloud_b->pdata))
+    {
+      return false;
+    }
+  }
+
+  const Curves *curves_a = input.get_curves();
+  const Curves *curves_b = geometry.get_curves();
+  if ((curves_a == nullptr) != (curves_b == nullptr)) {
+    return false;
+  }
+  if (curves_a) {
+    const CurvesGeometry &a = curves_a->geometry;
+    const CurvesGeometry &b = curves_b->geometry;
+    if (a.point_num != b.point_num || a.curve_num != b.curve_num ||
+        a.curve_offsets != b.curve_offsets ||
+        !customdata_layers_shared(a.point_data, b.point_data) ||
+        !customdata_layers_shared(a.curve_data, b.curve_data))
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/** Replace the components written by readers, keeping the others like instances. */
+static void prefetch_result_apply(const blender::bke::GeometrySet &result,
+                                  blender::bke::GeometrySet &geometry_set)
+{
+  using namespace blender::bke;
+  for (const GeometryComponent::Type type : {GeometryComponent::Type::Mesh,
+                                             GeometryComponent::Type::PointCloud,
+                                             GeometryComponent::Type::Curve})
+  {
+    geometry_set.remove(type);
+    if (const GeometryComponent *component = result.get_component(type)) {
+      geometry_set.add(*component);
+    }
+  }
+}
+
+static PrefetchFrame *prefetch_frame_find(CacheReaderPrefetch &reader_prefetch,
+                                          const double time)
+{
+  for (PrefetchFrame &frame : reader_prefetch.frames) {
+    if (frame.time == time) {
+      return &frame;
+    }
+  }
+  return nullptr;
+}
+
+static void prefetch_frames_remove_if(CacheFilePrefetch &prefetch,
+                                      CacheReaderPrefetch &reader_prefetch,
+                                      const blender::FunctionRef<bool(const PrefetchFrame &)> fn)
+{
+  for (const PrefetchFrame &frame : reader_prefetch.frames) {
+    if (fn(frame)) {
+      prefetch.size_in_bytes -= frame.size_in_bytes;
+    }
+  }
+  reader_prefetch.frames.remove_if([&](const PrefetchFrame &frame) { return fn(frame); });
+}
+
+/** Find the next frame to read, or stop reading ahead when the cache is full. */
+static PrefetchFrame *prefetch_frame_next(CacheFilePrefetch &prefetch,
+                                          const CacheReader **r_reader,
+                                          CacheReaderPrefetch **r_reader_prefetch)
+{
+  for (const auto item : prefetch.readers.items()) {
+    CacheReaderPrefetch &reader_prefetch = *item.value;
+    if (prefetch.size_in_bytes >= prefetch.max_size_in_bytes) {
+      /* Played frames have to be removed from the cache first. */
+      prefetch_frames_remove_if(prefetch, reader_prefetch, [](const PrefetchFrame &frame) {
+        return frame.state == PrefetchFrameState::Queued;
+      });
+      continue;
+    }
+    for (PrefetchFrame &frame : reader_prefetch.frames) {
+      if (frame.state == PrefetchFrameState::Queued) {
+        *r_reader = item.key;
+        *r_reader_prefetch = &reader_prefetch;
+        return &frame;
+      }
+    }
+  }
+  return nullptr;
+}
+
+static void *prefetch_thread_run(void *thread_data)
+{
+  CacheFilePrefetch &prefetch = *static_cast<CacheFilePrefetch *>(thread_data);
+
+  std::unique_lock lock(prefetch.mutex);
+  while (!prefetch.stop_thread) {
+    const CacheReader *reader = nullptr;
+    /* Readers are only removed after stopping the thread. */
+    CacheReaderPrefetch *reader_prefetch = nullptr;
+    PrefetchFrame *frame = prefetch_frame_next(prefetch, &reader, &reader_prefetch);
+    if (frame == nullptr) {
+      prefetch.frames_queued.wait(lock);
+      continue;
+    }
+
+    frame->state = PrefetchFrameState::Reading;
+    const double time = frame->time;
+    blender::bke::GeometrySet geometry = reader_prefetch->input;
+    const CacheFileReadGeometryFn read_fn = reader_prefetch->read_fn;
+    lock.unlock();
+
+    const char *err_str = nullptr;
+    {
+      std::lock_guard read_lock(reader_prefetch->read_mutex);
+      read_fn(const_cast<CacheReader *>(reader), time, geometry, &err_str);
+    }
+    const int64_t size_in_bytes = prefetch_geometry_size_in_bytes(geometry);
+
+    lock.lock();
+    /* The frame may have been removed in the meantime, when the input changed. */
+    frame = prefetch_frame_find(*reader_prefetch, time);
+    if (frame && frame->state == PrefetchFrameState::Reading) {
+      frame->state = PrefetchFrameState::Ready;
+      frame->geometry = std::move(geometry);
+      frame->err_str = err_str;
+      frame->size_in_bytes = size_in_bytes;
+      prefetch.size_in_bytes += size_in_bytes;
+    }
+    prefetch.frame_read.notify_all();
+  }
+  return nullptr;
+}
+
+static void cachefile_prefetch_thread_ensure(CacheFilePrefetch &prefetch)
+{
+  std::lock_guard thread_lock(prefetch.thread_mutex);
+  if (!prefetch.thread_running) {
+    BLI_threadpool_init(&prefetch.thread, prefetch_thread_run, 1);
+    BLI_threadpool_insert(&prefetch.thread, &prefetch);
+    prefetch.thread_running = true;
+  }
+}
+
+static CacheFilePrefetch &cachefile_prefetch_ensure(CacheFile *cache_file)
+{
+  std::lock_guard lock(prefetch_lifetime_mutex);
+  if (cache_file->prefetch == nullptr) {
+    cache_file->prefetch = MEM_new<CacheFilePrefetch>(__func__);
+  }
+  return *cache_file->prefetch;
+}
+
+/**
+ * Stop the IO thread after the frame it is reading, it is started again by the next read that
+ * queues frames.
+ */
+static void cachefile_prefetch_thread_stop(CacheFilePrefetch &prefetch)
+{
+  std::lock_guard thread_lock(prefetch.thread_mutex);
+  if (!prefetch.thread_running) {
+    return;
+  }
+
+  {
+    std::lock_guard lock(prefetch.mutex);
+    prefetch.stop_thread = true;
+  }
+  prefetch.frames_queued.notify_all();
+  BLI_threadpool_end(&prefetch.thread);
+  prefetch.thread_running = false;
+
+  std::lock_guard lock(prefetch.mutex);
+  prefetch.stop_thread = false;
+}
+
+/** Must be called before a reader is freed. */
+static void cachefile_prefetch_reader_remove(CacheFile *cache_file, const CacheReader *reader)
+{
+  std::lock_guard lifetime_lock(prefetch_lifetime_mutex);
+  CacheFilePrefetch *prefetch = cache_file->prefetch;
+  if (prefetch == nullptr || !prefetch->readers.contains(reader)) {
+    return;
+  }
+
+  cachefile_prefetch_thread_stop(*prefetch);
+
+  std::lock_guard lock(prefetch->mutex);
+  std::unique_ptr<CacheReaderPrefetch> reader_prefetch = prefetch->readers.pop(reader);
+  prefetch_frames_remove_if(
+      *prefetch, *reader_prefetch, [](const PrefetchFrame & /*frame*/) { return true; });
+}
+
+static void cachefile_prefetch_free(CacheFile *cache_file)
+{
+  std::lock_guard lifetime_lock(prefetch_lifetime_mutex);
+  if (cache_file->prefetch == nullptr) {
+    return;
+  }
+  cachefile_prefetch_thread_stop(*cache_file->prefetch);
+  MEM_delete(cache_file->prefetch);
+  cache_file->prefetch = nullptr;
+}
+
+static bool cachefile_use_prefetch(const CacheFile *cache_file)
+{
+  /* Sequences use a different file for every frame, and a fixed frame does not need to read
+   * ahead. */
+  return cache_file->use_prefetch && cache_file->prefetch_frames > 0 &&
+         cache_file->prefetch_cache_size > 0 && !cache_file->is_sequence &&
+         !cache_file->override_frame;
+}
+
+void BKE_cachefile_read_geometry(CacheFile *cache_file,
+                                 CacheReader *reader,
+                                 const double frame,
+                                 const double fps,
+                                 const uint64_t params_hash,
+                                 blender::bke::GeometrySet &geometry_set,
+                                 const CacheFileReadGeometryFn &read_fn,
+                                 const char **r_err_str)
+{
+  using namespace blender;
+  const double time = BKE_cachefile_time_offset(cache_file, frame, fps);
+
+  if (!cachefile_use_prefetch(cache_file)) {
+    if (cache_file->prefetch) {
+      cachefile_prefetch_free(cache_file);
+    }
+    read_fn(reader, time, geometry_set, r_err_str);
+    return;
+  }
+
+  CacheFilePrefetch &prefetch = cachefile_prefetch_ensure(cache_file);
+  const double last_time = BKE_cachefile_time_offset(
+      cache_file, frame + cache_file->prefetch_frames, fps);
+
+  std::unique_lock lock(prefetch.mutex);
+  prefetch.max_size_in_bytes = int64_t(cache_file->prefetch_cache_size) * 1024 * 1024;
+
+  CacheReaderPrefetch &reader_prefetch = *prefetch.readers.lookup_or_add_cb(
+      reader, []() { return std::make_unique<CacheReaderPrefetch>(); });
+
+  /* When modifiers come before this one, the input changes with every evaluation and prefetched
+   * frames could never be used. Only read ahead once the same input is used again. */
+  const bool input_reusable = reader_prefetch.params_hash == params_hash &&
+                              prefetch_input_matches(reader_prefetch.input, geometry_set);
+  if (!input_reusable) {
+    prefetch_frames_remove_if(
+        prefetch, reader_prefetch, [](const PrefetchFrame & /*frame*/) { return true; });
+    reader_prefetch.input = prefetch_input_copy(geometry_set);
+    reader_prefetch.params_hash = params_hash;
+  }
+  reader_prefetch.read_fn = read_fn;
+
+  /* Free frames that were played already, or that are out of reach after jumping back. */
+  prefetch_frames_remove_if(prefetch, reader_prefetch, [&](const PrefetchFrame &cached_frame) {
+    return cached_frame.time < time || cached_frame.time > last_time;
+  });
+
+  bool found = false;
+  if (PrefetchFrame *cached_frame = prefetch_frame_find(reader_prefetch, time)) {
+    if (cached_frame->state == PrefetchFrameState::Reading) {
+      prefetch.frame_read.wait(lock, [&]() {
+        const PrefetchFrame *read_frame = prefetch_frame_find(reader_prefetch, time);
+        return read_frame == nullptr || read_frame->state != PrefetchFrameState::Reading;
+      });
+      cached_frame = prefetch_frame_find(reader_prefetch, time);
+    }
+    if (cached_frame && cached_frame->state == PrefetchFrameState::Ready) {
+      prefetch_result_apply(cached_frame->geometry, geometry_set);
+      *r_err_str = cached_frame->err_str;
+      found = true;
+    }
+    else if (cached_frame) {
+      /* Still queued, reading it here is faster than waiting for the task. */
+      prefetch_frames_remove_if(prefetch, reader_prefetch, [&](const PrefetchFrame &queued_frame) {
+        return queued_frame.time == time;
+      });
+    }
+  }
+  lock.unlock();
+
+  if (!found) {
+    std::lock_guard read_lock(reader_prefetch.read_mutex);
+    threading::isolate_task([&]() { read_fn(reader, time, geometry_set, r_err_str); });
+  }
+
+  if (!input_reusable) {
+    return;
+  }
+
+  /* Queue the following frames, after reading the current one so it does not have to wait. */
+  lock.lock();
+  bool queued = false;
+  for (const int i : IndexRange(1, cache_file->prefetch_frames)) {
+    const double prefetch_time = BKE_cachefile_time_offset(cache_file, frame + i, fps);
+    if (prefetch_frame_find(reader_prefetch, prefetch_time) == nullptr) {
+      PrefetchFrame prefetch_frame;
+      prefetch_frame.time = prefetch_time;
+      reader_prefetch.frames.append(std::move(prefetch_frame));
+      queued = true;
+    }
+  }
+  lock.unlock();
+
+  if (queued) {
+    prefetch.frames_queued.notify_all();
+    cachefile_prefetch_thread_ensure(prefetch);
+  }
+}
+
+void BKE_cachefile_reader_run_exclusive(CacheFile *cache_file,
+                                        CacheReader *reader,
+                                        const blender::FunctionRef<void()> fn)
+{
+  std::mutex *read_mutex = nullptr;
+  {
+    std::lock_guard lifetime_lock(prefetch_lifetime_mutex);
+    if (CacheFilePrefetch *prefetch = cache_file->prefetch) {
+      std::lock_guard lock(prefetch->mutex);
+      if (const std::unique_ptr<CacheReaderPrefetch> *reader_prefetch =
+              prefetch->readers.lookup_ptr(reader))
+      {
+        read_mutex = &(*reader_prefetch)->read_mutex;
+      }
+    }
+  }
+
+  if (read_mutex == nullptr) {
+    fn();
+    return;
+  }
+  std::lock_guard read_lock(*read_mutex);
+  blender::threading::isolate_task(fn);
+}
+
+/** The IO thread has nothing left to read, until more frames are queued. */
+static bool prefetch_is_idle(const CacheFilePrefetch &prefetch)
+{
+  const bool cache_full = prefetch.size_in_bytes >= prefetch.max_size_in_bytes;
+  for (const std::unique_ptr<CacheReaderPrefetch> &reader_prefetch : prefetch.readers.values()) {
+    for (const PrefetchFrame &frame : reader_prefetch->frames) {
+      if (frame.state == PrefetchFrameState::Reading ||
+          (frame.state == PrefetchFrameState::Queued && !cache_full))
+      {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+void BKE_cachefile_prefetch_wait(CacheFile *cache_file)
+{
+  std::lock_guard lifetime_lock(prefetch_lifetime_mutex);
+  CacheFilePrefetch *prefetch = cache_file->prefetch;
+  if (prefetch == nullptr) {
+    return;
+  }
+  std::unique_lock lock(prefetch->mutex);
+  prefetch->frame_read.wait(lock, [&]() { return prefetch_is_idle(*prefetch); });
+}
+
+/** \} */
+
 void BKE_cachefile_reader_open(CacheFile *cache_file,
                                CacheReader **reader,
                                Object *object,
@@ -176,6 +713,11 @@ void BKE_cachefile_reader_open(CacheFile *cache_file,
     return;
   }
 
+  /* Opening frees the existing reader. */
+  if (*reader) {
+    cachefile_prefetch_reader_remove(cache_file, *reader);
+  }
+
   switch (cache_file->type) {
     case CACHEFILE_TYPE_ALEMBIC:
 #  ifdef WITH_ALEMBIC
@@ -217,6 +759,11 @@ void BKE_cachefile_reader_open(CacheFile *cache_file,
 void BKE_cachefile_reader_free(CacheFile *cache_file, CacheReader **reader)
 {
 #if defined(WITH_ALEMBIC) || defined(WITH_USD)
+  /* Wait for background reads before freeing, outside of the spin lock. */
+  if (cache_file && *reader) {
+    cachefile_prefetch_reader_remove(cache_file, *reader);
+  }
+
   /* Multiple modifiers and constraints can call this function concurrently, and
    * cachefile_handle_free() can also be called at the same time. */
   BLI_spin_lock(&spin);
@@ -254,6 +801,9 @@ void BKE_cachefile_reader_free(CacheFile *cache_file, CacheReader **reader)
 
 static void cachefile_handle_free(CacheFile *cache_file)
 {
+  /* Prefetching uses the readers from the IO thread. */
+  cachefile_prefetch_free(cache_file);
+
 #if defined(WITH_ALEMBIC) || defined(WITH_USD)
 
   /* Free readers in all modifiers and constraints that use the handle, before
@@ -0,0 +1,160 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include <atomic>
+#include <cmath>
+#include <thread>
+
+#include "testing/testing.h"
+
+#include "DNA_cachefile_types.h"
+#include "DNA_mesh_types.h"
+
+#include "BKE_cachefile.hh"
+#include "BKE_geometry_set.hh"
+#include "BKE_idtype.hh"
+#include "BKE_lib_id.hh"
+#include "BKE_main.hh"
+#include "BKE_mesh.hh"
+
+namespace blender::bke::tests {
+
+static constexpr double FPS = 25.0;
+
+class CacheFilePrefetchTest : public ::testing::Test {
+ public:
+  Main *bmain;
+  CacheFile *cache_file;
+  Mesh *input_mesh;
+  /* Only used as key, the read function does not access it. */
+  int reader_data = 0;
+  CacheReader *reader = reinterpret_cast<CacheReader *>(&reader_data);
+
+  std::thread::id test_thread = std::this_thread::get_id();
+  std::atomic<int> sync_reads = 0;
+  std::atomic<int> background_reads = 0;
+  /** Vertices of the meshes read for every frame, multiplied by the frame number. */
+  int verts_per_frame = 10;
+
+  static void SetUpTestSuite()
+  {
+    BKE_idtype_init();
+  }
+
+  void SetUp() override
+  {
+    bmain = BKE_main_new();
+    cache_file = static_cast<CacheFile *>(BKE_id_new(bmain, ID_CF, nullptr));
+    cache_file->use_prefetch = true;
+    cache_file->prefetch_frames = 2;
+    input_mesh = BKE_mesh_new_nomain(4, 0, 0, 0);
+  }
+
+  void TearDown() override
+  {
+    BKE_id_free(nullptr, input_mesh);
+    /* Stops the IO thread. */
+    BKE_main_free(bmain);
+  }
+
+  /** Read a frame, returns the number of vertices of the result. */
+  int read(const int frame, const uint64_t params_hash = 1)
+  {
+    GeometrySet geometry_set = GeometrySet::from_mesh(BKE_mesh_copy_for_eval(*input_mesh));
+    const char *err_str = nullptr;
+    BKE_cachefile_read_geometry(
+        cache_file,
+        reader,
+        frame,
+        FPS,
+        params_hash,
+        geometry_set,
+        [this](CacheReader * /*reader*/,
+               const double time,
+               GeometrySet &geometry,
+               const char ** /*r_err_str*/) {
+          if (std::this_thread::get_id() == test_thread) {
+            sync_reads++;
+          }
+          else {
+            background_reads++;
+          }
+          const int frame = int(std::round(time * FPS));
+          geometry.replace_mesh(BKE_mesh_new_nomain(frame * verts_per_frame, 0, 0, 0));
+        },
+        &err_str);
+    return geometry_set.get_mesh()->verts_num;
+  }
+
+  /** Wait until the prefetched frames are read, and check how many were read in total. */
+  void wait_for_background_reads(const int expected)
+  {
+    BKE_cachefile_prefetch_wait(cache_file);
+    EXPECT_EQ(background_reads, expected);
+  }
+};
+
+TEST_F(CacheFilePrefetchTest, hit)
+{
+  /* The input is only known to be reusable from the second frame on. */
+  EXPECT_EQ(read(1), 10);
+  EXPECT_EQ(read(2), 20);
+  EXPECT_EQ(sync_reads, 2);
+
+  wait_for_background_reads(2);
+  EXPECT_EQ(read(3), 30);
+  EXPECT_EQ(read(4), 40);
+  EXPECT_EQ(sync_reads, 2);
+}
+
+TEST_F(CacheFilePrefetchTest, invalidate_on_params_change)
+{
+  read(1);
+  read(2);
+  wait_for_background_reads(2);
+
+  /* Prefetched frames were read with other settings. */
+  EXPECT_EQ(read(3, 2), 30);
+  EXPECT_EQ(sync_reads, 3);
+
+  /* Prefetching starts again once the settings stay the same. */
+  read(4, 2);
+  EXPECT_EQ(sync_reads, 4);
+  wait_for_background_reads(4);
+  EXPECT_EQ(read(5, 2), 50);
+  EXPECT_EQ(sync_reads, 4);
+}
+
+TEST_F(CacheFilePrefetchTest, invalidate_on_input_change)
+{
+  read(1);
+  read(2);
+  wait_for_background_reads(2);
+
+  /* A new input mesh does not share its arrays with the input of the prefetched frames. */
+  BKE_id_free(nullptr, input_mesh);
+  input_mesh = BKE_mesh_new_nomain(4, 0, 0, 0);
+  EXPECT_EQ(read(3), 30);
+  EXPECT_EQ(sync_reads, 3);
+}
+
+TEST_F(CacheFilePrefetchTest, memory_limit)
+{
+  /* Every frame uses more than the limit of 1 MB. */
+  cache_file->prefetch_cache_size = 1;
+  cache_file->prefetch_frames = 4;
+  verts_per_frame = 100000;
+
+  read(1);
+  read(2);
+  /* Reading ahead stops once the first frame fills the cache. */
+  wait_for_background_reads(1);
+
+  EXPECT_EQ(read(3), 300000);
+  EXPECT_EQ(sync_reads, 2);
+  EXPECT_EQ(read(4), 400000);
+  EXPECT_EQ(sync_reads, 3);
+}
+
+}  // namespace blender::bke::tests
@@ -21,6 +21,10 @@
  *   #BLI_bvhtree_overlap, #BVHOverlapData_Shared, #BVHOverlapData_Thread
  * - Range Query:
  *   #BLI_bvhtree_range_query
+ *
+ * The bounds of all children of a branch node are additionally stored next to each other
+ * ("structure of arrays"), so that ray-cast, nearest and overlap queries can test all children of
+ * a node at once, see #bvhtree_node_wide_bv.
  */
 
 #include "MEM_guardedalloc.h"
@@ -33,6 +37,11 @@
 #include "BLI_task.h"
 #include "BLI_utildefines.h"
 
+#if defined(__SSE2__)
+#  include <emmintrin.h>
+#  define USE_KDOPBVH_SSE2
+#endif
+
 #include "BLI_strict_flags.h" /* Keep last. */
 
 /* used for iterative_raycast */
@@ -46,6 +55,12 @@
 
 #define MAX_TREETYPE 32
 
+/* Number of children that are tested at the same time. */
+#define BVH_WIDE_LANES 4
+/* Wide bounds are only stored for trees with at least this many children per node. They don't
+ * help much for binary trees, but would double the memory usage. */
+#define BVH_WIDE_MIN_TREETYPE 4
+
 /* Setting zero so we can catch bugs in BLI_task/KDOPBVH.
  * TODO(sergey): Deduplicate the limits with PBVH from BKE.
  */
@@ -79,6 +94,7 @@ struct BVHTree {
   BVHNode *nodearray;  /* pre-alloc branch nodes */
   BVHNode **nodechild; /* pre-alloc children for nodes */
   float *nodebv;       /* pre-alloc bounding-volumes for nodes */
+  float *nodebv_wide;  /* Bounding-volumes of children of branches, see #bvhtree_node_wide_bv. */
   float epsilon;       /* Epsilon is used for inflation of the K-DOP. */
   int leaf_num;        /* leafs */
   int branch_num;
@@ -88,8 +104,8 @@ struct BVHTree {
 };
 
 /* optimization, ensure we stay small */
-BLI_STATIC_ASSERT((sizeof(void *) == 8 && sizeof(BVHTree) <= 48) ||
-                      (sizeof(void *) == 4 && sizeof(BVHTree) <= 32),
+BLI_STATIC_ASSERT((sizeof(void *) == 8 && sizeof(BVHTree) <= 56) ||
+                      (sizeof(void *) == 4 && sizeof(BVHTree) <= 36),
                   "over sized")
 
 /* avoid duplicating vars in BVHOverlapData_Thread */
@@ -856,6 +872,84 @@ static void non_recursive_bvh_div_nodes(const BVHTree *tree,
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Wide Bounds
+ *
+ * For every branch node, the bounds of its children are stored in groups of #BVH_WIDE_LANES
+ * children. Within a group, there is one row for the minimum and maximum of every axis, each
+ * containing the values of all children in the group. Lanes of missing children contain empty
+ * bounds.
+ * \{ */
+
+static int wide_bv_rows_num(const BVHTree *tree)
+{
+  return (tree->stop_axis - tree->start_axis) * 2;
+}
+
+static int wide_bv_groups_num(const int children_num)
+{
+  return (children_num + BVH_WIDE_LANES - 1) / BVH_WIDE_LANES;
+}
+
+static size_t wide_bv_node_size(const BVHTree *tree)
+{
+  return (size_t)(wide_bv_groups_num(tree->tree_type) * wide_bv_rows_num(tree) * BVH_WIDE_LANES);
+}
+
+/** Bit mask with one bit for every child of a node. */
+static uint children_mask(const int children_num)
+{
+  return (children_num >= 32) ? ~0u : ((1u << children_num) - 1);
+}
+
+/**
+ * Get the bounds of the children of a branch node in the layout described above, or null for
+ * leaf nodes and trees without wide bounds. The first row corresponds to the minimum of
+ * #BVHTree.start_axis.
+ */
+static const float *bvhtree_node_wide_bv(const BVHTree *tree, const BVHNode *node)
+{
+  if (node->node_num == 0 || tree->nodebv_wide == NULL) {
+    return NULL;
+  }
+  const ptrdiff_t branch_index = node - (tree->nodearray + tree->leaf_num);
+  BLI_assert(branch_index >= 0 && branch_index < tree->branch_num);
+  return tree->nodebv_wide + (size_t)branch_index * wide_bv_node_size(tree);
+}
+
+/** Copy the bounds of all children into the wide bounds of their parents. */
+static void bvhtree_wide_bv_update(BVHTree *tree)
+{
+  if (tree->nodebv_wide == NULL) {
+    return;
+  }
+  const int rows_num = wide_bv_rows_num(tree);
+  const int groups_num = wide_bv_groups_num(tree->tree_type);
+  const size_t node_size = wide_bv_node_size(tree);
+  for (int branch_index = 0; branch_index < tree->branch_num; branch_index++) {
+    const BVHNode *node = &tree->nodearray[tree->leaf_num + branch_index];
+    float *wide_bv = tree->nodebv_wide + (size_t)branch_index * node_size;
+    for (int group = 0; group < groups_num; group++) {
+      for (int lane = 0; lane < BVH_WIDE_LANES; lane++) {
+        const int child_index = group * BVH_WIDE_LANES + lane;
+        const BVHNode *child = child_index < node->node_num ? node->children[child_index] : NULL;
+        for (int row = 0; row < rows_num; row++) {
+          float value;
+          if (child) {
+            value = child->bv[tree->start_axis * 2 + row];
+          }
+          else {
+            value = (row % 2 == 0) ? FLT_MAX : -FLT_MAX;
+          }
+          wide_bv[(group * rows_num + row) * BVH_WIDE_LANES + lane] = value;
+        }
+      }
+    }
+  }
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name BLI_bvhtree API
  * \{ */
@@ -938,6 +1032,7 @@ void BLI_bvhtree_free(BVHTree *tree)
     MEM_SAFE_FREE(tree->nodes);
     MEM_SAFE_FREE(tree->nodearray);
     MEM_SAFE_FREE(tree->nodebv);
+    MEM_SAFE_FREE(tree->nodebv_wide);
     MEM_SAFE_FREE(tree->nodechild);
     MEM_freeN(tree);
   }
@@ -962,6 +1057,12 @@ void BLI_bvhtree_balance(BVHTree *tree)
     tree->nodes[tree->leaf_num + i] = &tree->nodearray[tree->leaf_num + i];
   }
 
+  if (tree->tree_type >= BVH_WIDE_MIN_TREETYPE && tree->leaf_num > 0) {
+    tree->nodebv_wide = MEM_mallocN(
+        sizeof(float) * (size_t)tree->branch_num * wide_bv_node_size(tree), "BVHNodeBVWide");
+    bvhtree_wide_bv_update(tree);
+  }
+
 #ifdef USE_SKIP_LINKS
   build_skip_links(tree, tree->nodes[tree->leaf_num], NULL, NULL);
 #endif
@@ -1039,6 +1140,8 @@ void BLI_bvhtree_update_tree(BVHTree *tree)
   for (; index >= root; index--) {
     node_join(tree, *index);
   }
+
+  bvhtree_wide_bv_update(tree);
 }
 int BLI_bvhtree_get_len(const BVHTree *tree)
 {
@@ -1099,6 +1202,63 @@ static bool tree_overlap_test(const BVHNode *node1,
   return 1;
 }
 
+/**
+ * Test all children of the branch \a parent of \a tree against \a node at once.
+ * \return A bit mask of the children that overlap \a node.
+ */
+static uint tree_overlap_test_children(const BVHTree *tree,
+                                       const BVHNode *parent,
+                                       const BVHNode *node,
+                                       axis_t start_axis,
+                                       axis_t stop_axis)
+{
+  const float *wide_bv = bvhtree_node_wide_bv(tree, parent);
+  uint mask = 0;
+  if (wide_bv == NULL || start_axis < tree->start_axis || stop_axis > tree->stop_axis) {
+    for (int j = 0; j < parent->node_num; j++) {
+      if (tree_overlap_test(parent->children[j], node, start_axis, stop_axis)) {
+        mask |= 1u << j;
+      }
+    }
+    return mask;
+  }
+
+  const int rows_num = wide_bv_rows_num(tree);
+  const int groups_num = wide_bv_groups_num(parent->node_num);
+  for (int group = 0; group < groups_num; group++) {
+    const float *group_bv = wide_bv + group * rows_num * BVH_WIDE_LANES;
+    uint group_mask = (1u << BVH_WIDE_LANES) - 1;
+#ifdef USE_KDOPBVH_SSE2
+    __m128 miss = _mm_setzero_ps();
+    for (axis_t axis = start_axis; axis < stop_axis; axis++) {
+      const int row = (axis - tree->start_axis) * 2;
+      const __m128 child_min = _mm_loadu_ps(group_bv + row * BVH_WIDE_LANES);
+      const __m128 child_max = _mm_loadu_ps(group_bv + (row + 1) * BVH_WIDE_LANES);
+      miss = _mm_or_ps(miss, _mm_cmpgt_ps(child_min, _mm_set1_ps(node->bv[axis * 2 + 1])));
+      miss = _mm_or_ps(miss, _mm_cmpgt_ps(_mm_set1_ps(node->bv[axis * 2]), child_max));
+    }
+    group_mask &= ~(uint)_mm_movemask_ps(miss);
+#else
+    for (axis_t axis = start_axis; axis < stop_axis; axis++) {
+      const int row = (axis - tree->start_axis) * 2;
+      const float *child_min = group_bv + row * BVH_WIDE_LANES;
+      const float *child_max = group_bv + (row + 1) * BVH_WIDE_LANES;
+      for (int lane = 0; lane < BVH_WIDE_LANES; lane++) {
+        if ((child_min[lane] > node->bv[axis * 2 + 1]) || (node->bv[axis * 2] > child_max[lane])) {
+          group_mask &= ~(1u << lane);
+        }
+      }
+    }
+#endif
+    mask |= group_mask << (group * BVH_WIDE_LANES);
+  }
+  /* Lanes of missing children never overlap, but mask them anyway in case of infinite bounds. */
+  return mask & children_mask(parent->node_num);
+}
+
+/**
+ * Recursive overlap traversal, the bounds of \a node1 and \a node2 are known to overlap already.
+ */
 static void tree_overlap_traverse(BVHOverlapData_Thread *data_thread,
                                   const BVHNode *node1,
                                   const BVHNode *node2)
@@ -1106,38 +1266,40 @@ static void tree_overlap_traverse(BVHOverlapData_Thread *data_thread,
   BVHOverlapData_Shared *data = data_thread->shared;
   int j;
 
-  if (tree_overlap_test(node1, node2, data->start_axis, data->stop_axis)) {
-    /* check if node1 is a leaf */
-    if (!node1->node_num) {
-      /* check if node2 is a leaf */
-      if (!node2->node_num) {
-        BVHTreeOverlap *overlap;
+  /* check if node1 is a leaf */
+  if (!node1->node_num) {
+    /* check if node2 is a leaf */
+    if (!node2->node_num) {
+      BVHTreeOverlap *overlap;
 
-        if (UNLIKELY(node1 == node2)) {
-          return;
-        }
-
-        /* both leafs, insert overlap! */
-        overlap = BLI_stack_push_r(data_thread->overlap);
-        overlap->indexA = node1->index;
-        overlap->indexB = node2->index;
-      }
-      else {
-        for (j = 0; j < data->tree2->tree_type; j++) {
-          if (node2->children[j]) {
-            tree_overlap_traverse(data_thread, node1, node2->children[j]);
-          }
-        }
+      if (UNLIKELY(node1 == node2)) {
+        return;
       }
+
+      /* both leafs, insert overlap! */
+      overlap = BLI_stack_push_r(data_thread->overlap);
+      overlap->indexA = node1->index;
+      overlap->indexB = node2->index;
     }
     else {
-      for (j = 0; j < data->tree1->tree_type; j++) {
-        if (node1->children[j]) {
-          tree_overlap_traverse(data_thread, node1->children[j], node2);
+      const uint mask = tree_overlap_test_children(
+          data->tree2, node2, node1, data->start_axis, data->stop_axis);
+      for (j = 0; j < node2->node_num; j++) {
+        if (mask & (1u << j)) {
+          tree_overlap_traverse(data_thread, node1, node2->children[j]);
         }
       }
     }
   }
+  else {
+    const uint mask = tree_overlap_test_children(
+        data->tree1, node1, node2, data->start_axis, data->stop_axis);
+    for (j = 0; j < node1->node_num; j++) {
+      if (mask & (1u << j)) {
+        tree_overlap_traverse(data_thread, node1->children[j], node2);
+      }
+    }
+  }
 }
 
 /**
@@ -1150,41 +1312,43 @@ static void tree_overlap_traverse_cb(BVHOverlapData_Thread *data_thread,
   BVHOverlapData_Shared *data = data_thread->shared;
   int j;
 
-  if (tree_overlap_test(node1, node2, data->start_axis, data->stop_axis)) {
-    /* check if node1 is a leaf */
-    if (!node1->node_num) {
-      /* check if node2 is a leaf */
-      if (!node2->node_num) {
-        BVHTreeOverlap *overlap;
+  /* check if node1 is a leaf */
+  if (!node1->node_num) {
+    /* check if node2 is a leaf */
+    if (!node2->node_num) {
+      BVHTreeOverlap *overlap;
 
-        if (UNLIKELY(node1 == node2)) {
-          return;
-        }
-
-        /* only difference to tree_overlap_traverse! */
-        if (data->callback(data->userdata, node1->index, node2->index, data_thread->thread)) {
-          /* both leafs, insert overlap! */
-          overlap = BLI_stack_push_r(data_thread->overlap);
-          overlap->indexA = node1->index;
-          overlap->indexB = node2->index;
-        }
+      if (UNLIKELY(node1 == node2)) {
+        return;
       }
-      else {
-        for (j = 0; j < data->tree2->tree_type; j++) {
-          if (node2->children[j]) {
-            tree_overlap_traverse_cb(data_thread, node1, node2->children[j]);
-          }
-        }
+
+      /* only difference to tree_overlap_traverse! */
+      if (data->callback(data->userdata, node1->index, node2->index, data_thread->thread)) {
+        /* both leafs, insert overlap! */
+        overlap = BLI_stack_push_r(data_thread->overlap);
+        overlap->indexA = node1->index;
+        overlap->indexB = node2->index;
       }
     }
     else {
-      for (j = 0; j < data->tree1->tree_type; j++) {
-        if (node1->children[j]) {
-          tree_overlap_traverse_cb(data_thread, node1->children[j], node2);
+      const uint mask = tree_overlap_test_children(
+          data->tree2, node2, node1, data->start_axis, data->stop_axis);
+      for (j = 0; j < node2->node_num; j++) {
+        if (mask & (1u << j)) {
+          tree_overlap_traverse_cb(data_thread, node1, node2->children[j]);
         }
       }
     }
   }
+  else {
+    const uint mask = tree_overlap_test_children(
+        data->tree1, node1, node2, data->start_axis, data->stop_axis);
+    for (j = 0; j < node1->node_num; j++) {
+      if (mask & (1u << j)) {
+        tree_overlap_traverse_cb(data_thread, node1->children[j], node2);
+      }
+    }
+  }
 }
 
 /**
@@ -1197,41 +1361,47 @@ static bool tree_overlap_traverse_num(BVHOverlapData_Thread *data_thread,
   BVHOverlapData_Shared *data = data_thread->shared;
   int j;
 
-  if (tree_overlap_test(node1, node2, data->start_axis, data->stop_axis)) {
-    /* check if node1 is a leaf */
-    if (!node1->node_num) {
-      /* check if node2 is a leaf */
-      if (!node2->node_num) {
-        BVHTreeOverlap *overlap;
+  /* check if node1 is a leaf */
+  if (!node1->node_num) {
+    /* check if node2 is a leaf */
+    if (!node2->node_num) {
+      BVHTreeOverlap *overlap;
 
-        if (UNLIKELY(node1 == node2)) {
-          return false;
-        }
+      if (UNLIKELY(node1 == node2)) {
+        return false;
+      }
 
-        /* only difference to tree_overlap_traverse! */
-        if (!data->callback ||
-            data->callback(data->userdata, node1->index, node2->index, data_thread->thread))
-        {
-          /* both leafs, insert overlap! */
-          if (data_thread->overlap) {
-            overlap = BLI_stack_push_r(data_thread->overlap);
-            overlap->indexA = node1->index;
-            overlap->indexB = node2->index;
-          }
-          return (--data_thread->max_interactions) == 0;
+      /* only difference to tree_overlap_traverse! */
+      if (!data->callback ||
+          data->callback(data->userdata, node1->index, node2->index, data_thread->thread))
+      {
+        /* both leafs, insert overlap! */
+        if (data_thread->overlap) {
+          overlap = BLI_stack_push_r(data_thread->overlap);
+          overlap->indexA = node1->index;
+          overlap->indexB = node2->index;
         }
+        return (--data_thread->max_interactions) == 0;
       }
-      else {
-        for (j = 0; j < node2->node_num; j++) {
+    }
+    else {
+      const uint mask = tree_overlap_test_children(
+          data->tree2, node2, node1, data->start_axis, data->stop_axis);
+      for (j = 0; j < node2->node_num; j++) {
+        if (mask & (1u << j)) {
           if (tree_overlap_traverse_num(data_thread, node1, node2->children[j])) {
             return true;
           }
         }
       }
     }
-    else {
-      const uint max_interactions = data_thread->max_interactions;
-      for (j = 0; j < node1->node_num; j++) {
+  }
+  else {
+    const uint mask = tree_overlap_test_children(
+        data->tree1, node1, node2, data->start_axis, data->stop_axis);
+    const uint max_interactions = data_thread->max_interactions;
+    for (j = 0; j < node1->node_num; j++) {
+      if (mask & (1u << j)) {
         if (tree_overlap_traverse_num(data_thread, node1->children[j], node2)) {
           data_thread->max_interactions = max_interactions;
         }
@@ -1246,6 +1416,11 @@ static void tree_overlap_invoke_traverse(BVHOverlapData_Thread *data,
                                          const BVHNode *node1,
                                          const BVHNode *node2)
 {
+  BVHOverlapData_Shared *data_shared = data->shared;
+  if (!tree_overlap_test(node1, node2, data_shared->start_axis, data_shared->stop_axis)) {
+    return;
+  }
+
   if (data->max_interactions) {
     tree_overlap_traverse_num(data, node1, node2);
   }
@@ -1265,8 +1440,15 @@ static void tree_overlap_traverse_self_cb(BVHOverlapData_Thread *data_thread, co
     tree_overlap_traverse_self_cb(data_thread, node->children[i]);
 
     /* Compute overlap of pairs of children, testing each one only once (assume symmetry). */
+    const uint mask = tree_overlap_test_children(data_thread->shared->tree1,
+                                                 node,
+                                                 node->children[i],
+                                                 data_thread->shared->start_axis,
+                                                 data_thread->shared->stop_axis);
     for (int j = i + 1; j < node->node_num; j++) {
-      tree_overlap_traverse_cb(data_thread, node->children[i], node->children[j]);
+      if (mask & (1u << j)) {
+        tree_overlap_traverse_cb(data_thread, node->children[i], node->children[j]);
+      }
     }
   }
 }
@@ -1279,8 +1461,15 @@ static void tree_overlap_traverse_self(BVHOverlapData_Thread *data_thread, const
     tree_overlap_traverse_self(data_thread, node->children[i]);
 
     /* Compute overlap of pairs of children, testing each one only once (assume symmetry). */
+    const uint mask = tree_overlap_test_children(data_thread->shared->tree1,
+                                                 node,
+                                                 node->children[i],
+                                                 data_thread->shared->start_axis,
+                                                 data_thread->shared->stop_axis);
     for (int j = i + 1; j < node->node_num; j++) {
-      tree_overlap_traverse(data_thread, node->children[i], node->children[j]);
+      if (mask & (1u << j)) {
+        tree_overlap_traverse(data_thread, node->children[i], node->children[j]);
+      }
     }
   }
 }
@@ -1557,6 +1746,58 @@ static float calc_nearest_point_squared(const float proj[3], BVHNode *node, floa
   return len_squared_v3v3(proj, nearest);
 }
 
+/**
+ * Version of #calc_nearest_point_squared that computes the squared distances to all children of
+ * \a node at once.
+ * \return False if the node has no wide bounds that can be used.
+ */
+static bool calc_nearest_point_squared_children(const BVHTree *tree,
+                                                const float proj[3],
+                                                const BVHNode *node,
+                                                float r_dist_sq[MAX_TREETYPE])
+{
+  const float *wide_bv = bvhtree_node_wide_bv(tree, node);
+  if (wide_bv == NULL || tree->start_axis != 0 || tree->stop_axis < 3) {
+    return false;
+  }
+  const int rows_num = wide_bv_rows_num(tree);
+  const int groups_num = wide_bv_groups_num(node->node_num);
+  for (int group = 0; group < groups_num; group++) {
+    const float *group_bv = wide_bv + group * rows_num * BVH_WIDE_LANES;
+    float *dist_sq = r_dist_sq + group * BVH_WIDE_LANES;
+#ifdef USE_KDOPBVH_SSE2
+    __m128 sum = _mm_setzero_ps();
+    for (int i = 0; i != 3; i++) {
+      const __m128 co = _mm_set1_ps(proj[i]);
+      /* Same as the clamping in #calc_nearest_point_squared, including the order of arguments. */
+      __m128 val = _mm_max_ps(_mm_loadu_ps(group_bv + (i * 2) * BVH_WIDE_LANES), co);
+      val = _mm_min_ps(_mm_loadu_ps(group_bv + (i * 2 + 1) * BVH_WIDE_LANES), val);
+      const __m128 d = _mm_sub_ps(co, val);
+      sum = (i == 0) ? _mm_mul_ps(d, d) : _mm_add_ps(sum, _mm_mul_ps(d, d));
+    }
+    _mm_storeu_ps(dist_sq, sum);
+#else
+    for (int lane = 0; lane < BVH_WIDE_LANES; lane++) {
+      float nearest[3];
+      for (int i = 0; i != 3; i++) {
+        float val = proj[i];
+        const float bv_min = group_bv[(i * 2) * BVH_WIDE_LANES + lane];
+        const float bv_max = group_bv[(i * 2 + 1) * BVH_WIDE_LANES + lane];
+        if (bv_min > val) {
+          val = bv_min;
+        }
+        if (bv_max < val) {
+          val = bv_max;
+        }
+        nearest[i] = val;
+      }
+      dist_sq[lane] = len_squared_v3v3(proj, nearest);
+    }
+#endif
+  }
+  return true;
+}
+
 /* Depth first search method */
 static void dfs_find_nearest_dfs(BVHNearestData *data, BVHNode *node)
 {
@@ -1573,13 +1814,18 @@ static void dfs_find_nearest_dfs(BVHNearestData *data, BVHNode *node)
     /* Better heuristic to pick the closest node to dive on */
     int i;
     float nearest[3];
+    float children_dist_sq[MAX_TREETYPE];
+    const bool use_children_dist = calc_nearest_point_squared_children(
+        data->tree, data->proj, node, children_dist_sq);
 
     if (data->proj[node->main_axis] <= node->children[0]->bv[node->main_axis * 2 + 1]) {
 
       for (i = 0; i != node->node_num; i++) {
-        if (calc_nearest_point_squared(data->proj, node->children[i], nearest) >=
-            data->nearest.dist_sq)
-        {
+        const float dist_sq = use_children_dist ?
+                                  children_dist_sq[i] :
+                                  calc_nearest_point_squared(
+                                      data->proj, node->children[i], nearest);
+        if (dist_sq >= data->nearest.dist_sq) {
           continue;
         }
         dfs_find_nearest_dfs(data, node->children[i]);
@@ -1587,9 +1833,11 @@ static void dfs_find_nearest_dfs(BVHNearestData *data, BVHNode *node)
     }
     else {
       for (i = node->node_num - 1; i >= 0; i--) {
-        if (calc_nearest_point_squared(data->proj, node->children[i], nearest) >=
-            data->nearest.dist_sq)
-        {
+        const float dist_sq = use_children_dist ?
+                                  children_dist_sq[i] :
+                                  calc_nearest_point_squared(
+                                      data->proj, node->children[i], nearest);
+        if (dist_sq >= data->nearest.dist_sq) {
           continue;
         }
         dfs_find_nearest_dfs(data, node->children[i]);
@@ -1622,9 +1870,14 @@ static void heap_find_nearest_inner(BVHNearestData *data, HeapSimple *heap, BVHN
   }
   else {
     float nearest[3];
+    float children_dist_sq[MAX_TREETYPE];
+    const bool use_children_dist = calc_nearest_point_squared_children(
+        data->tree, data->proj, node, children_dist_sq);
 
     for (int i = 0; i != node->node_num; i++) {
-      float dist_sq = calc_nearest_point_squared(data->proj, node->children[i], nearest);
+      float dist_sq = use_children_dist ?
+                          children_dist_sq[i] :
+                          calc_nearest_point_squared(data->proj, node->children[i], nearest);
 
       if (dist_sq < data->nearest.dist_sq) {
         BLI_heapsimple_insert(heap, dist_sq, node->children[i]);
@@ -1876,18 +2129,93 @@ static float fast_ray_nearest_hit(const BVHRayCastData *data, const BVHNode *nod
   return max_fff(t1x, t1y, t1z);
 }
 
-static void dfs_raycast(BVHRayCastData *data, BVHNode *node)
-{
-  int i;
+/**
+ * Version of #fast_ray_nearest_hit that computes the distances to all children of \a node at
+ * once. Distances are computed with the current #BVHRayCastData.hit, they are only smaller than a
+ * later (smaller) hit distance if #fast_ray_nearest_hit would not have culled the child either.
+ * \return False if the node has no wide bounds that can be used.
+ */
+static bool fast_ray_nearest_hit_children(const BVHRayCastData *data,
+                                          const BVHNode *node,
+                                          float r_dists[MAX_TREETYPE])
+{
+  const BVHTree *tree = data->tree;
+  const float *wide_bv = bvhtree_node_wide_bv(tree, node);
+  if (wide_bv == NULL || data->ray.radius != 0.0f || tree->start_axis != 0 ||
+      tree->stop_axis < 3)
+  {
+    return false;
+  }
+  const int rows_num = wide_bv_rows_num(tree);
+  const int groups_num = wide_bv_groups_num(node->node_num);
+  for (int group = 0; group < groups_num; group++) {
+    /* With #BVHTree.start_axis being zero, rows have the same indices as #BVHNode.bv. */
+    const float *group_bv = wide_bv + group * rows_num * BVH_WIDE_LANES;
+    float *dists = r_dists + group * BVH_WIDE_LANES;
+#ifdef USE_KDOPBVH_SSE2
+    __m128 t1[3], t2[3];
+    for (int i = 0; i != 3; i++) {
+      const __m128 origin = _mm_set1_ps(data->ray.origin[i]);
+      const __m128 idot = _mm_set1_ps(data->idot_axis[i]);
+      t1[i] = _mm_mul_ps(
+          _mm_sub_ps(_mm_loadu_ps(group_bv + data->index[2 * i] * BVH_WIDE_LANES), origin), idot);
+      t2[i] = _mm_mul_ps(
+          _mm_sub_ps(_mm_loadu_ps(group_bv + data->index[2 * i + 1] * BVH_WIDE_LANES), origin),
+          idot);
+    }
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 hit_dist = _mm_set1_ps(data->hit.dist);
+    __m128 miss = _mm_or_ps(_mm_cmpgt_ps(t1[0], t2[1]), _mm_cmplt_ps(t2[0], t1[1]));
+    miss = _mm_or_ps(miss, _mm_or_ps(_mm_cmpgt_ps(t1[0], t2[2]), _mm_cmplt_ps(t2[0], t1[2])));
+    miss = _mm_or_ps(miss, _mm_or_ps(_mm_cmpgt_ps(t1[1], t2[2]), _mm_cmplt_ps(t2[1], t1[2])));
+    for (int i = 0; i != 3; i++) {
+      miss = _mm_or_ps(miss, _mm_cmplt_ps(t2[i], zero));
+      miss = _mm_or_ps(miss, _mm_cmpgt_ps(t1[i], hit_dist));
+    }
+    /* Same as #max_fff, including the order of arguments. */
+    const __m128 dist = _mm_max_ps(_mm_max_ps(t1[0], t1[1]), t1[2]);
+    _mm_storeu_ps(dists,
+                  _mm_or_ps(_mm_and_ps(miss, _mm_set1_ps(FLT_MAX)), _mm_andnot_ps(miss, dist)));
+#else
+    for (int lane = 0; lane < BVH_WIDE_LANES; lane++) {
+      float t1[3], t2[3];
+      for (int i = 0; i != 3; i++) {
+        t1[i] = (group_bv[data->index[2 * i] * BVH_WIDE_LANES + lane] - data->ray.origin[i]) *
+                data->idot_axis[i];
+        t2[i] = (group_bv[data->index[2 * i + 1] * BVH_WIDE_LANES + lane] - data->ray.origin[i]) *
+                data->idot_axis[i];
+      }
+      if ((t1[0] > t2[1] || t2[0] < t1[1] || t1[0] > t2[2] || t2[0] < t1[2] || t1[1] > t2[2] ||
+           t2[1] < t1[2]) ||
+          (t2[0] < 0.0f || t2[1] < 0.0f || t2[2] < 0.0f) ||
+          (t1[0] > data->hit.dist || t1[1] > data->hit.dist || t1[2] > data->hit.dist))
+      {
+        dists[lane] = FLT_MAX;
+      }
+      else {
+        dists[lane] = max_fff(t1[0], t1[1], t1[2]);
+      }
+    }
+#endif
+  }
+  return true;
+}
 
-  /* ray-bv is really fast.. and simple tests revealed its worth to test it
-   * before calling the ray-primitive functions */
+/** Distance to the bounds of a single node, see #fast_ray_nearest_hit and #ray_nearest_hit. */
+static float ray_node_nearest_hit(const BVHRayCastData *data, const BVHNode *node)
+{
   /* XXX: temporary solution for particles until fast_ray_nearest_hit supports ray.radius */
-  float dist = (data->ray.radius == 0.0f) ? fast_ray_nearest_hit(data, node) :
-                                            ray_nearest_hit(data, node->bv);
-  if (dist >= data->hit.dist) {
-    return;
-  }
+  return (data->ray.radius == 0.0f) ? fast_ray_nearest_hit(data, node) :
+                                      ray_nearest_hit(data, node->bv);
+}
+
+/**
+ * Recursive ray-cast into a node whose bounds are known to be hit at distance \a dist, which is
+ * closer than the current hit.
+ */
+static void dfs_raycast_hit(BVHRayCastData *data, BVHNode *node, float dist)
+{
+  int i;
 
   if (node->node_num == 0) {
     if (data->callback) {
@@ -1900,35 +2228,40 @@ static void dfs_raycast(BVHRayCastData *data, BVHNode *node)
     }
   }
   else {
+    /* ray-bv is really fast.. and simple tests revealed its worth to test it
+     * before calling the ray-primitive functions */
+    float children_dists[MAX_TREETYPE];
+    const bool use_children_dists = fast_ray_nearest_hit_children(data, node, children_dists);
+
     /* pick loop direction to dive into the tree (based on ray direction and split axis) */
-    if (data->ray_dot_axis[node->main_axis] > 0.0f) {
-      for (i = 0; i != node->node_num; i++) {
-        dfs_raycast(data, node->children[i]);
-      }
-    }
-    else {
-      for (i = node->node_num - 1; i >= 0; i--) {
-        dfs_raycast(data, node->children[i]);
+    const bool forward = data->ray_dot_axis[node->main_axis] > 0.0f;
+    for (int j = 0; j != node->node_num; j++) {
+      i = forward ? j : node->node_num - 1 - j;
+      const float child_dist = use_children_dists ?
+                                   children_dists[i] :
+                                   ray_node_nearest_hit(data, node->children[i]);
+      if (child_dist < data->hit.dist) {
+        dfs_raycast_hit(data, node->children[i], child_dist);
       }
     }
   }
 }
 
-/**
- * A version of #dfs_raycast with minor changes to reset the index & dist each ray cast.
- */
-static void dfs_raycast_all(BVHRayCastData *data, BVHNode *node)
+static void dfs_raycast(BVHRayCastData *data, BVHNode *node)
 {
-  int i;
-
-  /* ray-bv is really fast.. and simple tests revealed its worth to test it
-   * before calling the ray-primitive functions */
-  /* XXX: temporary solution for particles until fast_ray_nearest_hit supports ray.radius */
-  float dist = (data->ray.radius == 0.0f) ? fast_ray_nearest_hit(data, node) :
-                                            ray_nearest_hit(data, node->bv);
+  const float dist = ray_node_nearest_hit(data, node);
   if (dist >= data->hit.dist) {
     return;
   }
+  dfs_raycast_hit(data, node, dist);
+}
+
+/**
+ * A version of #dfs_raycast_hit with minor changes to reset the index & dist each ray cast.
+ */
+static void dfs_raycast_all_hit(BVHRayCastData *data, BVHNode *node, float dist)
+{
+  int i;
 
   if (node->node_num == 0) {
     /* no need to check for 'data->callback' (using 'all' only makes sense with a callback). */
@@ -1938,20 +2271,32 @@ static void dfs_raycast_all(BVHRayCastData *data, BVHNode *node)
     data->hit.dist = dist;
   }
   else {
+    float children_dists[MAX_TREETYPE];
+    const bool use_children_dists = fast_ray_nearest_hit_children(data, node, children_dists);
+
     /* pick loop direction to dive into the tree (based on ray direction and split axis) */
-    if (data->ray_dot_axis[node->main_axis] > 0.0f) {
-      for (i = 0; i != node->node_num; i++) {
-        dfs_raycast_all(data, node->children[i]);
-      }
-    }
-    else {
-      for (i = node->node_num - 1; i >= 0; i--) {
-        dfs_raycast_all(data, node->children[i]);
+    const bool forward = data->ray_dot_axis[node->main_axis] > 0.0f;
+    for (int j = 0; j != node->node_num; j++) {
+      i = forward ? j : node->node_num - 1 - j;
+      const float child_dist = use_children_dists ?
+                                   children_dists[i] :
+                                   ray_node_nearest_hit(data, node->children[i]);
+      if (child_dist < data->hit.dist) {
+        dfs_raycast_all_hit(data, node->children[i], child_dist);
       }
     }
   }
 }
 
+static void dfs_raycast_all(BVHRayCastData *data, BVHNode *node)
+{
+  const float dist = ray_node_nearest_hit(data, node);
+  if (dist >= data->hit.dist) {
+    return;
+  }
+  dfs_raycast_all_hit(data, node, dist);
+}
+
 static void bvhtree_ray_cast_data_precalc(BVHRayCastData *data, int flag)
 {
   int i;
@@ -11,9 +11,26 @@
 
 #include "BLI_filereader.h"
 #include "BLI_math_base.h"
+#include "BLI_task.h"
 
 #include "MEM_guardedalloc.h"
 
+#include "atomic_ops.h"
+
+/**
+ * Upper limit for the number of frames that are decompressed together when the file is read
+ * sequentially. With the 1 MB frames written by Blender this bounds the memory used by a single
+ * frame cache to 32 MB.
+ */
+#define ZSTD_MAX_PREFETCH_FRAMES 32
+
+/** Uncompressed content of a range of consecutive frames. */
+typedef struct ZstdFrameCache {
+  char *content;
+  int first_frame;
+  int frames_num;
+} ZstdFrameCache;
+
 typedef struct {
   FileReader reader;
 
@@ -28,8 +45,14 @@ typedef struct {
     size_t *compressed_ofs;
     size_t *uncompressed_ofs;
 
-    char *cached_content;
-    int cached_frame;
+    /**
+     * Two caches are used, so that reading data of a block that started just before the most
+     * recently decompressed frame range (which is common when reading blocks on demand) doesn't
+     * throw that range away.
+     */
+    ZstdFrameCache caches[2];
+    /** Index of the cache that was accessed last. */
+    int last_cache;
   } seek;
 } ZstdReader;
 
@@ -125,7 +148,8 @@ static bool zstd_read_seek_table(ZstdReader *zstd)
     return false;
   }
 
-  zstd->seek.cached_frame = -1;
+  zstd->seek.caches[0].first_frame = -1;
+  zstd->seek.caches[1].first_frame = -1;
 
   return true;
 }
@@ -153,24 +177,74 @@ static int zstd_frame_from_pos(ZstdReader *zstd, size_t pos)
   return low;
 }
 
-/* Ensure that the currently loaded frame is the correct one. */
-static const char *zstd_ensure_cache(ZstdReader *zstd, int frame)
+typedef struct ZstdDecompressData {
+  const ZstdReader *zstd;
+  int first_frame;
+  const char *compressed_data;
+  char *uncompressed_data;
+  uint32_t failed_frames_num;
+} ZstdDecompressData;
+
+typedef struct ZstdDecompressTLS {
+  ZSTD_DCtx *ctx;
+} ZstdDecompressTLS;
+
+static void zstd_decompress_frame_task(void *__restrict userdata,
+                                       const int iter,
+                                       const TaskParallelTLS *__restrict tls)
 {
-  if (zstd->seek.cached_frame == frame) {
-    /* Cached frame matches, so just return it. */
-    return zstd->seek.cached_content;
+  ZstdDecompressData *data = (ZstdDecompressData *)userdata;
+  ZstdDecompressTLS *data_tls = (ZstdDecompressTLS *)tls->userdata_chunk;
+  const ZstdReader *zstd = data->zstd;
+  const int frame = data->first_frame + iter;
+
+  if (data_tls->ctx == NULL) {
+    data_tls->ctx = ZSTD_createDCtx();
   }
 
-  /* Cached frame doesn't match, so discard it and cache the wanted one instead. */
-  MEM_SAFE_FREE(zstd->seek.cached_content);
+  const size_t compressed_start = zstd->seek.compressed_ofs[frame] -
+                                  zstd->seek.compressed_ofs[data->first_frame];
+  const size_t uncompressed_start = zstd->seek.uncompressed_ofs[frame] -
+                                    zstd->seek.uncompressed_ofs[data->first_frame];
+  const size_t compressed_size = zstd->seek.compressed_ofs[frame + 1] -
+                                 zstd->seek.compressed_ofs[frame];
+  const size_t uncompressed_size = zstd->seek.uncompressed_ofs[frame + 1] -
+                                   zstd->seek.uncompressed_ofs[frame];
+
+  size_t res = ZSTD_decompressDCtx(data_tls->ctx,
+                                   data->uncompressed_data + uncompressed_start,
+                                   uncompressed_size,
+                                   data->compressed_data + compressed_start,
+                                   compressed_size);
+  if (ZSTD_isError(res) || res < uncompressed_size) {
+    atomic_add_and_fetch_uint32(&data->failed_frames_num, 1);
+  }
+}
 
-  size_t compressed_size = zstd->seek.compressed_ofs[frame + 1] - zstd->seek.compressed_ofs[frame];
-  size_t uncompressed_size = zstd->seek.uncompressed_ofs[frame + 1] -
-                             zstd->seek.uncompressed_ofs[frame];
+static void zstd_decompress_frame_free(const void *__restrict UNUSED(userdata),
+                                       void *__restrict chunk)
+{
+  ZstdDecompressTLS *data_tls = (ZstdDecompressTLS *)chunk;
+  if (data_tls->ctx) {
+    ZSTD_freeDCtx(data_tls->ctx);
+  }
+}
+
+/**
+ * Read and decompress `frames_num` consecutive frames. All their compressed data is read at once,
+ * after which the frames are decompressed in parallel since they are independent of each other.
+ */
+static char *zstd_decompress_frames(ZstdReader *zstd, int first_frame, int frames_num)
+{
+  const int end_frame = first_frame + frames_num;
+  size_t compressed_size = zstd->seek.compressed_ofs[end_frame] -
+                           zstd->seek.compressed_ofs[first_frame];
+  size_t uncompressed_size = zstd->seek.uncompressed_ofs[end_frame] -
+                             zstd->seek.uncompressed_ofs[first_frame];
 
   char *uncompressed_data = MEM_mallocN(uncompressed_size, __func__);
   char *compressed_data = MEM_mallocN(compressed_size, __func__);
-  if (zstd->base->seek(zstd->base, zstd->seek.compressed_ofs[frame], SEEK_SET) < 0 ||
+  if (zstd->base->seek(zstd->base, zstd->seek.compressed_ofs[first_frame], SEEK_SET) < 0 ||
       zstd->base->read(zstd->base, compressed_data, compressed_size) < compressed_size)
   {
     MEM_freeN(compressed_data);
@@ -178,19 +252,93 @@ static const char *zstd_ensure_cache(ZstdReader *zstd, int frame)
     return NULL;
   }
 
-  size_t res = ZSTD_decompressDCtx(
-      zstd->ctx, uncompressed_data, uncompressed_size, compressed_data, compressed_size);
+  bool success;
+  if (frames_num == 1) {
+    size_t res = ZSTD_decompressDCtx(
+        zstd->ctx, uncompressed_data, uncompressed_size, compressed_data, compressed_size);
+    success = !ZSTD_isError(res) && res >= uncompressed_size;
+  }
+  else {
+    ZstdDecompressData data = {
+        .zstd = zstd,
+        .first_frame = first_frame,
+        .compressed_data = compressed_data,
+        .uncompressed_data = uncompressed_data,
+        .failed_frames_num = 0,
+    };
+    ZstdDecompressTLS data_tls = {NULL};
+
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.userdata_chunk = &data_tls;
+    settings.userdata_chunk_size = sizeof(data_tls);
+    settings.func_free = zstd_decompress_frame_free;
+    BLI_task_parallel_range(0, frames_num, &data, zstd_decompress_frame_task, &settings);
+    success = data.failed_frames_num == 0;
+  }
+
   MEM_freeN(compressed_data);
-  if (ZSTD_isError(res) || res < uncompressed_size) {
+  if (!success) {
     MEM_freeN(uncompressed_data);
     return NULL;
   }
-
-  zstd->seek.cached_frame = frame;
-  zstd->seek.cached_content = uncompressed_data;
   return uncompressed_data;
 }
 
+/**
+ * Ensure that one of the caches contains the given frame, and return that cache.
+ *
+ * When the frame directly follows the range of the cache that was used last, the file is
+ * probably being read sequentially. In that case the following frames are decompressed together
+ * with it, doubling the number of frames every time up to #ZSTD_MAX_PREFETCH_FRAMES. Random
+ * access only decompresses the requested frame, so that reading single blocks on demand doesn't
+ * become more expensive.
+ */
+static const ZstdFrameCache *zstd_ensure_cache(ZstdReader *zstd, int frame)
+{
+  for (int i = 0; i < 2; i++) {
+    ZstdFrameCache *cache = &zstd->seek.caches[i];
+    if (cache->first_frame >= 0 && frame >= cache->first_frame &&
+        frame < cache->first_frame + cache->frames_num)
+    {
+      /* Cached frame matches, so just return it. */
+      zstd->seek.last_cache = i;
+      return cache;
+    }
+  }
+
+  /* Cached frames don't match, so discard the least recently used ones and cache the wanted
+   * frames instead. */
+  const ZstdFrameCache *last_cache = &zstd->seek.caches[zstd->seek.last_cache];
+  int frames_num = 1;
+  if (last_cache->first_frame >= 0 && frame == last_cache->first_frame + last_cache->frames_num)
+  {
+    frames_num = min_ii(last_cache->frames_num * 2, ZSTD_MAX_PREFETCH_FRAMES);
+  }
+  frames_num = min_ii(frames_num, zstd->seek.frames_num - frame);
+
+  const int cache_index = 1 - zstd->seek.last_cache;
+  ZstdFrameCache *cache = &zstd->seek.caches[cache_index];
+  MEM_SAFE_FREE(cache->content);
+  cache->first_frame = -1;
+
+  char *uncompressed_data = zstd_decompress_frames(zstd, frame, frames_num);
+  if (uncompressed_data == NULL && frames_num > 1) {
+    /* Only fail when the requested frame itself can't be read. */
+    frames_num = 1;
+    uncompressed_data = zstd_decompress_frames(zstd, frame, frames_num);
+  }
+  if (uncompressed_data == NULL) {
+    return NULL;
+  }
+
+  cache->content = uncompressed_data;
+  cache->first_frame = frame;
+  cache->frames_num = frames_num;
+  zstd->seek.last_cache = cache_index;
+  return cache;
+}
+
 static int64_t zstd_read_seekable(FileReader *reader, void *buffer, size_t size)
 {
   ZstdReader *zstd = (ZstdReader *)reader;
@@ -203,17 +351,21 @@ static int64_t zstd_read_seekable(FileReader *reader, void *buffer, size_t size)
       break;
     }
 
-    const char *framedata = zstd_ensure_cache(zstd, frame);
-    if (framedata == NULL) {
+    const ZstdFrameCache *cache = zstd_ensure_cache(zstd, frame);
+    if (cache == NULL) {
       /* Error while reading the frame, so return as much as we can. */
       break;
     }
 
-    size_t frame_end_offset = min_zz(zstd->seek.uncompressed_ofs[frame + 1], end_offset);
+    /* Copy as much as possible from all the cached frames at once. */
+    const size_t cache_start_offset = zstd->seek.uncompressed_ofs[cache->first_frame];
+    const size_t cache_end_offset =
+        zstd->seek.uncompressed_ofs[cache->first_frame + cache->frames_num];
+    size_t frame_end_offset = min_zz(cache_end_offset, end_offset);
     size_t frame_read_len = frame_end_offset - zstd->reader.offset;
 
-    size_t offset_in_frame = zstd->reader.offset - zstd->seek.uncompressed_ofs[frame];
-    memcpy((char *)buffer + read_len, framedata + offset_in_frame, frame_read_len);
+    size_t offset_in_cache = zstd->reader.offset - cache_start_offset;
+    memcpy((char *)buffer + read_len, cache->content + offset_in_cache, frame_read_len);
     read_len += frame_read_len;
     zstd->reader.offset = frame_end_offset;
   }
@@ -282,8 +434,10 @@ static void zstd_close(FileReader *reader)
     MEM_freeN(zstd->seek.uncompressed_ofs);
     MEM_freeN(zstd->seek.compressed_ofs);
     /* When an error has occurred this may be NULL, see: #99744. */
-    if (zstd->seek.cached_content) {
-      MEM_freeN(zstd->seek.cached_content);
+    for (int i = 0; i < 2; i++) {
+      if (zstd->seek.caches[i].content) {
+        MEM_freeN(zstd->seek.caches[i].content);
+      }
     }
   }
   else {
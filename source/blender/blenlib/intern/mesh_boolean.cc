@@ -30,6 +30,7 @@
 #  include "BLI_stack.hh"
 #  include "BLI_task.hh"
 #  include "BLI_vector.hh"
+#  include "BLI_vector_set.hh"
 
 #  include "BLI_mesh_boolean.hh"
 
@@ -870,6 +871,39 @@ static const Vert *find_flap_vert(const Face &tri, const Edge e, bool *r_rev)
   return flapv;
 }
 
+/**
+ * Return the sign of #orient3d for the double approximations of exact coordinates, or 0 if the
+ * sign can't be determined reliably using doubles.
+ * The error bound uses the method of Burnikel et al. that is explained in more detail in
+ * mesh_intersect.cc. Inputs have index 1 (they are rounded from the exact values), and the
+ * index of the determinant is 11.
+ */
+static int filter_orient3d(const double3 &a, const double3 &b, const double3 &c, const double3 &d)
+{
+  constexpr int index_orient3d = 11;
+  const double3 ad = a - d;
+  const double3 bd = b - d;
+  const double3 cd = c - d;
+  const double det = ad[2] * (bd[0] * cd[1] - cd[0] * bd[1]) +
+                     bd[2] * (cd[0] * ad[1] - ad[0] * cd[1]) +
+                     cd[2] * (ad[0] * bd[1] - bd[0] * ad[1]);
+  if (det == 0.0) {
+    return 0;
+  }
+  const double3 abs_d = math::abs(d);
+  const double3 abs_ad = math::abs(a) + abs_d;
+  const double3 abs_bd = math::abs(b) + abs_d;
+  const double3 abs_cd = math::abs(c) + abs_d;
+  const double supremum = abs_ad[2] * (abs_bd[0] * abs_cd[1] + abs_cd[0] * abs_bd[1]) +
+                          abs_bd[2] * (abs_cd[0] * abs_ad[1] + abs_ad[0] * abs_cd[1]) +
+                          abs_cd[2] * (abs_ad[0] * abs_bd[1] + abs_bd[0] * abs_ad[1]);
+  const double err_bound = supremum * index_orient3d * DBL_EPSILON;
+  if (fabs(det) > err_bound) {
+    return det > 0 ? 1 : -1;
+  }
+  return 0;
+}
+
 /**
  * Triangle \a tri and tri0 share edge e.
  * Classify \a tri with respect to tri0 as described in
@@ -890,9 +924,6 @@ static int sort_tris_class(const Face &tri, const Face &tri0, const Edge e)
   if (dbg_level > 0) {
     std::cout << "classify  e = " << e << "\n";
   }
-  mpq3 a0 = tri0[0]->co_exact;
-  mpq3 a1 = tri0[1]->co_exact;
-  mpq3 a2 = tri0[2]->co_exact;
   bool rev;
   bool rev0;
   const Vert *flapv0 = find_flap_vert(tri0, e, &rev0);
@@ -904,9 +935,12 @@ static int sort_tris_class(const Face &tri, const Face &tri0, const Edge e)
     std::cout << " rev = " << rev << " flapv = " << flapv << "\n";
   }
   BLI_assert(flapv != nullptr && flapv0 != nullptr);
-  const mpq3 flap = flapv->co_exact;
-  /* orient will be positive if flap is below oriented plane of a0,a1,a2. */
-  int orient = orient3d(a0, a1, a2, flap);
+  /* orient will be positive if flap is below oriented plane of tri0.
+   * Only use exact arithmetic when the double approximation is not certain. */
+  int orient = filter_orient3d(tri0[0]->co, tri0[1]->co, tri0[2]->co, flapv->co);
+  if (orient == 0) {
+    orient = orient3d(tri0[0]->co_exact, tri0[1]->co_exact, tri0[2]->co_exact, flapv->co_exact);
+  }
   int ans;
   if (orient > 0) {
     ans = rev0 ? 4 : 3;
@@ -1065,27 +1099,23 @@ static Array<int> sort_tris_around_edge(
 }
 
 /**
- * Find the Cells around edge e.
+ * Find the Cells around edge e, given the triangles around it sorted by #sort_tris_around_edge.
  * This possibly makes new cells in \a cinfo, and sets up the
  * bipartite graph edges between cells and patches.
  * Will modify \a pinfo and \a cinfo and the patches and cells they contain.
  */
 static void find_cells_from_edge(const IMesh &tm,
-                                 const TriMeshTopology &tmtopo,
                                  PatchesInfo &pinfo,
                                  CellsInfo &cinfo,
-                                 const Edge e)
+                                 const Edge e,
+                                 const Span<int> sorted_tris)
 {
   const int dbg_level = 0;
   if (dbg_level > 0) {
     std::cout << "FIND_CELLS_FROM_EDGE " << e << "\n";
   }
-  const Vector<int> *edge_tris = tmtopo.edge_tris(e);
-  BLI_assert(edge_tris != nullptr);
-  Array<int> sorted_tris = sort_tris_around_edge(
-      tm, e, Span<int>(*edge_tris), (*edge_tris)[0], nullptr);
 
-  int n_edge_tris = edge_tris->size();
+  int n_edge_tris = sorted_tris.size();
   Array<int> edge_patches(n_edge_tris);
   for (int i = 0; i < n_edge_tris; ++i) {
     edge_patches[i] = pinfo.tri_patch(sorted_tris[i]);
@@ -1187,18 +1217,29 @@ static CellsInfo find_cells(const IMesh &tm, const TriMeshTopology &tmtopo, Patc
   }
   CellsInfo cinfo;
   /* For each unique edge shared between patch pairs, process it. */
-  Set<Edge> processed_edges;
+  VectorSet<Edge> edges;
   for (const auto item : pinfo.patch_patch_edge_map().items()) {
     int p = item.key.first;
     int q = item.key.second;
     if (p < q) {
-      const Edge &e = item.value;
-      if (!processed_edges.contains(e)) {
-        processed_edges.add_new(e);
-        find_cells_from_edge(tm, tmtopo, pinfo, cinfo, e);
-      }
+      edges.add(item.value);
     }
   }
+  /* Sorting the triangles around the edges is independent for every edge and is the expensive
+   * part, so do it in parallel. Building the cells from the sorted triangles is sequential. */
+  Array<Array<int>> edges_sorted_tris(edges.size());
+  threading::parallel_for(edges.index_range(), 256, [&](IndexRange range) {
+    for (const int i : range) {
+      const Edge e = edges[i];
+      const Vector<int> *edge_tris = tmtopo.edge_tris(e);
+      BLI_assert(edge_tris != nullptr);
+      edges_sorted_tris[i] = sort_tris_around_edge(
+          tm, e, Span<int>(*edge_tris), (*edge_tris)[0], nullptr);
+    }
+  });
+  for (const int i : edges.index_range()) {
+    find_cells_from_edge(tm, pinfo, cinfo, edges[i], edges_sorted_tris[i]);
+  }
   /* Some patches may have no cells at this point. These are either:
    * (a) a closed manifold patch only incident on itself (sphere, torus, klein bottle, etc.).
    * (b) an open manifold patch only incident on itself (has non-manifold boundaries).
@@ -4,7 +4,7 @@
 
 #include "testing/testing.h"
 
-/* TODO: ray intersection, overlap ... etc. */
+#include <algorithm>
 
 #include "MEM_guardedalloc.h"
 
@@ -12,6 +12,7 @@
 #include "BLI_kdopbvh.h"
 #include "BLI_math_vector.h"
 #include "BLI_rand.h"
+#include "BLI_vector.hh"
 
 /* -------------------------------------------------------------------- */
 /* Helper Functions */
@@ -134,3 +135,104 @@ TEST(kdopbvh, OptimalFindNearest_500)
 {
   find_nearest_points_test(500, 1.0, 1000, 12, true);
 }
+
+/* -------------------------------------------------------------------- */
+/* Overlap and ray-cast, compare binary trees with trees that test multiple children at once. */
+
+static BVHTree *random_boxes_tree(RNG *rng, int boxes_len, char tree_type)
+{
+  BVHTree *tree = BLI_bvhtree_new(boxes_len, 0.0, tree_type, 6);
+  for (int i = 0; i < boxes_len; i++) {
+    float co[2][3];
+    rng_v3_round(co[0], 3, rng, 1000, 1.0f);
+    rng_v3_round(co[1], 3, rng, 1000, 0.05f);
+    add_v3_v3(co[1], co[0]);
+    BLI_bvhtree_insert(tree, i, co[0], 2);
+  }
+  BLI_bvhtree_balance(tree);
+  return tree;
+}
+
+static void ray_cast_all_collect_callback(void *userdata,
+                                          int index,
+                                          const BVHTreeRay * /*ray*/,
+                                          BVHTreeRayHit * /*hit*/)
+{
+  blender::Vector<int> *indices = static_cast<blender::Vector<int> *>(userdata);
+  indices->append(index);
+}
+
+static blender::Vector<std::pair<int, int>> overlap_pairs(const BVHTree *tree, int flag)
+{
+  uint overlap_len = 0;
+  BVHTreeOverlap *overlap = BLI_bvhtree_overlap_ex(
+      tree, tree, &overlap_len, nullptr, nullptr, 0, BVH_OVERLAP_RETURN_PAIRS | flag);
+  blender::Vector<std::pair<int, int>> pairs;
+  for (int i = 0; i < int(overlap_len); i++) {
+    pairs.append({std::min(overlap[i].indexA, overlap[i].indexB),
+                  std::max(overlap[i].indexA, overlap[i].indexB)});
+  }
+  MEM_SAFE_FREE(overlap);
+  std::sort(pairs.begin(), pairs.end());
+  pairs.resize(std::unique(pairs.begin(), pairs.end()) - pairs.begin());
+  return pairs;
+}
+
+TEST(kdopbvh, TreeTypesMatch)
+{
+  const int boxes_len = 1000;
+  blender::Vector<BVHTree *> trees;
+  for (const char tree_type : {2, 4, 8, 16}) {
+    /* Use the same seed, so that all trees contain the same boxes. */
+    RNG *rng = BLI_rng_new(42);
+    trees.append(random_boxes_tree(rng, boxes_len, tree_type));
+    BLI_rng_free(rng);
+  }
+
+  const blender::Vector<std::pair<int, int>> reference_pairs = overlap_pairs(trees[0], 0);
+  EXPECT_FALSE(reference_pairs.is_empty());
+  for (const BVHTree *tree : trees.as_span().drop_front(1)) {
+    EXPECT_EQ(overlap_pairs(tree, 0), reference_pairs);
+    EXPECT_EQ(overlap_pairs(tree, BVH_OVERLAP_SELF), reference_pairs);
+  }
+
+  RNG *rng = BLI_rng_new(7);
+  int hits_num = 0;
+  for (int ray = 0; ray < 100; ray++) {
+    float co[3], dir[3];
+    rng_v3_round(co, 3, rng, 1000, 1.0f);
+    rng_v3_round(dir, 3, rng, 1000, 1.0f);
+    normalize_v3(dir);
+
+    blender::Vector<int> reference_indices;
+    float reference_dist_sq = 0.0f;
+    for (const int i : trees.index_range()) {
+      blender::Vector<int> indices;
+      BLI_bvhtree_ray_cast_all(
+          trees[i], co, dir, 0.0f, BVH_RAYCAST_DIST_MAX, ray_cast_all_collect_callback, &indices);
+      std::sort(indices.begin(), indices.end());
+
+      BVHTreeNearest nearest;
+      nearest.index = -1;
+      nearest.dist_sq = FLT_MAX;
+      BLI_bvhtree_find_nearest(trees[i], co, &nearest, nullptr, nullptr);
+      EXPECT_GE(nearest.index, 0);
+
+      if (i == 0) {
+        reference_indices = indices;
+        reference_dist_sq = nearest.dist_sq;
+        hits_num += int(indices.size());
+      }
+      else {
+        EXPECT_EQ(indices, reference_indices);
+        EXPECT_EQ(nearest.dist_sq, reference_dist_sq);
+      }
+    }
+  }
+  EXPECT_GT(hits_num, 0);
+  BLI_rng_free(rng);
+
+  for (BVHTree *tree : trees) {
+    BLI_bvhtree_free(tree);
+  }
+}
@@ -34,7 +34,10 @@ struct MemFileChunk {
   const char *buf;
   /** Size in bytes. */
   size_t size;
-  /** When true, this chunk doesn't own the memory, it's shared with a previous #MemFileChunk */
+  /**
+   * When true, this chunk is identical to the matching chunk of the previous step and shares its
+   * memory. Used by undo code to detect unchanged IDs.
+   */
   bool is_identical;
   /** When true, this chunk is also identical to the one in the next step (used by undo code to
    * detect unchanged IDs).
@@ -43,6 +46,13 @@ struct MemFileChunk {
   /** Session UID of the ID being currently written (MAIN_ID_SESSION_UID_UNSET when not writing
    * ID-related data). Used to find matching chunks in previous memundo step. */
   uint id_session_uid;
+  /**
+   * When true, this chunk doesn't own the memory, it's shared with another #MemFileChunk with the
+   * same content, from this or the previous step. Always true for identical chunks.
+   */
+  bool is_shared;
+  /** Hash of the content of the buffer, used to find chunks with the same content. */
+  uint64_t content_hash;
 };
 
 struct MemFile {
@@ -64,6 +74,16 @@ struct MemFileWriteData {
 
   /** Maps an ID session uid to its first reference MemFileChunk, if existing. */
   blender::Map<uint, MemFileChunk *> id_session_uid_mapping;
+  /**
+   * Maps content hashes to chunks of the reference and the written memfile, so that chunks with
+   * the same content can share memory regardless of their position.
+   */
+  blender::Map<uint64_t, MemFileChunk *> chunk_by_content_hash;
+
+  /** Number of bytes shared with the matching chunks of the reference memfile. */
+  size_t identical_size;
+  /** Number of bytes shared with other chunks with the same content. */
+  size_t shared_by_content_size;
 };
 
 struct MemFileUndoData {
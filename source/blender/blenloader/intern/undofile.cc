@@ -20,8 +20,12 @@
 #  include <io.h>
 #endif
 
+#include <xxhash.h>
+
 #include "MEM_guardedalloc.h"
 
+#include "CLG_log.h"
+
 #include "DNA_listBase.h"
 
 #include "BLI_blenlib.h"
@@ -36,12 +40,14 @@
 
 #include "BLI_strict_flags.h" /* Keep last. */
 
+static CLG_LogRef LOG = {"blo.undofile"};
+
 /* **************** support for memory-write, for undo buffers *************** */
 
 void BLO_memfile_free(MemFile *memfile)
 {
   while (MemFileChunk *chunk = static_cast<MemFileChunk *>(BLI_pophead(&memfile->chunks))) {
-    if (chunk->is_identical == false) {
+    if (chunk->is_shared == false) {
       MEM_freeN((void *)chunk->buf);
     }
     MEM_freeN(chunk);
@@ -67,7 +73,7 @@ void BLO_memfile_merge(MemFile *first, MemFile *second)
 
   /* First, detect all memchunks in second memfile that are not owned by it. */
   LISTBASE_FOREACH (MemFileChunk *, sc, &second->chunks) {
-    if (sc->is_identical) {
+    if (sc->is_shared) {
       buffer_to_second_memchunk.add(sc->buf, sc);
     }
   }
@@ -75,11 +81,12 @@ void BLO_memfile_merge(MemFile *first, MemFile *second)
   /* Now, check all chunks from first memfile (the one we are removing), and if a memchunk owned by
    * it is also used by the second memfile, transfer the ownership. */
   LISTBASE_FOREACH (MemFileChunk *, fc, &first->chunks) {
-    if (!fc->is_identical) {
+    if (!fc->is_shared) {
       if (MemFileChunk *sc = buffer_to_second_memchunk.lookup_default(fc->buf, nullptr)) {
-        BLI_assert(sc->is_identical);
+        BLI_assert(sc->is_shared);
         sc->is_identical = false;
-        fc->is_identical = true;
+        sc->is_shared = false;
+        fc->is_shared = true;
       }
       /* Note that if the second memfile does not use that chunk, we assume that the first one
        * fully owns it without sharing it with any other memfile, and hence it should be freed with
@@ -107,10 +114,17 @@ void BLO_memfile_write_init(MemFileWriteData *mem_data,
                                                               reference_memfile->chunks.first) :
                                                           nullptr;
 
+  mem_data->identical_size = 0;
+  mem_data->shared_by_content_size = 0;
+
   /* If we have a reference memfile, we generate a mapping between the session_uid's of the
    * IDs stored in that previous undo step, and its first matching memchunk. This will allow
    * us to easily find the existing undo memory storage of IDs even when some re-ordering in
    * current Main data-base broke the order matching with the memchunks from previous step.
+   *
+   * All chunks of the previous step are also indexed by their content, so that data that moved
+   * to another position (e.g. because it is now written as part of another ID or in another
+   * order) can still share memory.
    */
   if (reference_memfile != nullptr) {
     uint current_session_uid = MAIN_ID_SESSION_UID_UNSET;
@@ -119,13 +133,23 @@ void BLO_memfile_write_init(MemFileWriteData *mem_data,
         current_session_uid = mem_chunk->id_session_uid;
         mem_data->id_session_uid_mapping.add_new(current_session_uid, mem_chunk);
       }
+      mem_data->chunk_by_content_hash.add(mem_chunk->content_hash, mem_chunk);
     }
   }
 }
 
 void BLO_memfile_write_finalize(MemFileWriteData *mem_data)
 {
+  const MemFile *memfile = mem_data->written_memfile;
+  CLOG_INFO(&LOG,
+            1,
+            "Unique bytes: %zu, identical bytes: %zu, bytes shared by content: %zu",
+            memfile->size,
+            mem_data->identical_size,
+            mem_data->shared_by_content_size);
+
   mem_data->id_session_uid_mapping.clear_and_shrink();
+  mem_data->chunk_by_content_hash.clear_and_shrink();
 }
 
 void BLO_memfile_chunk_add(MemFileWriteData *mem_data, const char *buf, size_t size)
@@ -138,6 +162,7 @@ void BLO_memfile_chunk_add(MemFileWriteData *mem_data, const char *buf, size_t s
   curchunk->size = size;
   curchunk->buf = nullptr;
   curchunk->is_identical = false;
+  curchunk->is_shared = false;
   /* This is unsafe in the sense that an app handler or other code that does not
    * perform an undo push may make changes after the last undo push that
    * will then not be undo. Though it's not entirely clear that is wrong behavior. */
@@ -152,19 +177,39 @@ void BLO_memfile_chunk_add(MemFileWriteData *mem_data, const char *buf, size_t s
       if (memcmp(compchunk->buf, buf, size) == 0) {
         curchunk->buf = compchunk->buf;
         curchunk->is_identical = true;
+        curchunk->is_shared = true;
+        curchunk->content_hash = compchunk->content_hash;
         compchunk->is_identical_future = true;
+        mem_data->identical_size += size;
       }
     }
     *compchunk_step = static_cast<MemFileChunk *>(compchunk->next);
   }
 
-  /* not equal... */
-  if (curchunk->buf == nullptr) {
-    char *buf_new = static_cast<char *>(MEM_mallocN(size, "Chunk buffer"));
-    memcpy(buf_new, buf, size);
-    curchunk->buf = buf_new;
-    memfile->size += size;
+  if (curchunk->buf != nullptr) {
+    return;
   }
+
+  /* Not equal, but the same data may still exist elsewhere in this or the previous step.
+   * Such chunks share memory, but are not considered identical since they belong to another
+   * position in the file (and possibly another ID). */
+  curchunk->content_hash = XXH3_64bits(buf, size);
+  if (const MemFileChunk *other_chunk = mem_data->chunk_by_content_hash.lookup_default(
+          curchunk->content_hash, nullptr))
+  {
+    if (other_chunk->size == size && memcmp(other_chunk->buf, buf, size) == 0) {
+      curchunk->buf = other_chunk->buf;
+      curchunk->is_shared = true;
+      mem_data->shared_by_content_size += size;
+      return;
+    }
+  }
+
+  char *buf_new = static_cast<char *>(MEM_mallocN(size, "Chunk buffer"));
+  memcpy(buf_new, buf, size);
+  curchunk->buf = buf_new;
+  memfile->size += size;
+  mem_data->chunk_by_content_hash.add(curchunk->content_hash, curchunk);
 }
 
 Main *BLO_memfile_main_get(MemFile *memfile, Main *bmain, Scene **r_scene)
@@ -16,6 +16,7 @@
 
 #include "DNA_anim_types.h"
 #include "DNA_brush_types.h"
+#include "DNA_cachefile_types.h"
 #include "DNA_camera_types.h"
 #include "DNA_curve_types.h"
 #include "DNA_defaults.h"
@@ -4163,6 +4164,14 @@ void blo_do_versions_400(FileData *fd, Library * /*lib*/, Main *bmain)
     FOREACH_NODETREE_END;
   }
 
+  if (!MAIN_VERSION_FILE_ATLEAST(bmain, 403, 2)) {
+    if (!DNA_struct_member_exists(fd->filesdna, "CacheFile", "int", "prefetch_frames")) {
+      LISTBASE_FOREACH (CacheFile *, cache_file, &bmain->cachefiles) {
+        cache_file->prefetch_frames = 8;
+      }
+    }
+  }
+
   /**
    * Always bump subversion in BKE_blender_version.h when adding versioning
    * code here, and wrap it inside a MAIN_VERSION_FILE_ATLEAST check.
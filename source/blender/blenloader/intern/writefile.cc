@@ -58,6 +58,7 @@
  *   - #BLENDER_USERPREF_FILE (on UNIX `~/.config/blender/X.X/config/userpref.blend`).
  */
 
+#include <atomic>
 #include <cerrno>
 #include <climits>
 #include <cmath>
@@ -87,6 +88,7 @@
 #include "DNA_key_types.h"
 #include "DNA_sdna_types.h"
 
+#include "BLI_array.hh"
 #include "BLI_bitmap.h"
 #include "BLI_blenlib.h"
 #include "BLI_endian_defines.h"
@@ -96,7 +98,9 @@
 #include "BLI_linklist.h"
 #include "BLI_math_base.h"
 #include "BLI_mempool.h"
+#include "BLI_task.hh"
 #include "BLI_threads.h"
+#include "BLI_vector.hh"
 
 #include "MEM_guardedalloc.h" /* MEM_freeN */
 
@@ -143,6 +147,9 @@
 
 #define ZSTD_COMPRESSION_LEVEL 3
 
+/* Serialized data of IDs that is kept in memory until it is written, see #write_ids_parallel. */
+#define PARALLEL_PENDING_SIZE_MAX (1 << 26) /* 64mb */
+
 static CLG_LogRef LOG = {"blo.writefile"};
 
 /** Use if we want to store how many bytes have been written to the file. */
@@ -396,6 +403,17 @@ bool ZstdWriteWrap::write(const void *buf, size_t buf_len)
 /** \name Write Data Type & Functions
  * \{ */
 
+/**
+ * Data written for a single ID into its own stream, so that IDs can be serialized in parallel
+ * and written to the file in order afterwards.
+ */
+struct WriteIDStream {
+  /** All data written for the ID. */
+  blender::Vector<uchar> data;
+  /** Size of every #mywrite call, to replay them with exactly the same buffering. */
+  blender::Vector<size_t> write_sizes;
+};
+
 struct WriteData {
   const SDNA *sdna;
 
@@ -424,6 +442,12 @@ struct WriteData {
   /** When true, write to #WriteData.current, could also call 'is_undo'. */
   bool use_memfile;
 
+  /**
+   * When set, all data is recorded in this stream instead of being written,
+   * see #write_ids_parallel.
+   */
+  WriteIDStream *id_stream;
+
   /**
    * Wrap writing, so we can use zstd or
    * other compression types later, see: G_FILE_COMPRESS
@@ -459,6 +483,18 @@ static WriteData *writedata_new(WriteWrap *ww)
   return wd;
 }
 
+/**
+ * Create write data that records everything written into \a id_stream,
+ * using the same DNA as \a wd_parent.
+ */
+static WriteData *writedata_new_for_id_stream(const WriteData *wd_parent, WriteIDStream *id_stream)
+{
+  WriteData *wd = MEM_new<WriteData>(__func__);
+  wd->sdna = wd_parent->sdna;
+  wd->id_stream = id_stream;
+  return wd;
+}
+
 static void writedata_do_write(WriteData *wd, const void *mem, size_t memlen)
 {
   if ((wd == nullptr) || wd->error || (mem == nullptr) || memlen < 1) {
@@ -527,6 +563,12 @@ static void mywrite(WriteData *wd, const void *adr, size_t len)
     return;
   }
 
+  if (wd->id_stream != nullptr) {
+    wd->id_stream->data.extend(blender::Span(static_cast<const uchar *>(adr), int64_t(len)));
+    wd->id_stream->write_sizes.append(len);
+    return;
+  }
+
 #ifdef USE_WRITE_DATA_LEN
   wd->write_len += len;
 #endif
@@ -565,6 +607,18 @@ static void mywrite(WriteData *wd, const void *adr, size_t len)
   }
 }
 
+/**
+ * Write all data recorded in \a id_stream, as if it was written with #mywrite directly.
+ */
+static void mywrite_id_stream(WriteData *wd, const WriteIDStream &id_stream)
+{
+  const uchar *data = id_stream.data.data();
+  for (const size_t len : id_stream.write_sizes) {
+    mywrite(wd, data, len);
+    data += len;
+  }
+}
+
 /**
  * BeGiN initializer for mywrite
  * \param ww: File write wrapper.
@@ -1212,6 +1266,74 @@ static int write_id_direct_linked_data_process_cb(LibraryIDLinkCallbackData *cb_
   return IDWALK_RET_NOP;
 }
 
+/**
+ * ID types that can be serialized from multiple threads. Their `blend_write` callbacks only modify
+ * the ID copy they are given and data owned by it. Callbacks of other types may still update data
+ * shared with other IDs, e.g. #BKE_view_layer_blend_write ensures the synced bases of a scene.
+ */
+static bool write_id_type_supports_parallel(const short id_code)
+{
+  return ELEM(id_code, ID_ME, ID_CV, ID_PT, ID_LT, ID_AC);
+}
+
+/**
+ * Serialize IDs of the same type into separate streams in parallel, and write these streams in
+ * the original order of the IDs afterwards. The resulting file is the same as when the IDs are
+ * written one after another.
+ *
+ * Threads stop serializing more IDs once #PARALLEL_PENDING_SIZE_MAX bytes are waiting to be
+ * written, so at most one more ID per thread is kept in memory.
+ *
+ * Only used when writing files, undo steps compare the data of each ID with the previous
+ * #MemFile while it is being written.
+ */
+static void write_ids_parallel(WriteData *wd,
+                               const IDTypeInfo *id_type,
+                               const blender::Span<ID *> ids)
+{
+  using namespace blender;
+  BLI_assert(!wd->use_memfile);
+  BLI_assert(write_id_type_supports_parallel(id_type->id_code));
+
+  Array<WriteIDStream> id_streams(ids.size());
+  std::atomic<int64_t> next_id = 0;
+  int64_t ids_written = 0;
+  while (ids_written < ids.size()) {
+    std::atomic<size_t> pending_size = 0;
+    threading::parallel_for(IndexRange(BLI_system_thread_count()), 1, [&](const IndexRange) {
+      BLO_Write_IDBuffer *id_buffer = BLO_write_allocate_id_buffer();
+      id_buffer_init_for_id_type(id_buffer, id_type);
+      while (pending_size < PARALLEL_PENDING_SIZE_MAX) {
+        const int64_t i = next_id.fetch_add(1);
+        if (i >= ids.size()) {
+          break;
+        }
+        ID *id = ids[i];
+        WriteData *id_wd = writedata_new_for_id_stream(wd, &id_streams[i]);
+        BlendWriter writer = {id_wd};
+
+        id_buffer_init_from_id(id_buffer, id, false);
+        if (id_type->blend_write != nullptr) {
+          id_type->blend_write(&writer, static_cast<ID *>(id_buffer->temp_id), id);
+        }
+
+        writedata_free(id_wd);
+        pending_size += id_streams[i].data.size();
+      }
+      BLO_write_destroy_id_buffer(&id_buffer);
+    });
+
+    /* IDs are claimed in order, so all IDs up to the last claimed one are serialized. */
+    const int64_t ids_serialized = std::min<int64_t>(next_id, ids.size());
+    next_id = ids_serialized;
+    for (const int64_t i : IndexRange::from_begin_end(ids_written, ids_serialized)) {
+      mywrite_id_stream(wd, id_streams[i]);
+      id_streams[i] = {};
+    }
+    ids_written = ids_serialized;
+  }
+}
+
 /**
  * When #MemFile arguments are non-null, this is a file-safe to memory.
  *
@@ -1298,6 +1420,8 @@ static bool write_file_handle(Main *mainvar,
    * if needed, without duplicating whole code. */
   Main *bmain = mainvar;
   BLO_Write_IDBuffer *id_buffer = BLO_write_allocate_id_buffer();
+  /* When writing a file, consecutive IDs of some types are serialized in parallel. */
+  blender::Vector<ID *> parallel_ids;
   do {
     ListBase *lbarray[INDEX_ID_MAX];
     int a = set_listbasepointers(bmain, lbarray);
@@ -1310,6 +1434,9 @@ static bool write_file_handle(Main *mainvar,
 
       const IDTypeInfo *id_type = BKE_idtype_get_info_from_id(id);
       id_buffer_init_for_id_type(id_buffer, id_type);
+      /* There is nothing to gain from separate streams without multiple threads. */
+      const bool use_parallel = !wd->use_memfile && BLI_system_thread_count() > 1 &&
+                                write_id_type_supports_parallel(id_type->id_code);
 
       for (; id; id = static_cast<ID *>(id->next)) {
         /* We should never attempt to write non-regular IDs
@@ -1363,6 +1490,17 @@ static bool write_file_handle(Main *mainvar,
                                       IDWALK_READONLY | IDWALK_INCLUDE_UI);
         }
 
+        /* Overrides are written sequentially, the override storage is not thread-safe. */
+        if (use_parallel && !do_override) {
+          /* The ID itself is written later, together with the following IDs of this type. */
+          parallel_ids.append(id);
+          continue;
+        }
+        if (!parallel_ids.is_empty()) {
+          write_ids_parallel(wd, id_type, parallel_ids);
+          parallel_ids.clear();
+        }
+
         if (do_override) {
           BKE_lib_override_library_operations_store_start(bmain, override_storage, id);
         }
@@ -1382,6 +1520,11 @@ static bool write_file_handle(Main *mainvar,
         mywrite_id_end(wd, id);
       }
 
+      if (!parallel_ids.is_empty()) {
+        write_ids_parallel(wd, id_type, parallel_ids);
+        parallel_ids.clear();
+      }
+
       mywrite_flush(wd);
     }
   } while ((bmain != override_storage) && (bmain = override_storage));
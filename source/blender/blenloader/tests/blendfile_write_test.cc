@@ -0,0 +1,70 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+#include "blendfile_loading_base_test.h"
+
+#include <string>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_fileops.h"
+#include "BLI_path_util.h"
+#include "BLI_threads.h"
+
+#include "BKE_appdir.hh"
+#include "BKE_lib_id.hh"
+#include "BKE_main.hh"
+
+#include "BLO_readfile.hh"
+#include "BLO_writefile.hh"
+
+#include "DNA_mesh_types.h"
+
+class BlendfileWriteTest : public BlendfileLoadingBaseTest {
+ protected:
+  /** Write the loaded file and return its content. */
+  std::string write(const char *filename)
+  {
+    BKE_tempdir_init(nullptr);
+    char filepath[FILE_MAX];
+    BLI_path_join(filepath, sizeof(filepath), BKE_tempdir_session(), filename);
+
+    BlendFileWriteParams params{};
+    EXPECT_TRUE(BLO_write_file(bfile->main, filepath, 0, &params, nullptr));
+
+    size_t size = 0;
+    char *data = static_cast<char *>(BLI_file_read_binary_as_mem(filepath, 0, &size));
+    if (data == nullptr) {
+      ADD_FAILURE() << "Unable to read written file '" << filepath << "'";
+      return {};
+    }
+    std::string content(data, size);
+    MEM_freeN(data);
+    BLI_delete(filepath, false, false);
+    return content;
+  }
+};
+
+TEST_F(BlendfileWriteTest, ParallelWriteMatchesSerialWrite)
+{
+  if (!blendfile_load("modifier_stack" SEP_STR "array_test.blend")) {
+    return;
+  }
+
+  /* Add more meshes, so that several IDs of the same type are serialized in parallel. */
+  Mesh *mesh = static_cast<Mesh *>(bfile->main->meshes.first);
+  ASSERT_NE(mesh, nullptr);
+  for (int i = 0; i < 16; i++) {
+    ID *mesh_copy = BKE_id_copy(bfile->main, &mesh->id);
+    id_us_plus(mesh_copy);
+  }
+
+  /* IDs are only serialized in parallel when multiple threads are used. */
+  BLI_system_num_threads_override_set(1);
+  const std::string serial = write("serial.blend");
+  BLI_system_num_threads_override_set(0);
+  const std::string parallel = write("parallel.blend");
+
+  EXPECT_FALSE(serial.empty());
+  EXPECT_TRUE(serial == parallel);
+}
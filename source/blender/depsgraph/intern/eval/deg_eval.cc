@@ -8,14 +8,20 @@
  * Evaluation engine entry-points for Depsgraph Engine.
  */
 
+#include <algorithm>
+#include <mutex>
+
 #include "intern/eval/deg_eval.h"
 
 #include "BLI_compiler_attrs.h"
 #include "BLI_function_ref.hh"
 #include "BLI_gsqueue.h"
+#include "BLI_stack.hh"
 #include "BLI_task.h"
+#include "BLI_threads.h"
 #include "BLI_time.h"
 #include "BLI_utildefines.h"
+#include "BLI_vector.hh"
 
 #include "BKE_global.hh"
 
@@ -52,6 +58,7 @@ namespace {
 struct DepsgraphEvalState;
 
 void deg_task_run_func(TaskPool *pool, void *taskdata);
+void deg_task_run_ready_func(TaskPool *pool, void *taskdata);
 
 void schedule_children(DepsgraphEvalState *state,
                        OperationNode *node,
@@ -77,29 +84,50 @@ enum class EvaluationStage {
   SINGLE_THREADED_WORKAROUND,
 };
 
+/* Weight of the latest measurement in #OperationNode.eval_time_average. */
+constexpr float eval_time_average_factor = 0.25f;
+/* Time added to every operation when calculating the critical path, so that the length of the
+ * chain is taken into account for operations which were never evaluated or are very cheap. */
+constexpr float operation_overhead_time = 1e-6f;
+
 struct DepsgraphEvalState {
   Depsgraph *graph;
   bool do_stats;
   EvaluationStage stage;
   bool need_update_pending_parents = true;
   bool need_single_thread_pass = false;
+
+  /* When true, operations which are ready for evaluation are put into #ready_operations and the
+   * task pool only receives tasks which evaluate the operation with the longest remaining
+   * critical path. Otherwise the operations are pushed to the task pool directly. */
+  bool use_critical_path = false;
+  std::mutex ready_operations_mutex;
+  /* Heap of operations ordered by #OperationNode.critical_path_time. */
+  Vector<OperationNode *> ready_operations;
 };
 
+bool operation_critical_path_less(const OperationNode *a, const OperationNode *b)
+{
+  return a->critical_path_time < b->critical_path_time;
+}
+
 void evaluate_node(const DepsgraphEvalState *state, OperationNode *operation_node)
 {
   ::Depsgraph *depsgraph = reinterpret_cast<::Depsgraph *>(state->graph);
 
   /* Sanity checks. */
   BLI_assert_msg(!operation_node->is_noop(), "NOOP nodes should not actually be scheduled");
-  /* Perform operation. */
+  /* Perform operation. The timing is always gathered, as it is used to prioritize operations in
+   * subsequent evaluations. */
+  const double start_time = BLI_time_now_seconds();
+  operation_node->evaluate(depsgraph);
+  const double eval_time = BLI_time_now_seconds() - start_time;
   if (state->do_stats) {
-    const double start_time = BLI_time_now_seconds();
-    operation_node->evaluate(depsgraph);
-    operation_node->stats.current_time += BLI_time_now_seconds() - start_time;
-  }
-  else {
-    operation_node->evaluate(depsgraph);
+    operation_node->stats.current_time += eval_time;
   }
+  /* Only this thread accesses the operation node until its children are scheduled. */
+  operation_node->eval_time_average += (float(eval_time) - operation_node->eval_time_average) *
+                                       eval_time_average_factor;
 
   /* Clear the flag early on, allowing partial updates without re-evaluating the same node multiple
    * times.
@@ -123,6 +151,42 @@ void deg_task_run_func(TaskPool *pool, void *taskdata)
   });
 }
 
+void schedule_ready_operation(DepsgraphEvalState *state, TaskPool *pool, OperationNode *node)
+{
+  {
+    std::lock_guard lock{state->ready_operations_mutex};
+    state->ready_operations.append(node);
+    std::push_heap(state->ready_operations.begin(),
+                   state->ready_operations.end(),
+                   operation_critical_path_less);
+  }
+  /* The task does not necessarily evaluate this node, but the most important ready one. */
+  BLI_task_pool_push(pool, deg_task_run_ready_func, nullptr, false, nullptr);
+}
+
+void deg_task_run_ready_func(TaskPool *pool, void * /*taskdata*/)
+{
+  void *userdata_v = BLI_task_pool_user_data(pool);
+  DepsgraphEvalState *state = (DepsgraphEvalState *)userdata_v;
+
+  /* There is exactly one task for every ready operation, so the heap can't be empty here. */
+  OperationNode *operation_node;
+  {
+    std::lock_guard lock{state->ready_operations_mutex};
+    BLI_assert(!state->ready_operations.is_empty());
+    std::pop_heap(state->ready_operations.begin(),
+                  state->ready_operations.end(),
+                  operation_critical_path_less);
+    operation_node = state->ready_operations.pop_last();
+  }
+
+  evaluate_node(state, operation_node);
+
+  schedule_children(state, operation_node, [&](OperationNode *node) {
+    schedule_ready_operation(state, pool, node);
+  });
+}
+
 bool check_operation_node_visible(const DepsgraphEvalState *state, OperationNode *op_node)
 {
   const ComponentNode *comp_node = op_node->owner;
@@ -186,6 +250,59 @@ void calculate_pending_parents_if_needed(DepsgraphEvalState *state)
   state->need_update_pending_parents = false;
 }
 
+bool need_update_operation(const DepsgraphEvalState *state, OperationNode *node)
+{
+  return check_operation_node_visible(state, node) && (node->flag & DEPSOP_FLAG_NEEDS_UPDATE);
+}
+
+/* Calculate #OperationNode.critical_path_time of all operations which are to be evaluated, based
+ * on the evaluation times measured in previous evaluations. Operations are visited in reverse
+ * topological order, so that all children are known when a node is visited. */
+void calculate_critical_path_times(const DepsgraphEvalState *state)
+{
+  Vector<OperationNode *> nodes;
+  for (OperationNode *node : state->graph->operations) {
+    if (need_update_operation(state, node)) {
+      nodes.append(node);
+    }
+  }
+
+  Stack<OperationNode *> nodes_to_visit;
+  for (OperationNode *node : nodes) {
+    node->critical_path_time = 0.0f;
+    node->num_children_pending = 0;
+    for (Relation *rel : node->outlinks) {
+      OperationNode *child = (OperationNode *)rel->to;
+      if ((rel->flag & RELATION_FLAG_CYCLIC) == 0 && need_update_operation(state, child)) {
+        node->num_children_pending++;
+      }
+    }
+    if (node->num_children_pending == 0) {
+      nodes_to_visit.push(node);
+    }
+  }
+
+  while (!nodes_to_visit.is_empty()) {
+    OperationNode *node = nodes_to_visit.pop();
+    /* The children have accumulated their maximum critical path already. */
+    node->critical_path_time += node->eval_time_average + operation_overhead_time;
+    for (Relation *rel : node->inlinks) {
+      if (rel->from->type != NodeType::OPERATION || (rel->flag & RELATION_FLAG_CYCLIC) != 0) {
+        continue;
+      }
+      OperationNode *parent = (OperationNode *)rel->from;
+      if (!need_update_operation(state, parent)) {
+        continue;
+      }
+      parent->critical_path_time = std::max(parent->critical_path_time, node->critical_path_time);
+      BLI_assert(parent->num_children_pending > 0);
+      if (--parent->num_children_pending == 0) {
+        nodes_to_visit.push(parent);
+      }
+    }
+  }
+}
+
 void initialize_execution(DepsgraphEvalState *state, Depsgraph *graph)
 {
   /* Clear tags and other things which needs to be clear. */
@@ -317,10 +434,26 @@ void evaluate_graph_threaded_stage(DepsgraphEvalState *state,
 
   calculate_pending_parents_if_needed(state);
 
-  schedule_graph(state, [&](OperationNode *node) {
-    BLI_task_pool_push(task_pool, deg_task_run_func, node, false, nullptr);
-  });
+  /* Ordering by the critical path only helps when the heavy part of the graph is evaluated using
+   * multiple threads. */
+  state->use_critical_path = stage == EvaluationStage::THREADED_EVALUATION &&
+                             (G.debug & G_DEBUG_DEPSGRAPH_NO_THREADS) == 0 &&
+                             BLI_system_thread_count() > 1;
+
+  if (state->use_critical_path) {
+    calculate_critical_path_times(state);
+    schedule_graph(state, [&](OperationNode *node) {
+      schedule_ready_operation(state, task_pool, node);
+    });
+  }
+  else {
+    schedule_graph(state, [&](OperationNode *node) {
+      BLI_task_pool_push(task_pool, deg_task_run_func, node, false, nullptr);
+    });
+  }
   BLI_task_pool_work_and_wait(task_pool);
+  BLI_assert(state->ready_operations.is_empty());
+  state->use_critical_path = false;
 }
 
 /* Evaluate remaining operations of the dependency graph in a single threaded manner. */
@@ -300,8 +300,11 @@ bool id_copy_inplace_no_main(const ID *id, ID *newid)
 }
 
 /* Similar to BKE_scene_copy() but does not require main and assumes pointer
- * is already allocated. */
-bool scene_copy_inplace_no_main(const Scene *scene, Scene *new_scene)
+ * is already allocated.
+ *
+ * When copy_sequencer is false the sequencer editing data is not copied, the caller is responsible
+ * for providing it. */
+bool scene_copy_inplace_no_main(const Scene *scene, Scene *new_scene, const bool copy_sequencer)
 {
 
   if (G.debug & G_DEBUG_DEPSGRAPH_UID) {
@@ -311,8 +314,17 @@ bool scene_copy_inplace_no_main(const Scene *scene, Scene *new_scene)
 #ifdef NESTED_ID_NASTY_WORKAROUND
   NestedIDHackTempStorage id_hack_storage;
   const ID *id_for_copy = nested_id_hack_get_discarded_pointers(&id_hack_storage, &scene->id);
+  if (!copy_sequencer) {
+    id_hack_storage.scene.ed = nullptr;
+  }
 #else
+  Scene scene_for_copy;
   const ID *id_for_copy = &scene->id;
+  if (!copy_sequencer) {
+    scene_for_copy = *scene;
+    scene_for_copy.ed = nullptr;
+    id_for_copy = &scene_for_copy.id;
+  }
 #endif
   bool result = (BKE_id_copy_ex(nullptr,
                                 id_for_copy,
@@ -764,8 +776,13 @@ int foreach_libblock_validate_callback(LibraryIDLinkCallbackData *cb_data)
 /* Actual implementation of logic which "expands" all the data which was not
  * yet copied-on-eval.
  *
+ * When copy_sequencer is false, the sequencer data of scenes is skipped, see
+ * #scene_can_keep_eval_sequencer.
+ *
  * NOTE: Expects that evaluated datablock is empty. */
-ID *deg_expand_eval_copy_datablock(const Depsgraph *depsgraph, const IDNode *id_node)
+ID *deg_expand_eval_copy_datablock(const Depsgraph *depsgraph,
+                                   const IDNode *id_node,
+                                   const bool copy_sequencer = true)
 {
   const ID *id_orig = id_node->id_orig;
   ID *id_cow = id_node->id_cow;
@@ -801,7 +818,7 @@ ID *deg_expand_eval_copy_datablock(const Depsgraph *depsgraph, const IDNode *id_
   const ID_Type id_type = GS(id_orig->name);
   switch (id_type) {
     case ID_SCE: {
-      done = scene_copy_inplace_no_main((Scene *)id_orig, (Scene *)id_cow);
+      done = scene_copy_inplace_no_main((Scene *)id_orig, (Scene *)id_cow, copy_sequencer);
       if (done) {
         /* NOTE: This is important to do before remap, because this
          * function will make it so less IDs are to be remapped. */
@@ -855,6 +872,27 @@ ID *deg_expand_eval_copy_datablock(const Depsgraph *depsgraph, const IDNode *id_
   return id_cow;
 }
 
+/* Check whether the already copied sequencer data of the evaluated scene is still valid, so that
+ * it can be kept instead of being copied again. Scenes with many strips are expensive to copy, and
+ * are tagged for copy-on-evaluation for unrelated reasons, such as object selection changes.
+ *
+ * Modifications of the strips tag the scene with #ID_RECALC_SEQUENCER_STRIPS, or tag the
+ * copy-on-evaluation component explicitly (for example from RNA property updates). Relations
+ * updates also tag the strips, so the ID pointers of the kept strips are valid. */
+bool scene_can_keep_eval_sequencer(const IDNode *id_node)
+{
+  const Scene *scene_orig = reinterpret_cast<const Scene *>(id_node->id_orig);
+  const Scene *scene_cow = reinterpret_cast<const Scene *>(id_node->id_cow);
+  if (!check_datablock_expanded(&scene_cow->id) || id_node->is_cow_explicitly_tagged) {
+    return false;
+  }
+  if (scene_orig->ed == nullptr || scene_cow->ed == nullptr) {
+    return false;
+  }
+  return (scene_cow->id.recalc &
+          (ID_RECALC_SEQUENCER_STRIPS | ID_RECALC_AUDIO | ID_RECALC_AUDIO_FPS)) == 0;
+}
+
 }  // namespace
 
 ID *deg_update_eval_copy_datablock(const Depsgraph *depsgraph, const IDNode *id_node)
@@ -898,10 +936,22 @@ ID *deg_update_eval_copy_datablock(const Depsgraph *depsgraph, const IDNode *id_
     }
   }
 
+  /* Detach the sequencer data which is kept before the runtime backup, so that the runtime data
+   * of the strips stays where it is. */
+  Editing *kept_sequencer_editing = nullptr;
+  if (GS(id_orig->name) == ID_SCE && scene_can_keep_eval_sequencer(id_node)) {
+    Scene *scene_cow = reinterpret_cast<Scene *>(id_cow);
+    kept_sequencer_editing = scene_cow->ed;
+    scene_cow->ed = nullptr;
+  }
+
   RuntimeBackup backup(depsgraph);
   backup.init_from_id(id_cow);
   deg_free_eval_copy_datablock(id_cow);
-  deg_expand_eval_copy_datablock(depsgraph, id_node);
+  deg_expand_eval_copy_datablock(depsgraph, id_node, kept_sequencer_editing == nullptr);
+  if (kept_sequencer_editing) {
+    reinterpret_cast<Scene *>(id_cow)->ed = kept_sequencer_editing;
+  }
   backup.restore_to_id(id_cow);
   return id_cow;
 }
@@ -281,6 +281,14 @@ struct OperationNode : public Node {
   uint32_t num_links_pending;
   bool scheduled;
 
+  /* Moving average of the time spent in #evaluate, in seconds. Kept across evaluations. */
+  float eval_time_average;
+  /* Estimated time needed to evaluate this operation and the longest chain of operations that
+   * depend on it, in seconds. Operations with a longer remaining chain are evaluated first. */
+  float critical_path_time;
+  /* How many outlinks are not yet accounted for in #critical_path_time. */
+  uint32_t num_children_pending;
+
   /* Identifier for the operation being performed. */
   OperationCode opcode;
   int name_tag;
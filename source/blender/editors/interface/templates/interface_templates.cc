@@ -7025,15 +7025,14 @@ void uiTemplateCacheFileProcedural(uiLayout *layout, const bContext *C, PointerR
   uiLayoutSetActive(row, is_alembic && engine_supports_procedural);
   uiItemR(row, fileptr, "use_render_procedural", UI_ITEM_NONE, nullptr, ICON_NONE);
 
-  const bool use_render_procedural = RNA_boolean_get(fileptr, "use_render_procedural");
+  /* Prefetching is also used by modifiers, so these are available without the procedural. */
   const bool use_prefetch = RNA_boolean_get(fileptr, "use_prefetch");
 
   row = uiLayoutRow(layout, false);
-  uiLayoutSetEnabled(row, use_render_procedural);
   uiItemR(row, fileptr, "use_prefetch", UI_ITEM_NONE, nullptr, ICON_NONE);
 
   sub = uiLayoutRow(layout, false);
-  uiLayoutSetEnabled(sub, use_prefetch && use_render_procedural);
+  uiLayoutSetEnabled(sub, use_prefetch);
   uiItemR(sub, fileptr, "prefetch_cache_size", UI_ITEM_NONE, nullptr, ICON_NONE);
 }
 
@@ -7063,6 +7062,13 @@ void uiTemplateCacheFileTimeSettings(uiLayout *layout, PointerRNA *fileptr)
   row = uiLayoutRow(layout, false);
   uiItemR(row, fileptr, "frame_offset", UI_ITEM_NONE, nullptr, ICON_NONE);
   uiLayoutSetActive(row, !RNA_boolean_get(fileptr, "is_sequence"));
+
+  row = uiLayoutRow(layout, false);
+  uiItemR(row, fileptr, "prefetch_frames", UI_ITEM_NONE, nullptr, ICON_NONE);
+  uiLayoutSetActive(row,
+                    RNA_boolean_get(fileptr, "use_prefetch") &&
+                        !RNA_boolean_get(fileptr, "is_sequence") &&
+                        !RNA_boolean_get(fileptr, "override_frame"));
 }
 
 static void cache_file_layer_item(uiList * /*ui_list*/,
@@ -1008,6 +1008,7 @@ static int sequencer_reload_exec(bContext *C, wmOperator *op)
     }
   }
 
+  DEG_id_tag_update(&scene->id, ID_RECALC_SEQUENCER_STRIPS);
   WM_event_add_notifier(C, NC_SCENE | ND_SEQUENCER, scene);
 
   return OPERATOR_FINISHED;
@@ -1432,6 +1433,7 @@ static int sequencer_split_exec(bContext *C, wmOperator *op)
     }
   }
   if (changed) {
+    DEG_id_tag_update(&scene->id, ID_RECALC_SEQUENCER_STRIPS);
     WM_event_add_notifier(C, NC_SCENE | ND_SEQUENCER, scene);
     return OPERATOR_FINISHED;
   }
@@ -1894,6 +1896,7 @@ static int sequencer_separate_images_exec(bContext *C, wmOperator *op)
   }
 
   SEQ_edit_remove_flagged_sequences(scene, seqbase);
+  DEG_id_tag_update(&scene->id, ID_RECALC_SEQUENCER_STRIPS);
   WM_event_add_notifier(C, NC_SCENE | ND_SEQUENCER, scene);
 
   return OPERATOR_FINISHED;
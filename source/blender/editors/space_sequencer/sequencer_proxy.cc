@@ -18,6 +18,8 @@
 
 #include "BLT_translation.hh"
 
+#include "DEG_depsgraph.hh"
+
 #include "SEQ_proxy.hh"
 #include "SEQ_relations.hh"
 #include "SEQ_sequencer.hh"
@@ -221,6 +223,7 @@ static int sequencer_enable_proxies_exec(bContext *C, wmOperator *op)
     }
   }
 
+  DEG_id_tag_update(&scene->id, ID_RECALC_SEQUENCER_STRIPS);
   WM_event_add_notifier(C, NC_SCENE | ND_SEQUENCER, scene);
 
   return OPERATOR_FINISHED;
@@ -17,6 +17,8 @@
 #include "BKE_report.hh"
 #include "BKE_scene.hh"
 
+#include "DEG_depsgraph.hh"
+
 #include "ED_select_utils.hh"
 #include "ED_sequencer.hh"
 
@@ -162,6 +164,7 @@ static int sequencer_retiming_reset_exec(bContext *C, wmOperator * /*op*/)
   SEQ_retiming_data_clear(seq);
 
   retiming_key_overlap(scene, seq);
+  DEG_id_tag_update(&scene->id, ID_RECALC_SEQUENCER_STRIPS);
   WM_event_add_notifier(C, NC_SCENE | ND_SEQUENCER, scene);
   return OPERATOR_FINISHED;
 }
@@ -11,6 +11,9 @@
  * another #Graph again).
  */
 
+#include <memory>
+
+#include "BLI_timeit.hh"
 #include "BLI_vector.hh"
 #include "BLI_vector_set.hh"
 
@@ -37,6 +40,15 @@ class GraphExecutorLogger {
                                       const Params &params,
                                       const Context &context) const;
 
+  /**
+   * Is called every time a node has been executed. The same timings are used by the executor to
+   * prioritize expensive nodes in later evaluations of the graph.
+   */
+  virtual void log_node_execution_time(const FunctionNode &node,
+                                       timeit::TimePoint start,
+                                       timeit::TimePoint end,
+                                       const Context &context) const;
+
   virtual void dump_when_outputs_are_missing(const FunctionNode &node,
                                              Span<const OutputSocket *> missing_sockets,
                                              const Context &context) const;
@@ -118,6 +130,13 @@ class GraphExecutor : public LazyFunction {
     int total_size;
   } init_buffer_info_;
 
+  /**
+   * Execution times of the nodes measured in previous evaluations. They are used to schedule nodes
+   * on the critical path of the graph first.
+   */
+  struct NodeCosts;
+  std::unique_ptr<NodeCosts> node_costs_;
+
   friend class Executor;
 
  public:
@@ -127,6 +146,7 @@ class GraphExecutor : public LazyFunction {
                 const Logger *logger,
                 const SideEffectProvider *side_effect_provider,
                 const NodeExecuteWrapper *node_execute_wrapper);
+  ~GraphExecutor();
 
   void *init_storage(LinearAllocator<> &allocator) const override;
   void destruct_storage(void *storage) const override;
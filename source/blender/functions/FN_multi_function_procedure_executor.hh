@@ -8,22 +8,34 @@
  * \ingroup fn
  */
 
+#include <memory>
+
 #include "FN_multi_function_procedure.hh"
 
 namespace blender::fn::multi_function {
 
+struct ChunkedProcedure;
+
 /** A multi-function that executes a procedure internally. */
 class ProcedureExecutor : public MultiFunction {
  private:
   Signature signature_;
   const Procedure &procedure_;
+  /**
+   * Preprocessed version of the procedure that is evaluated chunk by chunk. This is only
+   * available when the procedure is a simple sequence of function calls without branches.
+   */
+  std::unique_ptr<const ChunkedProcedure> chunked_procedure_;
 
  public:
   ProcedureExecutor(const Procedure &procedure);
+  ~ProcedureExecutor();
 
   void call(const IndexMask &mask, Params params, Context context) const override;
 
  private:
+  void call_chunked(const IndexMask &mask, Params params, Context context) const;
+
   ExecutionHints get_execution_hints() const override;
 };
 
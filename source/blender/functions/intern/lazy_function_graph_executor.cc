@@ -39,14 +39,23 @@
  * When all tasks are completed, the executor gives back control to the caller which may later
  * provide new inputs to the graph which in turn leads to new nodes being scheduled and the process
  * starts again.
+ *
+ * The executor measures how long every node takes and remembers that for later evaluations of the
+ * same graph. When multiple nodes are scheduled, the ones on the most expensive path to the graph
+ * outputs are executed first, because they determine how long the entire evaluation takes. Nodes
+ * that are known to be expensive also make the remaining scheduled nodes available to other
+ * threads before they start.
  */
 
+#include <algorithm>
 #include <mutex>
 #include <sstream>
+#include <tuple>
 
 #include "BLI_compute_context.hh"
 #include "BLI_enumerable_thread_specific.hh"
 #include "BLI_function_ref.hh"
+#include "BLI_stack.hh"
 #include "BLI_task.h"
 #include "BLI_task.hh"
 #include "BLI_timeit.hh"
@@ -55,6 +64,126 @@
 
 namespace blender::fn::lazy_function {
 
+/**
+ * Nodes that are known to take at least this long are not executed while other scheduled nodes
+ * wait on the same thread. Instead, the other nodes are made available to other threads first.
+ */
+static constexpr int64_t expensive_node_threshold_ns = 100'000;
+
+struct GraphExecutor::NodeCosts {
+  /**
+   * Smoothed execution time of every node in nanoseconds, indexed by #Node::index_in_graph. It is
+   * zero for nodes that have not been executed yet. Atomics are used because the same graph may be
+   * evaluated by multiple executors at the same time. Concurrent updates may overwrite each
+   * other, which is fine for an estimate.
+   */
+  Array<std::atomic<int64_t>> costs;
+  /**
+   * Cost of every node at the time #path_costs has been computed. Timings are noisy, so the path
+   * costs are only recomputed when a node has been measured for the first time or when its cost
+   * moved away from this value by more than a factor of two.
+   */
+  Array<std::atomic<int64_t>> computed_costs;
+  /** True when #costs changed noticeably since #path_costs has been computed. */
+  std::atomic<bool> path_costs_dirty = false;
+  std::mutex path_costs_mutex;
+  /**
+   * Summed cost of the most expensive path from every node to the outputs of the graph. Nodes with
+   * a higher path cost are scheduled first, because they are more likely to delay the end of the
+   * evaluation. The array is replaced as a whole, so that running executors can keep using the
+   * previous version.
+   */
+  std::shared_ptr<const Array<int64_t>> path_costs;
+
+  NodeCosts(const int64_t nodes_num) : costs(nodes_num), computed_costs(nodes_num)
+  {
+    for (std::atomic<int64_t> &cost : costs) {
+      cost.store(0, std::memory_order_relaxed);
+    }
+    for (std::atomic<int64_t> &cost : computed_costs) {
+      cost.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  void add_measurement(const int node_index, const int64_t time_ns)
+  {
+    std::atomic<int64_t> &cost = costs[node_index];
+    const int64_t old_cost = cost.load(std::memory_order_relaxed);
+    /* Use a moving average to reduce the impact of outliers. */
+    const int64_t new_cost = old_cost == 0 ? time_ns : (old_cost * 3 + time_ns) / 4;
+    cost.store(new_cost, std::memory_order_relaxed);
+    /* Avoid recomputing the path costs because of timing noise. */
+    const int64_t computed_cost = computed_costs[node_index].load(std::memory_order_relaxed);
+    if (new_cost > computed_cost * 2 || new_cost * 2 < computed_cost) {
+      path_costs_dirty.store(true, std::memory_order_relaxed);
+    }
+  }
+
+  std::shared_ptr<const Array<int64_t>> ensure_path_costs(const Graph &graph)
+  {
+    if (path_costs_dirty.exchange(false, std::memory_order_relaxed)) {
+      auto new_path_costs = std::make_shared<const Array<int64_t>>(
+          this->compute_path_costs(graph));
+      std::lock_guard lock{path_costs_mutex};
+      path_costs = new_path_costs;
+      return new_path_costs;
+    }
+    std::lock_guard lock{path_costs_mutex};
+    return path_costs;
+  }
+
+ private:
+  Array<int64_t> compute_path_costs(const Graph &graph)
+  {
+    const Span<const Node *> nodes = graph.nodes();
+    Array<int64_t> path_costs(nodes.size(), 0);
+
+    Array<int64_t> node_costs(nodes.size());
+    for (const int node_index : nodes.index_range()) {
+      node_costs[node_index] = costs[node_index].load(std::memory_order_relaxed);
+      computed_costs[node_index].store(node_costs[node_index], std::memory_order_relaxed);
+    }
+
+    /* Process the nodes in reverse topological order, so that the path costs of all linked target
+     * nodes are known when a node is processed. Nodes that are part of a cycle are never processed
+     * and keep a path cost of zero, which just means that they are not prioritized. */
+    Array<int> remaining_targets_num(nodes.size());
+    Stack<const Node *> nodes_to_check;
+    for (const int node_index : nodes.index_range()) {
+      const Node &node = *nodes[node_index];
+      int targets_num = 0;
+      for (const OutputSocket *output_socket : node.outputs()) {
+        targets_num += output_socket->targets().size();
+      }
+      remaining_targets_num[node_index] = targets_num;
+      if (targets_num == 0) {
+        nodes_to_check.push(&node);
+      }
+    }
+    while (!nodes_to_check.is_empty()) {
+      const Node &node = *nodes_to_check.pop();
+      const int node_index = node.index_in_graph();
+      int64_t max_target_path_cost = 0;
+      for (const OutputSocket *output_socket : node.outputs()) {
+        for (const InputSocket *target_socket : output_socket->targets()) {
+          max_target_path_cost = std::max(
+              max_target_path_cost, path_costs[target_socket->node().index_in_graph()]);
+        }
+      }
+      path_costs[node_index] = node_costs[node_index] + max_target_path_cost;
+      for (const InputSocket *input_socket : node.inputs()) {
+        if (const OutputSocket *origin_socket = input_socket->origin()) {
+          const int origin_node_index = origin_socket->node().index_in_graph();
+          if (--remaining_targets_num[origin_node_index] == 0) {
+            nodes_to_check.push(&origin_socket->node());
+          }
+        }
+      }
+    }
+    return path_costs;
+  }
+};
+
 enum class NodeScheduleState : uint8_t {
   /**
    * Default state of every node.
@@ -184,6 +313,11 @@ struct NodeState {
    * Custom storage of the node.
    */
   void *storage = nullptr;
+  /**
+   * Total time spent executing the node in this evaluation. It is only accessed by the thread that
+   * is running the node or when the evaluation is done.
+   */
+  timeit::Nanoseconds execution_time{0};
 };
 
 /**
@@ -220,18 +354,36 @@ class GraphExecutorLFParams;
  */
 struct ScheduledNodes {
  private:
-  /** Use two stacks of scheduled nodes for different priorities. */
+  struct NormalNode {
+    const FunctionNode *node;
+    /** See #GraphExecutor::NodeCosts::path_costs. */
+    int64_t path_cost;
+    /** Used to process nodes with the same path cost in last-in-first-out order. */
+    int64_t order;
+
+    friend bool operator<(const NormalNode &a, const NormalNode &b)
+    {
+      return std::tie(a.path_cost, a.order) < std::tie(b.path_cost, b.order);
+    }
+  };
+
+  /**
+   * Priority nodes are processed first and are stored in a stack. The remaining nodes are stored
+   * in a heap so that nodes with the highest path cost are processed first.
+   */
   Vector<const FunctionNode *> priority_;
-  Vector<const FunctionNode *> normal_;
+  Vector<NormalNode> normal_;
+  int64_t next_order_ = 0;
 
  public:
-  void schedule(const FunctionNode &node, const bool is_priority)
+  void schedule(const FunctionNode &node, const bool is_priority, const int64_t path_cost)
   {
     if (is_priority) {
       this->priority_.append(&node);
     }
     else {
-      this->normal_.append(&node);
+      this->normal_.append({&node, path_cost, next_order_++});
+      std::push_heap(normal_.begin(), normal_.end());
     }
   }
 
@@ -241,7 +393,8 @@ struct ScheduledNodes {
       return this->priority_.pop_last();
     }
     if (!this->normal_.is_empty()) {
-      return this->normal_.pop_last();
+      std::pop_heap(normal_.begin(), normal_.end());
+      return this->normal_.pop_last().node;
     }
     return nullptr;
   }
@@ -262,12 +415,27 @@ struct ScheduledNodes {
   void split_into(ScheduledNodes &other)
   {
     BLI_assert(this != &other);
+    BLI_assert(other.is_empty());
     const int64_t priority_split = priority_.size() / 2;
-    const int64_t normal_split = normal_.size() / 2;
     other.priority_.extend(priority_.as_span().drop_front(priority_split));
-    other.normal_.extend(normal_.as_span().drop_front(normal_split));
     priority_.resize(priority_split);
-    normal_.resize(normal_split);
+
+    /* Distribute the nodes alternately so that both groups start with the most expensive nodes.
+     * Arrays sorted in descending order are valid heaps already. */
+    std::sort(normal_.begin(), normal_.end(), [](const NormalNode &a, const NormalNode &b) {
+      return b < a;
+    });
+    int64_t kept_num = 0;
+    for (const int64_t i : normal_.index_range()) {
+      if (i % 2 == 0) {
+        normal_[kept_num++] = normal_[i];
+      }
+      else {
+        other.normal_.append(normal_[i]);
+      }
+    }
+    normal_.resize(kept_num);
+    other.next_order_ = next_order_;
   }
 };
 
@@ -309,6 +477,11 @@ class Executor {
    * If this is empty, the executor is in single threaded mode.
    */
   std::atomic<TaskPool *> task_pool_ = nullptr;
+  /**
+   * Path costs computed from previous evaluations of the graph. This is null when no node has been
+   * evaluated before.
+   */
+  std::shared_ptr<const Array<int64_t>> path_costs_;
 #ifdef FN_LAZY_FUNCTION_DEBUG_THREADS
   std::thread::id current_main_thread_;
 #endif
@@ -346,6 +519,7 @@ class Executor {
   {
     /* The indices are necessary, because they are used as keys in #node_states_. */
     BLI_assert(self_.graph_.node_indices_are_valid());
+    path_costs_ = self_.node_costs_->ensure_path_costs(self_.graph_);
   }
 
   ~Executor()
@@ -357,6 +531,9 @@ class Executor {
       for (const int node_index : range) {
         const Node &node = *self_.graph_.nodes()[node_index];
         NodeState &node_state = *node_states_[node_index];
+        if (node_state.execution_time.count() > 0) {
+          self_.node_costs_->add_measurement(node_index, node_state.execution_time.count());
+        }
         this->destruct_node_state(node, node_state);
       }
     });
@@ -742,12 +919,13 @@ class Executor {
       case NodeScheduleState::NotScheduled: {
         locked_node.node_state.schedule_state = NodeScheduleState::Scheduled;
         const FunctionNode &node = static_cast<const FunctionNode &>(locked_node.node);
+        const int64_t path_cost = this->get_path_cost(node);
         if (this->use_multi_threading()) {
           std::lock_guard lock{current_task.mutex};
-          current_task.scheduled_nodes.schedule(node, is_priority);
+          current_task.scheduled_nodes.schedule(node, is_priority, path_cost);
         }
         else {
-          current_task.scheduled_nodes.schedule(node, is_priority);
+          current_task.scheduled_nodes.schedule(node, is_priority, path_cost);
         }
         current_task.has_scheduled_nodes.store(true, std::memory_order_relaxed);
         break;
@@ -765,6 +943,20 @@ class Executor {
     }
   }
 
+  int64_t get_path_cost(const FunctionNode &node) const
+  {
+    if (!path_costs_) {
+      return 0;
+    }
+    return (*path_costs_)[node.index_in_graph()];
+  }
+
+  bool is_expensive_node(const FunctionNode &node) const
+  {
+    return self_.node_costs_->costs[node.index_in_graph()].load(std::memory_order_relaxed) >=
+           expensive_node_threshold_ns;
+  }
+
   void with_locked_node(const Node &node,
                         NodeState &node_state,
                         CurrentTask &current_task,
@@ -812,6 +1004,13 @@ class Executor {
       if (current_task.scheduled_nodes.is_empty()) {
         current_task.has_scheduled_nodes.store(false, std::memory_order_relaxed);
       }
+      else if (this->is_expensive_node(*node)) {
+        /* The node took a while in previous evaluations, so let other threads work on the
+         * remaining scheduled nodes in the meantime. */
+        if (this->try_enable_multi_threading()) {
+          this->push_all_scheduled_nodes_to_task_pool(current_task);
+        }
+      }
       this->run_node_task(*node, current_task, local_data);
 
       /* If there are many nodes scheduled at the same time, it's beneficial to let multiple
@@ -1448,15 +1647,19 @@ inline void Executor::execute_node(const FunctionNode &node,
   };
 
   lazy_threading::HintReceiver blocking_hint_receiver{blocking_hint_fn};
+  const timeit::TimePoint start_time = timeit::Clock::now();
   if (self_.node_execute_wrapper_) {
     self_.node_execute_wrapper_->execute_node(node, node_params, fn_context);
   }
   else {
     fn.execute(node_params, fn_context);
   }
+  const timeit::TimePoint end_time = timeit::Clock::now();
+  node_state.execution_time += end_time - start_time;
 
   if (self_.logger_ != nullptr) {
     self_.logger_->log_after_node_execute(node, node_params, fn_context);
+    self_.logger_->log_node_execution_time(node, start_time, end_time, fn_context);
   }
 }
 
@@ -1515,8 +1718,12 @@ GraphExecutor::GraphExecutor(const Graph &graph,
   }
 
   init_buffer_info_.total_size = offset;
+
+  node_costs_ = std::make_unique<NodeCosts>(nodes.size());
 }
 
+GraphExecutor::~GraphExecutor() = default;
+
 void GraphExecutor::execute_impl(Params &params, const Context &context) const
 {
   Executor &executor = *static_cast<Executor *>(context.storage);
@@ -1567,6 +1774,14 @@ void GraphExecutorLogger::log_after_node_execute(const FunctionNode &node,
   UNUSED_VARS(node, params, context);
 }
 
+void GraphExecutorLogger::log_node_execution_time(const FunctionNode &node,
+                                                  const timeit::TimePoint start,
+                                                  const timeit::TimePoint end,
+                                                  const Context &context) const
+{
+  UNUSED_VARS(node, start, end, context);
+}
+
 Vector<const FunctionNode *> GraphExecutorSideEffectProvider::get_nodes_with_side_effects(
     const Context &context) const
 {
@@ -8,17 +8,6 @@
 
 namespace blender::fn::multi_function {
 
-ProcedureExecutor::ProcedureExecutor(const Procedure &procedure) : procedure_(procedure)
-{
-  SignatureBuilder builder("Procedure Executor", signature_);
-
-  for (const ConstParameter &param : procedure.params()) {
-    builder.add("Parameter", ParamType(param.type, param.variable->data_type()));
-  }
-
-  this->set_signature(&signature_);
-}
-
 using IndicesSplitVectors = std::array<Vector<int64_t>, 2>;
 
 namespace {
@@ -1157,10 +1146,466 @@ class InstructionScheduler {
   }
 };
 
+/**
+ * Many procedures (e.g. the ones built for fields) are just a linear sequence of function calls.
+ * The generic evaluation above executes every instruction for the full mask before the next one
+ * starts, so every intermediate variable is an array that is as large as the mask. For large masks
+ * that means that every instruction streams its inputs and outputs through main memory.
+ *
+ * Linear procedures are preprocessed into a flat list of instructions which is evaluated for
+ * small chunks of the mask at a time instead. That way, intermediate values only live in small
+ * buffers that stay in the CPU cache. Instructions whose inputs are all single values are still
+ * only evaluated once.
+ */
+
+/** Maximum number of indices that are processed at once when evaluating a #ChunkedProcedure. */
+static constexpr int64_t chunk_size = 4096;
+
+namespace {
+
+struct ChunkedParam {
+  /** Variable passed to the parameter, or -1 if the output is ignored. */
+  int variable = -1;
+  /** Buffer that stores the variable in the current chunk, or -1 for procedure parameters. */
+  int buffer = -1;
+};
+
+struct ChunkedInstruction {
+  /** Function that is called, or null when the instruction destructs a variable. */
+  const MultiFunction *fn = nullptr;
+  /** Range in #ChunkedProcedure::params. */
+  IndexRange params;
+};
+
+struct ChunkedBuffer {
+  int64_t element_size;
+  int64_t alignment;
+};
+
+}  // namespace
+
+struct ChunkedProcedure {
+  Vector<ChunkedInstruction> instructions;
+  Vector<ChunkedParam> params;
+  /** Buffers are reused for variables with the same size once the previous variable is freed. */
+  Vector<ChunkedBuffer> buffers;
+  /** Procedure parameter index for every variable, or -1 for intermediate variables. */
+  Array<int> param_by_variable;
+};
+
+static int get_chunked_buffer(ChunkedProcedure &chunked,
+                              Vector<int> &free_buffers,
+                              const CPPType &type)
+{
+  for (const int i : free_buffers.index_range()) {
+    const int buffer = free_buffers[i];
+    const ChunkedBuffer &info = chunked.buffers[buffer];
+    if (info.element_size == type.size() && info.alignment == type.alignment()) {
+      free_buffers.remove_and_reorder(i);
+      return buffer;
+    }
+  }
+  chunked.buffers.append({type.size(), type.alignment()});
+  return chunked.buffers.size() - 1;
+}
+
+/**
+ * Try to convert the procedure into a form that can be evaluated in chunks. This only works for
+ * procedures that don't have branches and only work with single values.
+ */
+static std::unique_ptr<const ChunkedProcedure> try_build_chunked_procedure(
+    const Procedure &procedure)
+{
+  auto chunked = std::make_unique<ChunkedProcedure>();
+  const int variables_num = procedure.variables().size();
+  chunked->param_by_variable.reinitialize(variables_num);
+  chunked->param_by_variable.fill(-1);
+
+  for (const int param_index : procedure.params().index_range()) {
+    const ConstParameter &param = procedure.params()[param_index];
+    if (param.type == ParamType::Mutable) {
+      return nullptr;
+    }
+    if (param.variable->data_type().category() != DataType::Single) {
+      return nullptr;
+    }
+    int &variable_param = chunked->param_by_variable[param.variable->index_in_procedure()];
+    if (variable_param != -1) {
+      return nullptr;
+    }
+    variable_param = param_index;
+  }
+
+  Array<int> buffer_by_variable(variables_num, -1);
+  Vector<int> free_buffers;
+
+  const Instruction *instruction = procedure.entry();
+  while (instruction != nullptr && instruction->type() != InstructionType::Return) {
+    switch (instruction->type()) {
+      case InstructionType::Call: {
+        const CallInstruction &call_instruction = static_cast<const CallInstruction &>(
+            *instruction);
+        const MultiFunction &fn = call_instruction.fn();
+        const IndexRange params_range(chunked->params.size(), fn.param_amount());
+        chunked->instructions.append({&fn, params_range});
+        for (const int param_index : fn.param_indices()) {
+          const ParamType param_type = fn.param_type(param_index);
+          if (!ELEM(param_type.category(),
+                    ParamCategory::SingleInput,
+                    ParamCategory::SingleOutput))
+          {
+            return nullptr;
+          }
+          chunked->params.append({});
+          ChunkedParam &param = chunked->params.last();
+          const Variable *variable = call_instruction.params()[param_index];
+          if (variable == nullptr) {
+            continue;
+          }
+          const int variable_i = variable->index_in_procedure();
+          param.variable = variable_i;
+          if (chunked->param_by_variable[variable_i] != -1) {
+            continue;
+          }
+          if (param_type.interface_type() == ParamType::Output) {
+            buffer_by_variable[variable_i] = get_chunked_buffer(
+                *chunked, free_buffers, param_type.data_type().single_type());
+          }
+          param.buffer = buffer_by_variable[variable_i];
+        }
+        instruction = call_instruction.next();
+        break;
+      }
+      case InstructionType::Destruct: {
+        const DestructInstruction &destruct_instruction = static_cast<const DestructInstruction &>(
+            *instruction);
+        const int variable_i = destruct_instruction.variable()->index_in_procedure();
+        const int buffer = buffer_by_variable[variable_i];
+        chunked->instructions.append({nullptr, IndexRange(chunked->params.size(), 1)});
+        chunked->params.append({variable_i, buffer});
+        if (buffer != -1) {
+          free_buffers.append(buffer);
+          buffer_by_variable[variable_i] = -1;
+        }
+        instruction = destruct_instruction.next();
+        break;
+      }
+      case InstructionType::Dummy: {
+        instruction = static_cast<const DummyInstruction &>(*instruction).next();
+        break;
+      }
+      case InstructionType::Branch:
+      case InstructionType::Return: {
+        return nullptr;
+      }
+    }
+  }
+  if (instruction == nullptr) {
+    return nullptr;
+  }
+  return chunked;
+}
+
+namespace {
+
+/** Where the value of a variable can be found while a chunked procedure is evaluated. */
+struct ChunkedBinding {
+  enum class Type : int8_t {
+    /** The variable is not used or not initialized. */
+    None,
+    /** The variable has the same value for all indices, which is stored in #value. */
+    Single,
+    /** The variable is the procedure input with the index #index. */
+    Input,
+    /** The variable is the procedure output with the index #index. */
+    Output,
+    /** The variable is stored in the chunk buffer with the index #index. */
+    Buffer,
+  };
+  Type type = Type::None;
+  int index = -1;
+  const void *value = nullptr;
+};
+
+}  // namespace
+
+static void execute_chunked_call(const MultiFunction &fn,
+                                 const Span<ChunkedBinding> bindings,
+                                 const IndexRange chunk_range,
+                                 const IndexMask &chunk_mask,
+                                 const Span<GVArray> input_varrays,
+                                 const Span<GMutableSpan> output_spans,
+                                 const Span<void *> buffers,
+                                 const Context &context)
+{
+  ParamsBuilder params(fn, &chunk_mask);
+  for (const int param_index : fn.param_indices()) {
+    const ParamType param_type = fn.param_type(param_index);
+    const CPPType &type = param_type.data_type().single_type();
+    const ChunkedBinding &binding = bindings[param_index];
+    if (param_type.interface_type() == ParamType::Input) {
+      switch (binding.type) {
+        case ChunkedBinding::Type::Single:
+          params.add_readonly_single_input(GPointer(type, binding.value));
+          break;
+        case ChunkedBinding::Type::Input:
+          params.add_readonly_single_input(input_varrays[binding.index].slice(chunk_range));
+          break;
+        case ChunkedBinding::Type::Output:
+          params.add_readonly_single_input(GSpan(output_spans[binding.index].slice(chunk_range)));
+          break;
+        case ChunkedBinding::Type::Buffer:
+          params.add_readonly_single_input(
+              GSpan(type, buffers[binding.index], chunk_range.size()));
+          break;
+        case ChunkedBinding::Type::None:
+          BLI_assert_unreachable();
+          break;
+      }
+    }
+    else {
+      switch (binding.type) {
+        case ChunkedBinding::Type::None:
+          params.add_ignored_single_output();
+          break;
+        case ChunkedBinding::Type::Output:
+          params.add_uninitialized_single_output(output_spans[binding.index].slice(chunk_range));
+          break;
+        case ChunkedBinding::Type::Buffer:
+          params.add_uninitialized_single_output(
+              GMutableSpan(type, buffers[binding.index], chunk_range.size()));
+          break;
+        case ChunkedBinding::Type::Single:
+        case ChunkedBinding::Type::Input:
+          BLI_assert_unreachable();
+          break;
+      }
+    }
+  }
+
+  try {
+    fn.call_auto(chunk_mask, params, context);
+  }
+  catch (...) {
+    /* Multi-functions must not throw exceptions. */
+    BLI_assert_unreachable();
+  }
+}
+
+void ProcedureExecutor::call_chunked(const IndexMask &full_mask,
+                                     Params params,
+                                     Context context) const
+{
+  const ChunkedProcedure &chunked = *chunked_procedure_;
+
+  AlignedBuffer<512, 64> local_buffer;
+  LinearAllocator<> linear_allocator;
+  linear_allocator.provide_buffer(local_buffer);
+
+  Array<GVArray> input_varrays(this->param_amount());
+  Array<GMutableSpan> output_spans(this->param_amount());
+  Array<ChunkedBinding> variable_bindings(procedure_.variables().size());
+  Vector<GMutablePointer> single_values;
+
+  for (const int param_index : this->param_indices()) {
+    const int variable_i = procedure_.params()[param_index].variable->index_in_procedure();
+    ChunkedBinding &binding = variable_bindings[variable_i];
+    if (this->param_type(param_index).interface_type() == ParamType::Input) {
+      const GVArray &varray = params.readonly_single_input(param_index);
+      if (varray.is_single()) {
+        const CPPType &type = varray.type();
+        void *value = linear_allocator.allocate(type.size(), type.alignment());
+        varray.get_internal_single_to_uninitialized(value);
+        single_values.append({type, value});
+        binding = {ChunkedBinding::Type::Single, param_index, value};
+      }
+      else {
+        input_varrays[param_index] = varray;
+        binding = {ChunkedBinding::Type::Input, param_index};
+      }
+    }
+    else {
+      output_spans[param_index] = params.uninitialized_single_output(param_index);
+      binding = {ChunkedBinding::Type::Output, param_index};
+    }
+  }
+
+  /* Evaluate instructions that only depend on single values once up-front and find where every
+   * parameter of the remaining instructions is stored. */
+  Array<ChunkedBinding> param_bindings(chunked.params.size());
+  Array<bool> evaluate_per_chunk(chunked.instructions.size(), true);
+  for (const int instruction_i : chunked.instructions.index_range()) {
+    const ChunkedInstruction &instruction = chunked.instructions[instruction_i];
+    const Span<ChunkedParam> instruction_params = chunked.params.as_span().slice(
+        instruction.params);
+    MutableSpan<ChunkedBinding> instruction_bindings = param_bindings.as_mutable_span().slice(
+        instruction.params);
+    if (instruction.fn == nullptr) {
+      const ChunkedParam &param = instruction_params[0];
+      instruction_bindings[0] = variable_bindings[param.variable];
+      if (chunked.param_by_variable[param.variable] == -1) {
+        variable_bindings[param.variable] = {};
+      }
+      continue;
+    }
+    const MultiFunction &fn = *instruction.fn;
+    bool all_inputs_single = true;
+    for (const int param_index : fn.param_indices()) {
+      const ChunkedParam &param = instruction_params[param_index];
+      if (fn.param_type(param_index).interface_type() == ParamType::Input &&
+          variable_bindings[param.variable].type != ChunkedBinding::Type::Single)
+      {
+        all_inputs_single = false;
+        break;
+      }
+    }
+    if (all_inputs_single) {
+      static const IndexMask one_mask(1);
+      ParamsBuilder one_params(fn, &one_mask);
+      for (const int param_index : fn.param_indices()) {
+        const ParamType param_type = fn.param_type(param_index);
+        const CPPType &type = param_type.data_type().single_type();
+        const ChunkedParam &param = instruction_params[param_index];
+        if (param_type.interface_type() == ParamType::Input) {
+          one_params.add_readonly_single_input(
+              GPointer(type, variable_bindings[param.variable].value));
+        }
+        else if (param.variable == -1) {
+          one_params.add_ignored_single_output();
+        }
+        else {
+          void *value = linear_allocator.allocate(type.size(), type.alignment());
+          one_params.add_uninitialized_single_output(GMutableSpan(type, value, 1));
+          single_values.append({type, value});
+          variable_bindings[param.variable] = {ChunkedBinding::Type::Single, -1, value};
+        }
+      }
+      try {
+        fn.call(one_mask, one_params, context);
+      }
+      catch (...) {
+        /* Multi-functions must not throw exceptions. */
+        BLI_assert_unreachable();
+      }
+      evaluate_per_chunk[instruction_i] = false;
+      continue;
+    }
+    for (const int param_index : fn.param_indices()) {
+      const ChunkedParam &param = instruction_params[param_index];
+      if (param.variable == -1) {
+        continue;
+      }
+      ChunkedBinding &binding = variable_bindings[param.variable];
+      if (fn.param_type(param_index).interface_type() == ParamType::Output) {
+        if (param.buffer == -1) {
+          binding = {ChunkedBinding::Type::Output, chunked.param_by_variable[param.variable]};
+        }
+        else {
+          binding = {ChunkedBinding::Type::Buffer, param.buffer};
+        }
+      }
+      instruction_bindings[param_index] = binding;
+    }
+  }
+
+  const int64_t array_size = full_mask.min_array_size();
+  const int64_t buffer_size = std::min(chunk_size, array_size - full_mask.first());
+  Array<void *> buffers(chunked.buffers.size());
+  for (const int buffer : chunked.buffers.index_range()) {
+    const ChunkedBuffer &info = chunked.buffers[buffer];
+    buffers[buffer] = linear_allocator.allocate(info.element_size * buffer_size,
+                                                std::max<int64_t>(info.alignment, 64));
+  }
+
+  int64_t chunk_start = full_mask.first();
+  while (true) {
+    const IndexRange chunk_range(chunk_start, std::min(buffer_size, array_size - chunk_start));
+    IndexMaskMemory memory;
+    const IndexMask chunk_mask = full_mask.slice_content(chunk_range).shift(-chunk_start, memory);
+
+    for (const int instruction_i : chunked.instructions.index_range()) {
+      if (!evaluate_per_chunk[instruction_i]) {
+        continue;
+      }
+      const ChunkedInstruction &instruction = chunked.instructions[instruction_i];
+      const Span<ChunkedBinding> instruction_bindings = param_bindings.as_span().slice(
+          instruction.params);
+      if (instruction.fn != nullptr) {
+        execute_chunked_call(*instruction.fn,
+                             instruction_bindings,
+                             chunk_range,
+                             chunk_mask,
+                             input_varrays,
+                             output_spans,
+                             buffers,
+                             context);
+        continue;
+      }
+      /* Procedure inputs are owned by the caller and single values are destructed in the end. */
+      const ChunkedBinding &binding = instruction_bindings[0];
+      const int variable_i = chunked.params[instruction.params.first()].variable;
+      const CPPType &type = procedure_.variables()[variable_i]->data_type().single_type();
+      if (type.is_trivially_destructible()) {
+        continue;
+      }
+      if (binding.type == ChunkedBinding::Type::Buffer) {
+        type.destruct_indices(buffers[binding.index], chunk_mask);
+      }
+      else if (binding.type == ChunkedBinding::Type::Output) {
+        type.destruct_indices(output_spans[binding.index].slice(chunk_range).data(), chunk_mask);
+      }
+    }
+
+    const int64_t next_start = chunk_range.one_after_last();
+    if (next_start >= array_size) {
+      break;
+    }
+    chunk_start = full_mask[full_mask.iterator_to_index(*full_mask.find_larger_equal(next_start))];
+  }
+
+  /* Outputs that have the same value for all indices still have to be copied to the caller. */
+  for (const int param_index : this->param_indices()) {
+    if (this->param_type(param_index).interface_type() != ParamType::Output) {
+      continue;
+    }
+    const int variable_i = procedure_.params()[param_index].variable->index_in_procedure();
+    const ChunkedBinding &binding = variable_bindings[variable_i];
+    if (binding.type == ChunkedBinding::Type::Single) {
+      const GMutableSpan span = output_spans[param_index];
+      span.type().fill_construct_indices(binding.value, span.data(), full_mask);
+    }
+  }
+  for (GMutablePointer value : single_values) {
+    value.destruct();
+  }
+}
+
+ProcedureExecutor::ProcedureExecutor(const Procedure &procedure)
+    : procedure_(procedure), chunked_procedure_(try_build_chunked_procedure(procedure))
+{
+  SignatureBuilder builder("Procedure Executor", signature_);
+
+  for (const ConstParameter &param : procedure.params()) {
+    builder.add("Parameter", ParamType(param.type, param.variable->data_type()));
+  }
+
+  this->set_signature(&signature_);
+}
+
+ProcedureExecutor::~ProcedureExecutor() = default;
+
 void ProcedureExecutor::call(const IndexMask &full_mask, Params params, Context context) const
 {
   BLI_assert(procedure_.validate());
 
+  /* Very sparse masks would result in many small chunks, so use the generic evaluation for them. */
+  if (chunked_procedure_ && !full_mask.is_empty() &&
+      full_mask.size() * 4 >= full_mask.last() - full_mask.first() + 1)
+  {
+    this->call_chunked(full_mask, params, context);
+    return;
+  }
+
   AlignedBuffer<512, 64> local_buffer;
   LinearAllocator<> linear_allocator;
   linear_allocator.provide_buffer(local_buffer);
@@ -1244,7 +1689,8 @@ void ProcedureExecutor::call(const IndexMask &full_mask, Params params, Context
 MultiFunction::ExecutionHints ProcedureExecutor::get_execution_hints() const
 {
   ExecutionHints hints;
-  hints.allocates_array = true;
+  /* Chunked evaluation only allocates buffers with a fixed maximum size. */
+  hints.allocates_array = chunked_procedure_ == nullptr;
   hints.min_grain_size = 10000;
   return hints;
 }
@@ -11,6 +11,8 @@
 #include "BLI_task.h"
 #include "BLI_timeit.hh"
 
+#include <atomic>
+
 namespace blender::fn::lazy_function::tests {
 
 class AddLazyFunction : public LazyFunction {
@@ -179,4 +181,53 @@ TEST(lazy_function, GraphWithCycle)
   EXPECT_EQ(result, 10 * 2 * 5);
 }
 
+class CountingLogger : public GraphExecutor::Logger {
+ public:
+  mutable std::atomic<int> timed_executions = 0;
+
+  void log_node_execution_time(const FunctionNode & /*node*/,
+                               const timeit::TimePoint start,
+                               const timeit::TimePoint end,
+                               const Context & /*context*/) const override
+  {
+    EXPECT_LE(start, end);
+    timed_executions++;
+  }
+};
+
+TEST(lazy_function, RepeatedEvaluation)
+{
+  BLI_task_scheduler_init();
+  const AddLazyFunction add_fn;
+
+  /* Many independent nodes that are all scheduled at the same time and are combined afterwards.
+   * Later evaluations use the execution times measured before to order the scheduled nodes. */
+  Graph graph;
+  GraphInputSocket &graph_input = graph.add_input(CPPType::get<int>());
+  GraphOutputSocket &graph_output = graph.add_output(CPPType::get<int>());
+  const int nodes_num = 200;
+  OutputSocket *sum_socket = &graph_input;
+  for (int i = 0; i < nodes_num; i++) {
+    FunctionNode &node = graph.add_function(add_fn);
+    FunctionNode &sum_node = graph.add_function(add_fn);
+    graph.add_link(graph_input, node.input(0));
+    graph.add_link(graph_input, node.input(1));
+    graph.add_link(*sum_socket, sum_node.input(0));
+    graph.add_link(node.output(0), sum_node.input(1));
+    sum_socket = &sum_node.output(0);
+  }
+  graph.add_link(*sum_socket, graph_output);
+  graph.update_node_indices();
+
+  CountingLogger logger;
+  GraphExecutor executor_fn{graph, {&graph_input}, {&graph_output}, &logger, nullptr, nullptr};
+  for (const int iteration : IndexRange(5)) {
+    int result = 0;
+    execute_lazy_function_eagerly(
+        executor_fn, nullptr, nullptr, std::make_tuple(iteration), std::make_tuple(&result));
+    EXPECT_EQ(result, iteration + nodes_num * iteration * 2);
+  }
+  EXPECT_EQ(logger.timed_executions, 5 * nodes_num * 2);
+}
+
 }  // namespace blender::fn::lazy_function::tests
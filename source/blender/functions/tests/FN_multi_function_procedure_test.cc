@@ -423,4 +423,73 @@ TEST(multi_function_procedure, OutputBufferReplaced)
   EXPECT_EQ(output[2], output_value);
 }
 
+TEST(multi_function_procedure, ChunkedEvaluation)
+{
+  /**
+   * procedure(int a, std::string *out) {
+   *   int b = a * 2;
+   *   int c = b + 5;
+   *   std::string d = to_string(c);
+   *   out = d + d;
+   * }
+   */
+
+  CustomMF_Constant<int> constant_fn{5};
+  auto double_fn = build::SI1_SO<int, int>("double", [](int a) { return a * 2; });
+  auto add_fn = build::SI2_SO<int, int, int>("add", [](int a, int b) { return a + b; });
+  auto to_string_fn = build::SI1_SO<int, std::string>("to string",
+                                                      [](int a) { return std::to_string(a); });
+  auto concat_fn = build::SI2_SO<std::string, std::string, std::string>(
+      "concat", [](const std::string &a, const std::string &b) { return a + b; });
+
+  Procedure procedure;
+  ProcedureBuilder builder{procedure};
+
+  Variable *var_a = &builder.add_single_input_parameter<int>();
+  auto [var_b] = builder.add_call<1>(double_fn, {var_a});
+  builder.add_destruct(*var_a);
+  auto [var_5] = builder.add_call<1>(constant_fn);
+  auto [var_c] = builder.add_call<1>(add_fn, {var_b, var_5});
+  builder.add_destruct({var_b, var_5});
+  auto [var_d] = builder.add_call<1>(to_string_fn, {var_c});
+  builder.add_destruct(*var_c);
+  auto [var_out] = builder.add_call<1>(concat_fn, {var_d, var_d});
+  builder.add_destruct(*var_d);
+  builder.add_return();
+  builder.add_output_parameter(*var_out);
+
+  EXPECT_TRUE(procedure.validate());
+
+  ProcedureExecutor procedure_fn{procedure};
+
+  /* Use enough indices so that the procedure is evaluated in multiple chunks. */
+  const int size = 20000;
+  Array<int> inputs(size);
+  for (const int i : inputs.index_range()) {
+    inputs[i] = i;
+  }
+  Array<std::string> results(size);
+
+  IndexMaskMemory memory;
+  const IndexMask mask = IndexMask::from_predicate(
+      IndexRange(3, size - 3), GrainSize(1024), memory, [](const int64_t i) { return i % 3 != 0; });
+  ParamsBuilder params{procedure_fn, &mask};
+
+  params.add_readonly_single_input(inputs.as_span());
+  params.add_uninitialized_single_output(results.as_mutable_span());
+
+  ContextBuilder context;
+  procedure_fn.call(mask, params, context);
+
+  for (const int i : results.index_range()) {
+    if (i < 3 || i % 3 == 0) {
+      EXPECT_TRUE(results[i].empty());
+    }
+    else {
+      const std::string expected = std::to_string(i * 2 + 5);
+      EXPECT_EQ(results[i], expected + expected);
+    }
+  }
+}
+
 }  // namespace blender::fn::multi_function::tests
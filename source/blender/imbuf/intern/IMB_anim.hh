@@ -59,6 +59,15 @@ struct ImBufAnim {
   AVPacket *cur_packet;
 
   bool seek_before_decode;
+
+  /**
+   * Ring buffer of references to recently decoded frames, looked up by PTS before seeking.
+   * Stepping backwards re-decodes a GOP only once, after that frames are taken from here.
+   * The memory of these frames is limited for all movies together.
+   */
+  AVFrame **decoded_frames;
+  int decoded_frames_num;
+  int decoded_frames_next;
 #endif
 
   char index_dir[768];
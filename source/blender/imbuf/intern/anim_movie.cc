@@ -6,6 +6,8 @@
  * \ingroup imbuf
  */
 
+#include <algorithm>
+#include <atomic>
 #include <cctype>
 #include <climits>
 #include <cmath>
@@ -25,6 +27,7 @@
 
 #include "DNA_scene_types.h"
 
+#include "MEM_CacheLimiterC-Api.h"
 #include "MEM_guardedalloc.h"
 
 #include "IMB_imbuf.hh"
@@ -544,7 +547,7 @@ static void ffmpeg_postprocess(ImBufAnim *anim, AVFrame *input, ImBuf *ibuf)
 
   if (anim->ib_flags & IB_animdeinterlace) {
     if (av_image_deinterlace(anim->pFrameDeinterlaced,
-                             anim->pFrame,
+                             input,
                              anim->pCodecCtx->pix_fmt,
                              anim->pCodecCtx->width,
                              anim->pCodecCtx->height) < 0)
@@ -621,6 +624,146 @@ static bool ffmpeg_pts_isect(int64_t pts_start, int64_t pts_end, int64_t pts_to_
   return pts_start <= pts_to_search && pts_to_search < pts_end;
 }
 
+/* Memory that references to decoded frames of all movies together are allowed to keep alive.
+ * It is derived from the cache memory preference, and at most FFMPEG_DECODED_FRAMES_MEMORY_LIMIT.
+ */
+#  define FFMPEG_DECODED_FRAMES_MEMORY_LIMIT (size_t(256) * 1024 * 1024)
+#  define FFMPEG_DECODED_FRAMES_MAX 256
+
+static std::atomic<size_t> ffmpeg_decoded_frames_memory_in_use = 0;
+
+static size_t ffmpeg_decoded_frames_memory_limit()
+{
+  return std::min(MEM_CacheLimiter_get_maximum() / 4, FFMPEG_DECODED_FRAMES_MEMORY_LIMIT);
+}
+
+static size_t ffmpeg_decoded_frame_size(const AVFrame *frame)
+{
+  const int size = av_image_get_buffer_size(
+      AVPixelFormat(frame->format), frame->width, frame->height, 1);
+  return std::max(size, 0);
+}
+
+static int ffmpeg_decoded_frames_capacity(ImBufAnim *anim)
+{
+  const int frame_size = av_image_get_buffer_size(anim->pCodecCtx->pix_fmt, anim->x, anim->y, 1);
+  if (frame_size <= 0) {
+    return 1;
+  }
+  return std::clamp(int(ffmpeg_decoded_frames_memory_limit() / size_t(frame_size)),
+                    1,
+                    FFMPEG_DECODED_FRAMES_MAX);
+}
+
+static void ffmpeg_decoded_frame_release(AVFrame *frame)
+{
+  if (frame->buf[0]) {
+    ffmpeg_decoded_frames_memory_in_use -= ffmpeg_decoded_frame_size(frame);
+    av_frame_unref(frame);
+  }
+}
+
+/* Keep a reference to a decoded frame, replacing the oldest one once the buffer is full. */
+static void ffmpeg_decoded_frames_store(ImBufAnim *anim, AVFrame *frame)
+{
+  /* Don't let a damaged frame be shown again, seeking may still decode it correctly. */
+  if ((frame->flags & AV_FRAME_FLAG_CORRUPT) || frame->decode_error_flags) {
+    return;
+  }
+
+  if (anim->decoded_frames == nullptr) {
+    anim->decoded_frames_num = ffmpeg_decoded_frames_capacity(anim);
+    anim->decoded_frames_next = 0;
+    anim->decoded_frames = MEM_cnew_array<AVFrame *>(anim->decoded_frames_num, __func__);
+  }
+
+  const int64_t pts = av_get_pts_from_frame(frame);
+  for (int i = 0; i < anim->decoded_frames_num; i++) {
+    AVFrame *cached_frame = anim->decoded_frames[i];
+    if (cached_frame && cached_frame->buf[0] && av_get_pts_from_frame(cached_frame) == pts) {
+      return;
+    }
+  }
+
+  AVFrame *&slot = anim->decoded_frames[anim->decoded_frames_next];
+  if (slot == nullptr) {
+    slot = av_frame_alloc();
+  }
+  else {
+    ffmpeg_decoded_frame_release(slot);
+  }
+
+  /* The limit is shared with other movies, so only keep the frame when there is room left. The
+   * oldest frame was released above, so the buffer shrinks instead of growing past the limit. */
+  const size_t frame_size = ffmpeg_decoded_frame_size(frame);
+  if (ffmpeg_decoded_frames_memory_in_use + frame_size > ffmpeg_decoded_frames_memory_limit()) {
+    return;
+  }
+  if (av_frame_ref(slot, frame) < 0) {
+    return;
+  }
+  ffmpeg_decoded_frames_memory_in_use += frame_size;
+  anim->decoded_frames_next = (anim->decoded_frames_next + 1) % anim->decoded_frames_num;
+}
+
+/* Return already decoded frame that matches `pts_to_search`, nullptr if there is none. */
+static AVFrame *ffmpeg_decoded_frames_find(ImBufAnim *anim, int64_t pts_to_search)
+{
+  if (anim->decoded_frames == nullptr) {
+    return nullptr;
+  }
+
+  /* Frame duration does not always match the PTS of the next frame, so don't let a frame cover
+   * more than one frame step, otherwise it could be picked instead of a frame that was not
+   * decoded yet. */
+  const int64_t max_duration = std::max(int64_t(ceil(ffmpeg_steps_per_frame_get(anim))),
+                                        int64_t(1));
+
+  AVFrame *best_frame = nullptr;
+  int64_t best_start = 0, best_end = 0;
+  for (int i = 0; i < anim->decoded_frames_num; i++) {
+    AVFrame *cached_frame = anim->decoded_frames[i];
+    if (cached_frame == nullptr || cached_frame->buf[0] == nullptr) {
+      continue;
+    }
+    /* Resolution can change per-frame with WebM, the conversion context only matches the current
+     * resolution. */
+    if (cached_frame->width != anim->x || cached_frame->height != anim->y) {
+      continue;
+    }
+    const int64_t start = av_get_pts_from_frame(cached_frame);
+    const int64_t end = start + std::min(av_get_frame_duration_in_pts_units(cached_frame),
+                                         max_duration);
+    if (ffmpeg_pts_isect(start, end, pts_to_search) && (!best_frame || start > best_start)) {
+      best_frame = cached_frame;
+      best_start = start;
+      best_end = end;
+    }
+  }
+
+  if (best_frame) {
+    final_frame_log(anim, best_start, best_end, "Cached");
+  }
+  return best_frame;
+}
+
+static void ffmpeg_decoded_frames_free(ImBufAnim *anim)
+{
+  if (anim->decoded_frames == nullptr) {
+    return;
+  }
+  for (int i = 0; i < anim->decoded_frames_num; i++) {
+    if (anim->decoded_frames[i]) {
+      ffmpeg_decoded_frame_release(anim->decoded_frames[i]);
+      av_frame_free(&anim->decoded_frames[i]);
+    }
+  }
+  MEM_freeN(anim->decoded_frames);
+  anim->decoded_frames = nullptr;
+  anim->decoded_frames_num = 0;
+  anim->decoded_frames_next = 0;
+}
+
 /* Return frame that matches `pts_to_search`, nullptr if matching frame does not exist. */
 static AVFrame *ffmpeg_frame_by_pts_get(ImBufAnim *anim, int64_t pts_to_search)
 {
@@ -657,6 +800,8 @@ static void ffmpeg_decode_store_frame_pts(ImBufAnim *anim)
     anim->cur_key_frame_pts = anim->cur_pts;
   }
 
+  ffmpeg_decoded_frames_store(anim, anim->pFrame);
+
   av_log(anim->pFormatCtx,
          AV_LOG_DEBUG,
          "  FRAME DONE: cur_pts=%" PRId64 ", guessed_pts=%" PRId64 "\n",
@@ -1105,15 +1250,22 @@ static ImBuf *ffmpeg_fetchibuf(ImBufAnim *anim, int position, IMB_Timecode_Type
          frame_rate,
          start_pts);
 
-  if (ffmpeg_must_seek(anim, position)) {
-    ffmpeg_seek_to_key_frame(anim, position, tc_index, pts_to_search);
-  }
+  /* Frames that were decoded recently don't need seeking and decoding. The decoder state is left
+   * untouched in that case, so `anim->cur_position` keeps matching it. */
+  AVFrame *final_frame = ffmpeg_decoded_frames_find(anim, pts_to_search);
+  const bool is_decoded_frame = final_frame != nullptr;
+
+  if (!is_decoded_frame) {
+    if (ffmpeg_must_seek(anim, position)) {
+      ffmpeg_seek_to_key_frame(anim, position, tc_index, pts_to_search);
+    }
 
-  ffmpeg_decode_video_frame_scan(anim, pts_to_search);
+    ffmpeg_decode_video_frame_scan(anim, pts_to_search);
 
-  /* Update resolution as it can change per-frame with WebM. See #100741 & #100081. */
-  anim->x = anim->pCodecCtx->width;
-  anim->y = anim->pCodecCtx->height;
+    /* Update resolution as it can change per-frame with WebM. See #100741 & #100081. */
+    anim->x = anim->pCodecCtx->width;
+    anim->y = anim->pCodecCtx->height;
+  }
 
   /* Certain versions of FFmpeg have a bug in libswscale which ends up in crash
    * when destination buffer is not properly aligned. For example, this happens
@@ -1150,11 +1302,13 @@ static ImBuf *ffmpeg_fetchibuf(ImBufAnim *anim, int position, IMB_Timecode_Type
 
   cur_frame_final->byte_buffer.colorspace = colormanage_colorspace_get_named(anim->colorspace);
 
-  AVFrame *final_frame = ffmpeg_frame_by_pts_get(anim, pts_to_search);
-  if (final_frame == nullptr) {
-    /* No valid frame was decoded for requested PTS, fall back on most recent decoded frame, even
-     * if it is incorrect. */
-    final_frame = ffmpeg_double_buffer_frame_fallback_get(anim);
+  if (!is_decoded_frame) {
+    final_frame = ffmpeg_frame_by_pts_get(anim, pts_to_search);
+    if (final_frame == nullptr) {
+      /* No valid frame was decoded for requested PTS, fall back on most recent decoded frame,
+       * even if it is incorrect. */
+      final_frame = ffmpeg_double_buffer_frame_fallback_get(anim);
+    }
   }
 
   /* Even with the fallback from above it is possible that the current decode frame is nullptr. In
@@ -1163,7 +1317,9 @@ static ImBuf *ffmpeg_fetchibuf(ImBufAnim *anim, int position, IMB_Timecode_Type
     ffmpeg_postprocess(anim, final_frame, cur_frame_final);
   }
 
-  anim->cur_position = position;
+  if (!is_decoded_frame) {
+    anim->cur_position = position;
+  }
 
   return cur_frame_final;
 }
@@ -1185,6 +1341,7 @@ static void free_anim_ffmpeg(ImBufAnim *anim)
     av_frame_free(&anim->pFrameDeinterlaced);
     BKE_ffmpeg_sws_release_context(anim->img_convert_ctx);
   }
+  ffmpeg_decoded_frames_free(anim);
   anim->duration_in_frames = 0;
 }
 
@@ -1289,14 +1446,11 @@ ImBuf *IMB_anim_absolute(ImBufAnim *anim,
 #ifdef WITH_FFMPEG
   if (anim->state == ImBufAnim::State::Valid) {
     ibuf = ffmpeg_fetchibuf(anim, position, tc);
-    if (ibuf) {
-      anim->cur_position = position;
-    }
   }
 #endif
 
   if (ibuf) {
-    SNPRINTF(ibuf->filepath, "%s.%04d", anim->filepath, anim->cur_position + 1);
+    SNPRINTF(ibuf->filepath, "%s.%04d", anim->filepath, position + 1);
   }
   return ibuf;
 }
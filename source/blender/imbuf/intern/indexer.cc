@@ -19,6 +19,7 @@
 #include "BLI_path_util.h"
 #include "BLI_string.h"
 #include "BLI_string_utils.hh"
+#include "BLI_task.hh"
 #include "BLI_threads.h"
 #include "BLI_time.h"
 #include "BLI_utildefines.h"
@@ -943,11 +944,15 @@ static void index_rebuild_ffmpeg_finish(FFmpegIndexBuilderContext *context, cons
     }
   }
 
-  for (i = 0; i < context->num_proxy_sizes; i++) {
-    if (context->proxy_sizes_in_use & proxy_sizes[i]) {
-      free_proxy_output_ffmpeg(context->proxy_ctx[i], do_rollback);
-    }
-  }
+  /* Flushing encodes the frames still buffered by each encoder, do it for all sizes at once. */
+  blender::threading::parallel_for(
+      blender::IndexRange(context->num_proxy_sizes), 1, [&](const blender::IndexRange range) {
+        for (const int64_t i : range) {
+          if (context->proxy_sizes_in_use & proxy_sizes[i]) {
+            free_proxy_output_ffmpeg(context->proxy_ctx[i], do_rollback);
+          }
+        }
+      });
 
   avcodec_free_context(&context->iCodecCtx);
   avformat_close_input(&context->iFormatCtx);
@@ -965,9 +970,14 @@ static void index_rebuild_ffmpeg_proc_decoded_frame(FFmpegIndexBuilderContext *c
   uint64_t s_dts = context->seek_pos_dts;
   uint64_t pts = av_get_pts_from_frame(in_frame);
 
-  for (i = 0; i < context->num_proxy_sizes; i++) {
-    add_to_proxy_output_ffmpeg(context->proxy_ctx[i], in_frame);
-  }
+  /* The frame is decoded only once, every proxy size has its own scaling context and encoder,
+   * so all of them can be scaled and encoded in parallel. */
+  blender::threading::parallel_for(
+      blender::IndexRange(context->num_proxy_sizes), 1, [&](const blender::IndexRange range) {
+        for (const int64_t i : range) {
+          add_to_proxy_output_ffmpeg(context->proxy_ctx[i], in_frame);
+        }
+      });
 
   if (!context->start_pts_set) {
     context->start_pts = pts;
@@ -5,6 +5,7 @@
 #include "ply_import_buffer.hh"
 
 #include "BLI_fileops.h"
+#include "BLI_mmap.h"
 
 #include <cstdio>
 #include <cstring>
@@ -25,6 +26,9 @@ PlyReadBuffer::PlyReadBuffer(const char *file_path, size_t read_buffer_size)
 
 PlyReadBuffer::~PlyReadBuffer()
 {
+  if (mmap_file_ != nullptr) {
+    BLI_mmap_free(mmap_file_);
+  }
   if (file_ != nullptr) {
     fclose(file_);
   }
@@ -33,6 +37,65 @@ PlyReadBuffer::~PlyReadBuffer()
 void PlyReadBuffer::after_header(bool is_binary)
 {
   is_binary_ = is_binary;
+  if (is_binary_) {
+    this->load_binary_data();
+  }
+}
+
+void PlyReadBuffer::load_binary_data()
+{
+  if (file_ == nullptr) {
+    return;
+  }
+  const size_t data_offset = buffer_file_offset_ + pos_;
+
+  mmap_file_ = BLI_mmap_open(fileno(file_));
+  if (mmap_file_ != nullptr) {
+    const size_t file_size = BLI_mmap_get_length(mmap_file_);
+    if (file_size >= data_offset) {
+      const uint8_t *data = static_cast<const uint8_t *>(BLI_mmap_get_pointer(mmap_file_));
+      binary_data_ = Span<uint8_t>(data + data_offset, file_size - data_offset);
+      return;
+    }
+    BLI_mmap_free(mmap_file_);
+    mmap_file_ = nullptr;
+  }
+
+  /* The file can't be mapped, read all of the remaining data instead. Start with what is left in
+   * the read buffer, and restore the file position in case the failed mapping changed it. */
+  binary_storage_.extend(Span<char>(buffer_.data() + pos_, buf_used_ - pos_).cast<uint8_t>());
+  BLI_fseek(file_, buffer_file_offset_ + buf_used_, SEEK_SET);
+  while (true) {
+    const int64_t prev_size = binary_storage_.size();
+    binary_storage_.resize(prev_size + read_buffer_size_);
+    const size_t read = fread(binary_storage_.data() + prev_size, 1, read_buffer_size_, file_);
+    binary_storage_.resize(prev_size + read);
+    if (read < read_buffer_size_) {
+      break;
+    }
+  }
+  binary_data_ = binary_storage_;
+}
+
+Span<uint8_t> PlyReadBuffer::binary_data() const
+{
+  BLI_assert(is_binary_);
+  return binary_data_.drop_front(binary_pos_);
+}
+
+bool PlyReadBuffer::skip_bytes(size_t size)
+{
+  BLI_assert(is_binary_);
+  if (size > binary_data_.size() - binary_pos_) {
+    return false;
+  }
+  binary_pos_ += size;
+  return true;
+}
+
+bool PlyReadBuffer::has_io_error() const
+{
+  return mmap_file_ != nullptr && BLI_mmap_any_io_error(mmap_file_);
 }
 
 Span<char> PlyReadBuffer::read_line()
@@ -62,21 +125,15 @@ Span<char> PlyReadBuffer::read_line()
 
 bool PlyReadBuffer::read_bytes(void *dst, size_t size)
 {
-  while (size > 0) {
-    if (pos_ + size > buf_used_) {
-      if (!refill_buffer()) {
-        return false;
-      }
-    }
-    int to_copy = int(size);
-    if (to_copy > buf_used_) {
-      to_copy = buf_used_;
-    }
-    memcpy(dst, buffer_.data() + pos_, to_copy);
-    pos_ += to_copy;
-    dst = (char *)dst + to_copy;
-    size -= to_copy;
+  if (!is_binary_) {
+    throw std::runtime_error("PLY read_bytes should not be used in ascii mode");
+  }
+  const Span<uint8_t> data = this->binary_data();
+  if (size > data.size()) {
+    return false;
   }
+  memcpy(dst, data.data(), size);
+  binary_pos_ += size;
   return true;
 }
 
@@ -91,6 +148,7 @@ bool PlyReadBuffer::refill_buffer()
   }
 
   /* Move any leftover to start of buffer. */
+  buffer_file_offset_ += pos_;
   int keep = buf_used_ - pos_;
   if (keep > 0) {
     memmove(buffer_.data(), buffer_.data() + pos_, keep);
@@ -12,6 +12,9 @@
 
 #include "BLI_array.hh"
 #include "BLI_span.hh"
+#include "BLI_vector.hh"
+
+struct BLI_mmap_file;
 
 namespace blender::io::ply {
 
@@ -38,8 +41,25 @@ class PlyReadBuffer {
    */
   bool read_bytes(void *dst, size_t size);
 
+  /**
+   * In binary mode, returns all remaining data of the file after the current position. The file
+   * is memory-mapped when possible, so the data can be decoded in place (e.g. in parallel) instead
+   * of being copied through the read buffer. Use #skip_bytes to move past the decoded data.
+   */
+  Span<uint8_t> binary_data() const;
+
+  /**
+   * Moves past a number of bytes in binary mode. Returns false if this amount of bytes is not
+   * available.
+   */
+  bool skip_bytes(size_t size);
+
+  /** Whether an IO error happened while accessing memory-mapped file data. */
+  bool has_io_error() const;
+
  private:
   bool refill_buffer();
+  void load_binary_data();
 
  private:
   FILE *file_ = nullptr;
@@ -48,8 +68,17 @@ class PlyReadBuffer {
   int buf_used_ = 0;
   int last_newline_ = 0;
   size_t read_buffer_size_ = 0;
+  /* Offset of the start of #buffer_ in the file. */
+  size_t buffer_file_offset_ = 0;
   bool at_eof_ = false;
   bool is_binary_ = false;
+
+  /* File data after the header in binary mode. Points either into the memory-mapped file,
+   * or into #binary_storage_ when mapping is not possible. */
+  Span<uint8_t> binary_data_;
+  size_t binary_pos_ = 0;
+  BLI_mmap_file *mmap_file_ = nullptr;
+  Vector<uint8_t> binary_storage_;
 };
 
 }  // namespace blender::io::ply
@@ -10,8 +10,11 @@
 #include "ply_data.hh"
 #include "ply_import_buffer.hh"
 
+#include "BLI_array.hh"
 #include "BLI_endian_switch.h"
+#include "BLI_offset_indices.hh"
 #include "BLI_string_ref.hh"
+#include "BLI_task.hh"
 
 #include "fast_float.h"
 
@@ -190,22 +193,18 @@ template<typename T> static T get_binary_value(PlyDataTypes type, const uint8_t
   return val;
 }
 
-static const char *parse_row_binary(PlyReadBuffer &file,
-                                    const PlyHeader &header,
-                                    const PlyElement &element,
-                                    Vector<uint8_t> &r_scratch,
-                                    Vector<float> &r_values)
+/**
+ * Convert a row of binary data to floats. For big endian files the row data is byte-swapped in
+ * place.
+ */
+static const char *convert_row_binary(const PlyHeader &header,
+                                      const PlyElement &element,
+                                      MutableSpan<uint8_t> row,
+                                      MutableSpan<float> r_values)
 {
-  if (element.stride == 0) {
-    return "Vertex/Edge element contains list properties, this is not supported";
-  }
-  BLI_assert(r_scratch.size() == element.stride);
+  BLI_assert(row.size() == element.stride);
   BLI_assert(r_values.size() == element.properties.size());
-  if (!file.read_bytes(r_scratch.data(), r_scratch.size())) {
-    return "Could not read row of binary property";
-  }
-
-  const uint8_t *ptr = r_scratch.data();
+  const uint8_t *ptr = row.data();
   if (header.type == PlyFormatType::BINARY_LE) {
     /* Little endian: just read/convert the values. */
     for (int i = 0, n = int(element.properties.size()); i != n; i++) {
@@ -229,6 +228,22 @@ static const char *parse_row_binary(PlyReadBuffer &file,
   return nullptr;
 }
 
+static const char *parse_row_binary(PlyReadBuffer &file,
+                                    const PlyHeader &header,
+                                    const PlyElement &element,
+                                    Vector<uint8_t> &r_scratch,
+                                    Vector<float> &r_values)
+{
+  if (element.stride == 0) {
+    return "Vertex/Edge element contains list properties, this is not supported";
+  }
+  BLI_assert(r_scratch.size() == element.stride);
+  if (!file.read_bytes(r_scratch.data(), r_scratch.size())) {
+    return "Could not read row of binary property";
+  }
+  return convert_row_binary(header, element, r_scratch, r_values);
+}
+
 static const char *load_vertex_element(PlyReadBuffer &file,
                                        const PlyHeader &header,
                                        const PlyElement &element,
@@ -266,15 +281,15 @@ static const char *load_vertex_element(PlyReadBuffer &file,
     data->vertex_custom_attr.append(attr);
   }
 
-  data->vertices.reserve(element.count);
+  data->vertices.resize(element.count);
   if (has_color) {
-    data->vertex_colors.reserve(element.count);
+    data->vertex_colors.resize(element.count);
   }
   if (has_normal) {
-    data->vertex_normals.reserve(element.count);
+    data->vertex_normals.resize(element.count);
   }
   if (has_uv) {
-    data->uv_coordinates.reserve(element.count);
+    data->uv_coordinates.resize(element.count);
   }
 
   float4 color_norm = {1, 1, 1, 1};
@@ -287,31 +302,13 @@ static const char *load_vertex_element(PlyReadBuffer &file,
     color_norm.w = data_type_normalizer[element.properties[alpha_index].type];
   }
 
-  Vector<float> value_vec(element.properties.size());
-  Vector<uint8_t> scratch;
-  if (header.type != PlyFormatType::ASCII) {
-    scratch.resize(element.stride);
-  }
-
-  for (int i = 0; i < element.count; i++) {
-
-    const char *error = nullptr;
-    if (header.type == PlyFormatType::ASCII) {
-      error = parse_row_ascii(file, value_vec);
-    }
-    else {
-      error = parse_row_binary(file, header, element, scratch, value_vec);
-    }
-    if (error != nullptr) {
-      return error;
-    }
-
+  auto store_row = [&](const int i, const Span<float> value_vec) {
     /* Vertex coord */
     float3 vertex3;
     vertex3.x = value_vec[vertex_index.x];
     vertex3.y = value_vec[vertex_index.y];
     vertex3.z = value_vec[vertex_index.z];
-    data->vertices.append(vertex3);
+    data->vertices[i] = vertex3;
 
     /* Vertex color */
     if (has_color) {
@@ -325,7 +322,7 @@ static const char *load_vertex_element(PlyReadBuffer &file,
       else {
         colors4.w = 1.0f;
       }
-      data->vertex_colors.append(colors4);
+      data->vertex_colors[i] = colors4;
     }
 
     /* If normals */
@@ -334,7 +331,7 @@ static const char *load_vertex_element(PlyReadBuffer &file,
       normals3.x = value_vec[normal_index.x];
       normals3.y = value_vec[normal_index.y];
       normals3.z = value_vec[normal_index.z];
-      data->vertex_normals.append(normals3);
+      data->vertex_normals[i] = normals3;
     }
 
     /* If uv */
@@ -342,7 +339,7 @@ static const char *load_vertex_element(PlyReadBuffer &file,
       float2 uvmap;
       uvmap.x = value_vec[uv_index.x];
       uvmap.y = value_vec[uv_index.y];
-      data->uv_coordinates.append(uvmap);
+      data->uv_coordinates[i] = uvmap;
     }
 
     /* Custom attributes */
@@ -350,7 +347,40 @@ static const char *load_vertex_element(PlyReadBuffer &file,
       float value = value_vec[custom_attr_indices[ci]];
       data->vertex_custom_attr[ci].data[i] = value;
     }
+  };
+
+  if (header.type == PlyFormatType::ASCII) {
+    Vector<float> value_vec(element.properties.size());
+    for (int i = 0; i < element.count; i++) {
+      const char *error = parse_row_ascii(file, value_vec);
+      if (error != nullptr) {
+        return error;
+      }
+      store_row(i, value_vec);
+    }
+    return nullptr;
   }
+
+  /* Binary rows have a fixed size, so they can be decoded directly from the file data,
+   * in parallel. */
+  if (element.stride == 0) {
+    return "Vertex/Edge element contains list properties, this is not supported";
+  }
+  const Span<uint8_t> rows = file.binary_data();
+  const int64_t stride = element.stride;
+  if (rows.size() < element.count * stride) {
+    return "Could not read row of binary property";
+  }
+  threading::parallel_for(IndexRange(element.count), 4096, [&](const IndexRange range) {
+    Vector<uint8_t> scratch(stride);
+    Vector<float> value_vec(element.properties.size());
+    for (const int i : range) {
+      scratch.as_mutable_span().copy_from(rows.slice(i * stride, stride));
+      convert_row_binary(header, element, scratch, value_vec);
+      store_row(i, value_vec);
+    }
+  });
+  file.skip_bytes(element.count * stride);
   return nullptr;
 }
 
@@ -454,48 +484,65 @@ static const char *load_face_element(PlyReadBuffer &file,
   }
   else {
     Vector<uint8_t> scratch(64);
+    const bool big_endian = header.type == PlyFormatType::BINARY_BE;
+    const int index_size = data_type_size[prop.type];
 
+    /* Find the vertex indices of all faces first, then decode them in parallel. */
+    Vector<const uint8_t *> face_indices_data;
+    face_indices_data.reserve(element.count);
     for (int i = 0; i < element.count; i++) {
-      const uint8_t *ptr;
-
       /* Skip any properties before vertex indices. */
       for (int j = 0; j < prop_index; j++) {
-        skip_property(
-            file, element.properties[j], scratch, header.type == PlyFormatType::BINARY_BE);
+        skip_property(file, element.properties[j], scratch, big_endian);
       }
 
       /* Read vertex indices list. */
-      uint32_t count = read_list_count(
-          file, prop, scratch, header.type == PlyFormatType::BINARY_BE);
+      uint32_t count = read_list_count(file, prop, scratch, big_endian);
       if (count < 1 || count > 255) {
         return "Invalid face size, must be between 1 and 255";
       }
 
-      scratch.resize(count * data_type_size[prop.type]);
-      file.read_bytes(scratch.data(), scratch.size());
+      const uint8_t *indices_data = file.binary_data().data();
+      if (!file.skip_bytes(count * index_size)) {
+        return "Could not read face vertex indices";
+      }
       /* Previous python based importer was accepting faces with fewer
        * than 3 vertices, and silently dropping them. */
       if (count < 3) {
         fprintf(stderr, "PLY Importer: ignoring face %i (%i vertices)\n", i, int(count));
       }
       else {
-        ptr = scratch.data();
-        if (header.type == PlyFormatType::BINARY_BE) {
-          endian_switch_array((uint8_t *)ptr, data_type_size[prop.type], count);
-        }
-        for (int j = 0; j < count; ++j) {
-          uint32_t index = get_binary_value<uint32_t>(prop.type, ptr);
-          data->face_vertices.append(index);
-        }
+        face_indices_data.append(indices_data);
         data->face_sizes.append(count);
       }
 
       /* Skip any properties after vertex indices. */
       for (int j = prop_index + 1; j < element.properties.size(); j++) {
-        skip_property(
-            file, element.properties[j], scratch, header.type == PlyFormatType::BINARY_BE);
+        skip_property(file, element.properties[j], scratch, big_endian);
       }
     }
+
+    Array<int> face_offsets_data(data->face_sizes.size() + 1);
+    for (const int i : data->face_sizes.index_range()) {
+      face_offsets_data[i] = data->face_sizes[i];
+    }
+    const OffsetIndices faces = offset_indices::accumulate_counts_to_offsets(face_offsets_data);
+    data->face_vertices.resize(faces.total_size());
+    threading::parallel_for(faces.index_range(), 1024, [&](const IndexRange range) {
+      for (const int face : range) {
+        const uint8_t *src = face_indices_data[face];
+        for (const int corner : faces[face]) {
+          uint8_t value[8];
+          memcpy(value, src, index_size);
+          src += index_size;
+          if (big_endian) {
+            endian_switch(value, index_size);
+          }
+          const uint8_t *ptr = value;
+          data->face_vertices[corner] = get_binary_value<uint32_t>(prop.type, ptr);
+        }
+      }
+    });
   }
   return nullptr;
 }
@@ -663,6 +710,9 @@ std::unique_ptr<PlyData> import_ply_data(PlyReadBuffer &file, PlyHeader &header)
     else {
       error = skip_element(file, header, element);
     }
+    if (error == nullptr && file.has_io_error()) {
+      error = "IO error while reading file";
+    }
     if (error != nullptr) {
       data->error = error;
       return data;
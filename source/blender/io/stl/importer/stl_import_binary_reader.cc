@@ -6,12 +6,17 @@
  * \ingroup stl
  */
 
+#include <algorithm>
 #include <cstdint>
 #include <cstdio>
 
+#include "BKE_lib_id.hh"
 #include "BKE_mesh.hh"
 
 #include "BLI_array.hh"
+#include "BLI_fileops.h"
+#include "BLI_memory_utils.hh"
+#include "BLI_mmap.h"
 
 #include "DNA_mesh_types.h"
 
@@ -24,7 +29,6 @@ namespace blender::io::stl {
 
 Mesh *read_stl_binary(FILE *file, const bool use_custom_normals)
 {
-  const int chunk_size = 1024;
   uint32_t num_tris = 0;
   fseek(file, BINARY_HEADER_SIZE, SEEK_SET);
   if (fread(&num_tris, sizeof(uint32_t), 1, file) != 1) {
@@ -32,20 +36,52 @@ Mesh *read_stl_binary(FILE *file, const bool use_custom_normals)
     return nullptr;
   }
 
+  /* The triangle count in the header is not trusted, never allocate more triangles than the file
+   * holds. */
+  const size_t tris_offset = BINARY_HEADER_SIZE + sizeof(uint32_t);
+  const size_t file_size = BLI_file_descriptor_size(fileno(file));
+  if (file_size == size_t(-1)) {
+    fprintf(stderr, "STL Importer: failed to get the file size.\n");
+    return nullptr;
+  }
+  const size_t max_tris = (file_size > tris_offset) ? (file_size - tris_offset) / BINARY_STRIDE :
+                                                      0;
+  num_tris = uint32_t(std::min<size_t>(num_tris, max_tris));
+
   if (num_tris == 0) {
     return BKE_mesh_new_nomain(0, 0, 0, 0);
   }
 
-  Array<PackedTriangle> tris_buf(chunk_size);
-  STLMeshHelper stl_mesh(num_tris, use_custom_normals);
-  size_t num_read_tris;
-  while ((num_read_tris = fread(tris_buf.data(), sizeof(PackedTriangle), chunk_size, file))) {
-    for (size_t i = 0; i < num_read_tris; i++) {
-      stl_mesh.add_triangle(tris_buf[i]);
+  /* Use the triangles directly from the memory-mapped file when possible, otherwise read them
+   * all at once. */
+  BLI_mmap_file *mmap_file = BLI_mmap_open(fileno(file));
+  BLI_SCOPED_DEFER([&]() {
+    if (mmap_file) {
+      BLI_mmap_free(mmap_file);
     }
+  });
+  Array<PackedTriangle> tris_buf;
+  Span<PackedTriangle> tris;
+  if (mmap_file && BLI_mmap_get_length(mmap_file) >= tris_offset + num_tris * BINARY_STRIDE) {
+    const char *data = static_cast<const char *>(BLI_mmap_get_pointer(mmap_file));
+    tris = Span<PackedTriangle>(reinterpret_cast<const PackedTriangle *>(data + tris_offset),
+                                num_tris);
+  }
+  else {
+    tris_buf.reinitialize(num_tris);
+    fseek(file, tris_offset, SEEK_SET);
+    const size_t num_read_tris = fread(tris_buf.data(), sizeof(PackedTriangle), num_tris, file);
+    tris = tris_buf.as_span().take_front(num_read_tris);
   }
 
-  return stl_mesh.to_mesh();
+  Mesh *mesh = stl_triangles_to_mesh(tris, use_custom_normals);
+
+  if (mmap_file && BLI_mmap_any_io_error(mmap_file)) {
+    fprintf(stderr, "STL Importer: failed to read file, IO error.\n");
+    BKE_id_free(nullptr, mesh);
+    return nullptr;
+  }
+  return mesh;
 }
 
 }  // namespace blender::io::stl
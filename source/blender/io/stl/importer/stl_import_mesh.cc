@@ -10,8 +10,12 @@
 
 #include "BKE_mesh.hh"
 
+#include "BLI_array.hh"
 #include "BLI_array_utils.hh"
+#include "BLI_index_mask.hh"
+#include "BLI_map.hh"
 #include "BLI_span.hh"
+#include "BLI_task.hh"
 
 #include "DNA_mesh_types.h"
 
@@ -53,16 +57,21 @@ bool STLMeshHelper::add_triangle(const PackedTriangle &data)
   return true;
 }
 
-Mesh *STLMeshHelper::to_mesh()
+static void report_removed_triangles(const int degenerate_tris_num, const int duplicate_tris_num)
 {
-  if (degenerate_tris_num_ > 0) {
-    std::cout << "STL Importer: " << degenerate_tris_num_ << " degenerate triangles were removed"
+  if (degenerate_tris_num > 0) {
+    std::cout << "STL Importer: " << degenerate_tris_num << " degenerate triangles were removed"
               << std::endl;
   }
-  if (duplicate_tris_num_ > 0) {
-    std::cout << "STL Importer: " << duplicate_tris_num_ << " duplicate triangles were removed"
+  if (duplicate_tris_num > 0) {
+    std::cout << "STL Importer: " << duplicate_tris_num << " duplicate triangles were removed"
               << std::endl;
   }
+}
+
+Mesh *STLMeshHelper::to_mesh()
+{
+  report_removed_triangles(degenerate_tris_num_, duplicate_tris_num_);
 
   Mesh *mesh = BKE_mesh_new_nomain(verts_.size(), 0, tris_.size(), tris_.size() * 3);
   mesh->vert_positions_for_write().copy_from(verts_);
@@ -79,4 +88,130 @@ Mesh *STLMeshHelper::to_mesh()
   return mesh;
 }
 
+/* Elements are distributed into this many hash buckets, which are searched for duplicates in
+ * parallel. */
+static constexpr int dedup_bucket_bits = 10;
+
+static int dedup_bucket(const uint64_t hash)
+{
+  /* Use the high bits of a multiplicative hash, the low bits are used by the #Map in a bucket. */
+  return int((hash * 0x9E3779B97F4A7C15ull) >> (64 - dedup_bucket_bits));
+}
+
+/**
+ * For every element, find the index of the first element that is equal to it.
+ */
+template<typename T, typename GetElementFn>
+static void find_first_occurrences(const int size,
+                                   const GetElementFn &get_element,
+                                   MutableSpan<int> r_first_indices)
+{
+  Array<int16_t> element_buckets(size);
+  threading::parallel_for(IndexRange(size), 4096, [&](const IndexRange range) {
+    for (const int i : range) {
+      element_buckets[i] = dedup_bucket(DefaultHash<T>{}(get_element(i)));
+    }
+  });
+
+  /* Sort element indices by bucket, keeping them in ascending order within each bucket. */
+  Array<int> offsets_data((1 << dedup_bucket_bits) + 1, 0);
+  for (const int16_t bucket : element_buckets) {
+    offsets_data[bucket]++;
+  }
+  const OffsetIndices buckets = offset_indices::accumulate_counts_to_offsets(offsets_data);
+  Array<int> sorted_indices(size);
+  {
+    Array<int> fill_offsets(offsets_data.as_span().drop_back(1));
+    for (const int i : IndexRange(size)) {
+      sorted_indices[fill_offsets[element_buckets[i]]++] = i;
+    }
+  }
+
+  threading::parallel_for(buckets.index_range(), 1, [&](const IndexRange range) {
+    for (const int bucket : range) {
+      const Span<int> indices = sorted_indices.as_span().slice(buckets[bucket]);
+      Map<T, int> first_indices;
+      first_indices.reserve(indices.size());
+      for (const int i : indices) {
+        r_first_indices[i] = first_indices.lookup_or_add(get_element(i), i);
+      }
+    }
+  });
+}
+
+Mesh *stl_triangles_to_mesh(const Span<PackedTriangle> tris, const bool use_custom_normals)
+{
+  const int corners_num = int(tris.size()) * 3;
+
+  /* Merge vertices with the same position, numbered in order of their first occurrence. */
+  Array<int> all_corner_verts(corners_num);
+  find_first_occurrences<float3>(
+      corners_num,
+      [&](const int corner) -> float3 { return tris[corner / 3].vertices[corner % 3]; },
+      all_corner_verts);
+  Vector<int> vert_first_corners;
+  for (const int corner : IndexRange(corners_num)) {
+    const int first_corner = all_corner_verts[corner];
+    if (first_corner == corner) {
+      all_corner_verts[corner] = vert_first_corners.append_and_get_index(corner);
+    }
+    else {
+      /* The first corner comes earlier, so it already contains the vertex index. */
+      all_corner_verts[corner] = all_corner_verts[first_corner];
+    }
+  }
+
+  /* Remove degenerate and duplicate triangles. */
+  const Span<Triangle> all_tris = all_corner_verts.as_span().cast<Triangle>();
+  IndexMaskMemory memory;
+  const IndexMask valid_tris = IndexMask::from_predicate(
+      all_tris.index_range(), GrainSize(4096), memory, [&](const int tri) {
+        const Triangle &t = all_tris[tri];
+        return t.v1 != t.v2 && t.v1 != t.v3 && t.v2 != t.v3;
+      });
+  Array<int> valid_tri_indices(valid_tris.size());
+  valid_tris.to_indices(valid_tri_indices.as_mutable_span());
+  Array<int> first_valid_tris(valid_tris.size());
+  find_first_occurrences<Triangle>(
+      valid_tris.size(),
+      [&](const int i) -> const Triangle & { return all_tris[valid_tri_indices[i]]; },
+      first_valid_tris);
+  const IndexMask unique_tris = IndexMask::from_predicate(
+      valid_tri_indices.index_range(), GrainSize(4096), memory, [&](const int i) {
+        return first_valid_tris[i] == i;
+      });
+
+  report_removed_triangles(int(all_tris.size() - valid_tris.size()),
+                           int(valid_tris.size() - unique_tris.size()));
+
+  const int tris_num = unique_tris.size();
+  Mesh *mesh = BKE_mesh_new_nomain(vert_first_corners.size(), 0, tris_num, tris_num * 3);
+  MutableSpan<float3> positions = mesh->vert_positions_for_write();
+  threading::parallel_for(positions.index_range(), 4096, [&](const IndexRange range) {
+    for (const int vert : range) {
+      const int corner = vert_first_corners[vert];
+      positions[vert] = tris[corner / 3].vertices[corner % 3];
+    }
+  });
+  offset_indices::fill_constant_group_size(3, 0, mesh->face_offsets_for_write());
+  MutableSpan<Triangle> mesh_tris = mesh->corner_verts_for_write().cast<Triangle>();
+  unique_tris.foreach_index(GrainSize(4096), [&](const int i, const int face) {
+    mesh_tris[face] = all_tris[valid_tri_indices[i]];
+  });
+
+  /* NOTE: edges must be calculated first before setting custom normals. */
+  bke::mesh_calc_edges(*mesh, false, false);
+
+  if (use_custom_normals) {
+    Array<float3> corner_normals(mesh->corners_num);
+    unique_tris.foreach_index(GrainSize(4096), [&](const int i, const int face) {
+      corner_normals.as_mutable_span().slice(face * 3, 3).fill(
+          tris[valid_tri_indices[i]].normal);
+    });
+    BKE_mesh_set_custom_normals(mesh, reinterpret_cast<float(*)[3]>(corner_normals.data()));
+  }
+
+  return mesh;
+}
+
 }  // namespace blender::io::stl
@@ -11,6 +11,7 @@
 #include <cstdint>
 
 #include "BLI_math_vector_types.hh"
+#include "BLI_span.hh"
 #include "BLI_vector.hh"
 #include "BLI_vector_set.hh"
 #include "stl_data.hh"
@@ -67,4 +68,11 @@ class STLMeshHelper {
   Mesh *to_mesh();
 };
 
+/**
+ * Create a mesh from a triangle soup, with the same result as adding all triangles to
+ * #STLMeshHelper: duplicate vertices are merged and degenerate or duplicate triangles removed,
+ * keeping the first occurrence of everything. Duplicates are found in parallel.
+ */
+Mesh *stl_triangles_to_mesh(Span<PackedTriangle> tris, bool use_custom_normals);
+
 }  // namespace blender::io::stl
@@ -8,12 +8,14 @@
 
 #include "BKE_report.hh"
 
+#include "BLI_array.hh"
 #include "BLI_fileops.hh"
 #include "BLI_map.hh"
 #include "BLI_math_vector.h"
 #include "BLI_math_vector_types.hh"
 #include "BLI_string.h"
 #include "BLI_string_ref.hh"
+#include "BLI_task.hh"
 #include "BLI_vector.hh"
 
 #include "obj_export_mtl.hh"
@@ -225,30 +227,30 @@ static void geom_add_polyline(Geometry *geom,
   }
 }
 
-static void geom_add_polygon(Geometry *geom,
-                             const char *p,
-                             const char *end,
-                             const GlobalVertices &global_vertices,
-                             const int material_index,
-                             const int group_index,
-                             const bool shaded_smooth)
-{
-  FaceElem curr_face;
-  curr_face.shaded_smooth = shaded_smooth;
-  curr_face.material_index = material_index;
-  if (group_index >= 0) {
-    curr_face.vertex_group_index = group_index;
-    geom->has_vertex_groups_ = true;
-  }
-
-  const int orig_corners_size = geom->face_corners_.size();
-  curr_face.start_index_ = orig_corners_size;
+/**
+ * Face corner as spelled out in the file, before the indices are transformed to be
+ * non-negative and zero-based. Resolving relative indices needs the amount of vertex data
+ * read so far, which is only known once all previous chunks of the file have been parsed.
+ */
+struct ParsedFaceCorner {
+  FaceCorner corner;
+  bool got_uv = false;
+  bool got_normal = false;
+};
 
+/**
+ * Parse corners of a face line ("f v1/vt1/vn1 ..."), without any validation of the indices.
+ * Returns false if the face is syntactically invalid.
+ */
+static bool parse_polygon_corners(const char *p,
+                                  const char *end,
+                                  Vector<ParsedFaceCorner> &r_corners)
+{
   bool face_valid = true;
   p = drop_whitespace(p, end);
   while (p < end && face_valid) {
-    FaceCorner corner;
-    bool got_uv = false, got_normal = false;
+    ParsedFaceCorner parsed;
+    FaceCorner &corner = parsed.corner;
     /* Parse vertex index. */
     p = parse_int(p, end, INT32_MAX, corner.vert_index, false);
 
@@ -263,15 +265,47 @@ static void geom_add_polygon(Geometry *geom,
       ++p;
       if (p < end && *p != '/') {
         p = parse_int(p, end, INT32_MAX, corner.uv_vert_index, false);
-        got_uv = corner.uv_vert_index != INT32_MAX;
+        parsed.got_uv = corner.uv_vert_index != INT32_MAX;
       }
       /* Parse normal index. */
       if (p < end && *p == '/') {
         ++p;
         p = parse_int(p, end, INT32_MAX, corner.vertex_normal_index, false);
-        got_normal = corner.vertex_normal_index != INT32_MAX;
+        parsed.got_normal = corner.vertex_normal_index != INT32_MAX;
       }
     }
+    r_corners.append(parsed);
+
+    /* Some files contain extra stuff per face (e.g. 4 indices); skip any remainder (#103441). */
+    p = drop_non_whitespace(p, end);
+    /* Skip whitespace to get to the next face corner. */
+    p = drop_whitespace(p, end);
+  }
+  return face_valid;
+}
+
+static void geom_add_polygon(Geometry *geom,
+                             const Span<ParsedFaceCorner> parsed_corners,
+                             const bool parsed_valid,
+                             const GlobalVertices &global_vertices,
+                             const int material_index,
+                             const int group_index,
+                             const bool shaded_smooth)
+{
+  FaceElem curr_face;
+  curr_face.shaded_smooth = shaded_smooth;
+  curr_face.material_index = material_index;
+  if (group_index >= 0) {
+    curr_face.vertex_group_index = group_index;
+    geom->has_vertex_groups_ = true;
+  }
+
+  const int orig_corners_size = geom->face_corners_.size();
+  curr_face.start_index_ = orig_corners_size;
+
+  bool face_valid = true;
+  for (const ParsedFaceCorner &parsed : parsed_corners) {
+    FaceCorner corner = parsed.corner;
     /* Always keep stored indices non-negative and zero-based. */
     corner.vert_index += corner.vert_index < 0 ? global_vertices.vertices.size() : -1;
     if (corner.vert_index < 0 || corner.vert_index >= global_vertices.vertices.size()) {
@@ -285,7 +319,7 @@ static void geom_add_polygon(Geometry *geom,
       geom->track_vertex_index(corner.vert_index);
     }
     /* Ignore UV index, if the geometry does not have any UVs (#103212). */
-    if (got_uv && !global_vertices.uv_vertices.is_empty()) {
+    if (parsed.got_uv && !global_vertices.uv_vertices.is_empty()) {
       corner.uv_vert_index += corner.uv_vert_index < 0 ? global_vertices.uv_vertices.size() : -1;
       if (corner.uv_vert_index < 0 || corner.uv_vert_index >= global_vertices.uv_vertices.size()) {
         fprintf(stderr,
@@ -298,7 +332,7 @@ static void geom_add_polygon(Geometry *geom,
     /* Ignore corner normal index, if the geometry does not have any normals.
      * Some obj files out there do have face definitions that refer to normal indices,
      * without any normals being present (#98782). */
-    if (got_normal && !global_vertices.vert_normals.is_empty()) {
+    if (parsed.got_normal && !global_vertices.vert_normals.is_empty()) {
       corner.vertex_normal_index += corner.vertex_normal_index < 0 ?
                                         global_vertices.vert_normals.size() :
                                         -1;
@@ -314,12 +348,11 @@ static void geom_add_polygon(Geometry *geom,
     }
     geom->face_corners_.append(corner);
     curr_face.corner_count_++;
-
-    /* Some files contain extra stuff per face (e.g. 4 indices); skip any remainder (#103441). */
-    p = drop_non_whitespace(p, end);
-    /* Skip whitespace to get to the next face corner. */
-    p = drop_whitespace(p, end);
+    if (!face_valid) {
+      break;
+    }
   }
+  face_valid &= parsed_valid;
 
   if (face_valid) {
     geom->face_elements_.append(curr_face);
@@ -456,6 +489,11 @@ OBJParser::OBJParser(const OBJImportParams &import_params, size_t read_buffer_si
                 import_params_.filepath);
     return;
   }
+  /* No need for a read buffer larger than the whole file. */
+  const size_t file_size = BLI_file_size(import_params_.filepath);
+  if (file_size != size_t(-1)) {
+    read_buffer_size_ = std::min(read_buffer_size_, file_size + 1);
+  }
 }
 
 OBJParser::~OBJParser()
@@ -500,6 +538,230 @@ static void use_all_vertices_if_no_faces(Geometry *geom,
   }
 }
 
+/**
+ * OBJ lines that depend on, or modify, the parser state (current object, material, group etc.).
+ * These can't be processed independently when a chunk of the file is parsed on a worker thread,
+ * so they are recorded and processed in file order afterwards.
+ */
+enum class DeferredLineType : int8_t {
+  Face,
+  Polyline,
+  Object,
+  Group,
+  SmoothGroup,
+  UseMaterial,
+  MaterialLibrary,
+  MRGBColors,
+  CurveType,
+  CurveDegree,
+  CurveIndices,
+  CurveParameters,
+  Unknown,
+};
+
+struct DeferredLine {
+  DeferredLineType type;
+  /* Remainder of the line after the keyword. */
+  const char *p;
+  const char *end;
+  /* Amount of vertex data in the chunk that precedes this line. */
+  int vertices_num;
+  int uv_vertices_num;
+  int vert_normals_num;
+  /* Range in #ParsedChunk::face_corners, only used for faces. */
+  int face_corners_start = 0;
+  int face_corners_num = 0;
+  bool face_valid = true;
+};
+
+/**
+ * Result of parsing one chunk of the input buffer. Vertex data and face corners are parsed into
+ * chunk-local storage, everything else is recorded as #DeferredLine.
+ */
+struct ParsedChunk {
+  GlobalVertices vertices;
+  Vector<ParsedFaceCorner> face_corners;
+  Vector<DeferredLine> lines;
+  size_t lines_num = 0;
+
+  /* Amount of chunk-local vertex data already appended to the global vertex data. */
+  int flushed_vertices_num = 0;
+  int flushed_uv_vertices_num = 0;
+  int flushed_vert_normals_num = 0;
+  int flushed_color_block = 0;
+
+  /**
+   * Append chunk-local vertex data to the global vertex data, until it contains the same amount
+   * of data as it would have when parsing the file sequentially up to that point.
+   */
+  void flush_vertices(const int vertices_num,
+                      const int uv_vertices_num,
+                      const int vert_normals_num,
+                      GlobalVertices &r_global_vertices)
+  {
+    const int base_vertex_index = r_global_vertices.vertices.size() - flushed_vertices_num;
+    r_global_vertices.vertices.extend(
+        vertices.vertices.as_span().slice(flushed_vertices_num, vertices_num - flushed_vertices_num));
+    r_global_vertices.uv_vertices.extend(vertices.uv_vertices.as_span().slice(
+        flushed_uv_vertices_num, uv_vertices_num - flushed_uv_vertices_num));
+    r_global_vertices.vert_normals.extend(vertices.vert_normals.as_span().slice(
+        flushed_vert_normals_num, vert_normals_num - flushed_vert_normals_num));
+
+    /* Colors of the flushed vertices, merged into the previous block when contiguous. */
+    while (flushed_color_block < vertices.vertex_colors.size()) {
+      const GlobalVertices::VertexColorsBlock &block = vertices.vertex_colors[flushed_color_block];
+      const int block_end = block.start_vertex_index + block.colors.size();
+      const int start = std::max(block.start_vertex_index, flushed_vertices_num);
+      const int end = std::min(block_end, vertices_num);
+      if (start >= end) {
+        break;
+      }
+      auto &blocks = r_global_vertices.vertex_colors;
+      if (blocks.is_empty() || (blocks.last().start_vertex_index + blocks.last().colors.size() !=
+                                base_vertex_index + start))
+      {
+        GlobalVertices::VertexColorsBlock new_block;
+        new_block.start_vertex_index = base_vertex_index + start;
+        blocks.append(new_block);
+      }
+      blocks.last().colors.extend(
+          block.colors.as_span().slice(start - block.start_vertex_index, end - start));
+      if (end < block_end) {
+        break;
+      }
+      flushed_color_block++;
+    }
+
+    flushed_vertices_num = vertices_num;
+    flushed_uv_vertices_num = uv_vertices_num;
+    flushed_vert_normals_num = vert_normals_num;
+  }
+
+  void flush_all_vertices(GlobalVertices &r_global_vertices)
+  {
+    this->flush_vertices(vertices.vertices.size(),
+                         vertices.uv_vertices.size(),
+                         vertices.vert_normals.size(),
+                         r_global_vertices);
+  }
+};
+
+/**
+ * Parse the given lines of the file. This does not depend on any other part of the file, so
+ * multiple chunks can be parsed in parallel.
+ */
+static void parse_chunk(StringRef buffer_str, ParsedChunk &r_chunk)
+{
+  while (!buffer_str.is_empty()) {
+    StringRef line = read_next_line(buffer_str);
+    const char *p = line.begin(), *end = line.end();
+    p = drop_whitespace(p, end);
+    ++r_chunk.lines_num;
+    if (p == end) {
+      continue;
+    }
+    /* Most common things that start with 'v': vertices, normals, UVs. */
+    if (*p == 'v') {
+      if (parse_keyword(p, end, "v")) {
+        geom_add_vertex(p, end, r_chunk.vertices);
+      }
+      else if (parse_keyword(p, end, "vn")) {
+        geom_add_vertex_normal(p, end, r_chunk.vertices);
+      }
+      else if (parse_keyword(p, end, "vt")) {
+        geom_add_uv_vertex(p, end, r_chunk.vertices);
+      }
+      continue;
+    }
+
+    DeferredLineType type;
+    /* Faces. */
+    if (parse_keyword(p, end, "f")) {
+      type = DeferredLineType::Face;
+    }
+    /* Polylines. */
+    else if (parse_keyword(p, end, "l")) {
+      type = DeferredLineType::Polyline;
+    }
+    /* Objects. */
+    else if (parse_keyword(p, end, "o")) {
+      type = DeferredLineType::Object;
+    }
+    /* Groups. */
+    else if (parse_keyword(p, end, "g")) {
+      type = DeferredLineType::Group;
+    }
+    /* Smoothing groups. */
+    else if (parse_keyword(p, end, "s")) {
+      type = DeferredLineType::SmoothGroup;
+    }
+    /* Materials and their libraries. */
+    else if (parse_keyword(p, end, "usemtl")) {
+      type = DeferredLineType::UseMaterial;
+    }
+    else if (parse_keyword(p, end, "mtllib")) {
+      type = DeferredLineType::MaterialLibrary;
+    }
+    else if (parse_keyword(p, end, "#MRGB")) {
+      type = DeferredLineType::MRGBColors;
+    }
+    /* Comments. */
+    else if (*p == '#') {
+      continue;
+    }
+    /* Curve related things. */
+    else if (parse_keyword(p, end, "cstype")) {
+      type = DeferredLineType::CurveType;
+    }
+    else if (parse_keyword(p, end, "deg")) {
+      type = DeferredLineType::CurveDegree;
+    }
+    else if (parse_keyword(p, end, "curv")) {
+      type = DeferredLineType::CurveIndices;
+    }
+    else if (parse_keyword(p, end, "parm")) {
+      type = DeferredLineType::CurveParameters;
+    }
+    else if (StringRef(p, end).startswith("end")) {
+      /* End of curve definition, nothing else to do. */
+      continue;
+    }
+    else {
+      type = DeferredLineType::Unknown;
+    }
+
+    DeferredLine deferred;
+    deferred.type = type;
+    deferred.p = p;
+    deferred.end = end;
+    deferred.vertices_num = r_chunk.vertices.vertices.size();
+    deferred.uv_vertices_num = r_chunk.vertices.uv_vertices.size();
+    deferred.vert_normals_num = r_chunk.vertices.vert_normals.size();
+    if (type == DeferredLineType::Face) {
+      deferred.face_corners_start = r_chunk.face_corners.size();
+      deferred.face_valid = parse_polygon_corners(p, end, r_chunk.face_corners);
+      deferred.face_corners_num = r_chunk.face_corners.size() - deferred.face_corners_start;
+    }
+    r_chunk.lines.append(deferred);
+  }
+}
+
+/**
+ * Split the buffer into chunks of roughly the given size, at line boundaries.
+ * The buffer is expected to end with a newline.
+ */
+static Vector<StringRef> split_into_chunks(StringRef buffer_str, const int64_t chunk_size)
+{
+  Vector<StringRef> chunks;
+  while (!buffer_str.is_empty()) {
+    const int64_t newline = buffer_str.find('\n', std::min(chunk_size, buffer_str.size()) - 1);
+    const int64_t size = newline == StringRef::not_found ? buffer_str.size() : newline + 1;
+    chunks.append(buffer_str.substr(0, size));
+    buffer_str = buffer_str.drop_prefix(size);
+  }
+  return chunks;
+}
+
 void OBJParser::parse(Vector<std::unique_ptr<Geometry>> &r_all_geometries,
                       GlobalVertices &r_global_vertices)
 {
@@ -526,6 +788,9 @@ void OBJParser::parse(Vector<std::unique_ptr<Geometry>> &r_all_geometries,
    * to possibly store remainder of the previous input line that got broken mid-chunk. */
   Array<char> buffer(read_buffer_size_ * 2);
 
+  /* Each read buffer is split into roughly 64 chunks that are parsed in parallel. */
+  const int64_t parse_chunk_size = std::max<int64_t>(read_buffer_size_ / 64, 1);
+
   size_t buffer_offset = 0;
   size_t line_number = 0;
   while (true) {
@@ -571,128 +836,119 @@ void OBJParser::parse(Vector<std::unique_ptr<Geometry>> &r_all_geometries,
     }
     ++last_nl;
 
-    /* Parse the buffer (until last newline) that we have so far,
-     * line by line. */
-    StringRef buffer_str{buffer.data(), int64_t(last_nl)};
-    while (!buffer_str.is_empty()) {
-      StringRef line = read_next_line(buffer_str);
-      const char *p = line.begin(), *end = line.end();
-      p = drop_whitespace(p, end);
-      ++line_number;
-      if (p == end) {
-        continue;
-      }
-      /* Most common things that start with 'v': vertices, normals, UVs. */
-      if (*p == 'v') {
-        if (parse_keyword(p, end, "v")) {
-          geom_add_vertex(p, end, r_global_vertices);
-        }
-        else if (parse_keyword(p, end, "vn")) {
-          geom_add_vertex_normal(p, end, r_global_vertices);
-        }
-        else if (parse_keyword(p, end, "vt")) {
-          geom_add_uv_vertex(p, end, r_global_vertices);
-        }
+    /* Parse the buffer (until last newline) that we have so far. Chunks are parsed in
+     * parallel, the results are then added to the geometries in file order. */
+    const Vector<StringRef> chunks = split_into_chunks(StringRef(buffer.data(), int64_t(last_nl)),
+                                                       parse_chunk_size);
+    Array<ParsedChunk> parsed_chunks(chunks.size());
+    threading::parallel_for(chunks.index_range(), 1, [&](IndexRange range) {
+      for (const int64_t i : range) {
+        parse_chunk(chunks[i], parsed_chunks[i]);
       }
-      /* Faces. */
-      else if (parse_keyword(p, end, "f")) {
-        /* If we don't have a material index assigned yet, get one.
-         * It means "usemtl" state came from the previous object. */
-        if (state_material_index == -1 && !state_material_name.empty() &&
-            curr_geom->material_indices_.is_empty())
-        {
-          curr_geom->material_indices_.add_new(state_material_name, 0);
-          curr_geom->material_order_.append(state_material_name);
-          state_material_index = 0;
-        }
-
-        geom_add_polygon(curr_geom,
-                         p,
-                         end,
-                         r_global_vertices,
-                         state_material_index,
-                         state_group_index,
-                         state_shaded_smooth);
-      }
-      /* Faces. */
-      else if (parse_keyword(p, end, "l")) {
-        geom_add_polyline(curr_geom, p, end, r_global_vertices);
-      }
-      /* Objects. */
-      else if (parse_keyword(p, end, "o")) {
-        if (import_params_.use_split_objects) {
-          geom_new_object(p,
-                          end,
-                          state_shaded_smooth,
-                          state_group_name,
-                          state_material_index,
-                          curr_geom,
-                          r_all_geometries);
-        }
-      }
-      /* Groups. */
-      else if (parse_keyword(p, end, "g")) {
-        if (import_params_.use_split_groups) {
-          geom_new_object(p,
-                          end,
-                          state_shaded_smooth,
-                          state_group_name,
-                          state_material_index,
-                          curr_geom,
-                          r_all_geometries);
-        }
-        else {
-          geom_update_group(StringRef(p, end).trim(), state_group_name);
-          int new_index = curr_geom->group_indices_.size();
-          state_group_index = curr_geom->group_indices_.lookup_or_add(state_group_name, new_index);
-          if (new_index == state_group_index) {
-            curr_geom->group_order_.append(state_group_name);
+    });
+
+    for (ParsedChunk &chunk : parsed_chunks) {
+      for (const DeferredLine &line : chunk.lines) {
+        /* Make the global vertex data match the state at this line, so that relative indices
+         * and index validation work the same as when parsing line by line. */
+        chunk.flush_vertices(
+            line.vertices_num, line.uv_vertices_num, line.vert_normals_num, r_global_vertices);
+        const char *p = line.p, *end = line.end;
+        switch (line.type) {
+          case DeferredLineType::Face: {
+            /* If we don't have a material index assigned yet, get one.
+             * It means "usemtl" state came from the previous object. */
+            if (state_material_index == -1 && !state_material_name.empty() &&
+                curr_geom->material_indices_.is_empty())
+            {
+              curr_geom->material_indices_.add_new(state_material_name, 0);
+              curr_geom->material_order_.append(state_material_name);
+              state_material_index = 0;
+            }
+
+            geom_add_polygon(
+                curr_geom,
+                chunk.face_corners.as_span().slice(line.face_corners_start, line.face_corners_num),
+                line.face_valid,
+                r_global_vertices,
+                state_material_index,
+                state_group_index,
+                state_shaded_smooth);
+            break;
           }
+          case DeferredLineType::Polyline:
+            geom_add_polyline(curr_geom, p, end, r_global_vertices);
+            break;
+          case DeferredLineType::Object:
+            if (import_params_.use_split_objects) {
+              geom_new_object(p,
+                              end,
+                              state_shaded_smooth,
+                              state_group_name,
+                              state_material_index,
+                              curr_geom,
+                              r_all_geometries);
+            }
+            break;
+          case DeferredLineType::Group:
+            if (import_params_.use_split_groups) {
+              geom_new_object(p,
+                              end,
+                              state_shaded_smooth,
+                              state_group_name,
+                              state_material_index,
+                              curr_geom,
+                              r_all_geometries);
+            }
+            else {
+              geom_update_group(StringRef(p, end).trim(), state_group_name);
+              int new_index = curr_geom->group_indices_.size();
+              state_group_index = curr_geom->group_indices_.lookup_or_add(state_group_name,
+                                                                          new_index);
+              if (new_index == state_group_index) {
+                curr_geom->group_order_.append(state_group_name);
+              }
+            }
+            break;
+          case DeferredLineType::SmoothGroup:
+            geom_update_smooth_group(p, end, state_shaded_smooth);
+            break;
+          case DeferredLineType::UseMaterial: {
+            state_material_name = StringRef(p, end).trim();
+            int new_mat_index = curr_geom->material_indices_.size();
+            state_material_index = curr_geom->material_indices_.lookup_or_add(state_material_name,
+                                                                              new_mat_index);
+            if (new_mat_index == state_material_index) {
+              curr_geom->material_order_.append(state_material_name);
+            }
+            break;
+          }
+          case DeferredLineType::MaterialLibrary:
+            add_mtl_library(StringRef(p, end).trim());
+            break;
+          case DeferredLineType::MRGBColors:
+            geom_add_mrgb_colors(p, end, r_global_vertices);
+            break;
+          case DeferredLineType::CurveType:
+            curr_geom = geom_set_curve_type(curr_geom, p, end, state_group_name, r_all_geometries);
+            break;
+          case DeferredLineType::CurveDegree:
+            geom_set_curve_degree(curr_geom, p, end);
+            break;
+          case DeferredLineType::CurveIndices:
+            geom_add_curve_vertex_indices(curr_geom, p, end, r_global_vertices);
+            break;
+          case DeferredLineType::CurveParameters:
+            geom_add_curve_parameters(curr_geom, p, end);
+            break;
+          case DeferredLineType::Unknown:
+            std::cout << "OBJ element not recognized: '" << std::string(p, end) << "'"
+                      << std::endl;
+            break;
         }
       }
-      /* Smoothing groups. */
-      else if (parse_keyword(p, end, "s")) {
-        geom_update_smooth_group(p, end, state_shaded_smooth);
-      }
-      /* Materials and their libraries. */
-      else if (parse_keyword(p, end, "usemtl")) {
-        state_material_name = StringRef(p, end).trim();
-        int new_mat_index = curr_geom->material_indices_.size();
-        state_material_index = curr_geom->material_indices_.lookup_or_add(state_material_name,
-                                                                          new_mat_index);
-        if (new_mat_index == state_material_index) {
-          curr_geom->material_order_.append(state_material_name);
-        }
-      }
-      else if (parse_keyword(p, end, "mtllib")) {
-        add_mtl_library(StringRef(p, end).trim());
-      }
-      else if (parse_keyword(p, end, "#MRGB")) {
-        geom_add_mrgb_colors(p, end, r_global_vertices);
-      }
-      /* Comments. */
-      else if (*p == '#') {
-        /* Nothing to do. */
-      }
-      /* Curve related things. */
-      else if (parse_keyword(p, end, "cstype")) {
-        curr_geom = geom_set_curve_type(curr_geom, p, end, state_group_name, r_all_geometries);
-      }
-      else if (parse_keyword(p, end, "deg")) {
-        geom_set_curve_degree(curr_geom, p, end);
-      }
-      else if (parse_keyword(p, end, "curv")) {
-        geom_add_curve_vertex_indices(curr_geom, p, end, r_global_vertices);
-      }
-      else if (parse_keyword(p, end, "parm")) {
-        geom_add_curve_parameters(curr_geom, p, end);
-      }
-      else if (StringRef(p, end).startswith("end")) {
-        /* End of curve definition, nothing else to do. */
-      }
-      else {
-        std::cout << "OBJ element not recognized: '" << std::string(p, end) << "'" << std::endl;
-      }
+      chunk.flush_all_vertices(r_global_vertices);
+      line_number += chunk.lines_num;
     }
 
     /* We might have a line that was cut in the middle by the previous buffer;
@@ -38,6 +38,10 @@ class OBJParser {
   /**
    * Read the OBJ file line by line and create OBJ Geometry instances. Also store all the vertex
    * and UV vertex coordinates in a struct accessible by all objects.
+   *
+   * The file is read in buffers of `read_buffer_size` bytes, each split into line-aligned chunks
+   * that are parsed in parallel. Parts that depend on the parser state (faces, objects, groups,
+   * materials etc.) are then processed in file order, so the result does not depend on threading.
    */
   void parse(Vector<std::unique_ptr<Geometry>> &r_all_geometries,
              GlobalVertices &r_global_vertices);
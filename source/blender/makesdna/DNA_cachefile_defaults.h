@@ -29,6 +29,7 @@
     .handle_readers = NULL, \
     .use_prefetch = 1, \
     .prefetch_cache_size = 4096, \
+    .prefetch_frames = 8, \
   }
 
 /** \} */
@@ -82,7 +82,8 @@ typedef struct CacheFile {
   /** The frame offset to subtract. */
   float frame_offset;
 
-  char _pad[4];
+  /** Number of frames after the current one to read in the background during playback. */
+  int prefetch_frames;
 
   /** Animation flag. */
   short flag;
@@ -99,10 +100,10 @@ typedef struct CacheFile {
 
   char _pad1[3];
 
-  /** Enable data prefetching when using the Cycles Procedural. */
+  /** Enable data prefetching for modifiers and the Cycles Procedural. */
   char use_prefetch;
 
-  /** Size in megabytes for the prefetch cache used by the Cycles Procedural. */
+  /** Size in megabytes for the prefetch cache used by modifiers and the Cycles Procedural. */
   int prefetch_cache_size;
 
   /** Index of the currently selected layer in the UI, starts at 1. */
@@ -118,4 +119,6 @@ typedef struct CacheFile {
   struct CacheArchiveHandle *handle;
   char handle_filepath[1024];
   struct GSet *handle_readers;
+  /** Frames read ahead of the current frame, see #BKE_cachefile_read_geometry. */
+  struct CacheFilePrefetch *prefetch;
 } CacheFile;
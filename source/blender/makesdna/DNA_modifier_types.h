@@ -2480,6 +2480,7 @@ typedef struct NodesModifierData {
 
 typedef enum NodesModifierFlag {
   NODES_MODIFIER_HIDE_DATABLOCK_SELECTOR = (1 << 0),
+  NODES_MODIFIER_CACHE_NODE_RESULTS = (1 << 1),
 } NodesModifierFlag;
 
 typedef struct MeshToVolumeModifierData {
@@ -1103,7 +1103,8 @@ typedef struct UserDef {
 
   float collection_instance_empty_size;
   char text_flag;
-  char _pad10[1];
+  /** Number of strips to build proxies for at the same time, 0 for automatic. */
+  char sequencer_proxy_threads;
 
   char file_preview_type; /* eUserpref_File_Preview_Type */
   char statusbar_flag;    /* eUserpref_StatusBar_Flag */
@@ -293,18 +293,27 @@ static void rna_def_cachefile(BlenderRNA *brna)
   /* ----------------- Cache controls ----------------- */
 
   prop = RNA_def_property(srna, "use_prefetch", PROP_BOOLEAN, PROP_NONE);
-  RNA_def_property_ui_text(
-      prop,
-      "Use Prefetch",
-      "When enabled, the Cycles Procedural will preload animation data for faster updates");
+  RNA_def_property_ui_text(prop,
+                           "Use Prefetch",
+                           "When enabled, animation data is preloaded in the background for "
+                           "faster playback, by modifiers and by the Cycles Procedural");
   RNA_def_property_update(prop, 0, "rna_CacheFile_update");
 
   prop = RNA_def_property(srna, "prefetch_cache_size", PROP_INT, PROP_UNSIGNED);
   RNA_def_property_ui_text(
       prop,
       "Prefetch Cache Size",
-      "Memory usage limit in megabytes for the Cycles Procedural cache, if the data does not "
-      "fit within the limit, rendering is aborted");
+      "Memory usage limit in megabytes for the prefetch cache. Modifiers stop reading ahead "
+      "when the limit is reached, for the Cycles Procedural rendering is aborted if the data "
+      "does not fit within the limit");
+  RNA_def_property_update(prop, 0, "rna_CacheFile_update");
+
+  prop = RNA_def_property(srna, "prefetch_frames", PROP_INT, PROP_NONE);
+  RNA_def_property_range(prop, 0, 250);
+  RNA_def_property_ui_text(prop,
+                           "Prefetch Frames",
+                           "Number of frames after the current frame that modifiers read in the "
+                           "background during playback");
   RNA_def_property_update(prop, 0, "rna_CacheFile_update");
 
   /* ----------------- Axis Conversion ----------------- */
@@ -7905,6 +7905,15 @@ static void rna_def_modifier_nodes(BlenderRNA *brna)
   RNA_def_property_flag(prop, PROP_NO_DEG_UPDATE);
   RNA_def_property_update(prop, NC_OBJECT | ND_MODIFIER, nullptr);
 
+  prop = RNA_def_property(srna, "use_node_result_cache", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, nullptr, "flag", NODES_MODIFIER_CACHE_NODE_RESULTS);
+  RNA_def_property_ui_text(prop,
+                           "Cache Node Results",
+                           "Reuse the results of nodes from the previous evaluation in the "
+                           "viewport when their inputs did not change. This can make tweaking "
+                           "node trees with expensive nodes faster, at the cost of memory usage");
+  RNA_def_property_update(prop, 0, "rna_Modifier_update");
+
   rna_def_modifier_panel_open_prop(srna, "open_output_attributes_panel", 0);
   rna_def_modifier_panel_open_prop(srna, "open_manage_panel", 1);
   rna_def_modifier_panel_open_prop(srna, "open_bake_panel", 2);
@@ -306,6 +306,46 @@ static void rna_SequenceEditor_update_cache(Main * /*bmain*/, Scene *scene, Poin
   SEQ_cache_cleanup(scene);
 }
 
+static PointerRNA rna_SequenceEditor_cache_statistics_get(PointerRNA *ptr)
+{
+  return rna_pointer_inherit_refine(ptr, &RNA_SequenceEditorCacheStatistics, ptr->data);
+}
+
+static int rna_SequenceEditorCacheStatistics_hits_get(PointerRNA *ptr)
+{
+  const SeqCacheStatistics stats = SEQ_cache_statistics_get((Scene *)ptr->owner_id);
+  return int(std::min<int64_t>(stats.hits, INT_MAX));
+}
+
+static int rna_SequenceEditorCacheStatistics_misses_get(PointerRNA *ptr)
+{
+  const SeqCacheStatistics stats = SEQ_cache_statistics_get((Scene *)ptr->owner_id);
+  return int(std::min<int64_t>(stats.misses, INT_MAX));
+}
+
+static int rna_SequenceEditorCacheStatistics_evictions_get(PointerRNA *ptr)
+{
+  const SeqCacheStatistics stats = SEQ_cache_statistics_get((Scene *)ptr->owner_id);
+  return int(std::min<int64_t>(stats.evictions, INT_MAX));
+}
+
+static float rna_SequenceEditorCacheStatistics_memory_stored_get(PointerRNA *ptr)
+{
+  const SeqCacheStatistics stats = SEQ_cache_statistics_get((Scene *)ptr->owner_id);
+  return float(stats.stored_bytes / (1024.0 * 1024.0));
+}
+
+static float rna_SequenceEditorCacheStatistics_memory_evicted_get(PointerRNA *ptr)
+{
+  const SeqCacheStatistics stats = SEQ_cache_statistics_get((Scene *)ptr->owner_id);
+  return float(stats.evicted_bytes / (1024.0 * 1024.0));
+}
+
+static void rna_SequenceEditorCacheStatistics_reset(ID *id)
+{
+  SEQ_cache_statistics_reset((Scene *)id);
+}
+
 /* internal use */
 static int rna_SequenceEditor_elements_length(PointerRNA *ptr)
 {
@@ -2372,6 +2412,55 @@ static void rna_def_channel(BlenderRNA *brna)
       prop, NC_SCENE | ND_SEQUENCER, "rna_SequenceTimelineChannel_mute_update");
 }
 
+static void rna_def_editor_cache_statistics(BlenderRNA *brna)
+{
+  StructRNA *srna;
+  FunctionRNA *func;
+  PropertyRNA *prop;
+
+  srna = RNA_def_struct(brna, "SequenceEditorCacheStatistics", nullptr);
+  RNA_def_struct_sdna(srna, "Editing");
+  RNA_def_struct_nested(brna, srna, "SequenceEditor");
+  RNA_def_struct_ui_text(
+      srna, "Cache Statistics", "Usage statistics of the sequencer image cache in memory");
+
+  prop = RNA_def_property(srna, "hits", PROP_INT, PROP_NONE);
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_int_funcs(prop, "rna_SequenceEditorCacheStatistics_hits_get", nullptr, nullptr);
+  RNA_def_property_ui_text(prop, "Hits", "Number of images found in cache");
+
+  prop = RNA_def_property(srna, "misses", PROP_INT, PROP_NONE);
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_int_funcs(
+      prop, "rna_SequenceEditorCacheStatistics_misses_get", nullptr, nullptr);
+  RNA_def_property_ui_text(prop, "Misses", "Number of images that had to be rendered");
+
+  prop = RNA_def_property(srna, "evictions", PROP_INT, PROP_NONE);
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_int_funcs(
+      prop, "rna_SequenceEditorCacheStatistics_evictions_get", nullptr, nullptr);
+  RNA_def_property_ui_text(
+      prop, "Evictions", "Number of frames removed from cache to make room for new frames");
+
+  prop = RNA_def_property(srna, "memory_stored", PROP_FLOAT, PROP_NONE);
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_float_funcs(
+      prop, "rna_SequenceEditorCacheStatistics_memory_stored_get", nullptr, nullptr);
+  RNA_def_property_ui_text(
+      prop, "Memory Stored", "Memory used by images stored in cache, in megabytes");
+
+  prop = RNA_def_property(srna, "memory_evicted", PROP_FLOAT, PROP_NONE);
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_float_funcs(
+      prop, "rna_SequenceEditorCacheStatistics_memory_evicted_get", nullptr, nullptr);
+  RNA_def_property_ui_text(
+      prop, "Memory Evicted", "Memory of images removed from cache, in megabytes");
+
+  func = RNA_def_function(srna, "reset", "rna_SequenceEditorCacheStatistics_reset");
+  RNA_def_function_flag(func, FUNC_USE_SELF_ID);
+  RNA_def_function_ui_description(func, "Reset hit, miss and eviction counters");
+}
+
 static void rna_def_editor(BlenderRNA *brna)
 {
   StructRNA *srna;
@@ -2518,6 +2607,13 @@ static void rna_def_editor(BlenderRNA *brna)
       "Render frames ahead of current frame in the background for faster playback");
   RNA_def_property_update(prop, NC_SCENE | ND_SEQUENCER, nullptr);
 
+  prop = RNA_def_property(srna, "cache_statistics", PROP_POINTER, PROP_NONE);
+  RNA_def_property_flag(prop, PROP_NEVER_NULL);
+  RNA_def_property_struct_type(prop, "SequenceEditorCacheStatistics");
+  RNA_def_property_pointer_funcs(
+      prop, "rna_SequenceEditor_cache_statistics_get", nullptr, nullptr, nullptr);
+  RNA_def_property_ui_text(prop, "Cache Statistics", "Usage statistics of the image cache");
+
   /* functions */
 
   func = RNA_def_function(srna, "display_stack", "rna_SequenceEditor_display_stack");
@@ -3936,6 +4032,7 @@ void RNA_def_sequencer(BlenderRNA *brna)
   rna_def_strip_transform(brna);
 
   rna_def_sequence(brna);
+  rna_def_editor_cache_statistics(brna);
   rna_def_editor(brna);
   rna_def_channel(brna);
 
@@ -6056,6 +6056,14 @@ static void rna_def_userdef_system(BlenderRNA *brna)
   RNA_def_property_enum_sdna(prop, nullptr, "sequencer_proxy_setup");
   RNA_def_property_ui_text(prop, "Proxy Setup", "When and how proxies are created");
 
+  prop = RNA_def_property(srna, "sequencer_proxy_threads", PROP_INT, PROP_NONE);
+  RNA_def_property_int_sdna(prop, nullptr, "sequencer_proxy_threads");
+  RNA_def_property_range(prop, 0, 64);
+  RNA_def_property_ui_text(
+      prop,
+      "Proxy Build Threads",
+      "Number of strips to build proxies for at the same time (0 for automatic)");
+
   prop = RNA_def_property(srna, "scrollback", PROP_INT, PROP_UNSIGNED);
   RNA_def_property_int_sdna(prop, nullptr, "scrollback");
   RNA_def_property_range(prop, 32, 32768);
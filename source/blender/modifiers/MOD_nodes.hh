@@ -13,6 +13,9 @@ struct ModifierCache;
 namespace blender::nodes::geo_eval_log {
 class GeoModifierLog;
 }
+namespace blender::nodes {
+class GeoNodesResultCache;
+}
 
 /**
  * Rebuild the list of properties based on the sockets exposed as the modifier's node group
@@ -35,6 +38,12 @@ struct NodesModifierRuntime {
    * used by the evaluated modifier.
    */
   std::shared_ptr<bke::bake::ModifierCache> cache;
+  /**
+   * Results of individual nodes from the last evaluation in the active depsgraph. This is only
+   * used when `NODES_MODIFIER_CACHE_NODE_RESULTS` is enabled and is stored on the original
+   * modifier.
+   */
+  std::shared_ptr<nodes::GeoNodesResultCache> result_cache;
 };
 
 void nodes_modifier_data_block_destruct(NodesModifierDataBlock *data_block, bool do_id_user);
@@ -8,9 +8,12 @@
 
 #include <cstring>
 #include <limits>
+#include <string>
 
+#include "BLI_hash.hh"
 #include "BLI_math_vector.hh"
 #include "BLI_string.h"
+#include "BLI_string_ref.hh"
 #include "BLI_utildefines.h"
 
 #include "BLT_translation.hh"
@@ -118,29 +121,29 @@ static bool can_use_mesh_for_orco_evaluation(MeshSeqCacheModifierData *mcmd,
   }
 
   CacheFile *cache_file = mcmd->cache_file;
+  bool topology_changed = true;
 
-  switch (cache_file->type) {
-    case CACHEFILE_TYPE_ALEMBIC:
+  /* The reader may be used by prefetching in the background. */
+  BKE_cachefile_reader_run_exclusive(cache_file, mcmd->reader, [&]() {
+    switch (cache_file->type) {
+      case CACHEFILE_TYPE_ALEMBIC:
 #  ifdef WITH_ALEMBIC
-      if (!ABC_mesh_topology_changed(mcmd->reader, ctx->object, mesh, time, err_str)) {
-        return true;
-      }
+        topology_changed = ABC_mesh_topology_changed(
+            mcmd->reader, ctx->object, mesh, time, err_str);
 #  endif
-      break;
-    case CACHEFILE_TYPE_USD:
+        break;
+      case CACHEFILE_TYPE_USD:
 #  ifdef WITH_USD
-      if (!blender::io::usd::USD_mesh_topology_changed(
-              mcmd->reader, ctx->object, mesh, time, err_str))
-      {
-        return true;
-      }
+        topology_changed = blender::io::usd::USD_mesh_topology_changed(
+            mcmd->reader, ctx->object, mesh, time, err_str);
 #  endif
-      break;
-    case CACHE_FILE_TYPE_INVALID:
-      break;
-  }
+        break;
+      case CACHE_FILE_TYPE_INVALID:
+        break;
+    }
+  });
 
-  return false;
+  return !topology_changed;
 }
 
 static Mesh *generate_bounding_box_mesh(const Mesh *org_mesh)
@@ -213,30 +216,51 @@ static void modify_geometry_set(ModifierData *md,
     velocity_scale *= FPS;
   }
 
-  switch (cache_file->type) {
-    case CACHEFILE_TYPE_ALEMBIC: {
+  /* Everything the read function uses is copied, as it also runs in background threads when
+   * prefetching the next frames. */
+  const eCacheFileType type = eCacheFileType(cache_file->type);
+  const int read_flag = mcmd->read_flag;
+  const std::string velocity_name = cache_file->velocity_name;
+  const double fps = FPS;
+  const short object_type = ctx->object->type;
+  const CacheFileReadGeometryFn read_fn = [=](CacheReader *reader,
+                                              const double read_time,
+                                              bke::GeometrySet &geometry,
+                                              const char **r_err_str) {
+    /* Readers only check the type of the object. The evaluated object is not passed, because it
+     * is modified by depsgraph evaluation while frames are read in the background. */
+    Object object_for_type = blender::dna::shallow_zero_initialize();
+    object_for_type.type = object_type;
+    Object *object = &object_for_type;
+    switch (type) {
+      case CACHEFILE_TYPE_ALEMBIC: {
 #  ifdef WITH_ALEMBIC
-      ABCReadParams params;
-      params.time = time;
-      params.read_flags = mcmd->read_flag;
-      params.velocity_name = mcmd->cache_file->velocity_name;
-      params.velocity_scale = velocity_scale;
-      ABC_read_geometry(mcmd->reader, ctx->object, *geometry_set, &params, &err_str);
+        ABCReadParams params;
+        params.time = read_time;
+        params.read_flags = read_flag;
+        params.velocity_name = velocity_name.c_str();
+        params.velocity_scale = velocity_scale;
+        ABC_read_geometry(reader, object, geometry, &params, r_err_str);
 #  endif
-      break;
-    }
-    case CACHEFILE_TYPE_USD: {
+        break;
+      }
+      case CACHEFILE_TYPE_USD: {
 #  ifdef WITH_USD
-      const blender::io::usd::USDMeshReadParams params = blender::io::usd::create_mesh_read_params(
-          time * FPS, mcmd->read_flag);
-      blender::io::usd::USD_read_geometry(
-          mcmd->reader, ctx->object, *geometry_set, params, &err_str);
+        const blender::io::usd::USDMeshReadParams params =
+            blender::io::usd::create_mesh_read_params(read_time * fps, read_flag);
+        blender::io::usd::USD_read_geometry(reader, object, geometry, params, r_err_str);
 #  endif
-      break;
+        break;
+      }
+      case CACHE_FILE_TYPE_INVALID:
+        break;
     }
-    case CACHE_FILE_TYPE_INVALID:
-      break;
-  }
+  };
+  const uint64_t params_hash = get_default_hash(
+      read_flag, velocity_scale, StringRef(velocity_name), fps);
+
+  BKE_cachefile_read_geometry(
+      cache_file, mcmd->reader, frame, fps, params_hash, *geometry_set, read_fn, &err_str);
 
   if (err_str) {
     BKE_modifier_set_error(ctx->object, md, "%s", err_str);
@@ -92,6 +92,7 @@
 #include "NOD_geometry.hh"
 #include "NOD_geometry_nodes_execute.hh"
 #include "NOD_geometry_nodes_lazy_function.hh"
+#include "NOD_geometry_nodes_result_cache.hh"
 #include "NOD_node_declaration.hh"
 
 #include "FN_field.hh"
@@ -1716,6 +1717,23 @@ static void modifyGeometry(ModifierData *md,
   find_side_effect_nodes(*nmd, *ctx, side_effect_nodes);
   call_data.side_effect_nodes = &side_effect_nodes;
 
+  /* Node results are only cached for the active depsgraph, which is the one that is re-evaluated
+   * while the user is tweaking the node tree. Logging has to be enabled as well, so that warnings
+   * of nodes are stored with their results and shown again when the results are reused. */
+  std::shared_ptr<nodes::GeoNodesResultCache> result_cache;
+  if (logging_enabled(ctx) && !(ctx->flag & MOD_APPLY_TO_BASE_MESH)) {
+    if (nmd->flag & NODES_MODIFIER_CACHE_NODE_RESULTS) {
+      if (!nmd_orig->runtime->result_cache) {
+        nmd_orig->runtime->result_cache = std::make_shared<nodes::GeoNodesResultCache>();
+      }
+      result_cache = nmd_orig->runtime->result_cache;
+      call_data.result_cache = result_cache.get();
+    }
+    else {
+      nmd_orig->runtime->result_cache.reset();
+    }
+  }
+
   bke::ModifierComputeContext modifier_compute_context{nullptr, nmd->modifier.name};
 
   geometry_set = nodes::execute_geometry_nodes_on_geometry(tree,
@@ -1724,6 +1742,10 @@ static void modifyGeometry(ModifierData *md,
                                                            call_data,
                                                            std::move(geometry_set));
 
+  if (result_cache) {
+    result_cache->remove_unused();
+  }
+
   if (logging_enabled(ctx)) {
     nmd_orig->runtime->eval_log = std::move(eval_log);
   }
@@ -2266,6 +2288,7 @@ static void draw_manage_panel(const bContext *C,
                               PointerRNA *modifier_ptr,
                               NodesModifierData &nmd)
 {
+  uiItemR(layout, modifier_ptr, "use_node_result_cache", UI_ITEM_NONE, nullptr, ICON_NONE);
   if (uiLayout *panel_layout = uiLayoutPanelProp(
           C, layout, modifier_ptr, "open_bake_panel", IFACE_("Bake")))
   {
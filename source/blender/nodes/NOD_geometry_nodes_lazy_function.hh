@@ -42,6 +42,8 @@ namespace blender::nodes {
 using lf::LazyFunction;
 using mf::MultiFunction;
 
+class GeoNodesResultCache;
+
 /** The structs in here describe the different possible behaviors of a simulation input node. */
 namespace sim_input {
 
@@ -230,6 +232,12 @@ struct GeoNodesCallData {
    */
   const Set<ComputeContextHash> *socket_log_contexts = nullptr;
 
+  /**
+   * Optional cache of node results from previous evaluations. If this is provided, nodes that are
+   * evaluated with the same inputs as before are not executed again.
+   */
+  GeoNodesResultCache *result_cache = nullptr;
+
   /**
    * Data from the modifier that is being evaluated.
    */
@@ -337,6 +345,11 @@ struct GeometryNodeLazyFunctionGraphMapping {
   Map<const bNode *, const lf::FunctionNode *> group_node_map;
   Map<const bNode *, const lf::FunctionNode *> possible_side_effect_node_map;
   Map<const bke::bNodeTreeZone *, const lf::FunctionNode *> zone_node_map;
+  /**
+   * Nodes whose execution time is logged. Node groups and zones are not included, because their
+   * run time is the sum of the run times of the nodes inside.
+   */
+  Map<const lf::FunctionNode *, const bNode *> timed_bnode_by_lf_node;
 
   /* Indexed by #bNodeSocket::index_in_all_outputs. */
   Array<int> lf_input_index_for_output_bsocket_usage;
@@ -0,0 +1,133 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#pragma once
+
+/** \file
+ * \ingroup nodes
+ *
+ * Optional cache for the outputs of geometry nodes that is kept across multiple evaluations of
+ * the same node tree. When a node is evaluated with the same inputs as in the previous evaluation
+ * (e.g. because only a node further downstream changed), the previous outputs are reused instead
+ * of executing the node again.
+ *
+ * Input geometries are identified by the implicit-sharing info and version of their arrays
+ * instead of by their content. That's cheap and still works well in practice, because geometry
+ * that did not change generally shares its data with the previous evaluation.
+ */
+
+#include <mutex>
+#include <optional>
+
+#include "BLI_compute_context.hh"
+#include "BLI_generic_pointer.hh"
+#include "BLI_implicit_sharing.hh"
+#include "BLI_map.hh"
+#include "BLI_vector.hh"
+
+#include "FN_lazy_function.hh"
+
+#include "NOD_geometry_nodes_log.hh"
+
+struct bNode;
+
+namespace blender::nodes {
+
+/** Identifies the inputs of a node evaluation in a way that can be compared to later ones. */
+class GeoNodesResultCacheKey : NonCopyable {
+ private:
+  /** Serialized node settings, input values and identifiers of the input geometry data. */
+  Vector<uint8_t> data_;
+  /**
+   * Sharing infos of the referenced geometry data. A weak user is kept, so that the pointers can't
+   * be reused for other data while the key exists. The referenced data itself can still be freed.
+   */
+  Vector<const ImplicitSharingInfo *> sharing_infos_;
+
+  friend class GeoNodesResultCacheKeyBuilder;
+
+ public:
+  GeoNodesResultCacheKey() = default;
+  GeoNodesResultCacheKey(GeoNodesResultCacheKey &&other) = default;
+  GeoNodesResultCacheKey &operator=(GeoNodesResultCacheKey &&other) = delete;
+  ~GeoNodesResultCacheKey();
+
+  /**
+   * Build the key for the current inputs of the node. Returns none if some of the inputs can't be
+   * identified reliably, e.g. because they are fields that depend on the evaluation context or
+   * reference data-blocks.
+   */
+  static std::optional<GeoNodesResultCacheKey> build(const bNode &node,
+                                                     const lf::LazyFunction &fn,
+                                                     const lf::Params &params);
+
+  friend bool operator==(const GeoNodesResultCacheKey &a, const GeoNodesResultCacheKey &b)
+  {
+    return a.data_.as_span() == b.data_.as_span();
+  }
+};
+
+/**
+ * Information a node logged while it was executed. It is logged again when the cached outputs are
+ * used, so that e.g. warnings stay visible in the node editor.
+ */
+struct GeoNodesResultCacheLog {
+  Vector<geo_eval_log::NodeWarning> warnings;
+  Vector<std::pair<std::string, geo_eval_log::NamedAttributeUsage>> used_named_attributes;
+};
+
+class GeoNodesResultCache : NonCopyable, NonMovable {
+ private:
+  struct Entry {
+    GeoNodesResultCacheKey key;
+    /** Copies of the outputs computed by the node. Outputs that were not computed are null. */
+    Vector<GMutablePointer> outputs;
+    GeoNodesResultCacheLog log;
+    /** True if the entry has been accessed since the last call to #remove_unused. */
+    bool used = true;
+
+    Entry(GeoNodesResultCacheKey key) : key(std::move(key)) {}
+    ~Entry();
+  };
+
+  std::mutex mutex_;
+  /** The most recent result for every node, identified by its compute context and identifier. */
+  Map<std::pair<ComputeContextHash, int32_t>, std::unique_ptr<Entry>> entries_;
+
+ public:
+  ~GeoNodesResultCache();
+
+  /**
+   * Output the cached values if the node was evaluated with the same inputs before. All outputs
+   * that are required currently have to be cached, otherwise nothing is output.
+   * \param r_log: Receives what the node logged when the outputs were computed.
+   * \return True if the outputs have been set.
+   */
+  bool try_load(const ComputeContextHash &context_hash,
+                const bNode &node,
+                const GeoNodesResultCacheKey &key,
+                lf::Params &params,
+                GeoNodesResultCacheLog &r_log);
+
+  /**
+   * Remember the outputs of a node evaluation. Null pointers in #outputs are outputs that have not
+   * been computed. The values are copied.
+   */
+  void store(const ComputeContextHash &context_hash,
+             const bNode &node,
+             GeoNodesResultCacheKey key,
+             Span<GMutablePointer> outputs,
+             GeoNodesResultCacheLog log);
+
+  /** Number of nodes that currently have cached results. */
+  int64_t size();
+
+  /**
+   * Remove entries of nodes that have not been evaluated since the last call. This is called after
+   * every evaluation, so that results of removed nodes or contexts don't keep memory alive.
+   */
+  void remove_unused();
+};
+
+}  // namespace blender::nodes
@@ -484,6 +484,10 @@ class NodeDeclaration {
    * exempt from that rule for now. */
   bool allow_any_socket_order = false;
 
+  /** The outputs only depend on the inputs and the properties of the node, and not on the
+   * evaluation context. Results of such nodes can be reused by #GeoNodesResultCache. */
+  bool allow_result_cache = false;
+
   /**
    * True if any context was used to build this declaration.
    */
@@ -549,6 +553,7 @@ class NodeDeclarationBuilder {
 
   void use_custom_socket_order(bool enable = true);
   void allow_any_socket_order(bool enable = true);
+  void allow_result_cache(bool enable = true);
 
   template<typename DeclType>
   typename DeclType::Builder &add_input(StringRef name, StringRef identifier = "");
@@ -22,6 +22,7 @@ namespace blender::nodes::node_geo_convex_hull_cc {
 
 static void node_declare(NodeDeclarationBuilder &b)
 {
+  b.allow_result_cache();
   b.add_input<decl::Geometry>("Geometry");
   b.add_output<decl::Geometry>("Convex Hull");
 }
@@ -10,6 +10,7 @@ namespace blender::nodes::node_geo_flip_faces_cc {
 
 static void node_declare(NodeDeclarationBuilder &b)
 {
+  b.allow_result_cache();
   b.add_input<decl::Geometry>("Mesh").supported_type(GeometryComponent::Type::Mesh);
   b.add_input<decl::Bool>("Selection").default_value(true).hide_value().field_on_all();
   b.add_output<decl::Geometry>("Mesh").propagate_all();
@@ -15,6 +15,7 @@ namespace blender::nodes::node_geo_mesh_subdivide_cc {
 
 static void node_declare(NodeDeclarationBuilder &b)
 {
+  b.allow_result_cache();
   b.add_input<decl::Geometry>("Mesh").supported_type(GeometryComponent::Type::Mesh);
   b.add_input<decl::Int>("Level").default_value(1).min(0).max(6);
   b.add_output<decl::Geometry>("Mesh").propagate_all();
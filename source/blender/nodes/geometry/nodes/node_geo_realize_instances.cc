@@ -14,6 +14,7 @@ namespace blender::nodes::node_geo_realize_instances_cc {
 
 static void node_declare(NodeDeclarationBuilder &b)
 {
+  b.allow_result_cache();
   b.add_input<decl::Geometry>("Geometry");
   b.add_input<decl::Bool>("Selection")
       .default_value(true)
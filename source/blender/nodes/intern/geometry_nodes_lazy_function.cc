@@ -22,6 +22,7 @@
 
 #include "NOD_geometry_exec.hh"
 #include "NOD_geometry_nodes_lazy_function.hh"
+#include "NOD_geometry_nodes_result_cache.hh"
 #include "NOD_multi_function.hh"
 #include "NOD_node_declaration.hh"
 
@@ -162,6 +163,11 @@ class LazyFunctionForGeometryNode : public LazyFunction {
    * does not have to execute.
    */
   Vector<bool> is_attribute_output_bsocket_;
+  /**
+   * True if the results of this node may be reused in a later evaluation when its inputs did not
+   * change, see #GeoNodesResultCache.
+   */
+  bool use_result_cache_ = false;
 
   struct OutputAttributeID {
     int bsocket_index;
@@ -184,6 +190,18 @@ class LazyFunctionForGeometryNode : public LazyFunction {
     lazy_function_interface_from_node(
         node, inputs_, outputs_, own_lf_graph_info.mapping.lf_index_by_bsocket);
 
+    /* Only nodes that process geometry are expensive enough to be worth caching. Settings stored
+     * outside of the node itself can't be compared reliably across evaluations. Nodes that may
+     * depend on the evaluation context, e.g. on objects that are not inputs, must not opt in. */
+    use_result_cache_ = node.declaration()->allow_result_cache && node.storage == nullptr &&
+                        node.id == nullptr &&
+                        std::any_of(node.input_sockets().begin(),
+                                    node.input_sockets().end(),
+                                    [](const bNodeSocket *socket) {
+                                      return socket->is_available() &&
+                                             socket->type == SOCK_GEOMETRY;
+                                    });
+
     const NodeDeclaration &node_decl = *node.declaration();
     const aal::RelationsInNode *relations = node_decl.anonymous_attribute_relations();
     if (relations == nullptr) {
@@ -252,7 +270,6 @@ class LazyFunctionForGeometryNode : public LazyFunction {
     Storage *storage = static_cast<Storage *>(context.storage);
     GeoNodesLFUserData *user_data = dynamic_cast<GeoNodesLFUserData *>(context.user_data);
     BLI_assert(user_data != nullptr);
-    const auto &local_user_data = *static_cast<GeoNodesLFLocalUserData *>(context.local_user_data);
 
     /* Lazily create the required anonymous attribute ids. */
     auto get_output_attribute_id = [&](const int output_bsocket_index) -> AnonymousAttributeIDPtr {
@@ -316,6 +333,35 @@ class LazyFunctionForGeometryNode : public LazyFunction {
       return;
     }
 
+    GeoNodesResultCache *result_cache = use_result_cache_ ? user_data->call_data->result_cache :
+                                                            nullptr;
+    if (result_cache != nullptr) {
+      if (std::optional<GeoNodesResultCacheKey> key = GeoNodesResultCacheKey::build(
+              node_, *this, params))
+      {
+        const ComputeContextHash &context_hash = user_data->compute_context->hash();
+        GeoNodesResultCacheLog cached_log;
+        if (result_cache->try_load(context_hash, node_, *key, params, cached_log)) {
+          this->log_cached_node(context, cached_log);
+          return;
+        }
+        this->execute_node_and_cache(params,
+                                     context,
+                                     get_output_attribute_id,
+                                     *result_cache,
+                                     context_hash,
+                                     std::move(*key));
+        return;
+      }
+    }
+
+    this->execute_node(params, context, get_output_attribute_id);
+  }
+
+  void execute_node(lf::Params &params,
+                    const lf::Context &context,
+                    const FunctionRef<AnonymousAttributeIDPtr(int)> get_output_attribute_id) const
+  {
     GeoNodeExecParams geo_params{
         node_,
         params,
@@ -324,14 +370,110 @@ class LazyFunctionForGeometryNode : public LazyFunction {
         own_lf_graph_info_.mapping.lf_input_index_for_attribute_propagation_to_output,
         get_output_attribute_id};
 
-    geo_eval_log::TimePoint start_time = geo_eval_log::Clock::now();
+    /* The execution time is logged by #GeometryNodesLazyFunctionLogger. */
     node_.typeinfo->geometry_node_execute(geo_params);
-    geo_eval_log::TimePoint end_time = geo_eval_log::Clock::now();
+  }
+
+  /**
+   * Execute the node with separate storage for its outputs, so that they can be added to the
+   * result cache before they are passed on. Values may be moved or freed as soon as they are set
+   * on the original #lf::Params.
+   */
+  void execute_node_and_cache(
+      lf::Params &params,
+      const lf::Context &context,
+      const FunctionRef<AnonymousAttributeIDPtr(int)> get_output_attribute_id,
+      GeoNodesResultCache &result_cache,
+      const ComputeContextHash &context_hash,
+      GeoNodesResultCacheKey key) const
+  {
+    const int inputs_num = inputs_.size();
+    const int outputs_num = outputs_.size();
+
+    Array<GMutablePointer> inputs(inputs_num);
+    Array<std::optional<lf::ValueUsage>> input_usages(inputs_num);
+    for (const int i : inputs_.index_range()) {
+      inputs[i] = {*inputs_[i].type, params.try_get_input_data_ptr(i)};
+    }
+
+    LinearAllocator<> allocator;
+    Array<GMutablePointer> outputs(outputs_num);
+    Array<lf::ValueUsage> output_usages(outputs_num);
+    Array<bool> set_outputs(outputs_num);
+    for (const int i : outputs_.index_range()) {
+      const CPPType &type = *outputs_[i].type;
+      outputs[i] = {type, allocator.allocate(type.size(), type.alignment())};
+      output_usages[i] = params.get_output_usage(i);
+      set_outputs[i] = params.output_was_set(i);
+    }
+
+    lf::BasicParams node_params{*this, inputs, outputs, input_usages, output_usages, set_outputs};
+    this->execute_node(node_params, context, get_output_attribute_id);
+
+    Array<GMutablePointer> new_outputs(outputs_num);
+    for (const int i : outputs_.index_range()) {
+      if (set_outputs[i] && !params.output_was_set(i)) {
+        new_outputs[i] = outputs[i];
+      }
+    }
+    result_cache.store(
+        context_hash, node_, std::move(key), new_outputs, this->gather_node_log(context));
 
-    if (geo_eval_log::GeoTreeLogger *tree_logger = local_user_data.try_get_tree_logger(*user_data))
+    for (const int i : outputs_.index_range()) {
+      if (new_outputs[i].get() != nullptr) {
+        new_outputs[i].type()->relocate_construct(new_outputs[i].get(),
+                                                  params.get_output_data_ptr(i));
+        params.output_set(i);
+      }
+    }
+  }
+
+  /**
+   * Copy what the node logged while it was executed, so that it can be logged again when its
+   * cached results are used.
+   */
+  GeoNodesResultCacheLog gather_node_log(const lf::Context &context) const
+  {
+    const GeoNodesLFUserData &user_data = *static_cast<GeoNodesLFUserData *>(context.user_data);
+    const auto &local_user_data = *static_cast<GeoNodesLFLocalUserData *>(context.local_user_data);
+    GeoNodesResultCacheLog log;
+    geo_eval_log::GeoTreeLogger *tree_logger = local_user_data.try_get_tree_logger(user_data);
+    if (tree_logger == nullptr) {
+      return log;
+    }
+    /* A node is executed only once per compute context, so everything logged for it belongs to
+     * this execution. */
+    for (const geo_eval_log::GeoTreeLogger::WarningWithNode &warning : tree_logger->node_warnings)
     {
-      tree_logger->node_execution_times.append(*tree_logger->allocator,
-                                               {node_.identifier, start_time, end_time});
+      if (warning.node_id == node_.identifier) {
+        log.warnings.append(warning.warning);
+      }
+    }
+    for (const geo_eval_log::GeoTreeLogger::AttributeUsageWithNode &attribute_usage :
+         tree_logger->used_named_attributes)
+    {
+      if (attribute_usage.node_id == node_.identifier) {
+        log.used_named_attributes.append({attribute_usage.attribute_name, attribute_usage.usage});
+      }
+    }
+    return log;
+  }
+
+  void log_cached_node(const lf::Context &context, const GeoNodesResultCacheLog &log) const
+  {
+    const GeoNodesLFUserData &user_data = *static_cast<GeoNodesLFUserData *>(context.user_data);
+    const auto &local_user_data = *static_cast<GeoNodesLFLocalUserData *>(context.local_user_data);
+    geo_eval_log::GeoTreeLogger *tree_logger = local_user_data.try_get_tree_logger(user_data);
+    if (tree_logger == nullptr) {
+      return;
+    }
+    for (const geo_eval_log::NodeWarning &warning : log.warnings) {
+      tree_logger->node_warnings.append(*tree_logger->allocator, {node_.identifier, warning});
+    }
+    for (const auto &[attribute_name, usage] : log.used_named_attributes) {
+      tree_logger->used_named_attributes.append(
+          *tree_logger->allocator,
+          {node_.identifier, tree_logger->allocator->copy_string(attribute_name), usage});
     }
   }
 
@@ -1998,6 +2140,26 @@ class GeometryNodesLazyFunctionLogger : public lf::GraphExecutor::Logger {
     }
   }
 
+  void log_node_execution_time(const lf::FunctionNode &node,
+                               const geo_eval_log::TimePoint start,
+                               const geo_eval_log::TimePoint end,
+                               const lf::Context &context) const override
+  {
+    const bNode *bnode = lf_graph_info_.mapping.timed_bnode_by_lf_node.lookup_default(&node,
+                                                                                      nullptr);
+    if (bnode == nullptr) {
+      return;
+    }
+    const auto &user_data = *static_cast<GeoNodesLFUserData *>(context.user_data);
+    const auto &local_user_data = *static_cast<GeoNodesLFLocalUserData *>(context.local_user_data);
+    geo_eval_log::GeoTreeLogger *tree_logger = local_user_data.try_get_tree_logger(user_data);
+    if (tree_logger == nullptr) {
+      return;
+    }
+    tree_logger->node_execution_times.append(*tree_logger->allocator,
+                                             {bnode->identifier, start, end});
+  }
+
   void add_thread_id_debug_message(const lf::FunctionNode &node, const lf::Context &context) const
   {
     static std::atomic<int> thread_id_source = 0;
@@ -3352,7 +3514,8 @@ struct GeometryNodesLazyFunctionBuilder {
   void build_geometry_node(const bNode &bnode, BuildGraphParams &graph_params)
   {
     auto &lazy_function = scope_.construct<LazyFunctionForGeometryNode>(bnode, *lf_graph_info_);
-    lf::Node &lf_node = graph_params.lf_graph.add_function(lazy_function);
+    lf::FunctionNode &lf_node = graph_params.lf_graph.add_function(lazy_function);
+    mapping_->timed_bnode_by_lf_node.add(&lf_node, &bnode);
 
     for (const bNodeSocket *bsocket : bnode.input_sockets()) {
       const int lf_index = mapping_->lf_index_by_bsocket[bsocket->index_in_tree()];
@@ -3457,7 +3620,8 @@ struct GeometryNodesLazyFunctionBuilder {
   {
     auto &lazy_function = scope_.construct<LazyFunctionForMultiFunctionNode>(
         bnode, fn_item, mapping_->lf_index_by_bsocket);
-    lf::Node &lf_node = graph_params.lf_graph.add_function(lazy_function);
+    lf::FunctionNode &lf_node = graph_params.lf_graph.add_function(lazy_function);
+    mapping_->timed_bnode_by_lf_node.add(&lf_node, &bnode);
 
     for (const bNodeSocket *bsocket : bnode.input_sockets()) {
       const int lf_index = mapping_->lf_index_by_bsocket[bsocket->index_in_tree()];
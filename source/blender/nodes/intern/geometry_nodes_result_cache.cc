@@ -0,0 +1,402 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include <algorithm>
+
+#include "NOD_geometry_nodes_result_cache.hh"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_listbase.h"
+
+#include "DNA_curves_types.h"
+#include "DNA_mesh_types.h"
+#include "DNA_node_types.h"
+#include "DNA_object_types.h"
+#include "DNA_pointcloud_types.h"
+
+#include "BKE_anonymous_attribute_id.hh"
+#include "BKE_curves.hh"
+#include "BKE_geometry_set.hh"
+#include "BKE_mesh_types.hh"
+#include "BKE_node.hh"
+#include "BKE_node_socket_value.hh"
+
+namespace blender::nodes {
+
+using bke::GeometryComponent;
+using bke::GeometrySet;
+using bke::SocketValueVariant;
+
+GeoNodesResultCacheKey::~GeoNodesResultCacheKey()
+{
+  for (const ImplicitSharingInfo *sharing_info : sharing_infos_) {
+    sharing_info->remove_weak_user_and_delete_if_last();
+  }
+}
+
+/** Serializes everything the outputs of a node depend on into a #GeoNodesResultCacheKey. */
+class GeoNodesResultCacheKeyBuilder {
+ private:
+  GeoNodesResultCacheKey &key_;
+
+ public:
+  GeoNodesResultCacheKeyBuilder(GeoNodesResultCacheKey &key) : key_(key) {}
+
+  template<typename T> void add(const T &value)
+  {
+    static_assert(std::is_trivially_copyable_v<T>);
+    key_.data_.extend(Span(reinterpret_cast<const uint8_t *>(&value), sizeof(T)));
+  }
+
+  void add_string(const StringRef str)
+  {
+    this->add(str.size());
+    key_.data_.extend(Span(reinterpret_cast<const uint8_t *>(str.data()), str.size()));
+  }
+
+  [[nodiscard]] bool add_sharing_info(const ImplicitSharingInfo *sharing_info)
+  {
+    if (sharing_info == nullptr) {
+      return false;
+    }
+    this->add(sharing_info);
+    this->add(sharing_info->version());
+    sharing_info->add_weak_user();
+    key_.sharing_infos_.append(sharing_info);
+    return true;
+  }
+
+  [[nodiscard]] bool add_custom_data(const CustomData &data)
+  {
+    this->add(data.totlayer);
+    for (const CustomDataLayer &layer : Span(data.layers, data.totlayer)) {
+      this->add(layer.type);
+      this->add(layer.flag);
+      this->add(layer.active);
+      this->add(layer.active_rnd);
+      this->add(layer.active_clone);
+      this->add(layer.active_mask);
+      this->add(layer.uid);
+      this->add_string(layer.name);
+      if (layer.data != nullptr) {
+        if (!this->add_sharing_info(layer.sharing_info)) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  void add_vertex_group_names(const ListBase &vertex_group_names)
+  {
+    this->add(BLI_listbase_count(&vertex_group_names));
+    LISTBASE_FOREACH (const bDeformGroup *, group, &vertex_group_names) {
+      this->add_string(group->name);
+    }
+  }
+
+  void add_materials(Material *const *materials, const int materials_num)
+  {
+    this->add(materials_num);
+    for (const int i : IndexRange(materials_num)) {
+      this->add(materials[i]);
+    }
+  }
+
+  [[nodiscard]] bool add_mesh(const Mesh &mesh)
+  {
+    this->add(mesh.verts_num);
+    this->add(mesh.edges_num);
+    this->add(mesh.faces_num);
+    this->add(mesh.corners_num);
+    if (mesh.faces_num > 0) {
+      if (!this->add_sharing_info(mesh.runtime->face_offsets_sharing_info)) {
+        return false;
+      }
+    }
+    if (!this->add_custom_data(mesh.vert_data) || !this->add_custom_data(mesh.edge_data) ||
+        !this->add_custom_data(mesh.face_data) || !this->add_custom_data(mesh.corner_data))
+    {
+      return false;
+    }
+    this->add_vertex_group_names(mesh.vertex_group_names);
+    this->add(mesh.vertex_group_active_index);
+    this->add(mesh.attributes_active_index);
+    this->add_string(mesh.active_color_attribute ? mesh.active_color_attribute : "");
+    this->add_string(mesh.default_color_attribute ? mesh.default_color_attribute : "");
+    this->add(mesh.texspace_location);
+    this->add(mesh.texspace_size);
+    this->add(mesh.texspace_flag);
+    this->add(mesh.flag);
+    this->add(mesh.key);
+    this->add_materials(mesh.mat, mesh.totcol);
+    return true;
+  }
+
+  [[nodiscard]] bool add_pointcloud(const PointCloud &pointcloud)
+  {
+    this->add(pointcloud.totpoint);
+    if (!this->add_custom_data(pointcloud.pdata)) {
+      return false;
+    }
+    this->add(pointcloud.flag);
+    this->add(pointcloud.attributes_active_index);
+    this->add_materials(pointcloud.mat, pointcloud.totcol);
+    return true;
+  }
+
+  [[nodiscard]] bool add_curves(const Curves &curves_id)
+  {
+    const bke::CurvesGeometry &curves = curves_id.geometry.wrap();
+    this->add(curves.point_num);
+    this->add(curves.curve_num);
+    if (curves.curve_num > 0) {
+      if (!this->add_sharing_info(curves.runtime->curve_offsets_sharing_info)) {
+        return false;
+      }
+    }
+    if (!this->add_custom_data(curves.point_data) || !this->add_custom_data(curves.curve_data)) {
+      return false;
+    }
+    this->add_vertex_group_names(curves.vertex_group_names);
+    this->add(curves.vertex_group_active_index);
+    this->add(curves_id.flag);
+    this->add(curves_id.attributes_active_index);
+    this->add(curves_id.symmetry);
+    this->add(curves_id.selection_domain);
+    this->add(curves_id.surface);
+    this->add_string(curves_id.surface_uv_map ? curves_id.surface_uv_map : "");
+    this->add_materials(curves_id.mat, curves_id.totcol);
+    return true;
+  }
+
+  [[nodiscard]] bool add_geometry(const GeometrySet &geometry)
+  {
+    const Vector<const GeometryComponent *> components = geometry.get_components();
+    this->add(components.size());
+    for (const GeometryComponent *component : components) {
+      const GeometryComponent::Type type = component->type();
+      this->add(type);
+      switch (type) {
+        case GeometryComponent::Type::Mesh: {
+          if (!this->add_mesh(*geometry.get_mesh())) {
+            return false;
+          }
+          break;
+        }
+        case GeometryComponent::Type::PointCloud: {
+          if (!this->add_pointcloud(*geometry.get_pointcloud())) {
+            return false;
+          }
+          break;
+        }
+        case GeometryComponent::Type::Curve: {
+          if (!this->add_curves(*geometry.get_curves())) {
+            return false;
+          }
+          break;
+        }
+        default: {
+          /* Instances, volumes, Grease Pencil and edit data are not supported yet. */
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  [[nodiscard]] bool add_socket_value(const SocketValueVariant &value)
+  {
+    if (value.is_context_dependent_field() || value.is_volume_grid()) {
+      return false;
+    }
+    SocketValueVariant single_value = value;
+    single_value.convert_to_single();
+    const GPointer ptr = single_value.get_single_ptr();
+    const CPPType &type = *ptr.type();
+    this->add(&type);
+    if (type.is<std::string>()) {
+      this->add_string(*ptr.get<std::string>());
+      return true;
+    }
+    if (type.is_trivial()) {
+      key_.data_.extend(Span(static_cast<const uint8_t *>(ptr.get()), type.size()));
+      return true;
+    }
+    return false;
+  }
+
+  void add_attribute_set(const bke::AnonymousAttributeSet &set)
+  {
+    if (!set.names) {
+      this->add(int64_t(0));
+      return;
+    }
+    Vector<StringRef> names(set.names->begin(), set.names->end());
+    std::sort(names.begin(), names.end());
+    this->add(names.size());
+    for (const StringRef name : names) {
+      this->add_string(name);
+    }
+  }
+
+  [[nodiscard]] bool add_value(const GPointer value)
+  {
+    const CPPType &type = *value.type();
+    if (type.is<GeometrySet>()) {
+      return this->add_geometry(*value.get<GeometrySet>());
+    }
+    if (type.is<SocketValueVariant>()) {
+      return this->add_socket_value(*value.get<SocketValueVariant>());
+    }
+    if (type.is<Vector<GeometrySet>>()) {
+      const Vector<GeometrySet> &geometries = *value.get<Vector<GeometrySet>>();
+      this->add(geometries.size());
+      for (const GeometrySet &geometry : geometries) {
+        if (!this->add_geometry(geometry)) {
+          return false;
+        }
+      }
+      return true;
+    }
+    if (type.is<Vector<SocketValueVariant>>()) {
+      const Vector<SocketValueVariant> &values = *value.get<Vector<SocketValueVariant>>();
+      this->add(values.size());
+      for (const SocketValueVariant &socket_value : values) {
+        if (!this->add_socket_value(socket_value)) {
+          return false;
+        }
+      }
+      return true;
+    }
+    if (type.is<bool>()) {
+      this->add(*value.get<bool>());
+      return true;
+    }
+    if (type.is<bke::AnonymousAttributeSet>()) {
+      this->add_attribute_set(*value.get<bke::AnonymousAttributeSet>());
+      return true;
+    }
+    /* Other types like data-block pointers can't be compared reliably across evaluations. */
+    return false;
+  }
+};
+
+std::optional<GeoNodesResultCacheKey> GeoNodesResultCacheKey::build(const bNode &node,
+                                                                     const lf::LazyFunction &fn,
+                                                                     const lf::Params &params)
+{
+  if (node.storage != nullptr || node.id != nullptr) {
+    return std::nullopt;
+  }
+  GeoNodesResultCacheKey key;
+  GeoNodesResultCacheKeyBuilder builder{key};
+  builder.add_string(node.idname);
+  builder.add(node.custom1);
+  builder.add(node.custom2);
+  builder.add(node.custom3);
+  builder.add(node.custom4);
+  for (const int i : fn.inputs().index_range()) {
+    const void *value = params.try_get_input_data_ptr(i);
+    if (value == nullptr) {
+      return std::nullopt;
+    }
+    if (!builder.add_value({fn.inputs()[i].type, value})) {
+      return std::nullopt;
+    }
+  }
+  /* Nodes may skip computing outputs that are not used. */
+  for (const int i : fn.outputs().index_range()) {
+    builder.add(params.get_output_usage(i));
+    builder.add(params.output_was_set(i));
+  }
+  return key;
+}
+
+GeoNodesResultCache::Entry::~Entry()
+{
+  for (GMutablePointer &value : this->outputs) {
+    if (value.get() != nullptr) {
+      value.destruct();
+      MEM_freeN(value.get());
+    }
+  }
+}
+
+GeoNodesResultCache::~GeoNodesResultCache() = default;
+
+bool GeoNodesResultCache::try_load(const ComputeContextHash &context_hash,
+                                   const bNode &node,
+                                   const GeoNodesResultCacheKey &key,
+                                   lf::Params &params,
+                                   GeoNodesResultCacheLog &r_log)
+{
+  std::lock_guard lock{mutex_};
+  const std::unique_ptr<Entry> *entry_ptr = entries_.lookup_ptr({context_hash, node.identifier});
+  if (entry_ptr == nullptr) {
+    return false;
+  }
+  Entry &entry = **entry_ptr;
+  if (!(entry.key == key)) {
+    return false;
+  }
+  for (const int i : entry.outputs.index_range()) {
+    if (entry.outputs[i].get() == nullptr && !params.output_was_set(i) &&
+        params.get_output_usage(i) == lf::ValueUsage::Used)
+    {
+      return false;
+    }
+  }
+  for (const int i : entry.outputs.index_range()) {
+    const GMutablePointer value = entry.outputs[i];
+    if (value.get() == nullptr || params.output_was_set(i)) {
+      continue;
+    }
+    value.type()->copy_construct(value.get(), params.get_output_data_ptr(i));
+    params.output_set(i);
+  }
+  r_log = entry.log;
+  entry.used = true;
+  return true;
+}
+
+void GeoNodesResultCache::store(const ComputeContextHash &context_hash,
+                                const bNode &node,
+                                GeoNodesResultCacheKey key,
+                                const Span<GMutablePointer> outputs,
+                                GeoNodesResultCacheLog log)
+{
+  auto entry = std::make_unique<Entry>(std::move(key));
+  entry->log = std::move(log);
+  for (const GMutablePointer value : outputs) {
+    if (value.get() == nullptr) {
+      entry->outputs.append({});
+      continue;
+    }
+    const CPPType &type = *value.type();
+    void *buffer = MEM_mallocN_aligned(type.size(), type.alignment(), __func__);
+    type.copy_construct(value.get(), buffer);
+    entry->outputs.append({type, buffer});
+  }
+  std::lock_guard lock{mutex_};
+  entries_.add_overwrite({context_hash, node.identifier}, std::move(entry));
+}
+
+int64_t GeoNodesResultCache::size()
+{
+  std::lock_guard lock{mutex_};
+  return entries_.size();
+}
+
+void GeoNodesResultCache::remove_unused()
+{
+  std::lock_guard lock{mutex_};
+  entries_.remove_if([](const auto item) { return !item.value->used; });
+  for (std::unique_ptr<Entry> &entry : entries_.values()) {
+    entry->used = false;
+  }
+}
+
+}  // namespace blender::nodes
@@ -0,0 +1,212 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include "BLI_array.hh"
+#include "BLI_math_vector_types.hh"
+#include "BLI_memory_utils.hh"
+#include "BLI_string.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_node_types.h"
+
+#include "BKE_geometry_set.hh"
+#include "BKE_idtype.hh"
+#include "BKE_mesh.hh"
+#include "BKE_node_socket_value.hh"
+
+#include "FN_lazy_function_execute.hh"
+
+#include "NOD_geometry_nodes_result_cache.hh"
+
+namespace blender::nodes::tests {
+
+using bke::GeometrySet;
+using bke::SocketValueVariant;
+
+/** Has the inputs and outputs of a typical geometry node. The cache never executes it. */
+class GeometryNodeFunction : public lf::LazyFunction {
+ public:
+  GeometryNodeFunction()
+  {
+    debug_name_ = "Geometry Node";
+    inputs_.append({"Geometry", CPPType::get<GeometrySet>()});
+    inputs_.append({"Value", CPPType::get<SocketValueVariant>()});
+    outputs_.append({"Geometry", CPPType::get<GeometrySet>()});
+    outputs_.append({"Value", CPPType::get<SocketValueVariant>()});
+  }
+
+  void execute_impl(lf::Params & /*params*/, const lf::Context & /*context*/) const override
+  {
+    BLI_assert_unreachable();
+  }
+};
+
+/** Input values and output storage for a single evaluation of #GeometryNodeFunction. */
+class Evaluation {
+ public:
+  GeometrySet geometry;
+  SocketValueVariant value;
+  TypedBuffer<GeometrySet> geometry_output;
+  TypedBuffer<SocketValueVariant> value_output;
+
+  Array<GMutablePointer> inputs;
+  Array<GMutablePointer> outputs;
+  Array<std::optional<lf::ValueUsage>> input_usages = Array<std::optional<lf::ValueUsage>>(2);
+  Array<lf::ValueUsage> output_usages = Array<lf::ValueUsage>(2, lf::ValueUsage::Used);
+  Array<bool> set_outputs = Array<bool>(2, false);
+  lf::BasicParams params;
+
+  Evaluation(const lf::LazyFunction &fn, GeometrySet geometry_, const float value_)
+      : geometry(std::move(geometry_)),
+        value(value_),
+        inputs({&geometry, &value}),
+        outputs({static_cast<GeometrySet *>(geometry_output),
+                 static_cast<SocketValueVariant *>(value_output)}),
+        params(fn, inputs, outputs, input_usages, output_usages, set_outputs)
+  {
+  }
+
+  ~Evaluation()
+  {
+    if (set_outputs[0]) {
+      std::destroy_at(static_cast<GeometrySet *>(geometry_output));
+    }
+    if (set_outputs[1]) {
+      std::destroy_at(static_cast<SocketValueVariant *>(value_output));
+    }
+  }
+};
+
+class GeoNodesResultCacheTest : public testing::Test {
+ public:
+  GeometryNodeFunction fn;
+  bNode node = {};
+  ComputeContextHash context_hash;
+  GeometrySet geometry;
+  GeoNodesResultCache cache;
+
+  static void SetUpTestSuite()
+  {
+    BKE_idtype_init();
+  }
+
+  void SetUp() override
+  {
+    STRNCPY(node.idname, "GeometryNodeTest");
+    node.identifier = 1;
+    geometry = GeometrySet::from_mesh(BKE_mesh_new_nomain(4, 0, 0, 0));
+  }
+
+  GeoNodesResultCacheKey build_key(Evaluation &evaluation)
+  {
+    std::optional<GeoNodesResultCacheKey> key = GeoNodesResultCacheKey::build(
+        node, fn, evaluation.params);
+    if (!key) {
+      ADD_FAILURE() << "Inputs can't be identified";
+      return {};
+    }
+    return std::move(*key);
+  }
+
+  /** Store the results of an evaluation with the given value, which output twice the value. */
+  void store(const float value, const StringRef warning = "")
+  {
+    Evaluation evaluation(fn, geometry, value);
+    GeometrySet output_geometry = geometry;
+    SocketValueVariant output_value(value * 2.0f);
+    const Array<GMutablePointer> outputs = {&output_geometry, &output_value};
+
+    GeoNodesResultCacheLog log;
+    if (!warning.is_empty()) {
+      log.warnings.append({geo_eval_log::NodeWarningType::Info, std::string(warning)});
+    }
+    cache.store(context_hash, node, this->build_key(evaluation), outputs, std::move(log));
+  }
+
+  /**
+   * Try to load the results of an evaluation.
+   * \return The value output, or -1 if there was no cached result.
+   */
+  float load(const float value, GeoNodesResultCacheLog *r_log = nullptr)
+  {
+    Evaluation evaluation(fn, geometry, value);
+    const GeoNodesResultCacheKey key = this->build_key(evaluation);
+    GeoNodesResultCacheLog log;
+    if (!cache.try_load(context_hash, node, key, evaluation.params, log)) {
+      return -1.0f;
+    }
+    EXPECT_TRUE(evaluation.set_outputs[0]);
+    EXPECT_TRUE(evaluation.set_outputs[1]);
+    if (r_log) {
+      *r_log = std::move(log);
+    }
+    return (*evaluation.value_output).get<float>();
+  }
+};
+
+TEST_F(GeoNodesResultCacheTest, hit)
+{
+  EXPECT_EQ(this->load(1.0f), -1.0f);
+  this->store(1.0f, "Warning");
+
+  GeoNodesResultCacheLog log;
+  EXPECT_EQ(this->load(1.0f, &log), 2.0f);
+  /* Warnings of the node are kept with its results, so that they can be shown again. */
+  ASSERT_EQ(log.warnings.size(), 1);
+  EXPECT_EQ(log.warnings[0].type, geo_eval_log::NodeWarningType::Info);
+  EXPECT_EQ(log.warnings[0].message, "Warning");
+}
+
+TEST_F(GeoNodesResultCacheTest, invalidate_on_input_value_change)
+{
+  this->store(1.0f);
+  EXPECT_EQ(this->load(3.0f), -1.0f);
+}
+
+TEST_F(GeoNodesResultCacheTest, invalidate_on_input_geometry_change)
+{
+  this->store(1.0f);
+
+  Mesh *mesh = geometry.get_mesh_for_write();
+  mesh->vert_positions_for_write().fill(float3(1.0f));
+  mesh->tag_positions_changed();
+  EXPECT_EQ(this->load(1.0f), -1.0f);
+}
+
+TEST_F(GeoNodesResultCacheTest, invalidate_on_property_change)
+{
+  this->store(1.0f);
+
+  node.custom1 = 1;
+  EXPECT_EQ(this->load(1.0f), -1.0f);
+  node.custom1 = 0;
+  EXPECT_EQ(this->load(1.0f), 2.0f);
+}
+
+TEST_F(GeoNodesResultCacheTest, remove_unused)
+{
+  this->store(1.0f);
+  node.identifier = 2;
+  this->store(1.0f);
+  EXPECT_EQ(cache.size(), 2);
+
+  /* Both nodes were evaluated since the last call. */
+  cache.remove_unused();
+  EXPECT_EQ(cache.size(), 2);
+
+  /* Only the first node is evaluated again, the other node is evicted. */
+  node.identifier = 1;
+  EXPECT_EQ(this->load(1.0f), 2.0f);
+  cache.remove_unused();
+  EXPECT_EQ(cache.size(), 1);
+
+  node.identifier = 2;
+  EXPECT_EQ(this->load(1.0f), -1.0f);
+  node.identifier = 1;
+  EXPECT_EQ(this->load(1.0f), 2.0f);
+}
+
+}  // namespace blender::nodes::tests
@@ -111,6 +111,11 @@ void NodeDeclarationBuilder::allow_any_socket_order(bool enable)
   declaration_.allow_any_socket_order = enable;
 }
 
+void NodeDeclarationBuilder::allow_result_cache(bool enable)
+{
+  declaration_.allow_result_cache = enable;
+}
+
 Span<SocketDeclaration *> NodeDeclaration::sockets(eNodeSocketInOut in_out) const
 {
   if (in_out == SOCK_IN) {
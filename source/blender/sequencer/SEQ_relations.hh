@@ -8,6 +8,9 @@
  * \ingroup sequencer
  */
 
+#include <cstddef>
+#include <cstdint>
+
 struct ListBase;
 struct Main;
 struct MovieClip;
@@ -59,6 +62,20 @@ void SEQ_cache_iterate(
     void *userdata,
     bool callback_init(void *userdata, size_t item_count),
     bool callback_iter(void *userdata, Sequence *seq, int timeline_frame, int cache_type));
+
+/** Counters of the RAM image cache, accumulated since the cache was created or reset. */
+struct SeqCacheStatistics {
+  int64_t hits;
+  int64_t misses;
+  /** Number of frames removed from cache to make room for new ones. */
+  int64_t evictions;
+  size_t evicted_bytes;
+  /** Memory used by images currently stored in cache. */
+  size_t stored_bytes;
+};
+
+SeqCacheStatistics SEQ_cache_statistics_get(Scene *scene);
+void SEQ_cache_statistics_reset(Scene *scene);
 /**
  * Return immediate parent meta of sequence.
  */
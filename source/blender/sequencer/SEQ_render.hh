@@ -23,7 +23,9 @@ struct rctf;
 
 enum eSeqTaskId {
   SEQ_TASK_MAIN_RENDER,
+  /** Every prefetch worker has its own ID, starting at this one. */
   SEQ_TASK_PREFETCH_RENDER,
+  SEQ_TASK_PREFETCH_RENDER_LAST = SEQ_TASK_PREFETCH_RENDER + 7,
 };
 
 struct SeqRenderData {
@@ -9,6 +9,7 @@
 #include <cstddef>
 #include <ctime>
 #include <memory.h>
+#include <zstd.h>
 
 #include "MEM_guardedalloc.h"
 
@@ -44,9 +45,15 @@
  * For each cached non-temp image, image data and supplementary info are written to HDD.
  * Multiple(DCACHE_IMAGES_PER_FILE) images share the same file.
  * Each of these files contains header DiskCacheHeader followed by image data.
- * ZLIB compression with user definable level can be used to compress image data(per image)
+ * ZSTD compression with user definable level can be used to compress image data(per image)
  * Images are written in order in which they are rendered.
  * Overwriting of individual entry is not possible.
+ *
+ * Writing is done by a dedicated thread, so rendering and playback don't wait for compression and
+ * file IO. Until the write is finished, the image is kept in list of pending writes, from where it
+ * can be read back. When more than DCACHE_PENDING_SIZE_MAX bytes are pending, images are written
+ * synchronously instead. Image data is compressed and written without holding the lock used by
+ * readers, which only see the image once the file header is updated.
  * Stored images are deleted by invalidation, or when size of all files exceeds maximum
  * size specified in user preferences.
  * To distinguish 2 blend files with same name, scene->ed->disk_cache_timestamp
@@ -59,6 +66,7 @@
 #define DCACHE_IMAGES_PER_FILE 100
 #define DCACHE_CURRENT_VERSION 2
 #define COLORSPACE_NAME_MAX 64 /* XXX: defined in IMB intern. */
+#define DCACHE_PENDING_SIZE_MAX (256 * 1024 * 1024)
 
 struct DiskCacheHeaderEntry {
   uchar encoding;
@@ -79,6 +87,32 @@ struct SeqDiskCache {
   ListBase files;
   ThreadMutex read_write_mutex;
   size_t size_total;
+  /** Images waiting to be written by #write_thread, see #DiskCacheWrite. */
+  ListBase pending_writes;
+  /** Size of image data in #pending_writes. */
+  size_t pending_size;
+  ThreadCondition pending_writes_cond;
+  /** Notified when #pending_writes becomes empty, see #seq_disk_cache_flush. */
+  ThreadCondition pending_writes_done_cond;
+  /** Held for the whole write, so that data can be written without #read_write_mutex. */
+  ThreadMutex write_mutex;
+  ListBase write_thread;
+  bool write_thread_stop;
+};
+
+/** Image to be compressed and written to cache file. */
+struct DiskCacheWrite {
+  DiskCacheWrite *next, *prev;
+  /* Path and directory of the cache file, resolved when the write is queued, because the strip
+   * can be renamed or removed before the write happens. */
+  char filepath[FILE_MAX];
+  char dir[FILE_MAXDIR];
+  int cache_type;
+  float frame_index;
+  int compression_level;
+  ImBuf *ibuf;
+  /** Set when the image was invalidated before it was written. */
+  bool is_cancelled;
 };
 
 struct DiskCacheFile {
@@ -95,8 +129,6 @@ struct DiskCacheFile {
   int start_frame;
 };
 
-static ThreadMutex cache_create_lock = BLI_MUTEX_INITIALIZER;
-
 static const char *seq_disk_cache_base_dir()
 {
   return U.sequencer_disk_cache_dir;
@@ -216,7 +248,7 @@ static void seq_disk_cache_delete_file(SeqDiskCache *disk_cache, DiskCacheFile *
   MEM_freeN(file);
 }
 
-bool seq_disk_cache_enforce_limits(SeqDiskCache *disk_cache)
+static bool seq_disk_cache_enforce_limits(SeqDiskCache *disk_cache)
 {
   BLI_mutex_lock(&disk_cache->read_write_mutex);
   while (disk_cache->size_total > seq_disk_cache_size_limit()) {
@@ -392,6 +424,17 @@ static void seq_disk_cache_delete_invalid_files(SeqDiskCache *disk_cache,
     }
     cache_file = next_file;
   }
+
+  LISTBASE_FOREACH (DiskCacheWrite *, write, &disk_cache->pending_writes) {
+    if ((write->cache_type & invalidate_types) && STREQ(cache_dir, write->dir)) {
+      const int start_frame = (int(write->frame_index) / DCACHE_IMAGES_PER_FILE) *
+                              DCACHE_IMAGES_PER_FILE;
+      int timeline_frame_start = seq_cache_frame_index_to_timeline_frame(seq, start_frame);
+      if (timeline_frame_start > range_start && timeline_frame_start <= range_end) {
+        write->is_cancelled = true;
+      }
+    }
+  }
 }
 
 void seq_disk_cache_invalidate(SeqDiskCache *disk_cache,
@@ -413,28 +456,57 @@ void seq_disk_cache_invalidate(SeqDiskCache *disk_cache,
   BLI_mutex_unlock(&disk_cache->read_write_mutex);
 }
 
-static size_t deflate_imbuf_to_file(ImBuf *ibuf,
-                                    FILE *file,
-                                    int level,
-                                    DiskCacheHeaderEntry *header_entry)
+static void *imbuf_data_get(ImBuf *ibuf)
 {
-  void *data = (ibuf->byte_buffer.data != nullptr) ? (void *)ibuf->byte_buffer.data :
-                                                     (void *)ibuf->float_buffer.data;
+  return (ibuf->byte_buffer.data != nullptr) ? (void *)ibuf->byte_buffer.data :
+                                               (void *)ibuf->float_buffer.data;
+}
 
-  /* Apply compression if wanted, otherwise just write directly to the file. */
-  if (level > 0) {
-    return BLI_file_zstd_from_mem_at_pos(
-        data, header_entry->size_raw, file, header_entry->offset, level);
+static size_t imbuf_data_size(const ImBuf *ibuf)
+{
+  if (ibuf->byte_buffer.data != nullptr) {
+    return size_t(ibuf->x) * ibuf->y * ibuf->channels;
+  }
+  return size_t(ibuf->x) * ibuf->y * ibuf->channels * 4;
+}
+
+/**
+ * Compress image data into newly allocated buffer.
+ * Returns null if compression is disabled or failed, in which case raw data is written.
+ */
+static void *deflate_imbuf_to_mem(ImBuf *ibuf, int level, size_t *r_size)
+{
+  if (level <= 0) {
+    return nullptr;
+  }
+
+  const size_t size_raw = imbuf_data_size(ibuf);
+  const size_t out_buf_len = ZSTD_compressBound(size_raw);
+  void *out_buf = MEM_mallocN(out_buf_len, "SeqDiskCache compressed image");
+  const size_t out_size = ZSTD_compress(
+      out_buf, out_buf_len, imbuf_data_get(ibuf), size_raw, level);
+
+  if (ZSTD_isError(out_size)) {
+    MEM_freeN(out_buf);
+    return nullptr;
   }
 
+  *r_size = out_size;
+  return out_buf;
+}
+
+static size_t write_data_to_file(const void *data,
+                                 size_t size,
+                                 FILE *file,
+                                 DiskCacheHeaderEntry *header_entry)
+{
   fseek(file, header_entry->offset, SEEK_SET);
-  return fwrite(data, 1, header_entry->size_raw, file);
+  return fwrite(data, 1, size, file);
 }
 
 static size_t inflate_file_to_imbuf(ImBuf *ibuf, FILE *file, DiskCacheHeaderEntry *header_entry)
 {
-  void *data = (ibuf->byte_buffer.data != nullptr) ? (void *)ibuf->byte_buffer.data :
-                                                     (void *)ibuf->float_buffer.data;
+  void *data = imbuf_data_get(ibuf);
   char header[4];
   fseek(file, header_entry->offset, SEEK_SET);
   if (fread(header, 1, sizeof(header), file) != sizeof(header)) {
@@ -478,7 +550,9 @@ static size_t seq_disk_cache_write_header(FILE *file, const DiskCacheHeader *hea
   return fwrite(header, sizeof(*header), 1, file);
 }
 
-static int seq_disk_cache_add_header_entry(SeqCacheKey *key, ImBuf *ibuf, DiskCacheHeader *header)
+static int seq_disk_cache_add_header_entry(float frame_index,
+                                           ImBuf *ibuf,
+                                           DiskCacheHeader *header)
 {
   int i;
   uint64_t offset = sizeof(*header);
@@ -511,16 +585,15 @@ static int seq_disk_cache_add_header_entry(SeqCacheKey *key, ImBuf *ibuf, DiskCa
   }
 
   header->entry[i].offset = offset;
-  header->entry[i].frameno = key->frame_index;
+  header->entry[i].frameno = frame_index;
+  header->entry[i].size_raw = imbuf_data_size(ibuf);
 
   /* Store colorspace name of ibuf. */
   const char *colorspace_name;
   if (ibuf->byte_buffer.data) {
-    header->entry[i].size_raw = int64_t(ibuf->x) * ibuf->y * ibuf->channels;
     colorspace_name = IMB_colormanagement_get_rect_colorspace(ibuf);
   }
   else {
-    header->entry[i].size_raw = int64_t(ibuf->x) * ibuf->y * ibuf->channels * 4;
     colorspace_name = IMB_colormanagement_get_float_colorspace(ibuf);
   }
   STRNCPY(header->entry[i].colorspace_name, colorspace_name);
@@ -539,13 +612,21 @@ static int seq_disk_cache_get_header_entry(SeqCacheKey *key, const DiskCacheHead
   return -1;
 }
 
-bool seq_disk_cache_write_file(SeqDiskCache *disk_cache, SeqCacheKey *key, ImBuf *ibuf)
+static bool seq_disk_cache_write_data(SeqDiskCache *disk_cache,
+                                      const DiskCacheWrite *write,
+                                      const void *data,
+                                      size_t size)
 {
+  BLI_mutex_lock(&disk_cache->write_mutex);
   BLI_mutex_lock(&disk_cache->read_write_mutex);
 
-  char filepath[FILE_MAX];
+  if (write->is_cancelled) {
+    BLI_mutex_unlock(&disk_cache->read_write_mutex);
+    BLI_mutex_unlock(&disk_cache->write_mutex);
+    return false;
+  }
 
-  seq_disk_cache_get_file_path(disk_cache, key, filepath, sizeof(filepath));
+  const char *filepath = write->filepath;
   BLI_file_ensure_parent_dir_exists(filepath);
 
   /* Touch the file. */
@@ -554,12 +635,17 @@ bool seq_disk_cache_write_file(SeqDiskCache *disk_cache, SeqCacheKey *key, ImBuf
     file = BLI_fopen(filepath, "wb+");
     if (!file) {
       BLI_mutex_unlock(&disk_cache->read_write_mutex);
+      BLI_mutex_unlock(&disk_cache->write_mutex);
       return false;
     }
     seq_disk_cache_add_file_to_list(disk_cache, filepath);
   }
 
   DiskCacheFile *cache_file = seq_disk_cache_get_file_entry_by_path(disk_cache, filepath);
+  if (cache_file == nullptr) {
+    /* File exists on disk, but it was removed from the list, when its files were invalidated. */
+    cache_file = seq_disk_cache_add_file_to_list(disk_cache, filepath);
+  }
   DiskCacheHeader header;
   memset(&header, 0, sizeof(header));
   /* The file may be empty when touched (above).
@@ -568,28 +654,148 @@ bool seq_disk_cache_write_file(SeqDiskCache *disk_cache, SeqCacheKey *key, ImBuf
     fclose(file);
     seq_disk_cache_delete_file(disk_cache, cache_file);
     BLI_mutex_unlock(&disk_cache->read_write_mutex);
+    BLI_mutex_unlock(&disk_cache->write_mutex);
     return false;
   }
-  int entry_index = seq_disk_cache_add_header_entry(key, ibuf, &header);
+  int entry_index = seq_disk_cache_add_header_entry(write->frame_index, write->ibuf, &header);
+  BLI_mutex_unlock(&disk_cache->read_write_mutex);
 
-  size_t bytes_written = deflate_imbuf_to_file(
-      ibuf, file, seq_disk_cache_compression_level(), &header.entry[entry_index]);
+  /* Readers don't see the new entry until the header is written, other writers wait for
+   * #SeqDiskCache.write_mutex. */
+  size_t bytes_written = write_data_to_file(data, size, file, &header.entry[entry_index]);
 
-  if (bytes_written != 0) {
+  BLI_mutex_lock(&disk_cache->read_write_mutex);
+  /* The file may have been deleted by invalidation or by enforcing the size limit meanwhile. */
+  bool success = bytes_written == size && !write->is_cancelled &&
+                 seq_disk_cache_get_file_entry_by_path(disk_cache, filepath) != nullptr;
+  if (success) {
     /* Last step is writing header, as image data can be overwritten,
      * but missing data would cause problems.
      */
     header.entry[entry_index].size_compressed = bytes_written;
     seq_disk_cache_write_header(file, &header);
     seq_disk_cache_update_file(disk_cache, filepath);
-    fclose(file);
+  }
+  fclose(file);
+
+  BLI_mutex_unlock(&disk_cache->read_write_mutex);
+  BLI_mutex_unlock(&disk_cache->write_mutex);
+  return success;
+}
+
+static bool seq_disk_cache_write_image(SeqDiskCache *disk_cache, const DiskCacheWrite *write)
+{
+  size_t size = imbuf_data_size(write->ibuf);
+  void *compressed_data = deflate_imbuf_to_mem(write->ibuf, write->compression_level, &size);
+  const void *data = compressed_data ? compressed_data : imbuf_data_get(write->ibuf);
+
+  const bool success = seq_disk_cache_write_data(disk_cache, write, data, size);
+  if (success) {
+    seq_disk_cache_enforce_limits(disk_cache);
+  }
+
+  if (compressed_data) {
+    MEM_freeN(compressed_data);
+  }
+  return success;
+}
 
+static void seq_disk_cache_write_free(DiskCacheWrite *write)
+{
+  IMB_freeImBuf(write->ibuf);
+  MEM_freeN(write);
+}
+
+static void *seq_disk_cache_write_thread_run(void *data)
+{
+  SeqDiskCache *disk_cache = static_cast<SeqDiskCache *>(data);
+
+  BLI_mutex_lock(&disk_cache->read_write_mutex);
+  while (!disk_cache->write_thread_stop) {
+    /* Only this thread removes pending writes, so the image stays readable while it is written. */
+    DiskCacheWrite *write = static_cast<DiskCacheWrite *>(disk_cache->pending_writes.first);
+    if (write == nullptr) {
+      BLI_condition_wait(&disk_cache->pending_writes_cond, &disk_cache->read_write_mutex);
+      continue;
+    }
+
+    if (!write->is_cancelled) {
+      BLI_mutex_unlock(&disk_cache->read_write_mutex);
+      seq_disk_cache_write_image(disk_cache, write);
+      BLI_mutex_lock(&disk_cache->read_write_mutex);
+    }
+
+    BLI_remlink(&disk_cache->pending_writes, write);
+    disk_cache->pending_size -= imbuf_data_size(write->ibuf);
+    seq_disk_cache_write_free(write);
+    if (BLI_listbase_is_empty(&disk_cache->pending_writes)) {
+      BLI_condition_notify_all(&disk_cache->pending_writes_done_cond);
+    }
+  }
+  BLI_mutex_unlock(&disk_cache->read_write_mutex);
+
+  return nullptr;
+}
+
+bool seq_disk_cache_write_file(SeqDiskCache *disk_cache, SeqCacheKey *key, ImBuf *ibuf)
+{
+  if (imbuf_data_get(ibuf) == nullptr) {
+    return false;
+  }
+
+  DiskCacheWrite *write = static_cast<DiskCacheWrite *>(
+      MEM_callocN(sizeof(DiskCacheWrite), "SeqDiskCacheWrite"));
+  seq_disk_cache_get_file_path(disk_cache, key, write->filepath, sizeof(write->filepath));
+  BLI_path_split_dir_part(write->filepath, write->dir, sizeof(write->dir));
+  write->cache_type = key->type;
+  write->frame_index = key->frame_index;
+  write->compression_level = seq_disk_cache_compression_level();
+  write->ibuf = ibuf;
+  const size_t size = imbuf_data_size(ibuf);
+
+  BLI_mutex_lock(&disk_cache->read_write_mutex);
+  /* When the write thread can't keep up, write synchronously, so that images waiting to be written
+   * don't use an unbounded amount of memory. */
+  if (!BLI_listbase_is_empty(&disk_cache->pending_writes) &&
+      disk_cache->pending_size + size > DCACHE_PENDING_SIZE_MAX)
+  {
     BLI_mutex_unlock(&disk_cache->read_write_mutex);
-    return true;
+    const bool success = seq_disk_cache_write_image(disk_cache, write);
+    MEM_freeN(write);
+    return success;
   }
 
+  IMB_refImBuf(ibuf);
+  BLI_addtail(&disk_cache->pending_writes, write);
+  disk_cache->pending_size += size;
+  BLI_condition_notify_one(&disk_cache->pending_writes_cond);
+  BLI_mutex_unlock(&disk_cache->read_write_mutex);
+  return true;
+}
+
+void seq_disk_cache_flush(SeqDiskCache *disk_cache)
+{
+  BLI_mutex_lock(&disk_cache->read_write_mutex);
+  while (!BLI_listbase_is_empty(&disk_cache->pending_writes)) {
+    BLI_condition_wait(&disk_cache->pending_writes_done_cond, &disk_cache->read_write_mutex);
+  }
   BLI_mutex_unlock(&disk_cache->read_write_mutex);
-  return false;
+}
+
+/* Find image that is queued for writing, but may not be written yet. */
+static ImBuf *seq_disk_cache_get_pending_write(SeqDiskCache *disk_cache,
+                                               const char *filepath,
+                                               SeqCacheKey *key)
+{
+  LISTBASE_FOREACH (DiskCacheWrite *, write, &disk_cache->pending_writes) {
+    if (!write->is_cancelled && write->frame_index == key->frame_index &&
+        STREQ(write->filepath, filepath))
+    {
+      IMB_refImBuf(write->ibuf);
+      return write->ibuf;
+    }
+  }
+  return nullptr;
 }
 
 ImBuf *seq_disk_cache_read_file(SeqDiskCache *disk_cache, SeqCacheKey *key)
@@ -600,6 +806,13 @@ ImBuf *seq_disk_cache_read_file(SeqDiskCache *disk_cache, SeqCacheKey *key)
   DiskCacheHeader header;
 
   seq_disk_cache_get_file_path(disk_cache, key, filepath, sizeof(filepath));
+
+  ImBuf *pending_ibuf = seq_disk_cache_get_pending_write(disk_cache, filepath, key);
+  if (pending_ibuf) {
+    BLI_mutex_unlock(&disk_cache->read_write_mutex);
+    return pending_ibuf;
+  }
+
   BLI_file_ensure_parent_dir_exists(filepath);
 
   FILE *file = BLI_fopen(filepath, "rb");
@@ -668,16 +881,37 @@ SeqDiskCache *seq_disk_cache_create(Main *bmain, Scene *scene)
       MEM_callocN(sizeof(SeqDiskCache), "SeqDiskCache"));
   disk_cache->bmain = bmain;
   BLI_mutex_init(&disk_cache->read_write_mutex);
+  BLI_mutex_init(&disk_cache->write_mutex);
+  BLI_condition_init(&disk_cache->pending_writes_cond);
+  BLI_condition_init(&disk_cache->pending_writes_done_cond);
+  BLI_threadpool_init(&disk_cache->write_thread, seq_disk_cache_write_thread_run, 1);
+  BLI_threadpool_insert(&disk_cache->write_thread, disk_cache);
   seq_disk_cache_handle_versioning(disk_cache);
   seq_disk_cache_get_files(disk_cache, seq_disk_cache_base_dir());
   disk_cache->timestamp = scene->ed->disk_cache_timestamp;
-  BLI_mutex_unlock(&cache_create_lock);
   return disk_cache;
 }
 
 void seq_disk_cache_free(SeqDiskCache *disk_cache)
 {
+  /* Images that were not written yet are dropped. */
+  BLI_mutex_lock(&disk_cache->read_write_mutex);
+  disk_cache->write_thread_stop = true;
+  LISTBASE_FOREACH (DiskCacheWrite *, write, &disk_cache->pending_writes) {
+    write->is_cancelled = true;
+  }
+  BLI_condition_notify_one(&disk_cache->pending_writes_cond);
+  BLI_mutex_unlock(&disk_cache->read_write_mutex);
+  BLI_threadpool_end(&disk_cache->write_thread);
+
+  LISTBASE_FOREACH_MUTABLE (DiskCacheWrite *, write, &disk_cache->pending_writes) {
+    seq_disk_cache_write_free(write);
+  }
+
   BLI_freelistN(&disk_cache->files);
+  BLI_condition_end(&disk_cache->pending_writes_cond);
+  BLI_condition_end(&disk_cache->pending_writes_done_cond);
+  BLI_mutex_end(&disk_cache->write_mutex);
   BLI_mutex_end(&disk_cache->read_write_mutex);
   MEM_freeN(disk_cache);
 }
@@ -23,8 +23,13 @@ SeqDiskCache *seq_disk_cache_create(Main *bmain, Scene *scene);
 void seq_disk_cache_free(SeqDiskCache *disk_cache);
 bool seq_disk_cache_is_enabled(Main *bmain);
 ImBuf *seq_disk_cache_read_file(SeqDiskCache *disk_cache, SeqCacheKey *key);
+/**
+ * Queue image to be compressed and written to disk by the write thread, or write it directly when
+ * too many images are queued already. Cache size limit is enforced after the image is written.
+ */
 bool seq_disk_cache_write_file(SeqDiskCache *disk_cache, SeqCacheKey *key, ImBuf *ibuf);
-bool seq_disk_cache_enforce_limits(SeqDiskCache *disk_cache);
+/** Wait until all queued images are written. */
+void seq_disk_cache_flush(SeqDiskCache *disk_cache);
 void seq_disk_cache_invalidate(SeqDiskCache *disk_cache,
                                Scene *scene,
                                Sequence *seq,
@@ -0,0 +1,160 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_fileops.h"
+#include "BLI_path_util.h"
+#include "BLI_string.h"
+
+#include "DNA_scene_types.h"
+#include "DNA_sequence_types.h"
+#include "DNA_userdef_types.h"
+
+#include "BKE_appdir.hh"
+#include "BKE_main.hh"
+
+#include "IMB_imbuf.hh"
+#include "IMB_imbuf_types.hh"
+
+#include "SEQ_render.hh"
+
+#include "disk_cache.hh"
+#include "image_cache.hh"
+
+namespace blender::seq::tests {
+
+class DiskCacheTest : public testing::Test {
+ protected:
+  Main *bmain = nullptr;
+  Scene *scene = nullptr;
+  Sequence *seq = nullptr;
+  SeqRenderData context = {};
+  SeqDiskCache *disk_cache = nullptr;
+  UserDef userdef = {};
+
+  void SetUp() override
+  {
+    userdef = U;
+    BKE_tempdir_init(nullptr);
+    BLI_path_join(U.sequencer_disk_cache_dir,
+                  sizeof(U.sequencer_disk_cache_dir),
+                  BKE_tempdir_session(),
+                  "sequencer_disk_cache");
+    U.sequencer_disk_cache_size_limit = 1;
+    U.sequencer_disk_cache_flag = SEQ_CACHE_DISK_CACHE_ENABLE;
+    /* Compressed images are written and read through zstd. */
+    U.sequencer_disk_cache_compression = USER_SEQ_DISK_CACHE_COMPRESSION_LOW;
+
+    bmain = BKE_main_new();
+    STRNCPY(bmain->filepath, "disk_cache_test.blend");
+
+    scene = static_cast<Scene *>(MEM_callocN(sizeof(Scene), __func__));
+    STRNCPY(scene->id.name, "SCScene");
+    scene->ed = static_cast<Editing *>(MEM_callocN(sizeof(Editing), __func__));
+    scene->ed->disk_cache_timestamp = 1;
+
+    seq = static_cast<Sequence *>(MEM_callocN(sizeof(Sequence), __func__));
+    STRNCPY(seq->name, "SQStrip");
+    seq->type = SEQ_TYPE_CROSS;
+
+    SEQ_render_new_render_data(bmain, nullptr, scene, 64, 32, 100, false, &context);
+    ASSERT_TRUE(seq_disk_cache_is_enabled(bmain));
+    disk_cache = seq_disk_cache_create(bmain, scene);
+  }
+
+  void TearDown() override
+  {
+    seq_disk_cache_free(disk_cache);
+    BLI_delete(U.sequencer_disk_cache_dir, true, true);
+    BKE_tempdir_session_purge();
+
+    MEM_freeN(seq);
+    MEM_freeN(scene->ed);
+    MEM_freeN(scene);
+    BKE_main_free(bmain);
+    U = userdef;
+  }
+
+  SeqCacheKey key(const int frame_index)
+  {
+    SeqCacheKey key = {};
+    key.seq = seq;
+    key.context = context;
+    key.frame_index = frame_index;
+    key.timeline_frame = frame_index;
+    key.type = SEQ_CACHE_STORE_FINAL_OUT;
+    return key;
+  }
+
+  /** Image with pixels that are different for every frame. */
+  ImBuf *image(const int frame_index)
+  {
+    ImBuf *ibuf = IMB_allocImBuf(context.rectx, context.recty, 32, IB_rect);
+    const size_t size = size_t(ibuf->x) * ibuf->y * 4;
+    for (size_t i = 0; i < size; i++) {
+      ibuf->byte_buffer.data[i] = uchar((i / 4) * (frame_index + 1) + i % 4);
+    }
+    return ibuf;
+  }
+};
+
+TEST_F(DiskCacheTest, write_flush_read)
+{
+  for (int frame_index = 0; frame_index < 4; frame_index++) {
+    SeqCacheKey write_key = key(frame_index);
+    ImBuf *ibuf = image(frame_index);
+    EXPECT_TRUE(seq_disk_cache_write_file(disk_cache, &write_key, ibuf));
+    IMB_freeImBuf(ibuf);
+  }
+  seq_disk_cache_flush(disk_cache);
+
+  /* A new disk cache has no queued images, so images can only be read from the files. */
+  seq_disk_cache_free(disk_cache);
+  disk_cache = seq_disk_cache_create(bmain, scene);
+
+  for (int frame_index = 0; frame_index < 4; frame_index++) {
+    SeqCacheKey read_key = key(frame_index);
+    ImBuf *ibuf = seq_disk_cache_read_file(disk_cache, &read_key);
+    ASSERT_NE(ibuf, nullptr) << "frame " << frame_index;
+    ASSERT_NE(ibuf->byte_buffer.data, nullptr);
+
+    ImBuf *expected = image(frame_index);
+    EXPECT_EQ(ibuf->x, expected->x);
+    EXPECT_EQ(ibuf->y, expected->y);
+    EXPECT_EQ(
+        memcmp(ibuf->byte_buffer.data, expected->byte_buffer.data, size_t(ibuf->x) * ibuf->y * 4),
+        0)
+        << "frame " << frame_index;
+    IMB_freeImBuf(expected);
+    IMB_freeImBuf(ibuf);
+  }
+
+  SeqCacheKey missing_key = key(4);
+  EXPECT_EQ(seq_disk_cache_read_file(disk_cache, &missing_key), nullptr);
+}
+
+TEST_F(DiskCacheTest, read_queued_image)
+{
+  SeqCacheKey write_key = key(0);
+  ImBuf *ibuf = image(0);
+  EXPECT_TRUE(seq_disk_cache_write_file(disk_cache, &write_key, ibuf));
+
+  /* Whether or not the write thread got to it yet, the image can be read back. */
+  SeqCacheKey read_key = key(0);
+  ImBuf *read_ibuf = seq_disk_cache_read_file(disk_cache, &read_key);
+  ASSERT_NE(read_ibuf, nullptr);
+  EXPECT_EQ(memcmp(read_ibuf->byte_buffer.data,
+                   ibuf->byte_buffer.data,
+                   size_t(ibuf->x) * ibuf->y * 4),
+            0);
+  IMB_freeImBuf(read_ibuf);
+  IMB_freeImBuf(ibuf);
+
+  seq_disk_cache_flush(disk_cache);
+}
+
+}  // namespace blender::seq::tests
@@ -20,6 +20,7 @@
 #include "BLI_math_vector_types.hh"
 #include "BLI_path_util.h"
 #include "BLI_rect.h"
+#include "BLI_simd.hh"
 #include "BLI_string.h"
 #include "BLI_task.hh"
 #include "BLI_threads.h"
@@ -118,10 +119,58 @@ static void slice_get_float_buffers(const SeqRenderData *context,
   }
 }
 
+#if BLI_HAVE_SSE2
+
+/* SIMD versions of pixel operations. Results match the scalar code exactly. */
+
+static __m128i load_4_pixels(const uchar *ptr)
+{
+  return _mm_loadu_si128(reinterpret_cast<const __m128i *>(ptr));
+}
+
+static void store_4_pixels(uchar *ptr, const __m128i pixels)
+{
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(ptr), pixels);
+}
+
+/* Replace 16 bit channels of each pixel with its alpha channel. */
+static __m128i broadcast_alpha_epi16(const __m128i pixels)
+{
+  const __m128i lo = _mm_shufflelo_epi16(pixels, _MM_SHUFFLE(3, 3, 3, 3));
+  return _mm_shufflehi_epi16(lo, _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+/* Take RGB of `rgb` and alpha of `alpha`, for 4 byte pixels. */
+static __m128i merge_alpha_epi8(const __m128i rgb, const __m128i alpha)
+{
+  const __m128i alpha_mask = _mm_set1_epi32(int(0xFF000000));
+  return _mm_or_si128(_mm_andnot_si128(alpha_mask, rgb), _mm_and_si128(alpha_mask, alpha));
+}
+
+/* Take RGB of `rgb` and alpha of `alpha`, for single float pixel. */
+static __m128 merge_alpha_ps(const __m128 rgb, const __m128 alpha)
+{
+  const __m128 alpha_mask = _mm_castsi128_ps(_mm_set_epi32(-1, 0, 0, 0));
+  return _mm_or_ps(_mm_andnot_ps(alpha_mask, rgb), _mm_and_ps(alpha_mask, alpha));
+}
+
+#endif
+
 static float4 load_premul_pixel(const uchar *ptr)
 {
   float4 res;
+#if BLI_HAVE_SSE2
+  int packed;
+  memcpy(&packed, ptr, sizeof(packed));
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i pix16 = _mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero);
+  const __m128 pix = _mm_cvtepi32_ps(_mm_unpacklo_epi16(pix16, zero));
+  const float alpha = ptr[3] * (1.0f / 255.0f);
+  const float fac = alpha * (1.0f / 255.0f);
+  _mm_storeu_ps(res, _mm_mul_ps(pix, _mm_set_ps(1.0f / 255.0f, fac, fac, fac)));
+#else
   straight_uchar_to_premul_float(res, ptr);
+#endif
   return res;
 }
 
@@ -132,7 +181,23 @@ static float4 load_premul_pixel(const float *ptr)
 
 static void store_premul_pixel(const float4 &pix, uchar *dst)
 {
+#if BLI_HAVE_SSE2
+  __m128 col = _mm_loadu_ps(pix);
+  if (pix.w != 0.0f && pix.w != 1.0f) {
+    const float alpha_inv = 1.0f / pix.w;
+    col = _mm_mul_ps(col, _mm_set_ps(1.0f, alpha_inv, alpha_inv, alpha_inv));
+  }
+  /* Same rounding as #unit_float_to_uchar_clamp. */
+  col = _mm_add_ps(_mm_mul_ps(col, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f));
+  col = _mm_min_ps(_mm_max_ps(col, _mm_setzero_ps()), _mm_set1_ps(255.0f));
+  __m128i col32 = _mm_cvttps_epi32(col);
+  col32 = _mm_packs_epi32(col32, col32);
+  col32 = _mm_packus_epi16(col32, col32);
+  const int packed = _mm_cvtsi128_si32(col32);
+  memcpy(dst, &packed, sizeof(packed));
+#else
   premul_float_to_straight_uchar(dst, pix);
+#endif
 }
 
 static void store_premul_pixel(const float4 &pix, float *dst)
@@ -392,18 +457,43 @@ static void do_cross_effect_byte(float fac, int x, int y, uchar *rect1, uchar *r
   int temp_fac = int(256.0f * fac);
   int temp_mfac = 256 - temp_fac;
 
-  for (int i = 0; i < y; i++) {
-    for (int j = 0; j < x; j++) {
-      rt[0] = (temp_mfac * rt1[0] + temp_fac * rt2[0]) >> 8;
-      rt[1] = (temp_mfac * rt1[1] + temp_fac * rt2[1]) >> 8;
-      rt[2] = (temp_mfac * rt1[2] + temp_fac * rt2[2]) >> 8;
-      rt[3] = (temp_mfac * rt1[3] + temp_fac * rt2[3]) >> 8;
-
-      rt1 += 4;
-      rt2 += 4;
-      rt += 4;
+  const int64_t pixels_num = int64_t(x) * y;
+  int64_t i = 0;
+
+#if BLI_HAVE_SSE2
+  /* Weighted sum of channels fits into 16 bits only for factor in 0..1 range. */
+  if (temp_fac >= 0 && temp_mfac >= 0) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i fac16 = _mm_set1_epi16(short(temp_fac));
+    const __m128i mfac16 = _mm_set1_epi16(short(temp_mfac));
+    for (; i + 4 <= pixels_num; i += 4) {
+      const __m128i col1 = load_4_pixels(rt1);
+      const __m128i col2 = load_4_pixels(rt2);
+      __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(col1, zero), mfac16),
+                                 _mm_mullo_epi16(_mm_unpacklo_epi8(col2, zero), fac16));
+      __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(col1, zero), mfac16),
+                                 _mm_mullo_epi16(_mm_unpackhi_epi8(col2, zero), fac16));
+      lo = _mm_srli_epi16(lo, 8);
+      hi = _mm_srli_epi16(hi, 8);
+      store_4_pixels(rt, _mm_packus_epi16(lo, hi));
+
+      rt1 += 16;
+      rt2 += 16;
+      rt += 16;
     }
   }
+#endif
+
+  for (; i < pixels_num; i++) {
+    rt[0] = (temp_mfac * rt1[0] + temp_fac * rt2[0]) >> 8;
+    rt[1] = (temp_mfac * rt1[1] + temp_fac * rt2[1]) >> 8;
+    rt[2] = (temp_mfac * rt1[2] + temp_fac * rt2[2]) >> 8;
+    rt[3] = (temp_mfac * rt1[3] + temp_fac * rt2[3]) >> 8;
+
+    rt1 += 4;
+    rt2 += 4;
+    rt += 4;
+  }
 }
 
 static void do_cross_effect_float(float fac, int x, int y, float *rect1, float *rect2, float *out)
@@ -414,17 +504,22 @@ static void do_cross_effect_float(float fac, int x, int y, float *rect1, float *
 
   float mfac = 1.0f - fac;
 
-  for (int i = 0; i < y; i++) {
-    for (int j = 0; j < x; j++) {
-      rt[0] = mfac * rt1[0] + fac * rt2[0];
-      rt[1] = mfac * rt1[1] + fac * rt2[1];
-      rt[2] = mfac * rt1[2] + fac * rt2[2];
-      rt[3] = mfac * rt1[3] + fac * rt2[3];
+  const int64_t pixels_num = int64_t(x) * y;
+  for (int64_t i = 0; i < pixels_num; i++) {
+#if BLI_HAVE_SSE2
+    const __m128 col = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(mfac), _mm_loadu_ps(rt1)),
+                                  _mm_mul_ps(_mm_set1_ps(fac), _mm_loadu_ps(rt2)));
+    _mm_storeu_ps(rt, col);
+#else
+    rt[0] = mfac * rt1[0] + fac * rt2[0];
+    rt[1] = mfac * rt1[1] + fac * rt2[1];
+    rt[2] = mfac * rt1[2] + fac * rt2[2];
+    rt[3] = mfac * rt1[3] + fac * rt2[3];
+#endif
 
-      rt1 += 4;
-      rt2 += 4;
-      rt += 4;
-    }
+    rt1 += 4;
+    rt2 += 4;
+    rt += 4;
   }
 }
 
@@ -492,9 +587,23 @@ static void do_gammacross_effect(
       float4 col1 = load_premul_pixel(src1);
       float4 col2 = load_premul_pixel(src2);
       float4 col;
+#if BLI_HAVE_SSE2
+      /* Same as #invGammaCorrect and #gammaCorrect, for all channels at once. */
+      const __m128 sign_mask = _mm_set1_ps(-0.0f);
+      const __m128 c1 = _mm_loadu_ps(col1);
+      const __m128 c2 = _mm_loadu_ps(col2);
+      const __m128 inv1 = _mm_or_ps(_mm_sqrt_ps(_mm_andnot_ps(sign_mask, c1)),
+                                    _mm_and_ps(sign_mask, c1));
+      const __m128 inv2 = _mm_or_ps(_mm_sqrt_ps(_mm_andnot_ps(sign_mask, c2)),
+                                    _mm_and_ps(sign_mask, c2));
+      const __m128 mix = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(mfac), inv1),
+                                    _mm_mul_ps(_mm_set1_ps(fac), inv2));
+      _mm_storeu_ps(col, _mm_mul_ps(mix, _mm_andnot_ps(sign_mask, mix)));
+#else
       for (int c = 0; c < 4; ++c) {
         col[c] = gammaCorrect(mfac * invGammaCorrect(col1[c]) + fac * invGammaCorrect(col2[c]));
       }
+#endif
       store_premul_pixel(col, dst);
       src1 += 4;
       src2 += 4;
@@ -547,6 +656,26 @@ static void do_gammacross_effect(const SeqRenderData *context,
 /** \name Color Add Effect
  * \{ */
 
+#if BLI_HAVE_SSE2
+/**
+ * `(temp_fac * alpha2 * col2) >> 16` for 4 byte pixels, as used by add and subtract effects.
+ * The product of factor and alpha fits into 16 bits for `temp_fac` in 0..256 range.
+ */
+static void add_sub_effect_term_epi16(const __m128i col2,
+                                      const __m128i fac16,
+                                      __m128i *r_lo,
+                                      __m128i *r_hi)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i col2_lo = _mm_unpacklo_epi8(col2, zero);
+  const __m128i col2_hi = _mm_unpackhi_epi8(col2, zero);
+  const __m128i fac2_lo = _mm_mullo_epi16(broadcast_alpha_epi16(col2_lo), fac16);
+  const __m128i fac2_hi = _mm_mullo_epi16(broadcast_alpha_epi16(col2_hi), fac16);
+  *r_lo = _mm_mulhi_epu16(fac2_lo, col2_lo);
+  *r_hi = _mm_mulhi_epu16(fac2_hi, col2_hi);
+}
+#endif
+
 static void do_add_effect_byte(float fac, int x, int y, uchar *rect1, uchar *rect2, uchar *out)
 {
   uchar *cp1 = rect1;
@@ -555,19 +684,40 @@ static void do_add_effect_byte(float fac, int x, int y, uchar *rect1, uchar *rec
 
   int temp_fac = int(256.0f * fac);
 
-  for (int i = 0; i < y; i++) {
-    for (int j = 0; j < x; j++) {
-      const int temp_fac2 = temp_fac * int(cp2[3]);
-      rt[0] = min_ii(cp1[0] + ((temp_fac2 * cp2[0]) >> 16), 255);
-      rt[1] = min_ii(cp1[1] + ((temp_fac2 * cp2[1]) >> 16), 255);
-      rt[2] = min_ii(cp1[2] + ((temp_fac2 * cp2[2]) >> 16), 255);
-      rt[3] = cp1[3];
-
-      cp1 += 4;
-      cp2 += 4;
-      rt += 4;
+  const int64_t pixels_num = int64_t(x) * y;
+  int64_t i = 0;
+
+#if BLI_HAVE_SSE2
+  if (temp_fac >= 0 && temp_fac <= 256) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i fac16 = _mm_set1_epi16(short(temp_fac));
+    for (; i + 4 <= pixels_num; i += 4) {
+      const __m128i col1 = load_4_pixels(cp1);
+      __m128i term_lo, term_hi;
+      add_sub_effect_term_epi16(load_4_pixels(cp2), fac16, &term_lo, &term_hi);
+      /* Packing saturates to 255. */
+      const __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(col1, zero), term_lo);
+      const __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(col1, zero), term_hi);
+      store_4_pixels(rt, merge_alpha_epi8(_mm_packus_epi16(lo, hi), col1));
+
+      cp1 += 16;
+      cp2 += 16;
+      rt += 16;
     }
   }
+#endif
+
+  for (; i < pixels_num; i++) {
+    const int temp_fac2 = temp_fac * int(cp2[3]);
+    rt[0] = min_ii(cp1[0] + ((temp_fac2 * cp2[0]) >> 16), 255);
+    rt[1] = min_ii(cp1[1] + ((temp_fac2 * cp2[1]) >> 16), 255);
+    rt[2] = min_ii(cp1[2] + ((temp_fac2 * cp2[2]) >> 16), 255);
+    rt[3] = cp1[3];
+
+    cp1 += 4;
+    cp2 += 4;
+    rt += 4;
+  }
 }
 
 static void do_add_effect_float(float fac, int x, int y, float *rect1, float *rect2, float *out)
@@ -576,18 +726,23 @@ static void do_add_effect_float(float fac, int x, int y, float *rect1, float *re
   float *rt2 = rect2;
   float *rt = out;
 
-  for (int i = 0; i < y; i++) {
-    for (int j = 0; j < x; j++) {
-      const float temp_fac = (1.0f - (rt1[3] * (1.0f - fac))) * rt2[3];
-      rt[0] = rt1[0] + temp_fac * rt2[0];
-      rt[1] = rt1[1] + temp_fac * rt2[1];
-      rt[2] = rt1[2] + temp_fac * rt2[2];
-      rt[3] = rt1[3];
+  const int64_t pixels_num = int64_t(x) * y;
+  for (int64_t i = 0; i < pixels_num; i++) {
+    const float temp_fac = (1.0f - (rt1[3] * (1.0f - fac))) * rt2[3];
+#if BLI_HAVE_SSE2
+    const __m128 col1 = _mm_loadu_ps(rt1);
+    const __m128 col = _mm_add_ps(col1, _mm_mul_ps(_mm_set1_ps(temp_fac), _mm_loadu_ps(rt2)));
+    _mm_storeu_ps(rt, merge_alpha_ps(col, col1));
+#else
+    rt[0] = rt1[0] + temp_fac * rt2[0];
+    rt[1] = rt1[1] + temp_fac * rt2[1];
+    rt[2] = rt1[2] + temp_fac * rt2[2];
+    rt[3] = rt1[3];
+#endif
 
-      rt1 += 4;
-      rt2 += 4;
-      rt += 4;
-    }
+    rt1 += 4;
+    rt2 += 4;
+    rt += 4;
   }
 }
 
@@ -634,19 +789,40 @@ static void do_sub_effect_byte(float fac, int x, int y, uchar *rect1, uchar *rec
 
   int temp_fac = int(256.0f * fac);
 
-  for (int i = 0; i < y; i++) {
-    for (int j = 0; j < x; j++) {
-      const int temp_fac2 = temp_fac * int(cp2[3]);
-      rt[0] = max_ii(cp1[0] - ((temp_fac2 * cp2[0]) >> 16), 0);
-      rt[1] = max_ii(cp1[1] - ((temp_fac2 * cp2[1]) >> 16), 0);
-      rt[2] = max_ii(cp1[2] - ((temp_fac2 * cp2[2]) >> 16), 0);
-      rt[3] = cp1[3];
-
-      cp1 += 4;
-      cp2 += 4;
-      rt += 4;
+  const int64_t pixels_num = int64_t(x) * y;
+  int64_t i = 0;
+
+#if BLI_HAVE_SSE2
+  if (temp_fac >= 0 && temp_fac <= 256) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i fac16 = _mm_set1_epi16(short(temp_fac));
+    for (; i + 4 <= pixels_num; i += 4) {
+      const __m128i col1 = load_4_pixels(cp1);
+      __m128i term_lo, term_hi;
+      add_sub_effect_term_epi16(load_4_pixels(cp2), fac16, &term_lo, &term_hi);
+      /* Saturating subtraction clamps to 0. */
+      const __m128i lo = _mm_subs_epu16(_mm_unpacklo_epi8(col1, zero), term_lo);
+      const __m128i hi = _mm_subs_epu16(_mm_unpackhi_epi8(col1, zero), term_hi);
+      store_4_pixels(rt, merge_alpha_epi8(_mm_packus_epi16(lo, hi), col1));
+
+      cp1 += 16;
+      cp2 += 16;
+      rt += 16;
     }
   }
+#endif
+
+  for (; i < pixels_num; i++) {
+    const int temp_fac2 = temp_fac * int(cp2[3]);
+    rt[0] = max_ii(cp1[0] - ((temp_fac2 * cp2[0]) >> 16), 0);
+    rt[1] = max_ii(cp1[1] - ((temp_fac2 * cp2[1]) >> 16), 0);
+    rt[2] = max_ii(cp1[2] - ((temp_fac2 * cp2[2]) >> 16), 0);
+    rt[3] = cp1[3];
+
+    cp1 += 4;
+    cp2 += 4;
+    rt += 4;
+  }
 }
 
 static void do_sub_effect_float(float fac, int x, int y, float *rect1, float *rect2, float *out)
@@ -657,18 +833,24 @@ static void do_sub_effect_float(float fac, int x, int y, float *rect1, float *re
 
   float mfac = 1.0f - fac;
 
-  for (int i = 0; i < y; i++) {
-    for (int j = 0; j < x; j++) {
-      const float temp_fac = (1.0f - (rt1[3] * mfac)) * rt2[3];
-      rt[0] = max_ff(rt1[0] - temp_fac * rt2[0], 0.0f);
-      rt[1] = max_ff(rt1[1] - temp_fac * rt2[1], 0.0f);
-      rt[2] = max_ff(rt1[2] - temp_fac * rt2[2], 0.0f);
-      rt[3] = rt1[3];
+  const int64_t pixels_num = int64_t(x) * y;
+  for (int64_t i = 0; i < pixels_num; i++) {
+    const float temp_fac = (1.0f - (rt1[3] * mfac)) * rt2[3];
+#if BLI_HAVE_SSE2
+    const __m128 col1 = _mm_loadu_ps(rt1);
+    __m128 col = _mm_sub_ps(col1, _mm_mul_ps(_mm_set1_ps(temp_fac), _mm_loadu_ps(rt2)));
+    col = _mm_max_ps(col, _mm_setzero_ps());
+    _mm_storeu_ps(rt, merge_alpha_ps(col, col1));
+#else
+    rt[0] = max_ff(rt1[0] - temp_fac * rt2[0], 0.0f);
+    rt[1] = max_ff(rt1[1] - temp_fac * rt2[1], 0.0f);
+    rt[2] = max_ff(rt1[2] - temp_fac * rt2[2], 0.0f);
+    rt[3] = rt1[3];
+#endif
 
-      rt1 += 4;
-      rt2 += 4;
-      rt += 4;
-    }
+    rt1 += 4;
+    rt2 += 4;
+    rt += 4;
   }
 }
 
@@ -796,18 +978,48 @@ static void do_mul_effect_byte(float fac, int x, int y, uchar *rect1, uchar *rec
    * `fac * (a * b) + (1 - fac) * a => fac * a * (b - 1) + axaux = c * px + py * s;` // + centx
    * `yaux = -s * px + c * py;` // + centy */
 
-  for (int i = 0; i < y; i++) {
-    for (int j = 0; j < x; j++) {
-      rt[0] = rt1[0] + ((temp_fac * rt1[0] * (rt2[0] - 255)) >> 16);
-      rt[1] = rt1[1] + ((temp_fac * rt1[1] * (rt2[1] - 255)) >> 16);
-      rt[2] = rt1[2] + ((temp_fac * rt1[2] * (rt2[2] - 255)) >> 16);
-      rt[3] = rt1[3] + ((temp_fac * rt1[3] * (rt2[3] - 255)) >> 16);
-
-      rt1 += 4;
-      rt2 += 4;
-      rt += 4;
+  const int64_t pixels_num = int64_t(x) * y;
+  int64_t i = 0;
+
+#if BLI_HAVE_SSE2
+  if (temp_fac >= 0 && temp_fac <= 256) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i fac16 = _mm_set1_epi16(short(temp_fac));
+    const __m128i max16 = _mm_set1_epi16(255);
+    /* The term is negative, and shifting it rounds towards negative infinity. So subtract
+     * `ceil(temp_fac * a * (255 - b) / 65536)` computed from the high and low product halves. */
+    auto mul_term = [&](const __m128i col1, const __m128i col2) {
+      const __m128i fac1 = _mm_mullo_epi16(col1, fac16);
+      const __m128i inv2 = _mm_sub_epi16(max16, col2);
+      const __m128i prod_hi = _mm_mulhi_epu16(fac1, inv2);
+      const __m128i prod_lo_zero = _mm_cmpeq_epi16(_mm_mullo_epi16(fac1, inv2), zero);
+      const __m128i round_up = _mm_andnot_si128(prod_lo_zero, _mm_set1_epi16(1));
+      return _mm_sub_epi16(col1, _mm_add_epi16(prod_hi, round_up));
+    };
+    for (; i + 4 <= pixels_num; i += 4) {
+      const __m128i col1 = load_4_pixels(rt1);
+      const __m128i col2 = load_4_pixels(rt2);
+      const __m128i lo = mul_term(_mm_unpacklo_epi8(col1, zero), _mm_unpacklo_epi8(col2, zero));
+      const __m128i hi = mul_term(_mm_unpackhi_epi8(col1, zero), _mm_unpackhi_epi8(col2, zero));
+      store_4_pixels(rt, _mm_packus_epi16(lo, hi));
+
+      rt1 += 16;
+      rt2 += 16;
+      rt += 16;
     }
   }
+#endif
+
+  for (; i < pixels_num; i++) {
+    rt[0] = rt1[0] + ((temp_fac * rt1[0] * (rt2[0] - 255)) >> 16);
+    rt[1] = rt1[1] + ((temp_fac * rt1[1] * (rt2[1] - 255)) >> 16);
+    rt[2] = rt1[2] + ((temp_fac * rt1[2] * (rt2[2] - 255)) >> 16);
+    rt[3] = rt1[3] + ((temp_fac * rt1[3] * (rt2[3] - 255)) >> 16);
+
+    rt1 += 4;
+    rt2 += 4;
+    rt += 4;
+  }
 }
 
 static void do_mul_effect_float(float fac, int x, int y, float *rect1, float *rect2, float *out)
@@ -819,17 +1031,24 @@ static void do_mul_effect_float(float fac, int x, int y, float *rect1, float *re
   /* Formula:
    * `fac * (a * b) + (1 - fac) * a => fac * a * (b - 1) + a`. */
 
-  for (int i = 0; i < y; i++) {
-    for (int j = 0; j < x; j++) {
-      rt[0] = rt1[0] + fac * rt1[0] * (rt2[0] - 1.0f);
-      rt[1] = rt1[1] + fac * rt1[1] * (rt2[1] - 1.0f);
-      rt[2] = rt1[2] + fac * rt1[2] * (rt2[2] - 1.0f);
-      rt[3] = rt1[3] + fac * rt1[3] * (rt2[3] - 1.0f);
+  const int64_t pixels_num = int64_t(x) * y;
+  for (int64_t i = 0; i < pixels_num; i++) {
+#if BLI_HAVE_SSE2
+    const __m128 col1 = _mm_loadu_ps(rt1);
+    const __m128 col2 = _mm_loadu_ps(rt2);
+    const __m128 term = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(fac), col1),
+                                   _mm_sub_ps(col2, _mm_set1_ps(1.0f)));
+    _mm_storeu_ps(rt, _mm_add_ps(col1, term));
+#else
+    rt[0] = rt1[0] + fac * rt1[0] * (rt2[0] - 1.0f);
+    rt[1] = rt1[1] + fac * rt1[1] * (rt2[1] - 1.0f);
+    rt[2] = rt1[2] + fac * rt1[2] * (rt2[2] - 1.0f);
+    rt[3] = rt1[3] + fac * rt1[3] * (rt2[3] - 1.0f);
+#endif
 
-      rt1 += 4;
-      rt2 += 4;
-      rt += 4;
-    }
+    rt1 += 4;
+    rt2 += 4;
+    rt += 4;
   }
 }
 
@@ -866,6 +1085,12 @@ static void do_mul_effect(const SeqRenderData *context,
 
 /* -------------------------------------------------------------------- */
 /** \name Blend Mode Effect
+ *
+ * Screen, overlay, darken, lighten, the burn, dodge and light modes, difference, exclusion and
+ * the hue, saturation, value and color modes are intentionally left scalar. They call the
+ * per-pixel functions of `BLI_math_color_blend.h`, which branch per channel and are shared with
+ * painting and the compositor. A SIMD copy of each of them would have to match those functions
+ * exactly, and they are much less commonly used than the strip effects above.
  * \{ */
 
 /* blend_function has to be: void (T* dst, const T *src1, const T *src2) */
@@ -3046,6 +3271,9 @@ static void draw_text_outline(const SeqRenderData *context,
   BLF_buffer(font, nullptr, out->byte_buffer.data, size.x, size.y, display);
 }
 
+/* BLF is not thread-safe, and prefetch workers can render text strips at the same time. */
+static ThreadMutex text_effect_mutex = BLI_MUTEX_INITIALIZER;
+
 static ImBuf *do_text_effect(const SeqRenderData *context,
                              Sequence *seq,
                              float /*timeline_frame*/,
@@ -3064,6 +3292,8 @@ static ImBuf *do_text_effect(const SeqRenderData *context,
   int y_ofs, x, y;
   double proxy_size_comp;
 
+  BLI_mutex_lock(&text_effect_mutex);
+
   if (data->text_blf_id == SEQ_FONT_NOT_LOADED) {
     data->text_blf_id = -1;
 
@@ -3162,6 +3392,8 @@ static ImBuf *do_text_effect(const SeqRenderData *context,
 
   BLF_disable(font, font_flags);
 
+  BLI_mutex_unlock(&text_effect_mutex);
+
   return out;
 }
 
@@ -0,0 +1,410 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include <cfloat>
+#include <cstring>
+#include <functional>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_math_base.h"
+#include "BLI_math_color.h"
+#include "BLI_math_vector.h"
+#include "BLI_math_vector_types.hh"
+#include "BLI_rand.hh"
+
+#include "DNA_sequence_types.h"
+
+#include "IMB_imbuf.hh"
+#include "IMB_imbuf_types.hh"
+
+#include "SEQ_effects.hh"
+#include "SEQ_modifier.hh"
+#include "SEQ_render.hh"
+
+/* Compare sequencer blend effects and the color balance modifier with straightforward scalar
+ * implementations, which they used before they were optimized. Results of byte images must match
+ * exactly. */
+
+namespace blender::seq::tests {
+
+/* Width is not a multiple of the SIMD width, so that the remaining pixels of every line are
+ * processed by the scalar code. */
+static constexpr int IMAGE_WIDTH = 67;
+static constexpr int IMAGE_HEIGHT = 13;
+static constexpr int64_t PIXELS_NUM = int64_t(IMAGE_WIDTH) * IMAGE_HEIGHT;
+
+using ReferenceByteFn = std::function<void(float fac, const uchar *, const uchar *, uchar *)>;
+using ReferenceFloatFn = std::function<void(float fac, const float *, const float *, float *)>;
+
+static ImBuf *create_random_image(const bool is_float, const uint32_t seed)
+{
+  ImBuf *ibuf = IMB_allocImBuf(IMAGE_WIDTH, IMAGE_HEIGHT, 32, is_float ? IB_rectfloat : IB_rect);
+  RandomNumberGenerator rng(seed);
+  for (int64_t i = 0; i < PIXELS_NUM * 4; i += 4) {
+    if (is_float) {
+      /* Premultiplied color. */
+      float *col = ibuf->float_buffer.data + i;
+      col[3] = rng.get_float();
+      col[0] = rng.get_float() * col[3];
+      col[1] = rng.get_float() * col[3];
+      col[2] = rng.get_float() * col[3];
+    }
+    else {
+      for (int c = 0; c < 4; c++) {
+        ibuf->byte_buffer.data[i + c] = uchar(rng.get_uint32() & 0xFF);
+      }
+    }
+  }
+  /* Fully transparent and opaque pixels take separate paths in the alpha over and under
+   * effects. */
+  for (int64_t i = 0; i < PIXELS_NUM; i += 5) {
+    if (is_float) {
+      float *col = ibuf->float_buffer.data + i * 4;
+      if ((i / 5) % 2) {
+        col[3] = 1.0f;
+      }
+      else {
+        zero_v4(col);
+      }
+    }
+    else {
+      ibuf->byte_buffer.data[i * 4 + 3] = ((i / 5) % 2) ? 255 : 0;
+    }
+  }
+  return ibuf;
+}
+
+static void test_effect(const int effect_type,
+                        const bool is_float,
+                        const ReferenceByteFn &reference_byte,
+                        const ReferenceFloatFn &reference_float)
+{
+  Sequence seq = {};
+  seq.type = effect_type;
+  SeqEffectHandle sh = SEQ_effect_handle_get(&seq);
+
+  SeqRenderData context = {};
+  context.rectx = IMAGE_WIDTH;
+  context.recty = IMAGE_HEIGHT;
+
+  ImBuf *ibuf1 = create_random_image(is_float, 1);
+  ImBuf *ibuf2 = create_random_image(is_float, 2);
+  ImBuf *out = IMB_allocImBuf(IMAGE_WIDTH, IMAGE_HEIGHT, 32, is_float ? IB_rectfloat : IB_rect);
+  ImBuf *out_reference = IMB_allocImBuf(
+      IMAGE_WIDTH, IMAGE_HEIGHT, 32, is_float ? IB_rectfloat : IB_rect);
+
+  for (const float fac : {0.0f, 0.3f, 0.7f, 1.0f}) {
+    sh.execute_slice(&context, &seq, 0.0f, fac, ibuf1, ibuf2, nullptr, 0, IMAGE_HEIGHT, out);
+    if (is_float) {
+      reference_float(fac,
+                      ibuf1->float_buffer.data,
+                      ibuf2->float_buffer.data,
+                      out_reference->float_buffer.data);
+      for (int64_t i = 0; i < PIXELS_NUM * 4; i++) {
+        ASSERT_NEAR(out->float_buffer.data[i], out_reference->float_buffer.data[i], 1e-5f)
+            << "fac " << fac << ", value " << i;
+      }
+    }
+    else {
+      reference_byte(fac,
+                     ibuf1->byte_buffer.data,
+                     ibuf2->byte_buffer.data,
+                     out_reference->byte_buffer.data);
+      for (int64_t i = 0; i < PIXELS_NUM * 4; i++) {
+        ASSERT_EQ(out->byte_buffer.data[i], out_reference->byte_buffer.data[i])
+            << "fac " << fac << ", value " << i;
+      }
+    }
+  }
+
+  IMB_freeImBuf(ibuf1);
+  IMB_freeImBuf(ibuf2);
+  IMB_freeImBuf(out);
+  IMB_freeImBuf(out_reference);
+}
+
+static void cross_byte_reference(float fac, const uchar *rt1, const uchar *rt2, uchar *rt)
+{
+  const int temp_fac = int(256.0f * fac);
+  const int temp_mfac = 256 - temp_fac;
+  for (int64_t i = 0; i < PIXELS_NUM * 4; i++) {
+    rt[i] = (temp_mfac * rt1[i] + temp_fac * rt2[i]) >> 8;
+  }
+}
+
+static void cross_float_reference(float fac, const float *rt1, const float *rt2, float *rt)
+{
+  const float mfac = 1.0f - fac;
+  for (int64_t i = 0; i < PIXELS_NUM * 4; i++) {
+    rt[i] = mfac * rt1[i] + fac * rt2[i];
+  }
+}
+
+static void add_byte_reference(float fac, const uchar *cp1, const uchar *cp2, uchar *rt)
+{
+  const int temp_fac = int(256.0f * fac);
+  for (int64_t i = 0; i < PIXELS_NUM * 4; i += 4) {
+    const int temp_fac2 = temp_fac * int(cp2[i + 3]);
+    for (int c = 0; c < 3; c++) {
+      rt[i + c] = min_ii(cp1[i + c] + ((temp_fac2 * cp2[i + c]) >> 16), 255);
+    }
+    rt[i + 3] = cp1[i + 3];
+  }
+}
+
+static void add_float_reference(float fac, const float *rt1, const float *rt2, float *rt)
+{
+  for (int64_t i = 0; i < PIXELS_NUM * 4; i += 4) {
+    const float temp_fac = (1.0f - (rt1[i + 3] * (1.0f - fac))) * rt2[i + 3];
+    for (int c = 0; c < 3; c++) {
+      rt[i + c] = rt1[i + c] + temp_fac * rt2[i + c];
+    }
+    rt[i + 3] = rt1[i + 3];
+  }
+}
+
+static void sub_byte_reference(float fac, const uchar *cp1, const uchar *cp2, uchar *rt)
+{
+  const int temp_fac = int(256.0f * fac);
+  for (int64_t i = 0; i < PIXELS_NUM * 4; i += 4) {
+    const int temp_fac2 = temp_fac * int(cp2[i + 3]);
+    for (int c = 0; c < 3; c++) {
+      rt[i + c] = max_ii(cp1[i + c] - ((temp_fac2 * cp2[i + c]) >> 16), 0);
+    }
+    rt[i + 3] = cp1[i + 3];
+  }
+}
+
+static void sub_float_reference(float fac, const float *rt1, const float *rt2, float *rt)
+{
+  const float mfac = 1.0f - fac;
+  for (int64_t i = 0; i < PIXELS_NUM * 4; i += 4) {
+    const float temp_fac = (1.0f - (rt1[i + 3] * mfac)) * rt2[i + 3];
+    for (int c = 0; c < 3; c++) {
+      rt[i + c] = max_ff(rt1[i + c] - temp_fac * rt2[i + c], 0.0f);
+    }
+    rt[i + 3] = rt1[i + 3];
+  }
+}
+
+static void mul_byte_reference(float fac, const uchar *rt1, const uchar *rt2, uchar *rt)
+{
+  const int temp_fac = int(256.0f * fac);
+  for (int64_t i = 0; i < PIXELS_NUM * 4; i++) {
+    rt[i] = rt1[i] + ((temp_fac * rt1[i] * (rt2[i] - 255)) >> 16);
+  }
+}
+
+static void mul_float_reference(float fac, const float *rt1, const float *rt2, float *rt)
+{
+  for (int64_t i = 0; i < PIXELS_NUM * 4; i++) {
+    rt[i] = rt1[i] + fac * rt1[i] * (rt2[i] - 1.0f);
+  }
+}
+
+static float4 load_premul_reference(const uchar *ptr)
+{
+  float4 res;
+  straight_uchar_to_premul_float(res, ptr);
+  return res;
+}
+
+static float4 load_premul_reference(const float *ptr)
+{
+  return float4(ptr);
+}
+
+static void store_premul_reference(const float4 &col, uchar *dst)
+{
+  premul_float_to_straight_uchar(dst, col);
+}
+
+static void store_premul_reference(const float4 &col, float *dst)
+{
+  copy_v4_v4(dst, col);
+}
+
+static bool is_opaque_reference(const uchar alpha)
+{
+  return alpha == 255;
+}
+
+static bool is_opaque_reference(const float alpha)
+{
+  return alpha >= 1.0f;
+}
+
+template<typename T>
+static void gammacross_reference(float fac, const T *src1, const T *src2, T *dst)
+{
+  const float mfac = 1.0f - fac;
+  for (int64_t i = 0; i < PIXELS_NUM * 4; i += 4) {
+    const float4 col1 = load_premul_reference(src1 + i);
+    const float4 col2 = load_premul_reference(src2 + i);
+    float4 col;
+    for (int c = 0; c < 4; c++) {
+      const float mix = mfac * sqrtf_signed(col1[c]) + fac * sqrtf_signed(col2[c]);
+      col[c] = (mix < 0.0f) ? -(mix * mix) : mix * mix;
+    }
+    store_premul_reference(col, dst + i);
+  }
+}
+
+template<typename T>
+static void alphaover_reference(float fac, const T *src1, const T *src2, T *dst)
+{
+  for (int64_t i = 0; i < PIXELS_NUM * 4; i += 4) {
+    if (src1[i + 3] <= 0) {
+      memcpy(dst + i, src2 + i, sizeof(T) * 4);
+    }
+    else {
+      const float4 col1 = load_premul_reference(src1 + i);
+      const float4 col2 = load_premul_reference(src2 + i);
+      const float mfac = 1.0f - fac * col1.w;
+      store_premul_reference(fac * col1 + mfac * col2, dst + i);
+    }
+  }
+}
+
+template<typename T>
+static void alphaunder_reference(float fac, const T *src1, const T *src2, T *dst)
+{
+  for (int64_t i = 0; i < PIXELS_NUM * 4; i += 4) {
+    if (is_opaque_reference(src2[i + 3])) {
+      memcpy(dst + i, src2 + i, sizeof(T) * 4);
+    }
+    else {
+      const float4 col1 = load_premul_reference(src1 + i);
+      const float4 col2 = load_premul_reference(src2 + i);
+      const float mfac = fac * (1.0f - col2.w);
+      store_premul_reference(mfac * col1 + col2, dst + i);
+    }
+  }
+}
+
+TEST(seq_effects, cross)
+{
+  test_effect(SEQ_TYPE_CROSS, false, cross_byte_reference, nullptr);
+  test_effect(SEQ_TYPE_CROSS, true, nullptr, cross_float_reference);
+}
+
+TEST(seq_effects, gamma_cross)
+{
+  test_effect(SEQ_TYPE_GAMCROSS, false, gammacross_reference<uchar>, nullptr);
+  test_effect(SEQ_TYPE_GAMCROSS, true, nullptr, gammacross_reference<float>);
+}
+
+TEST(seq_effects, add)
+{
+  test_effect(SEQ_TYPE_ADD, false, add_byte_reference, nullptr);
+  test_effect(SEQ_TYPE_ADD, true, nullptr, add_float_reference);
+}
+
+TEST(seq_effects, subtract)
+{
+  test_effect(SEQ_TYPE_SUB, false, sub_byte_reference, nullptr);
+  test_effect(SEQ_TYPE_SUB, true, nullptr, sub_float_reference);
+}
+
+TEST(seq_effects, multiply)
+{
+  test_effect(SEQ_TYPE_MUL, false, mul_byte_reference, nullptr);
+  test_effect(SEQ_TYPE_MUL, true, nullptr, mul_float_reference);
+}
+
+TEST(seq_effects, alpha_over)
+{
+  test_effect(SEQ_TYPE_ALPHAOVER, false, alphaover_reference<uchar>, nullptr);
+  test_effect(SEQ_TYPE_ALPHAOVER, true, nullptr, alphaover_reference<float>);
+}
+
+TEST(seq_effects, alpha_under)
+{
+  test_effect(SEQ_TYPE_ALPHAUNDER, false, alphaunder_reference<uchar>, nullptr);
+  test_effect(SEQ_TYPE_ALPHAUNDER, true, nullptr, alphaunder_reference<float>);
+}
+
+/* Color balance of a byte image without mask, as done for every pixel before opaque pixels were
+ * looked up from a table. Parameters are converted like #calc_cb does without inverse flags. */
+static void color_balance_byte_reference(const StripColorBalance &cb,
+                                         const float mul,
+                                         const uchar *src,
+                                         uchar *dst)
+{
+  for (int64_t i = 0; i < PIXELS_NUM * 4; i += 4) {
+    float p[4];
+    straight_uchar_to_premul_float(p, src + i);
+    for (int c = 0; c < 3; c++) {
+      float x;
+      if (cb.method == SEQ_COLOR_BALANCE_METHOD_LIFTGAMMAGAIN) {
+        x = (((p[c] - 1.0f) * (2.0f - cb.lift[c])) + 1.0f) * cb.gain[c];
+        x = powf(max_ff(x, 0.0f), 1.0f / cb.gamma[c]) * mul;
+      }
+      else {
+        x = p[c] * cb.slope[c] + (cb.offset[c] - 1.0f);
+        x = powf(max_ff(x, 0.0f) / 1.0f, 1.0f / cb.power[c]) * 1.0f;
+        x *= mul;
+      }
+      p[c] = clamp_f(x, FLT_MIN, FLT_MAX);
+    }
+    premul_float_to_straight_uchar(dst + i, p);
+  }
+}
+
+static void test_color_balance(const int method)
+{
+  Sequence seq = {};
+  ColorBalanceModifierData *cbmd = reinterpret_cast<ColorBalanceModifierData *>(
+      SEQ_modifier_new(&seq, nullptr, seqModifierType_ColorBalance));
+  StripColorBalance &cb = cbmd->color_balance;
+  cb.method = method;
+  copy_v3_fl3(cb.lift, 1.1f, 0.9f, 1.0f);
+  copy_v3_fl3(cb.gamma, 0.8f, 1.0f, 1.3f);
+  copy_v3_fl3(cb.gain, 1.2f, 0.7f, 1.0f);
+  copy_v3_fl3(cb.slope, 1.2f, 0.9f, 1.0f);
+  copy_v3_fl3(cb.offset, 1.05f, 0.95f, 1.0f);
+  copy_v3_fl3(cb.power, 0.9f, 1.1f, 1.0f);
+  cbmd->color_multiply = 1.1f;
+
+  SeqRenderData context = {};
+  context.rectx = IMAGE_WIDTH;
+  context.recty = IMAGE_HEIGHT;
+
+  /* Make half of the pixels opaque, so both the lookup table and the per-pixel path are used. */
+  ImBuf *ibuf = create_random_image(false, 1);
+  for (int64_t i = 0; i < PIXELS_NUM; i += 2) {
+    ibuf->byte_buffer.data[i * 4 + 3] = 255;
+  }
+
+  ImBuf *out = SEQ_modifier_apply_stack(&context, &seq, ibuf, 0);
+  ImBuf *out_reference = IMB_allocImBuf(IMAGE_WIDTH, IMAGE_HEIGHT, 32, IB_rect);
+  color_balance_byte_reference(
+      cb, cbmd->color_multiply, ibuf->byte_buffer.data, out_reference->byte_buffer.data);
+
+  ASSERT_NE(out, ibuf);
+  ASSERT_NE(out->byte_buffer.data, nullptr);
+  for (int64_t i = 0; i < PIXELS_NUM * 4; i++) {
+    ASSERT_EQ(out->byte_buffer.data[i], out_reference->byte_buffer.data[i]) << "value " << i;
+  }
+
+  SEQ_modifier_clear(&seq);
+  IMB_freeImBuf(ibuf);
+  IMB_freeImBuf(out);
+  IMB_freeImBuf(out_reference);
+}
+
+TEST(seq_effects, color_balance_lift_gamma_gain)
+{
+  test_color_balance(SEQ_COLOR_BALANCE_METHOD_LIFTGAMMAGAIN);
+}
+
+TEST(seq_effects, color_balance_slope_offset_power)
+{
+  test_color_balance(SEQ_COLOR_BALANCE_METHOD_SLOPEOFFSETPOWER);
+}
+
+}  // namespace blender::seq::tests
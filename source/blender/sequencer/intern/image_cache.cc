@@ -21,8 +21,10 @@
 
 #include "BLI_fileops_types.h"
 #include "BLI_ghash.h"
+#include "BLI_math_base.h"
 #include "BLI_mempool.h"
 #include "BLI_threads.h"
+#include "BLI_time.h"
 
 #include "BKE_main.hh"
 
@@ -59,6 +61,13 @@
  * entries one by one in reverse order to their creation.
  *
  * User can exclude caching of some images. Such entries will have is_temp_cache set.
+ *
+ * Recycling: Frames are chosen for removal using GreedyDual-Size policy. Each frame has priority
+ * `H = L + cost / size`, where cost is time it took to render images of the frame and size is
+ * memory used by these images. `L` is cache inflation value, which is raised to the priority of
+ * each removed frame, so frames that were not used for a long time are eventually removed, even
+ * if they were expensive to render. Frame with lowest priority is removed first, so cheap frames
+ * which use a lot of memory are removed before expensive composited frames.
  */
 
 #define THUMB_CACHE_LIMIT 5000
@@ -72,11 +81,16 @@ struct SeqCache {
   SeqCacheKey *last_key;
   SeqDiskCache *disk_cache;
   int thumbnail_count;
+  /** GreedyDual-Size inflation value, priority of last removed frame. */
+  double inflation;
+  SeqCacheStatistics stats;
 };
 
 struct SeqCacheItem {
   SeqCache *cache_owner;
   ImBuf *ibuf;
+  /** Cache inflation value at the time when item was stored or last used. */
+  double inflation;
 };
 
 static ThreadMutex cache_create_lock = BLI_MUTEX_INITIALIZER;
@@ -178,9 +192,18 @@ static size_t seq_cache_get_mem_total()
   return size_t(U.memcachelimit) * 1024 * 1024;
 }
 
+static float seq_cache_render_cost(const Scene *scene, const double render_start)
+{
+  const double frame_duration = double(scene->r.frs_sec_base) / double(scene->r.frs_sec);
+  return float((BLI_time_now_seconds() - render_start) / frame_duration);
+}
+
 static void seq_cache_keyfree(void *val)
 {
   SeqCacheKey *key = static_cast<SeqCacheKey *>(val);
+  if (key->type != SEQ_CACHE_STORE_THUMBNAIL) {
+    key->cache_owner->stats.stored_bytes -= key->size;
+  }
   BLI_mempool_free(key->cache_owner->keys_pool, key);
 }
 
@@ -218,6 +241,13 @@ static void seq_cache_put_ex(Scene *scene, SeqCacheKey *key, ImBuf *ibuf)
   item = static_cast<SeqCacheItem *>(BLI_mempool_alloc(cache->items_pool));
   item->cache_owner = cache;
   item->ibuf = ibuf;
+  item->inflation = cache->inflation;
+
+  key->size = IMB_get_size_in_memory(ibuf);
+  /* Thumbnails are managed separately, they don't compete for memory with rendered images. */
+  if (key->type != SEQ_CACHE_STORE_THUMBNAIL) {
+    cache->stats.stored_bytes += key->size;
+  }
 
   const int stored_types_flag = get_stored_types_flag(scene, key);
 
@@ -257,6 +287,7 @@ static ImBuf *seq_cache_get_ex(SeqCache *cache, SeqCacheKey *key)
 
   if (item && item->ibuf) {
     IMB_refImBuf(item->ibuf);
+    item->inflation = cache->inflation;
 
     return item->ibuf;
   }
@@ -276,69 +307,6 @@ static void seq_cache_key_unlink(SeqCacheKey *key)
   }
 }
 
-/* Choose a key out of 2 candidates(leftmost and rightmost items)
- * to recycle based on currently used strategy */
-static SeqCacheKey *seq_cache_choose_key(Scene *scene, SeqCacheKey *lkey, SeqCacheKey *rkey)
-{
-  SeqCacheKey *finalkey = nullptr;
-
-  /* Ideally, cache would not need to check the state of prefetching task
-   * that is tricky to do however, because prefetch would need to know,
-   * if a key, that is about to be created would be removed by itself.
-   *
-   * This can happen because only FINAL_OUT item insertion will trigger recycling
-   * but that is also the point, where prefetch can be suspended.
-   *
-   * We could use temp cache as a shield and later make it a non-temporary entry,
-   * but it is not worth of increasing system complexity.
-   */
-  if (scene->ed->cache_flag & SEQ_CACHE_PREFETCH_ENABLE && seq_prefetch_job_is_running(scene)) {
-    int pfjob_start, pfjob_end;
-    seq_prefetch_get_time_range(scene, &pfjob_start, &pfjob_end);
-
-    if (lkey) {
-      if (lkey->timeline_frame < pfjob_start || lkey->timeline_frame > pfjob_end) {
-        return lkey;
-      }
-    }
-
-    if (rkey) {
-      if (rkey->timeline_frame < pfjob_start || rkey->timeline_frame > pfjob_end) {
-        return rkey;
-      }
-    }
-
-    return nullptr;
-  }
-
-  if (rkey && lkey) {
-    if (lkey->timeline_frame > rkey->timeline_frame) {
-      SeqCacheKey *swapkey = lkey;
-      lkey = rkey;
-      rkey = swapkey;
-    }
-
-    int l_diff = scene->r.cfra - lkey->timeline_frame;
-    int r_diff = rkey->timeline_frame - scene->r.cfra;
-
-    if (l_diff > r_diff) {
-      finalkey = lkey;
-    }
-    else {
-      finalkey = rkey;
-    }
-  }
-  else {
-    if (lkey) {
-      finalkey = lkey;
-    }
-    else {
-      finalkey = rkey;
-    }
-  }
-  return finalkey;
-}
-
 static void seq_cache_recycle_linked(Scene *scene, SeqCacheKey *base)
 {
   SeqCache *cache = seq_cache_get_from_scene(scene);
@@ -386,22 +354,80 @@ static void seq_cache_recycle_linked(Scene *scene, SeqCacheKey *base)
   }
 }
 
+/**
+ * GreedyDual-Size priority of frame linked to `base` key. Images of a frame are removed together
+ * by #seq_cache_recycle_linked, so they are treated as single item: cost of the frame is the
+ * highest cost of its images (cost of final image includes rendering of its inputs) and size is
+ * the sum of their sizes. The chain is walked in both directions, same as when it is removed.
+ */
+static double seq_cache_linked_priority(SeqCache *cache, SeqCacheKey *base)
+{
+  double inflation = 0.0;
+  float cost = 0.0f;
+  size_t size = 0;
+
+  auto add_key = [&](const SeqCacheKey *key) {
+    SeqCacheItem *item = static_cast<SeqCacheItem *>(BLI_ghash_lookup(cache->hash, key));
+    if (item == nullptr) {
+      return false; /* Key has already been removed from cache. */
+    }
+
+    inflation = max_dd(inflation, item->inflation);
+    cost = max_ff(cost, key->cost);
+    size += key->size;
+    return true;
+  };
+
+  for (SeqCacheKey *key = base; key != nullptr; key = key->link_prev) {
+    if (!add_key(key)) {
+      break;
+    }
+    if (key->link_prev != nullptr && key->link_prev->link_next != key) {
+      break; /* Key doesn't belong to this chain anymore. */
+    }
+  }
+
+  for (SeqCacheKey *key = base; key->link_next != nullptr; key = key->link_next) {
+    if (key->link_next->link_prev != key) {
+      break; /* Key doesn't belong to this chain anymore. */
+    }
+    if (!add_key(key->link_next)) {
+      break;
+    }
+  }
+
+  return inflation + double(cost) * 1024.0 * 1024.0 / double(max_zz(size, 1));
+}
+
 static SeqCacheKey *seq_cache_get_item_for_removal(Scene *scene)
 {
   SeqCache *cache = seq_cache_get_from_scene(scene);
   SeqCacheKey *finalkey = nullptr;
-  /* Leftmost key. */
-  SeqCacheKey *lkey = nullptr;
-  /* Rightmost key. */
-  SeqCacheKey *rkey = nullptr;
-  SeqCacheKey *key = nullptr;
+  double final_priority = 0.0;
+  float final_distance = 0.0f;
+
+  /* Ideally, cache would not need to check the state of prefetching task
+   * that is tricky to do however, because prefetch would need to know,
+   * if a key, that is about to be created would be removed by itself.
+   *
+   * This can happen because only FINAL_OUT item insertion will trigger recycling
+   * but that is also the point, where prefetch can be suspended.
+   *
+   * We could use temp cache as a shield and later make it a non-temporary entry,
+   * but it is not worth of increasing system complexity.
+   */
+  const bool use_prefetch_range = (scene->ed->cache_flag & SEQ_CACHE_PREFETCH_ENABLE) &&
+                                  seq_prefetch_job_is_running(scene);
+  int pfjob_start = 0, pfjob_end = 0;
+  if (use_prefetch_range) {
+    seq_prefetch_get_time_range(scene, &pfjob_start, &pfjob_end);
+  }
 
   GHashIterator gh_iter;
   BLI_ghashIterator_init(&gh_iter, cache->hash);
-  int total_count = 0;
 
   while (!BLI_ghashIterator_done(&gh_iter)) {
-    key = static_cast<SeqCacheKey *>(BLI_ghashIterator_getKey(&gh_iter));
+    SeqCacheKey *key = static_cast<SeqCacheKey *>(BLI_ghashIterator_getKey(&gh_iter));
     SeqCacheItem *item = static_cast<SeqCacheItem *>(BLI_ghashIterator_getValue(&gh_iter));
     BLI_ghashIterator_step(&gh_iter);
     BLI_assert(key->cache_owner == cache);
@@ -411,35 +437,37 @@ static SeqCacheKey *seq_cache_get_item_for_removal(Scene *scene)
       seq_cache_recycle_linked(scene, key);
       /* Can not continue iterating after linked remove. */
       BLI_ghashIterator_init(&gh_iter, cache->hash);
+      finalkey = nullptr;
       continue;
     }
 
+    /* Only chain-base keys are scored, so every frame is considered once. */
     if (key->is_temp_cache || key->link_next != nullptr) {
       continue;
     }
 
-    total_count++;
-
-    if (lkey) {
-      if (key->timeline_frame < lkey->timeline_frame) {
-        lkey = key;
-      }
-    }
-    else {
-      lkey = key;
-    }
-    if (rkey) {
-      if (key->timeline_frame > rkey->timeline_frame) {
-        rkey = key;
-      }
+    if (use_prefetch_range && key->timeline_frame >= pfjob_start &&
+        key->timeline_frame <= pfjob_end)
+    {
+      continue;
     }
-    else {
-      rkey = key;
+
+    const double priority = seq_cache_linked_priority(cache, key);
+    /* With equal priority, prefer removing frames further away from current frame. */
+    const float distance = fabsf(key->timeline_frame - scene->r.cfra);
+
+    if (finalkey == nullptr || priority < final_priority ||
+        (priority == final_priority && distance > final_distance))
+    {
+      finalkey = key;
+      final_priority = priority;
+      final_distance = distance;
     }
   }
-  (void)total_count; /* Quiet set-but-unused warning (may be removed). */
 
-  finalkey = seq_cache_choose_key(scene, lkey, rkey);
+  if (finalkey) {
+    cache->inflation = max_dd(cache->inflation, final_priority);
+  }
 
   return finalkey;
 }
@@ -457,7 +485,10 @@ bool seq_cache_recycle_item(Scene *scene)
     SeqCacheKey *finalkey = seq_cache_get_item_for_removal(scene);
 
     if (finalkey) {
+      const size_t stored_bytes = cache->stats.stored_bytes;
       seq_cache_recycle_linked(scene, finalkey);
+      cache->stats.evictions++;
+      cache->stats.evicted_bytes += stored_bytes - cache->stats.stored_bytes;
     }
     else {
       seq_cache_unlock(scene);
@@ -513,6 +544,18 @@ static void seq_cache_create(Main *bmain, Scene *scene)
   BLI_mutex_unlock(&cache_create_lock);
 }
 
+/* Checked under the cache lock, because prefetch workers can use the cache at the same time. */
+static SeqDiskCache *seq_cache_disk_cache_ensure(Main *bmain, Scene *scene)
+{
+  seq_cache_lock(scene);
+  SeqCache *cache = seq_cache_get_from_scene(scene);
+  if (cache->disk_cache == nullptr) {
+    cache->disk_cache = seq_disk_cache_create(bmain, scene);
+  }
+  seq_cache_unlock(scene);
+  return cache->disk_cache;
+}
+
 static void seq_cache_populate_key(SeqCacheKey *key,
                                    const SeqRenderData *context,
                                    Sequence *seq,
@@ -530,6 +573,8 @@ static void seq_cache_populate_key(SeqCacheKey *key,
   key->link_next = nullptr;
   key->is_temp_cache = true;
   key->task_id = context->task_id;
+  key->cost = 0.0f;
+  key->size = 0;
 }
 
 static SeqCacheKey *seq_cache_allocate_key(SeqCache *cache,
@@ -733,9 +778,12 @@ void seq_cache_thumbnail_cleanup(Scene *scene, rctf *view_area_safe)
   cache->last_key = nullptr;
 }
 
-ImBuf *seq_cache_get(const SeqRenderData *context, Sequence *seq, float timeline_frame, int type)
+static ImBuf *seq_cache_lookup(const SeqRenderData *context,
+                               Sequence *seq,
+                               float timeline_frame,
+                               int type,
+                               const bool update_statistics)
 {
-
   if (context->skip_cache || context->is_proxy_render || !seq) {
     return nullptr;
   }
@@ -766,6 +814,12 @@ ImBuf *seq_cache_get(const SeqRenderData *context, Sequence *seq, float timeline
     seq_cache_populate_key(&key, context, seq, timeline_frame, type);
     ibuf = seq_cache_get_ex(cache, &key);
   }
+
+  /* Thumbnails are managed separately, they don't compete for memory with rendered images. */
+  const bool count_lookup = update_statistics && type != SEQ_CACHE_STORE_THUMBNAIL;
+  if (ibuf && count_lookup) {
+    cache->stats.hits++;
+  }
   seq_cache_unlock(scene);
 
   if (ibuf) {
@@ -774,28 +828,48 @@ ImBuf *seq_cache_get(const SeqRenderData *context, Sequence *seq, float timeline
 
   /* Try disk cache: */
   if (seq_disk_cache_is_enabled(context->bmain)) {
-    if (cache->disk_cache == nullptr) {
-      cache->disk_cache = seq_disk_cache_create(context->bmain, context->scene);
+    SeqDiskCache *disk_cache = seq_cache_disk_cache_ensure(context->bmain, scene);
+
+    const double render_start = BLI_time_now_seconds();
+    ibuf = seq_disk_cache_read_file(disk_cache, &key);
+
+    if (ibuf != nullptr) {
+      /* Store read image in RAM. Only recycle item for final type. */
+      if (key.type != SEQ_CACHE_STORE_FINAL_OUT || seq_cache_recycle_item(scene)) {
+        seq_cache_lock(scene);
+        SeqCacheKey *new_key = seq_cache_allocate_key(cache, context, seq, timeline_frame, type);
+        new_key->cost = seq_cache_render_cost(scene, render_start);
+        seq_cache_put_ex(scene, new_key, ibuf);
+        seq_cache_unlock(scene);
+      }
     }
+  }
 
-    ibuf = seq_disk_cache_read_file(cache->disk_cache, &key);
-
-    if (ibuf == nullptr) {
-      return nullptr;
+  if (count_lookup) {
+    seq_cache_lock(scene);
+    if (ibuf) {
+      cache->stats.hits++;
     }
-
-    /* Store read image in RAM. Only recycle item for final type. */
-    if (key.type != SEQ_CACHE_STORE_FINAL_OUT || seq_cache_recycle_item(scene)) {
-      SeqCacheKey *new_key = seq_cache_allocate_key(cache, context, seq, timeline_frame, type);
-      seq_cache_put_ex(scene, new_key, ibuf);
+    else {
+      cache->stats.misses++;
     }
+    seq_cache_unlock(scene);
   }
 
   return ibuf;
 }
 
-bool seq_cache_put_if_possible(
-    const SeqRenderData *context, Sequence *seq, float timeline_frame, int type, ImBuf *ibuf)
+ImBuf *seq_cache_get(const SeqRenderData *context, Sequence *seq, float timeline_frame, int type)
+{
+  return seq_cache_lookup(context, seq, timeline_frame, type, true);
+}
+
+bool seq_cache_put_if_possible(const SeqRenderData *context,
+                               Sequence *seq,
+                               float timeline_frame,
+                               int type,
+                               ImBuf *ibuf,
+                               const double render_start)
 {
   Scene *scene = context->scene;
 
@@ -810,7 +884,7 @@ bool seq_cache_put_if_possible(
   }
 
   if (seq_cache_recycle_item(scene)) {
-    seq_cache_put(context, seq, timeline_frame, type, ibuf);
+    seq_cache_put(context, seq, timeline_frame, type, ibuf, render_start);
     return true;
   }
 
@@ -853,8 +927,12 @@ void seq_cache_thumbnail_put(const SeqRenderData *context,
   seq_cache_unlock(scene);
 }
 
-void seq_cache_put(
-    const SeqRenderData *context, Sequence *seq, float timeline_frame, int type, ImBuf *i)
+void seq_cache_put(const SeqRenderData *context,
+                   Sequence *seq,
+                   float timeline_frame,
+                   int type,
+                   ImBuf *i,
+                   const double render_start)
 {
   if (i == nullptr || context->skip_cache || context->is_proxy_render || !seq) {
     return;
@@ -870,7 +948,7 @@ void seq_cache_put(
   }
 
   /* Prevent reinserting, it breaks cache key linking. */
-  ImBuf *test = seq_cache_get(context, seq, timeline_frame, type);
+  ImBuf *test = seq_cache_lookup(context, seq, timeline_frame, type, false);
   if (test) {
     IMB_freeImBuf(test);
     return;
@@ -883,17 +961,14 @@ void seq_cache_put(
   seq_cache_lock(scene);
   SeqCache *cache = seq_cache_get_from_scene(scene);
   SeqCacheKey *key = seq_cache_allocate_key(cache, context, seq, timeline_frame, type);
+  key->cost = seq_cache_render_cost(scene, render_start);
   seq_cache_put_ex(scene, key, i);
   seq_cache_unlock(scene);
 
   if (!key->is_temp_cache) {
     if (seq_disk_cache_is_enabled(context->bmain)) {
-      if (cache->disk_cache == nullptr) {
-        seq_disk_cache_create(context->bmain, context->scene);
-      }
-
-      seq_disk_cache_write_file(cache->disk_cache, key, i);
-      seq_disk_cache_enforce_limits(cache->disk_cache);
+      SeqDiskCache *disk_cache = seq_cache_disk_cache_ensure(context->bmain, scene);
+      seq_disk_cache_write_file(disk_cache, key, i);
     }
   }
 }
@@ -943,6 +1018,34 @@ void SEQ_cache_iterate(
   seq_cache_unlock(scene);
 }
 
+SeqCacheStatistics SEQ_cache_statistics_get(Scene *scene)
+{
+  SeqCacheStatistics stats = {};
+  SeqCache *cache = seq_cache_get_from_scene(scene);
+  if (!cache) {
+    return stats;
+  }
+
+  seq_cache_lock(scene);
+  stats = cache->stats;
+  seq_cache_unlock(scene);
+  return stats;
+}
+
+void SEQ_cache_statistics_reset(Scene *scene)
+{
+  SeqCache *cache = seq_cache_get_from_scene(scene);
+  if (!cache) {
+    return;
+  }
+
+  seq_cache_lock(scene);
+  const size_t stored_bytes = cache->stats.stored_bytes;
+  cache->stats = {};
+  cache->stats.stored_bytes = stored_bytes;
+  seq_cache_unlock(scene);
+}
+
 bool seq_cache_is_full()
 {
   return seq_cache_get_mem_total() < MEM_get_memory_in_use();
@@ -27,6 +27,7 @@ struct SeqCacheKey {
   float frame_index;    /* Usually same as timeline_frame. Mapped to media for RAW entries. */
   float timeline_frame; /* Only for reference - used for freeing when cache is full. */
   float cost;           /* In short: render time(s) divided by playback frame duration(s) */
+  size_t size;          /* Memory used by the cached image, in bytes. */
   bool is_temp_cache;   /* this cache entry will be freed before rendering next frame */
   /* ID of task for assigning temp cache entries to particular task(thread, etc.) */
   eSeqTaskId task_id;
@@ -34,15 +35,27 @@ struct SeqCacheKey {
 };
 
 ImBuf *seq_cache_get(const SeqRenderData *context, Sequence *seq, float timeline_frame, int type);
-void seq_cache_put(
-    const SeqRenderData *context, Sequence *seq, float timeline_frame, int type, ImBuf *i);
+/**
+ * \param render_start: Time (#BLI_time_now_seconds) when rendering of the image started. It is
+ * used to measure the cost of the image, so expensive images are kept in cache for longer.
+ */
+void seq_cache_put(const SeqRenderData *context,
+                   Sequence *seq,
+                   float timeline_frame,
+                   int type,
+                   ImBuf *i,
+                   double render_start);
 void seq_cache_thumbnail_put(const SeqRenderData *context,
                              Sequence *seq,
                              float timeline_frame,
                              ImBuf *i,
                              const rctf *view_area);
-bool seq_cache_put_if_possible(
-    const SeqRenderData *context, Sequence *seq, float timeline_frame, int type, ImBuf *nval);
+bool seq_cache_put_if_possible(const SeqRenderData *context,
+                               Sequence *seq,
+                               float timeline_frame,
+                               int type,
+                               ImBuf *nval,
+                               double render_start);
 /**
  * Find only "base" keys.
  * Sources(other types) for a frame must be freed all at once.
@@ -0,0 +1,120 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_time.h"
+
+#include "DNA_scene_types.h"
+#include "DNA_sequence_types.h"
+#include "DNA_userdef_types.h"
+
+#include "IMB_imbuf.hh"
+
+#include "SEQ_relations.hh"
+#include "SEQ_render.hh"
+
+#include "image_cache.hh"
+
+namespace blender::seq::tests {
+
+class ImageCacheTest : public testing::Test {
+ protected:
+  Scene *scene = nullptr;
+  Sequence *seq = nullptr;
+  SeqRenderData context = {};
+  int memcachelimit = 0;
+
+  void SetUp() override
+  {
+    memcachelimit = U.memcachelimit;
+    U.memcachelimit = 1024 * 1024;
+
+    scene = static_cast<Scene *>(MEM_callocN(sizeof(Scene), __func__));
+    scene->r.frs_sec = 25;
+    scene->r.frs_sec_base = 1.0f;
+    scene->ed = static_cast<Editing *>(MEM_callocN(sizeof(Editing), __func__));
+    scene->ed->cache_flag = SEQ_CACHE_STORE_RAW | SEQ_CACHE_STORE_FINAL_OUT;
+
+    /* Effect strips map timeline frames to cache keys without looking at strip media. */
+    seq = static_cast<Sequence *>(MEM_callocN(sizeof(Sequence), __func__));
+    seq->type = SEQ_TYPE_CROSS;
+
+    SEQ_render_new_render_data(nullptr, nullptr, scene, 256, 256, 100, false, &context);
+  }
+
+  void TearDown() override
+  {
+    seq_cache_destruct(scene);
+    MEM_freeN(seq);
+    MEM_freeN(scene->ed);
+    MEM_freeN(scene);
+    U.memcachelimit = memcachelimit;
+  }
+
+  /** Store an image that took `render_time` seconds to render. */
+  void put(const int timeline_frame, const int type, const double render_time)
+  {
+    ImBuf *ibuf = IMB_allocImBuf(1024, 1024, 32, IB_rectfloat);
+    seq_cache_put(
+        &context, seq, timeline_frame, type, ibuf, BLI_time_now_seconds() - render_time);
+    IMB_freeImBuf(ibuf);
+  }
+
+  bool is_cached(const int timeline_frame, const int type)
+  {
+    ImBuf *ibuf = seq_cache_get(&context, seq, timeline_frame, type);
+    IMB_freeImBuf(ibuf);
+    return ibuf != nullptr;
+  }
+};
+
+TEST_F(ImageCacheTest, evict_cheap_frame_first)
+{
+  /* Frame 1 has a cheap raw image, but its final image was expensive to composite. */
+  put(1, SEQ_CACHE_STORE_RAW, 0.0);
+  put(1, SEQ_CACHE_STORE_FINAL_OUT, 10.0);
+  /* Frame 2 is cheap to render. */
+  put(2, SEQ_CACHE_STORE_RAW, 0.0);
+  put(2, SEQ_CACHE_STORE_FINAL_OUT, 0.0);
+
+  /* Frame 1 is further away from current frame, so it would be removed first if both frames had
+   * the same priority. */
+  scene->r.cfra = 3;
+
+  const SeqCacheStatistics stats = SEQ_cache_statistics_get(scene);
+  const size_t frame_size = stats.stored_bytes / 2;
+
+  /* Make the cache full, so removing a single frame is enough to make room. */
+  U.memcachelimit = int((MEM_get_memory_in_use() - frame_size / 2) / (1024 * 1024));
+  EXPECT_TRUE(seq_cache_recycle_item(scene));
+
+  EXPECT_TRUE(is_cached(1, SEQ_CACHE_STORE_RAW));
+  EXPECT_TRUE(is_cached(1, SEQ_CACHE_STORE_FINAL_OUT));
+  EXPECT_FALSE(is_cached(2, SEQ_CACHE_STORE_RAW));
+  EXPECT_FALSE(is_cached(2, SEQ_CACHE_STORE_FINAL_OUT));
+
+  const SeqCacheStatistics stats_after = SEQ_cache_statistics_get(scene);
+  EXPECT_EQ(stats_after.evictions, 1);
+  EXPECT_EQ(stats_after.evicted_bytes, frame_size);
+  EXPECT_EQ(stats_after.stored_bytes, frame_size);
+}
+
+TEST_F(ImageCacheTest, thumbnails_not_in_stored_bytes)
+{
+  put(1, SEQ_CACHE_STORE_FINAL_OUT, 0.0);
+  const size_t stored_bytes = SEQ_cache_statistics_get(scene).stored_bytes;
+  EXPECT_GT(stored_bytes, 0);
+
+  ImBuf *thumbnail = IMB_allocImBuf(64, 64, 32, IB_rect);
+  const rctf view_area = {0.0f, 100.0f, 0.0f, 10.0f};
+  seq_cache_thumbnail_put(&context, seq, 1, thumbnail, &view_area);
+  IMB_freeImBuf(thumbnail);
+
+  EXPECT_EQ(SEQ_cache_statistics_get(scene).stored_bytes, stored_bytes);
+}
+
+}  // namespace blender::seq::tests
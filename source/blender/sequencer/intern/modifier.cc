@@ -347,42 +347,69 @@ static void make_cb_table_float_sop(
   }
 }
 
+static void color_balance_byte_pixel(const StripColorBalance &cb,
+                                     uchar *cp,
+                                     const uchar *m,
+                                     float mul)
+{
+  float p[4];
+
+  straight_uchar_to_premul_float(p, cp);
+
+  for (int c = 0; c < 3; c++) {
+    float t;
+    if (cb.method == SEQ_COLOR_BALANCE_METHOD_LIFTGAMMAGAIN) {
+      t = color_balance_fl_lgg(p[c], cb.lift[c], cb.gain[c], cb.gamma[c], mul);
+    }
+    else {
+      t = color_balance_fl_sop(p[c], cb.slope[c], cb.offset[c], cb.power[c], 1.0, mul);
+    }
+
+    if (m) {
+      float m_normal = float(m[c]) / 255.0f;
+
+      p[c] = p[c] * (1.0f - m_normal) + t * m_normal;
+    }
+    else {
+      p[c] = t;
+    }
+  }
+
+  premul_float_to_straight_uchar(cp, p);
+}
+
 static void color_balance_byte_byte(
     StripColorBalance *cb_, uchar *rect, const uchar *mask_rect, int width, int height, float mul)
 {
-  // uchar cb_tab[3][256];
   uchar *cp = rect;
   uchar *e = cp + width * 4 * height;
   const uchar *m = mask_rect;
 
   StripColorBalance cb = calc_cb(cb_);
 
-  while (cp < e) {
-    float p[4];
-    int c;
-
-    straight_uchar_to_premul_float(p, cp);
-
-    for (c = 0; c < 3; c++) {
-      float t;
-      if (cb.method == SEQ_COLOR_BALANCE_METHOD_LIFTGAMMAGAIN) {
-        t = color_balance_fl_lgg(p[c], cb.lift[c], cb.gain[c], cb.gamma[c], mul);
-      }
-      else {
-        t = color_balance_fl_sop(p[c], cb.slope[c], cb.offset[c], cb.power[c], 1.0, mul);
-      }
-
-      if (m) {
-        float m_normal = float(m[c]) / 255.0f;
-
-        p[c] = p[c] * (1.0f - m_normal) + t * m_normal;
-      }
-      else {
-        p[c] = t;
-      }
+  /* Result for opaque pixels without mask only depends on the channel value, so it is looked up
+   * from a table, which is filled using the same code as other pixels to get identical results.
+   * This avoids `powf` calls for most pixels of typical footage. */
+  uchar cb_tab[3][256];
+  if (m == nullptr) {
+    for (int i = 0; i < 256; i++) {
+      uchar pixel[4] = {uchar(i), uchar(i), uchar(i), 255};
+      color_balance_byte_pixel(cb, pixel, nullptr, mul);
+      cb_tab[0][i] = pixel[0];
+      cb_tab[1][i] = pixel[1];
+      cb_tab[2][i] = pixel[2];
     }
+  }
 
-    premul_float_to_straight_uchar(cp, p);
+  while (cp < e) {
+    if (m == nullptr && cp[3] == 255) {
+      cp[0] = cb_tab[0][cp[0]];
+      cp[1] = cb_tab[1][cp[1]];
+      cp[2] = cb_tab[2][cp[2]];
+    }
+    else {
+      color_balance_byte_pixel(cb, cp, m, mul);
+    }
 
     cp += 4;
     if (m) {
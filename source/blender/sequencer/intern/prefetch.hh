@@ -19,6 +19,12 @@ void seq_prefetch_start(const SeqRenderData *context, float timeline_frame);
 void seq_prefetch_free(Scene *scene);
 bool seq_prefetch_job_is_running(Scene *scene);
 void seq_prefetch_get_time_range(Scene *scene, int *r_start, int *r_end);
+/**
+ * Mark renders requested by the UI, prefetch workers except the first one wait until they are
+ * done so the UI stays responsive.
+ */
+void seq_prefetch_main_render_begin(Scene *scene);
+void seq_prefetch_main_render_end(Scene *scene);
 /**
  * For cache context swapping.
  */
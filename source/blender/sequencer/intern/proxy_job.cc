@@ -8,12 +8,25 @@
  * \ingroup bke
  */
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
 #include "MEM_guardedalloc.h"
 
 #include "DNA_scene_types.h"
 #include "DNA_sequence_types.h"
+#include "DNA_userdef_types.h"
+
+#include "BLI_array.hh"
+#include "BLI_listbase.h"
+#include "BLI_math_base.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
 
 #include "BKE_context.hh"
+#include "BKE_global.hh"
 
 #include "SEQ_proxy.hh"
 #include "SEQ_relations.hh"
@@ -31,22 +44,121 @@ static void proxy_freejob(void *pjv)
   MEM_freeN(pj);
 }
 
+/**
+ * Strips are built concurrently, each worker takes the next strip from the queue until it is
+ * empty. Every strip gets its own worker status, the job thread forwards cancellation to them and
+ * combines their progress.
+ */
+struct ProxyBuildData {
+  wmJobWorkerStatus *job_status;
+  blender::Array<SeqIndexBuildContext *> contexts;
+  blender::Array<wmJobWorkerStatus> worker_status;
+  std::atomic<int> next_context = 0;
+
+  /* Notified when a strip is done, guards `workers_running`. */
+  std::mutex mutex;
+  std::condition_variable strip_done_cond;
+  int workers_running = 0;
+};
+
+static int proxy_build_workers_num(const int contexts_num)
+{
+  /* Each strip is decoded and encoded by FFmpeg with its own threads, so by default use a
+   * fraction of the system threads to drive strips. */
+  const int threads = U.sequencer_proxy_threads > 0 ? U.sequencer_proxy_threads :
+                                                      max_ii(1, BLI_system_thread_count() / 4);
+  return min_ii(threads, contexts_num);
+}
+
+static bool proxy_build_is_stopped(const ProxyBuildData *data)
+{
+  return data->job_status->stop || G.is_break;
+}
+
+static void proxy_build_worker(TaskPool *__restrict pool, void * /*taskdata*/)
+{
+  ProxyBuildData *data = static_cast<ProxyBuildData *>(BLI_task_pool_user_data(pool));
+
+  for (int i = data->next_context++; i < data->contexts.size(); i = data->next_context++) {
+    wmJobWorkerStatus &worker_status = data->worker_status[i];
+    /* Don't rely on the job thread alone to forward cancellation, a strip may be started before
+     * it got to it. */
+    if (worker_status.stop || proxy_build_is_stopped(data)) {
+      worker_status.stop = true;
+      continue;
+    }
+    SEQ_proxy_rebuild(data->contexts[i], &worker_status);
+    worker_status.progress = 1.0f;
+    data->strip_done_cond.notify_one();
+  }
+
+  {
+    std::lock_guard lock(data->mutex);
+    data->workers_running--;
+  }
+  data->strip_done_cond.notify_one();
+}
+
 /* Only this runs inside thread. */
 static void proxy_startjob(void *pjv, wmJobWorkerStatus *worker_status)
 {
   ProxyJob *pj = static_cast<ProxyJob *>(pjv);
 
+  ProxyBuildData data;
+  data.job_status = worker_status;
+  data.contexts.reinitialize(BLI_listbase_count(&pj->queue));
+  data.worker_status.reinitialize(data.contexts.size());
+  int i = 0;
   LISTBASE_FOREACH (LinkData *, link, &pj->queue) {
-    SeqIndexBuildContext *context = static_cast<SeqIndexBuildContext *>(link->data);
+    data.contexts[i] = static_cast<SeqIndexBuildContext *>(link->data);
+    data.worker_status[i] = {};
+    data.worker_status[i].reports = worker_status->reports;
+    i++;
+  }
+
+  if (data.contexts.is_empty()) {
+    return;
+  }
+
+  const int workers_num = proxy_build_workers_num(data.contexts.size());
+  data.workers_running = workers_num;
+
+  /* A background pool never runs tasks inside the job thread, also when running with a single
+   * thread, so that this thread is free to forward cancellation while strips are built. */
+  TaskPool *task_pool = BLI_task_pool_create_background(&data, TASK_PRIORITY_LOW);
+  for (int worker = 0; worker < workers_num; worker++) {
+    BLI_task_pool_push(task_pool, proxy_build_worker, nullptr, false, nullptr);
+  }
 
-    SEQ_proxy_rebuild(context, worker_status);
+  std::unique_lock lock(data.mutex);
+  bool workers_done = false;
+  while (!workers_done) {
+    /* Progress of strips being built is only stored in their status, so also wake up at the rate
+     * the job timer reads the combined progress. */
+    workers_done = data.strip_done_cond.wait_for(
+        lock, std::chrono::milliseconds(100), [&]() { return data.workers_running == 0; });
+
+    const bool stop = proxy_build_is_stopped(&data);
+    float progress = 0.0f;
+    for (wmJobWorkerStatus &status : data.worker_status) {
+      status.stop |= stop;
+      progress += status.progress;
+      if (status.do_update) {
+        status.do_update = false;
+        worker_status->do_update = true;
+      }
+    }
+    worker_status->progress = progress / data.worker_status.size();
 
-    if (worker_status->stop) {
+    if (stop && !pj->stop) {
       pj->stop = true;
       fprintf(stderr, "Canceling proxy rebuild on users request...\n");
-      break;
     }
   }
+  lock.unlock();
+
+  BLI_task_pool_work_and_wait(task_pool);
+  BLI_task_pool_free(task_pool);
 }
 
 static void proxy_endjob(void *pjv)
@@ -25,6 +25,7 @@
 #include "BLI_math_vector_types.hh"
 #include "BLI_path_util.h"
 #include "BLI_rect.h"
+#include "BLI_time.h"
 
 #include "BKE_anim_data.hh"
 #include "BKE_animsys.h"
@@ -759,7 +760,8 @@ static ImBuf *seq_render_preprocess_ibuf(const SeqRenderData *context,
                                          ImBuf *ibuf,
                                          float timeline_frame,
                                          bool use_preprocess,
-                                         const bool is_proxy_image)
+                                         const bool is_proxy_image,
+                                         const double render_start)
 {
   if (context->is_proxy_render == false &&
       (ibuf->x != context->rectx || ibuf->y != context->recty))
@@ -771,14 +773,14 @@ static ImBuf *seq_render_preprocess_ibuf(const SeqRenderData *context,
   const bool is_effect_with_inputs = (seq->type & SEQ_TYPE_EFFECT) != 0 &&
                                      SEQ_effect_get_num_inputs(seq->type) != 0;
   if (!is_proxy_image && !is_effect_with_inputs) {
-    seq_cache_put(context, seq, timeline_frame, SEQ_CACHE_STORE_RAW, ibuf);
+    seq_cache_put(context, seq, timeline_frame, SEQ_CACHE_STORE_RAW, ibuf, render_start);
   }
 
   if (use_preprocess) {
     ibuf = input_preprocess(context, seq, timeline_frame, ibuf, is_proxy_image);
   }
 
-  seq_cache_put(context, seq, timeline_frame, SEQ_CACHE_STORE_PREPROCESSED, ibuf);
+  seq_cache_put(context, seq, timeline_frame, SEQ_CACHE_STORE_PREPROCESSED, ibuf, render_start);
   return ibuf;
 }
 
@@ -1083,6 +1085,7 @@ static ImBuf *seq_render_image_strip(const SeqRenderData *context,
       context->scene, seq, totfiles, filepath, prefix, ext);
 
   if (is_multiview_render) {
+    const double render_start = BLI_time_now_seconds();
     int totviews = BKE_scene_multiview_num_views_get(&context->scene->r);
     ImBuf **ibufs_arr = static_cast<ImBuf **>(
         MEM_callocN(sizeof(ImBuf *) * totviews, "Sequence Image Views Imbufs"));
@@ -1106,7 +1109,7 @@ static ImBuf *seq_render_image_strip(const SeqRenderData *context,
 
       if (view_id != context->view_id) {
         ibufs_arr[view_id] = seq_render_preprocess_ibuf(
-            &localcontext, seq, ibufs_arr[view_id], timeline_frame, true, false);
+            &localcontext, seq, ibufs_arr[view_id], timeline_frame, true, false, render_start);
       }
     }
 
@@ -1239,6 +1242,7 @@ static ImBuf *seq_render_movie_strip(const SeqRenderData *context,
                              BLI_listbase_count_at_most(&seq->anims, totfiles + 1) == totfiles;
 
   if (is_multiview_render) {
+    const double render_start = BLI_time_now_seconds();
     ImBuf **ibuf_arr;
     int totviews = BKE_scene_multiview_num_views_get(&context->scene->r);
     ibuf_arr = static_cast<ImBuf **>(
@@ -1270,7 +1274,7 @@ static ImBuf *seq_render_movie_strip(const SeqRenderData *context,
 
       if (view_id != context->view_id && ibuf_arr[view_id]) {
         ibuf_arr[view_id] = seq_render_preprocess_ibuf(
-            &localcontext, seq, ibuf_arr[view_id], timeline_frame, true, false);
+            &localcontext, seq, ibuf_arr[view_id], timeline_frame, true, false, render_start);
       }
     }
 
@@ -1475,6 +1479,7 @@ static ImBuf *seq_render_scene_strip(const SeqRenderData *context,
                                      float frame_index,
                                      float timeline_frame)
 {
+  const double render_start = BLI_time_now_seconds();
   ImBuf *ibuf = nullptr;
   double frame;
   Object *camera;
@@ -1697,7 +1702,12 @@ static ImBuf *seq_render_scene_strip(const SeqRenderData *context,
       }
 
       if (view_id != context->view_id) {
-        seq_cache_put(&localcontext, seq, timeline_frame, SEQ_CACHE_STORE_RAW, ibufs_arr[view_id]);
+        seq_cache_put(&localcontext,
+                      seq,
+                      timeline_frame,
+                      SEQ_CACHE_STORE_RAW,
+                      ibufs_arr[view_id],
+                      render_start);
       }
 
       RE_ReleaseResultImage(re);
@@ -1872,6 +1882,7 @@ ImBuf *seq_render_strip(const SeqRenderData *context,
                         Sequence *seq,
                         float timeline_frame)
 {
+  const double render_start = BLI_time_now_seconds();
   ImBuf *ibuf = nullptr;
   bool use_preprocess = false;
   bool is_proxy_image = false;
@@ -1894,7 +1905,7 @@ ImBuf *seq_render_strip(const SeqRenderData *context,
   if (ibuf) {
     use_preprocess = seq_input_have_to_preprocess(context, seq, timeline_frame);
     ibuf = seq_render_preprocess_ibuf(
-        context, seq, ibuf, timeline_frame, use_preprocess, is_proxy_image);
+        context, seq, ibuf, timeline_frame, use_preprocess, is_proxy_image, render_start);
   }
 
   if (ibuf == nullptr) {
@@ -1977,6 +1988,7 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
                                      float timeline_frame,
                                      int chanshown)
 {
+  const double render_start = BLI_time_now_seconds();
   Vector<Sequence *> strips = seq_get_shown_sequences(
       context->scene, channels, seqbasep, timeline_frame, chanshown);
   if (strips.is_empty()) {
@@ -2050,7 +2062,8 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
           out = seq_render_strip_stack_apply_effect(context, seq, timeline_frame, ibuf1, ibuf2);
           IMB_metadata_copy(out, ibuf2);
 
-          seq_cache_put(context, strips[i], timeline_frame, SEQ_CACHE_STORE_COMPOSITE, out);
+          seq_cache_put(
+              context, strips[i], timeline_frame, SEQ_CACHE_STORE_COMPOSITE, out, render_start);
 
           IMB_freeImBuf(ibuf1);
           IMB_freeImBuf(ibuf2);
@@ -2081,7 +2094,8 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
       IMB_freeImBuf(ibuf2);
     }
 
-    seq_cache_put(context, strips[i], timeline_frame, SEQ_CACHE_STORE_COMPOSITE, out);
+    seq_cache_put(
+        context, strips[i], timeline_frame, SEQ_CACHE_STORE_COMPOSITE, out, render_start);
   }
 
   return out;
@@ -2109,6 +2123,7 @@ ImBuf *SEQ_render_give_ibuf(const SeqRenderData *context, float timeline_frame,
     channels = ed->displayed_channels;
   }
 
+  const double render_start = BLI_time_now_seconds();
   SeqRenderState state;
   ImBuf *out = nullptr;
 
@@ -2124,17 +2139,21 @@ ImBuf *SEQ_render_give_ibuf(const SeqRenderData *context, float timeline_frame,
   SEQ_relations_free_all_anim_ibufs(context->scene, timeline_frame);
 
   if (!strips.is_empty() && !out) {
-    BLI_mutex_lock(&seq_render_mutex);
-    out = seq_render_strip_stack(context, &state, channels, seqbasep, timeline_frame, chanshown);
-
     if (context->is_prefetch_render) {
-      seq_cache_put(context, strips.last(), timeline_frame, SEQ_CACHE_STORE_FINAL_OUT, out);
+      /* Prefetch workers render their own copy of the scene, and can run in parallel. */
+      out = seq_render_strip_stack(context, &state, channels, seqbasep, timeline_frame, chanshown);
+      seq_cache_put(
+          context, strips.last(), timeline_frame, SEQ_CACHE_STORE_FINAL_OUT, out, render_start);
     }
     else {
+      seq_prefetch_main_render_begin(context->scene);
+      BLI_mutex_lock(&seq_render_mutex);
+      out = seq_render_strip_stack(context, &state, channels, seqbasep, timeline_frame, chanshown);
       seq_cache_put_if_possible(
-          context, strips.last(), timeline_frame, SEQ_CACHE_STORE_FINAL_OUT, out);
+          context, strips.last(), timeline_frame, SEQ_CACHE_STORE_FINAL_OUT, out, render_start);
+      BLI_mutex_unlock(&seq_render_mutex);
+      seq_prefetch_main_render_end(context->scene);
     }
-    BLI_mutex_unlock(&seq_render_mutex);
   }
 
   seq_prefetch_start(context, timeline_frame);
@@ -0,0 +1,173 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_math_vector.h"
+#include "BLI_rand.hh"
+#include "BLI_timeit.hh"
+
+#include "DNA_sequence_types.h"
+
+#include "IMB_imbuf.hh"
+#include "IMB_imbuf_types.hh"
+
+#include "SEQ_effects.hh"
+#include "SEQ_modifier.hh"
+#include "SEQ_render.hh"
+
+/* Timings of sequencer blend effects and the color balance modifier on 4K images. Their results
+ * are checked against reference implementations in `effects_test.cc`. */
+
+namespace blender::seq::tests {
+
+static constexpr int IMAGE_WIDTH = 3840;
+static constexpr int IMAGE_HEIGHT = 2160;
+static constexpr int ITERATIONS = 10;
+
+static ImBuf *create_random_image(const bool is_float, const uint32_t seed)
+{
+  ImBuf *ibuf = IMB_allocImBuf(IMAGE_WIDTH, IMAGE_HEIGHT, 32, is_float ? IB_rectfloat : IB_rect);
+  RandomNumberGenerator rng(seed);
+  const int64_t values_num = int64_t(IMAGE_WIDTH) * IMAGE_HEIGHT * 4;
+  for (int64_t i = 0; i < values_num; i += 4) {
+    if (is_float) {
+      /* Premultiplied color. */
+      float *col = ibuf->float_buffer.data + i;
+      col[3] = rng.get_float();
+      col[0] = rng.get_float() * col[3];
+      col[1] = rng.get_float() * col[3];
+      col[2] = rng.get_float() * col[3];
+    }
+    else {
+      for (int c = 0; c < 4; c++) {
+        ibuf->byte_buffer.data[i + c] = uchar(rng.get_uint32() & 0xFF);
+      }
+    }
+  }
+  return ibuf;
+}
+
+static void run_effect(const char *name, const int effect_type, const bool is_float)
+{
+  Sequence seq = {};
+  seq.type = effect_type;
+  SeqEffectHandle sh = SEQ_effect_handle_get(&seq);
+
+  SeqRenderData context = {};
+  context.rectx = IMAGE_WIDTH;
+  context.recty = IMAGE_HEIGHT;
+
+  ImBuf *ibuf1 = create_random_image(is_float, 1);
+  ImBuf *ibuf2 = create_random_image(is_float, 2);
+  ImBuf *out = IMB_allocImBuf(IMAGE_WIDTH, IMAGE_HEIGHT, 32, is_float ? IB_rectfloat : IB_rect);
+
+  const std::string timer_name = std::string(name) + (is_float ? " float" : " byte");
+  int64_t count = 0;
+  timeit::Nanoseconds total_time{}, min_time = timeit::Nanoseconds::max();
+  for (int i = 0; i < ITERATIONS; i++) {
+    timeit::ScopedTimerAveraged timer(timer_name, count, total_time, min_time);
+    sh.execute_slice(&context, &seq, 0.0f, 0.7f, ibuf1, ibuf2, nullptr, 0, IMAGE_HEIGHT, out);
+  }
+
+  IMB_freeImBuf(ibuf1);
+  IMB_freeImBuf(ibuf2);
+  IMB_freeImBuf(out);
+}
+
+TEST(seq_effects, cross)
+{
+  run_effect("cross", SEQ_TYPE_CROSS, false);
+  run_effect("cross", SEQ_TYPE_CROSS, true);
+}
+
+TEST(seq_effects, gamma_cross)
+{
+  run_effect("gamma cross", SEQ_TYPE_GAMCROSS, false);
+  run_effect("gamma cross", SEQ_TYPE_GAMCROSS, true);
+}
+
+TEST(seq_effects, add)
+{
+  run_effect("add", SEQ_TYPE_ADD, false);
+  run_effect("add", SEQ_TYPE_ADD, true);
+}
+
+TEST(seq_effects, subtract)
+{
+  run_effect("subtract", SEQ_TYPE_SUB, false);
+  run_effect("subtract", SEQ_TYPE_SUB, true);
+}
+
+TEST(seq_effects, multiply)
+{
+  run_effect("multiply", SEQ_TYPE_MUL, false);
+  run_effect("multiply", SEQ_TYPE_MUL, true);
+}
+
+TEST(seq_effects, alpha_over)
+{
+  run_effect("alpha over", SEQ_TYPE_ALPHAOVER, false);
+  run_effect("alpha over", SEQ_TYPE_ALPHAOVER, true);
+}
+
+TEST(seq_effects, alpha_under)
+{
+  run_effect("alpha under", SEQ_TYPE_ALPHAUNDER, false);
+  run_effect("alpha under", SEQ_TYPE_ALPHAUNDER, true);
+}
+
+static void run_color_balance(const char *name, const int method)
+{
+  Sequence seq = {};
+  ColorBalanceModifierData *cbmd = reinterpret_cast<ColorBalanceModifierData *>(
+      SEQ_modifier_new(&seq, nullptr, seqModifierType_ColorBalance));
+  StripColorBalance &cb = cbmd->color_balance;
+  cb.method = method;
+  copy_v3_fl3(cb.lift, 1.1f, 0.9f, 1.0f);
+  copy_v3_fl3(cb.gamma, 0.8f, 1.0f, 1.3f);
+  copy_v3_fl3(cb.gain, 1.2f, 0.7f, 1.0f);
+  copy_v3_fl3(cb.slope, 1.2f, 0.9f, 1.0f);
+  copy_v3_fl3(cb.offset, 1.05f, 0.95f, 1.0f);
+  copy_v3_fl3(cb.power, 0.9f, 1.1f, 1.0f);
+  cbmd->color_multiply = 1.1f;
+
+  SeqRenderData context = {};
+  context.rectx = IMAGE_WIDTH;
+  context.recty = IMAGE_HEIGHT;
+
+  /* Make half of the pixels opaque, so both the lookup table and the per-pixel path are used. */
+  ImBuf *ibuf = create_random_image(false, 1);
+  const int64_t pixels_num = int64_t(IMAGE_WIDTH) * IMAGE_HEIGHT;
+  for (int64_t i = 0; i < pixels_num; i += 2) {
+    ibuf->byte_buffer.data[i * 4 + 3] = 255;
+  }
+
+  int64_t count = 0;
+  timeit::Nanoseconds total_time{}, min_time = timeit::Nanoseconds::max();
+  for (int i = 0; i < ITERATIONS; i++) {
+    timeit::ScopedTimerAveraged timer(name, count, total_time, min_time);
+    ImBuf *out = SEQ_modifier_apply_stack(&context, &seq, ibuf, 0);
+    if (out != ibuf) {
+      IMB_freeImBuf(out);
+    }
+  }
+
+  SEQ_modifier_clear(&seq);
+  IMB_freeImBuf(ibuf);
+}
+
+TEST(seq_effects, color_balance_lift_gamma_gain)
+{
+  run_color_balance("color balance lift gamma gain", SEQ_COLOR_BALANCE_METHOD_LIFTGAMMAGAIN);
+}
+
+TEST(seq_effects, color_balance_slope_offset_power)
+{
+  run_color_balance("color balance slope offset power", SEQ_COLOR_BALANCE_METHOD_SLOPEOFFSETPOWER);
+}
+
+}  // namespace blender::seq::tests
@@ -9,6 +9,13 @@ def _run(args):
     import bpy
     import time
 
+    # Generate a scene instead of using the opened file.
+    if 'num_rigs' in args:
+        _create_many_rigs_scene(args)
+        # Evaluate once first, so that timings of the previous evaluation are available.
+        scene = bpy.context.scene
+        scene.frame_set(scene.frame_start)
+
     start_time = time.time()
     elapsed_time = 0.0
     num_frames = 0
@@ -27,6 +34,68 @@ def _run(args):
     return result
 
 
+def _create_many_rigs_scene(args):
+    # Create a scene with many animated rigs of different cost: each rig deforms a mesh that is
+    # subdivided a different number of times, and has a few drivers and constraints that are cheap
+    # to evaluate. This stresses ordering of the dependency graph evaluation, where the long chains
+    # of the heavy rigs should not wait for the cheap operations.
+    import bpy
+
+    bpy.ops.wm.read_factory_settings(use_empty=True)
+    scene = bpy.context.scene
+    scene.frame_start = 1
+    scene.frame_end = 10
+
+    for rig_index in range(args['num_rigs']):
+        location = ((rig_index % 8) * 3.0, (rig_index // 8) * 3.0, 0.0)
+
+        armature = bpy.data.armatures.new("Rig")
+        rig = bpy.data.objects.new("Rig", armature)
+        rig.location = location
+        scene.collection.objects.link(rig)
+
+        bpy.context.view_layer.objects.active = rig
+        bpy.ops.object.mode_set(mode='EDIT')
+        parent = None
+        num_bones = args['num_bones']
+        for bone_index in range(num_bones):
+            bone = armature.edit_bones.new("Bone{:d}".format(bone_index))
+            bone.head = (0.0, 0.0, bone_index / num_bones * 2.0)
+            bone.tail = (0.0, 0.0, (bone_index + 1) / num_bones * 2.0)
+            bone.parent = parent
+            bone.use_connect = parent is not None
+            parent = bone
+        bpy.ops.object.mode_set(mode='OBJECT')
+
+        for bone_index, pose_bone in enumerate(rig.pose.bones):
+            pose_bone.rotation_mode = 'XYZ'
+            if bone_index % 2 == 0:
+                fcurve = pose_bone.driver_add("rotation_euler", 0)
+                frequency = 0.1 + bone_index * 0.05
+                fcurve.driver.expression = "sin(frame * {:.3f}) * 0.3".format(frequency)
+            else:
+                constraint = pose_bone.constraints.new('COPY_ROTATION')
+                constraint.target = rig
+                constraint.subtarget = rig.pose.bones[bone_index - 1].name
+                constraint.influence = 0.5
+
+        bpy.ops.mesh.primitive_cylinder_add(vertices=32, radius=0.3, depth=2.0,
+                                            location=(location[0], location[1], 1.0))
+        mesh_object = bpy.context.object
+        mesh_object.parent = rig
+        mesh_object.location = (0.0, 0.0, 1.0)
+        modifier = mesh_object.modifiers.new("Armature", 'ARMATURE')
+        modifier.object = rig
+        for bone_index in range(num_bones):
+            group = mesh_object.vertex_groups.new(name="Bone{:d}".format(bone_index))
+            indices = [vertex.index for vertex in mesh_object.data.vertices
+                       if min(int((vertex.co.z + 1.0) * 0.5 * num_bones), num_bones - 1) == bone_index]
+            group.add(indices, 1.0, 'REPLACE')
+        # Only a few rigs are heavy, those should define the frame time.
+        subdivision = mesh_object.modifiers.new("Subdivision", 'SUBSURF')
+        subdivision.levels = 4 if rig_index % 8 == 0 else 1
+
+
 class AnimationTest(api.Test):
     def __init__(self, filepath):
         self.filepath = filepath
@@ -43,6 +112,24 @@ class AnimationTest(api.Test):
         return result
 
 
+class ManyRigsTest(api.Test):
+    def __init__(self, num_rigs):
+        self.num_rigs = num_rigs
+
+    def name(self):
+        return "many_rigs_{:d}".format(self.num_rigs)
+
+    def category(self):
+        return "animation"
+
+    def run(self, env, device_id):
+        args = {'num_rigs': self.num_rigs, 'num_bones': 8}
+        result, _ = env.run_in_blender(_run, args, ['--factory-startup'])
+        return result
+
+
 def generate(env):
     filepaths = env.find_blend_files('animation/*')
-    return [AnimationTest(filepath) for filepath in filepaths]
+    tests = [AnimationTest(filepath) for filepath in filepaths]
+    tests += [ManyRigsTest(num_rigs) for num_rigs in (32, 128)]
+    return tests